@@ -366,6 +366,10 @@ class BluetoothScanService : Service(), LocationListener {
         private fun handleCharacteristicChange(characteristic: BluetoothGattCharacteristic, value: ByteArray? = null) {
             if (characteristic.uuid == CHARACTERISTIC_TX_UUID) {
                 val data = value ?: byteArrayOf()
+                // Binary control protocol responses start with 0xF5, never valid UTF-8
+                if (data.isNotEmpty() && data[0] == 0xF5.toByte()) {
+                    return
+                }
                 val chunk = String(data)
 
                 dataBuffer.append(chunk)
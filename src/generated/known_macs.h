@@ -0,0 +1,550 @@
+// Generated by tools/gen_signatures.py from tools/signatures.json and
+// datasets/ - do not edit, re-run the generator instead.
+
+#pragma once
+#include <stdint.h>
+
+// Full 48-bit MACs of surveyed units, see encode_known_macs() in
+// tools/gen_signatures.py for the layout
+#define GEN_KNOWN_MAC_COUNT 5700
+
+struct GenMacBlock {
+    uint32_t first_hi;              // First (lowest) MAC of the block, top 32 bits
+    uint16_t first_lo;              // ...and low 16 bits
+    uint8_t count;                  // MACs in the block, including the first
+    uint8_t width;                  // Bits per packed (mac - first)
+    uint32_t packed;                // (bit offset in GEN_KNOWN_MAC_BITS << 8) | DetectionType
+};
+
+// Sorted by first MAC
+static constexpr GenMacBlock GEN_KNOWN_MAC_BLOCKS[] = {
+    { 0x00f48d62, 0x3409, 7, 10, 0x00000001 },  // 00:f4:8d
+    { 0x040d842b, 0xc2a4, 32, 10, 0x00003c01 },  // 04:0d:84
+    { 0x040d842b, 0xc4f4, 32, 12, 0x00017201 },  // 04:0d:84
+    { 0x040d842b, 0xcff6, 32, 8, 0x0002e601 },  // 04:0d:84
+    { 0x040d842b, 0xd09d, 32, 9, 0x0003de01 },  // 04:0d:84
+    { 0x040d842b, 0xd21a, 32, 22, 0x0004f501 },  // 04:0d:84
+    { 0x040d844c, 0x7163, 32, 18, 0x00079f01 },  // 04:0d:84
+    { 0x040d844f, 0xa7f4, 32, 14, 0x0009cd01 },  // 04:0d:84
+    { 0x040d844f, 0xd214, 32, 8, 0x000b7f01 },  // 04:0d:84
+    { 0x040d844f, 0xd341, 32, 19, 0x000c7701 },  // 04:0d:84
+    { 0x040d8454, 0xd544, 32, 14, 0x000ec401 },  // 04:0d:84
+    { 0x040d8455, 0x001c, 28, 7, 0x00107601 },  // 04:0d:84
+    { 0x083a8820, 0xf140, 30, 17, 0x00113301 },  // 08:3a:88
+    { 0x145afc6f, 0xd549, 32, 21, 0x00132001 },  // 14:5a:fc
+    { 0x145afc86, 0x47af, 32, 20, 0x0015ab01 },  // 14:5a:fc
+    { 0x145afc91, 0xe8c9, 16, 19, 0x00181701 },  // 14:5a:fc
+    { 0x1bbdaf35, 0x3800, 1, 0, 0x00193401 },  // 1b:bd:af
+    { 0x1c34f101, 0xa10b, 32, 23, 0x00193401 },  // 1c:34:f1
+    { 0x1c34f15a, 0x52c6, 15, 13, 0x001bfd01 },  // 1c:34:f1
+    { 0x385b44e6, 0x7a74, 24, 14, 0x001cb301 },  // 38:5b:44
+    { 0x3c9180a4, 0xe005, 32, 21, 0x001df501 },  // 3c:91:80
+    { 0x3c9180bd, 0xb34f, 32, 18, 0x00208001 },  // 3c:91:80
+    { 0x3c9180bf, 0xe1df, 8, 13, 0x0022ae01 },  // 3c:91:80
+    { 0x588e81f9, 0x51e5, 32, 18, 0x00230901 },  // 58:8e:81
+    { 0x588e81fb, 0x5ddd, 32, 17, 0x00253701 },  // 58:8e:81
+    { 0x588e81fc, 0xdc1b, 32, 7, 0x00274601 },  // 58:8e:81
+    { 0x588e81fc, 0xdc79, 32, 7, 0x00281f01 },  // 58:8e:81
+    { 0x588e81fc, 0xdcd5, 32, 8, 0x0028f801 },  // 58:8e:81
+    { 0x588e81fc, 0xdd62, 32, 7, 0x0029f001 },  // 58:8e:81
+    { 0x588e81fc, 0xddb0, 32, 7, 0x002ac901 },  // 58:8e:81
+    { 0x588e81fc, 0xddfa, 32, 8, 0x002ba201 },  // 58:8e:81
+    { 0x588e81fc, 0xdeea, 32, 7, 0x002c9a01 },  // 58:8e:81
+    { 0x588e81fc, 0xdf3b, 32, 13, 0x002d7301 },  // 58:8e:81
+    { 0x588e81fc, 0xf582, 32, 7, 0x002f0601 },  // 58:8e:81
+    { 0x588e81fc, 0xf5c5, 32, 7, 0x002fdf01 },  // 58:8e:81
+    { 0x588e81fc, 0xf61f, 32, 10, 0x0030b801 },  // 58:8e:81
+    { 0x588e81fc, 0xf8b0, 32, 7, 0x0031ee01 },  // 58:8e:81
+    { 0x588e81fc, 0xf90d, 32, 7, 0x0032c701 },  // 58:8e:81
+    { 0x588e81fc, 0xf969, 32, 7, 0x0033a001 },  // 58:8e:81
+    { 0x588e81fc, 0xf9c3, 32, 7, 0x00347901 },  // 58:8e:81
+    { 0x588e81fc, 0xfa35, 32, 7, 0x00355201 },  // 58:8e:81
+    { 0x588e81fc, 0xfa8c, 32, 7, 0x00362b01 },  // 58:8e:81
+    { 0x588e81fc, 0xfae7, 32, 7, 0x00370401 },  // 58:8e:81
+    { 0x588e81fc, 0xfb51, 32, 7, 0x0037dd01 },  // 58:8e:81
+    { 0x588e81fc, 0xfb96, 32, 16, 0x0038b601 },  // 58:8e:81
+    { 0x588e81fd, 0x9a61, 32, 7, 0x003aa601 },  // 58:8e:81
+    { 0x588e81fd, 0x9abc, 32, 8, 0x003b7f01 },  // 58:8e:81
+    { 0x588e81fd, 0x9b41, 32, 7, 0x003c7701 },  // 58:8e:81
+    { 0x588e81fd, 0x9b8c, 32, 7, 0x003d5001 },  // 58:8e:81
+    { 0x588e81fd, 0x9bf8, 32, 7, 0x003e2901 },  // 58:8e:81
+    { 0x588e81fd, 0x9c46, 32, 7, 0x003f0201 },  // 58:8e:81
+    { 0x588e81fd, 0x9c9d, 32, 7, 0x003fdb01 },  // 58:8e:81
+    { 0x588e81fd, 0x9ceb, 32, 7, 0x0040b401 },  // 58:8e:81
+    { 0x588e81fd, 0x9d2c, 32, 11, 0x00418d01 },  // 58:8e:81
+    { 0x588e81fd, 0xa41f, 32, 7, 0x0042e201 },  // 58:8e:81
+    { 0x588e81fd, 0xa48b, 32, 8, 0x0043bb01 },  // 58:8e:81
+    { 0x588e81fd, 0xa57e, 32, 7, 0x0044b301 },  // 58:8e:81
+    { 0x588e81fd, 0xa5ee, 32, 7, 0x00458c01 },  // 58:8e:81
+    { 0x588e81fd, 0xa641, 32, 16, 0x00466501 },  // 58:8e:81
+    { 0x588e81fe, 0x7298, 13, 12, 0x00485501 },  // 58:8e:81
+    { 0x588e87fc, 0xddf2, 1, 0, 0x0048e501 },  // 58:8e:87
+    { 0x62dd4c98, 0x3272, 1, 0, 0x0048e501 },  // 62:dd:4c
+    { 0x70c94e7f, 0x5b7d, 24, 13, 0x0048e501 },  // 70:c9:4e
+    { 0x744ca168, 0xda9d, 32, 21, 0x004a1001 },  // 74:4c:a1
+    { 0x744ca17e, 0xb03f, 32, 12, 0x004c9b01 },  // 74:4c:a1
+    { 0x744ca17e, 0xbf2f, 32, 20, 0x004e0f01 },  // 74:4c:a1
+    { 0x744ca189, 0x2977, 32, 14, 0x00507b01 },  // 74:4c:a1
+    { 0x744ca189, 0x5ca9, 32, 18, 0x00522d01 },  // 74:4c:a1
+    { 0x744ca18c, 0x7273, 9, 12, 0x00545b01 },  // 74:4c:a1
+    { 0x80304912, 0x77fd, 32, 20, 0x0054bb01 },  // 80:30:49
+    { 0x80304921, 0xd3a1, 32, 24, 0x00572701 },  // 80:30:49
+    { 0x803049e0, 0x5afd, 3, 7, 0x005a0f01 },  // 80:30:49
+    { 0x86a2f435, 0x7512, 1, 0, 0x005a1d01 },  // 86:a2:f4
+    { 0x903586ca, 0x1b5a, 1, 0, 0x005a1d01 },  // 90:35:86
+    { 0x9035eaac, 0x9000, 32, 17, 0x005a1d01 },  // 90:35:ea
+    { 0x9035eaae, 0x4656, 32, 12, 0x005c2c01 },  // 90:35:ea
+    { 0x9035eaae, 0x4fc5, 32, 7, 0x005da001 },  // 90:35:ea
+    { 0x9035eaae, 0x5017, 32, 8, 0x005e7901 },  // 90:35:ea
+    { 0x9035eaae, 0x50ef, 32, 8, 0x005f7101 },  // 90:35:ea
+    { 0x9035eaae, 0x51f0, 32, 7, 0x00606901 },  // 90:35:ea
+    { 0x9035eaae, 0x524a, 32, 7, 0x00614201 },  // 90:35:ea
+    { 0x9035eaae, 0x529b, 32, 7, 0x00621b01 },  // 90:35:ea
+    { 0x9035eaae, 0x5314, 32, 7, 0x0062f401 },  // 90:35:ea
+    { 0x9035eaae, 0x5368, 32, 7, 0x0063cd01 },  // 90:35:ea
+    { 0x9035eaae, 0x53c4, 32, 7, 0x0064a601 },  // 90:35:ea
+    { 0x9035eaae, 0x543c, 32, 7, 0x00657f01 },  // 90:35:ea
+    { 0x9035eaae, 0x5490, 32, 7, 0x00665801 },  // 90:35:ea
+    { 0x9035eaae, 0x5501, 32, 9, 0x00673101 },  // 90:35:ea
+    { 0x9035eaae, 0x5667, 32, 10, 0x00684801 },  // 90:35:ea
+    { 0x9035eaae, 0x5898, 32, 12, 0x00697e01 },  // 90:35:ea
+    { 0x9035eaae, 0x62d1, 32, 11, 0x006af201 },  // 90:35:ea
+    { 0x9035eaae, 0x671e, 32, 18, 0x006c4701 },  // 90:35:ea
+    { 0x9035eab2, 0x623a, 32, 13, 0x006e7501 },  // 90:35:ea
+    { 0x9035eab2, 0x7367, 32, 11, 0x00700801 },  // 90:35:ea
+    { 0x9035eab2, 0x7b56, 32, 7, 0x00715d01 },  // 90:35:ea
+    { 0x9035eab2, 0x7bc2, 32, 11, 0x00723601 },  // 90:35:ea
+    { 0x9035eab2, 0x802f, 24, 8, 0x00738b01 },  // 90:35:ea
+    { 0x92b7ddd9, 0x9c8b, 1, 0, 0x00744301 },  // 92:b7:dd
+    { 0x94085328, 0x12e5, 32, 22, 0x00744301 },  // 94:08:53
+    { 0x94346926, 0x2fbd, 32, 23, 0x0076ed01 },  // 94:34:69
+    { 0x9434697b, 0xa428, 5, 12, 0x0079b601 },  // 94:34:69
+    { 0x9c2f9d4f, 0xe173, 12, 22, 0x0079e601 },  // 9c:2f:9d
+    { 0xa2a2f435, 0x7513, 2, 23, 0x007ad801 },  // a2:a2:f4
+    { 0xa6a2f435, 0x7512, 2, 23, 0x007aef01 },  // a6:a2:f4
+    { 0xb4e3f93f, 0xe8f5, 32, 20, 0x007b0601 },  // b4:e3:f9
+    { 0xb4e3f94a, 0x39d2, 32, 8, 0x007d7201 },  // b4:e3:f9
+    { 0xb4e3f94a, 0x3ab9, 32, 8, 0x007e6a01 },  // b4:e3:f9
+    { 0xb4e3f94a, 0x3b45, 32, 9, 0x007f6201 },  // b4:e3:f9
+    { 0xb4e3f94a, 0x3d39, 32, 7, 0x00807901 },  // b4:e3:f9
+    { 0xb4e3f94a, 0x3d9b, 32, 9, 0x00815201 },  // b4:e3:f9
+    { 0xb4e3f94a, 0x3ea4, 32, 8, 0x00826901 },  // b4:e3:f9
+    { 0xb4e3f94a, 0x3f6f, 32, 11, 0x00836101 },  // b4:e3:f9
+    { 0xb4e3f94a, 0x449a, 32, 10, 0x0084b601 },  // b4:e3:f9
+    { 0xb4e3f94a, 0x47e8, 32, 9, 0x0085ec01 },  // b4:e3:f9
+    { 0xb4e3f94a, 0x4960, 32, 10, 0x00870301 },  // b4:e3:f9
+    { 0xb4e3f94a, 0x4b81, 32, 8, 0x00883901 },  // b4:e3:f9
+    { 0xb4e3f94a, 0x4c6a, 24, 12, 0x00893101 },  // b4:e3:f9
+    { 0xb827eb0b, 0x7c52, 25, 24, 0x008a4501 },  // b8:27:eb
+    { 0xc0c9e350, 0x301e, 1, 0, 0x008c8501 },  // c0:c9:e3
+    { 0xccccac9a, 0x347b, 1, 0, 0x008c8501 },  // cc:cc:ac
+    { 0xcccccc95, 0x1869, 32, 12, 0x008c8501 },  // cc:cc:cc
+    { 0xcccccc95, 0x2109, 32, 14, 0x008df901 },  // cc:cc:cc
+    { 0xcccccc95, 0x43b5, 32, 12, 0x008fab01 },  // cc:cc:cc
+    { 0xcccccc97, 0x71a4, 32, 12, 0x00911f01 },  // cc:cc:cc
+    { 0xcccccc97, 0x7d68, 32, 7, 0x00929301 },  // cc:cc:cc
+    { 0xcccccc97, 0x7daf, 32, 8, 0x00936c01 },  // cc:cc:cc
+    { 0xcccccc98, 0xf2e5, 32, 17, 0x00946401 },  // cc:cc:cc
+    { 0xcccccc9a, 0x371c, 32, 7, 0x00967301 },  // cc:cc:cc
+    { 0xcccccc9a, 0x3765, 32, 8, 0x00974c01 },  // cc:cc:cc
+    { 0xcccccc9a, 0x37fa, 32, 7, 0x00984401 },  // cc:cc:cc
+    { 0xcccccc9a, 0x3848, 32, 6, 0x00991d01 },  // cc:cc:cc
+    { 0xcccccc9a, 0x3888, 32, 10, 0x0099d701 },  // cc:cc:cc
+    { 0xcccccc9a, 0x3b40, 31, 7, 0x009b0d01 },  // cc:cc:cc
+    { 0xccd4cc9a, 0x387b, 1, 0, 0x009bdf01 },  // cc:d4:cc
+    { 0xd0395754, 0xd935, 6, 22, 0x009bdf01 },  // d0:39:57
+    { 0xd8f3bc3d, 0x0b2d, 32, 12, 0x009c4d01 },  // d8:f3:bc
+    { 0xd8f3bc3d, 0x17b3, 32, 12, 0x009dc101 },  // d8:f3:bc
+    { 0xd8f3bc3d, 0x201f, 32, 23, 0x009f3501 },  // d8:f3:bc
+    { 0xd8f3bc7d, 0xb97f, 32, 12, 0x00a1fe01 },  // d8:f3:bc
+    { 0xd8f3bc7d, 0xc795, 32, 12, 0x00a37201 },  // d8:f3:bc
+    { 0xd8f3bc7d, 0xd13d, 10, 11, 0x00a4e601 },  // d8:f3:bc
+    { 0xe00af6b7, 0x856b, 8, 20, 0x00a54901 },  // e0:0a:f6
+    { 0xe0382e13, 0x857c, 1, 0, 0x00a5d501 },  // e0:38:2e
+    { 0xe4aaea32, 0xf3cd, 32, 23, 0x00a5d501 },  // e4:aa:ea
+    { 0xe4aaea80, 0x98fb, 32, 12, 0x00a89e01 },  // e4:aa:ea
+    { 0xe4aaea80, 0xa177, 8, 10, 0x00aa1201 },  // e4:aa:ea
+    { 0xe4c32a6c, 0x1abe, 1, 0, 0x00aa5801 },  // e4:c3:2a
+    { 0xe6f4c61d, 0x7a55, 1, 0, 0x00aa5801 },  // e6:f4:c6
+    { 0xe8d0fc8a, 0x43e9, 1, 0, 0x00aa5801 },  // e8:d0:fc
+    { 0xec1bbd1f, 0x4401, 32, 16, 0x00aa5801 },  // ec:1b:bd
+    { 0xec1bbd20, 0x0b66, 32, 8, 0x00ac4801 },  // ec:1b:bd
+    { 0xec1bbd20, 0x0c3b, 32, 8, 0x00ad4001 },  // ec:1b:bd
+    { 0xec1bbd20, 0x0d10, 32, 20, 0x00ae3801 },  // ec:1b:bd
+    { 0xec1bbd2a, 0x1c46, 32, 7, 0x00b0a401 },  // ec:1b:bd
+    { 0xec1bbd2a, 0x1ca5, 32, 16, 0x00b17d01 },  // ec:1b:bd
+    { 0xec1bbd2a, 0xe0ca, 32, 9, 0x00b36d01 },  // ec:1b:bd
+    { 0xec1bbd2a, 0xe233, 32, 7, 0x00b48401 },  // ec:1b:bd
+    { 0xec1bbd2a, 0xe29d, 32, 7, 0x00b55d01 },  // ec:1b:bd
+    { 0xec1bbd2a, 0xe2e9, 32, 23, 0x00b63601 },  // ec:1b:bd
+    { 0xec1bbd87, 0xc71f, 32, 9, 0x00b8ff01 },  // ec:1b:bd
+    { 0xec1bbd87, 0xc827, 32, 7, 0x00ba1601 },  // ec:1b:bd
+    { 0xec1bbd87, 0xc8f0, 32, 7, 0x00baef01 },  // ec:1b:bd
+    { 0xec1bbd87, 0xc933, 32, 7, 0x00bbc801 },  // ec:1b:bd
+    { 0xec1bbd87, 0xc995, 32, 7, 0x00bca101 },  // ec:1b:bd
+    { 0xec1bbd87, 0xc9f1, 32, 16, 0x00bd7a01 },  // ec:1b:bd
+    { 0xec1bbd88, 0x98d7, 32, 10, 0x00bf6a01 },  // ec:1b:bd
+    { 0xec1bbd88, 0x9b1c, 32, 13, 0x00c0a001 },  // ec:1b:bd
+    { 0xec1bbd88, 0xb21f, 32, 7, 0x00c23301 },  // ec:1b:bd
+    { 0xec1bbd88, 0xb29f, 32, 8, 0x00c30c01 },  // ec:1b:bd
+    { 0xec1bbd88, 0xb354, 32, 8, 0x00c40401 },  // ec:1b:bd
+    { 0xec1bbd88, 0xb40c, 32, 8, 0x00c4fc01 },  // ec:1b:bd
+    { 0xec1bbd88, 0xb53d, 32, 8, 0x00c5f401 },  // ec:1b:bd
+    { 0xec1bbd88, 0xb5d2, 32, 22, 0x00c6ec01 },  // ec:1b:bd
+    { 0xec1bbdaf, 0x2e08, 32, 7, 0x00c99601 },  // ec:1b:bd
+    { 0xec1bbdaf, 0x2e70, 32, 7, 0x00ca6f01 },  // ec:1b:bd
+    { 0xec1bbdaf, 0x2ed6, 32, 7, 0x00cb4801 },  // ec:1b:bd
+    { 0xec1bbdaf, 0x2f1f, 32, 7, 0x00cc2101 },  // ec:1b:bd
+    { 0xec1bbdaf, 0x2f64, 32, 6, 0x00ccfa01 },  // ec:1b:bd
+    { 0xec1bbdaf, 0x2f9d, 32, 11, 0x00cdb401 },  // ec:1b:bd
+    { 0xec1bbdaf, 0x3534, 32, 7, 0x00cf0901 },  // ec:1b:bd
+    { 0xec1bbdaf, 0x357d, 32, 7, 0x00cfe201 },  // ec:1b:bd
+    { 0xec1bbdaf, 0x35de, 32, 9, 0x00d0bb01 },  // ec:1b:bd
+    { 0xec1bbdaf, 0x3763, 32, 9, 0x00d1d201 },  // ec:1b:bd
+    { 0xec1bbdaf, 0x3880, 32, 9, 0x00d2e901 },  // ec:1b:bd
+    { 0xec1bbdaf, 0x3a5f, 32, 8, 0x00d40001 },  // ec:1b:bd
+    { 0xec1bbdaf, 0x3ae8, 32, 7, 0x00d4f801 },  // ec:1b:bd
+    { 0xec1bbdaf, 0x3b3c, 32, 6, 0x00d5d101 },  // ec:1b:bd
+    { 0xec1bbdaf, 0x3b7e, 32, 9, 0x00d68b01 },  // ec:1b:bd
+    { 0xec1bbdaf, 0x3c85, 32, 7, 0x00d7a201 },  // ec:1b:bd
+    { 0xec1bbdaf, 0x3cd8, 32, 9, 0x00d87b01 },  // ec:1b:bd
+    { 0xec1bbdaf, 0x3e68, 32, 7, 0x00d99201 },  // ec:1b:bd
+    { 0xec1bbdaf, 0x3eba, 32, 18, 0x00da6b01 },  // ec:1b:bd
+    { 0xec1bbdb2, 0x2021, 32, 7, 0x00dc9901 },  // ec:1b:bd
+    { 0xec1bbdb2, 0x2079, 32, 7, 0x00dd7201 },  // ec:1b:bd
+    { 0xec1bbdb2, 0x20d7, 32, 8, 0x00de4b01 },  // ec:1b:bd
+    { 0xec1bbdb2, 0x21dd, 32, 8, 0x00df4301 },  // ec:1b:bd
+    { 0xec1bbdb2, 0x2267, 32, 9, 0x00e03b01 },  // ec:1b:bd
+    { 0xec1bbdb2, 0x2405, 32, 9, 0x00e15201 },  // ec:1b:bd
+    { 0xec1bbdb2, 0x25d4, 27, 16, 0x00e26901 },  // ec:1b:bd
+    { 0xf082c035, 0x335b, 32, 15, 0x00e40901 },  // f0:82:c0
+    { 0xf082c035, 0xb734, 32, 20, 0x00e5da01 },  // f0:82:c0
+    { 0xf082c03f, 0x53a9, 32, 22, 0x00e84601 },  // f0:82:c0
+    { 0xf082c07d, 0x6984, 26, 18, 0x00eaf001 },  // f0:82:c0
+    { 0xf46add32, 0x009d, 9, 22, 0x00ecb201 },  // f4:6a:dd
+    { 0xf67fd7d2, 0x794c, 1, 0, 0x00ed6201 },  // f6:7f:d7
+    { 0xf70f1230, 0x823d, 1, 0, 0x00ed6201 },  // f7:0f:12
+    { 0xf8a2d647, 0x9b85, 8, 11, 0x00ed6201 },  // f8:a2:d6
+    { 0xfa35a21e, 0x964f, 1, 0, 0x00edaf01 },  // fa:35:a2
+};
+
+static constexpr uint32_t GEN_KNOWN_MAC_BITS[] = {
+    0x90627884, 0xbae1d86d, 0x3dca0741, 0xd774dd07, 0x781df775, 0x1f8799e2,
+    0xb856137f, 0xd62a88e1, 0x3d8ee378, 0x9063f8fa, 0xa4791243, 0x000a4c92,
+    0x61c60003, 0x0c6ec69c, 0x07207107, 0x8d277269, 0x028f68ee, 0x293a9129,
+    0x95695294, 0x7ab6a962, 0xeb92b86b, 0xbd2bbab9, 0xeabe6bd6, 0x45c2806b,
+    0xcac98907, 0x8f4d0c8b, 0x5110500f, 0xd652d251, 0x9f5e1c18, 0x6423a2a1,
+    0x68682625, 0xe84c2200, 0xcd56a32c, 0xeb72b81a, 0xc7dbe5ee, 0x9dc4200f,
+    0x6d329344, 0x576b155a, 0xcedf6eb0, 0x0197abb5, 0x00090800, 0x92000246,
+    0x00250000, 0x62000980, 0x00990002, 0xa8002680, 0x02720009, 0x20009f00,
+    0x0ca00032, 0x00032a00, 0x33c000cb, 0x000d0000, 0x04800408, 0x004ce001,
+    0xea001350, 0x3e558004, 0xdc13e690, 0x3e7d04f9, 0xb04fa1c1, 0xfa3413e8,
+    0xc13e8f04, 0x001e0004, 0x3ba00098, 0xc800f180, 0x000f5003, 0x0101803e,
+    0xa6966992, 0x72e69bb9, 0xae69e39a, 0x669f19a7, 0x6a019a7e, 0xbb59a83e,
+    0xd59af266, 0xd9af6e6b, 0x9afde6bd, 0xb11e6bfb, 0x30e6c5b9, 0x166cfd9b,
+    0x780039b4, 0x0e803600, 0x029003e0, 0xc0410102, 0x5c052013, 0x17005881,
+    0x018c05d8, 0x301ca068, 0x7581ce07, 0x0a8029e0, 0x74f482a8, 0x014fed3f,
+    0x41950454, 0xd435507d, 0x04830100, 0x8d8c8b08, 0xae1e9c98, 0xbcbc3bb3,
+    0xc0c03f3d, 0x494847c1, 0x504e4b4a, 0x37d55251, 0x6001e000, 0x00b10015,
+    0x2e400598, 0x50018200, 0x0063000c, 0x1a400338, 0xa800d300, 0x01d54006,
+    0x76c00ec4, 0x0403bf00, 0x0120e01e, 0x4b980968, 0x3c026240, 0x0239f047,
+    0x8e9c11d2, 0xab047540, 0xc11de823, 0x03e008f0, 0x004c00ca, 0xd00ac01e,
+    0x1e00bc02, 0x7409cfa7, 0x67469d16, 0x3e74d9d2, 0xd6a7509d, 0x9d8675c9,
+    0x79d96764, 0x8c9dc276, 0x79f9e427, 0x67aa9e8e, 0x267c79ec, 0xe0aacbab,
+    0x223860b0, 0x03864c16, 0x284e951a, 0xf2f5aad5, 0x2b509115, 0x0f464c58,
+    0x598024c0, 0x98013000, 0x8c06c402, 0x6027100d, 0xc691605b, 0x1ab68d28,
+    0x74ac3683, 0xe0c8eed8, 0x1183c4d1, 0x25109888, 0x124c7e23, 0x113a1c99,
+    0x45dd527a, 0x1d82ce8d, 0xb6eb3bd2, 0x43800004, 0x000bc000, 0x53200266,
+    0x80132c00, 0x5e20028a, 0xc00e9600, 0x40f80203, 0xc0090700, 0x28d80131,
+    0xb005b900, 0xf6bc4585, 0xc15edd0a, 0x7b9f2bdb, 0x2caf7f85, 0xbe1195f0,
+    0x6c57c4f2, 0x5f3e8af9, 0x4e2be981, 0xafc2057d, 0x6115f9e8, 0x0002359c,
+    0x0a500053, 0x5000da00, 0x01310012, 0x31001b50, 0x00266002, 0x2f900298,
+    0x20035800, 0x03a60039, 0x57004120, 0x0050e004, 0x5960053d, 0x8005c700,
+    0x062e0061, 0x60006590, 0x0071c006, 0xa4800733, 0xa5ca525c, 0xce815ce6,
+    0xbb5cf555, 0xc0153800, 0xac7200d6, 0x18a57544, 0x4962b12c, 0x59184b1a,
+    0xaf92d2ea, 0x64b69e96, 0x2e15a5b7, 0x006973d9, 0x00009800, 0x38000054,
+    0x00250000, 0x80008a00, 0x23800046, 0x0011d000, 0x980008f8, 0x02600004,
+    0x80013200, 0x70c000de, 0x003ac000, 0x68001dd0, 0x0bb80017, 0x0005de00,
+    0x810002f8, 0x00c28001, 0x40006200, 0x05780031, 0x83cd9821, 0x2dacfcc4,
+    0x589a58b0, 0x962c5cac, 0xd784ec25, 0xc5de2120, 0x0b25b0e8, 0x98b4b005,
+    0x1c6e234a, 0x00b698b3, 0x8925a48c, 0x1493124a, 0xa40a8aaa, 0x2a5aa962,
+    0xcb0eac35, 0x8b30f6c3, 0xd8f3632d, 0x0d923644, 0xead9c366, 0x639002bf,
+    0x000db800, 0x4b000209, 0x800f6400, 0x6e40027c, 0x800e3400, 0x47c001e2,
+    0xa00af100, 0xa6f0d536, 0xb57b4d9a, 0x001aafdc, 0x02c06196, 0x03bb5816,
+    0x4d6085ab, 0x838fac1c, 0xa2b07b95, 0x194c160f, 0x04633523, 0x8cf1cc67,
+    0x23b1a071, 0xc685c634, 0x05f0013a, 0x7b001920, 0x68020a00, 0x00222008,
+    0x02b00092, 0x75201570, 0x1401df00, 0x0029b009, 0x035180c5, 0x39000d9a,
+    0xf680e940, 0x08115803, 0x013ae04b, 0x16ae052b, 0x74405cd0, 0x9605fa81,
+    0x48b06818, 0x400122c2, 0xffc6980a, 0xa8802cb8, 0xd8013d11, 0x802dc007,
+    0xfc680102, 0xcb6ff1b3, 0x08ff343f, 0xeff523fd, 0xff98bfe1, 0xfd53fe70,
+    0xa6bffc0f, 0x8c05a500, 0xc0809018, 0x0a3f0247, 0xacf02b24, 0x8503c440,
+    0x9043ec10, 0x0598c110, 0x5c5416fd, 0xacc177b0, 0x0a02c100, 0x0018ac08,
+    0x81192036, 0x84b60253, 0x13e109c5, 0x5eac2b54, 0x7d10be70, 0xf60300a1,
+    0x8c484123, 0xd1213a90, 0x64ebd245, 0xafc4b7e1, 0xbf13df89, 0xfc597e28,
+    0xf1c5f8da, 0xc7b7e3ab, 0x605080af, 0x8d17223c, 0x9d2a3427, 0x8c582c50,
+    0x931603b6, 0x49d325ca, 0x5cb15aad, 0x78d0e142, 0x4c162844, 0x9501f366,
+    0xcb15294c, 0x76c582f5, 0x19b2e1bd, 0x03af4e95, 0x1a0d0c04, 0x524f4e4c,
+    0x5b5a5554, 0x605f5e5c, 0x6a696865, 0x76716e6d, 0x817f7c7a, 0x02818c86,
+    0x3c58a122, 0xa60b9528, 0x4a8501e3, 0x86ec55a7, 0xc482f5d3, 0x64b8f1a2,
+    0xc4050536, 0x509901c2, 0x86cc962a, 0x5094f9d3, 0xf58ad529, 0xb86ac982,
+    0x3448505d, 0x1c181006, 0x403c3028, 0x7060544c, 0x84807c74, 0x94908c88,
+    0x00d8d098, 0x675f4731, 0x17a7a39b, 0x84c78c14, 0x3c68c172, 0xd56a111f,
+    0x3860bd72, 0x1c07cf5d, 0xe5498f12, 0x000ce9b2, 0x2c00e002, 0xc1600680,
+    0xe57d2bc8, 0xc095ffaf, 0x4b065826, 0x866c2d61, 0xb623b0e5, 0x1658aec4,
+    0xac6b632b, 0x3cb1dd8e, 0xd902c7f6, 0x89643b20, 0x386080ec, 0x888d1828,
+    0x68c972c4, 0x280f9e36, 0x54a13244, 0x968c582d, 0xc180f9eb, 0x68a0c101,
+    0x0a121e38, 0xb5424407, 0x501c3362, 0x93222438, 0x1a13e6cb, 0x01b3569d,
+    0x02405010, 0x0120440a, 0x30681805, 0xf93d0ac2, 0x689825e4, 0x9ce6c9ae,
+    0x2789da74, 0x2a027f9f, 0x1a85a128, 0xa080e8aa, 0x13223460, 0xf9c3460b,
+    0x58274c84, 0xe9cb564c, 0xf161417a, 0xaf427ca8, 0x60a100dc, 0x921c3050,
+    0x423385ca, 0x56ac56a9, 0xe5c3666c, 0x4f9ebc74, 0xb14e5c68, 0xc1628386,
+    0x95263c70, 0x5aa4e8cb, 0x5bb260bd, 0x121c176e, 0x74a6c98f, 0x0362ad4a,
+    0x11e34606, 0x9e3a68a1, 0xd365ea4f, 0xa3c280ed, 0x82cd3a52, 0xdb35eac9,
+    0x1a0b8f0d, 0xd3664c10, 0x274c84f1, 0x9ad56a54, 0xa0bb6cd1, 0x2e4c78d0,
+    0x7467cd99, 0x080c156a, 0x31a30508, 0x213c5ca9, 0xbb666bd3, 0x5e3b72e1,
+    0x4224180f, 0x566bd5a3, 0x1e34403b, 0x9447cb14, 0xb65cb562, 0x5468afdd,
+    0x29d29f32, 0x72ddaad5, 0x39b160bb, 0x0e182820, 0xf1c30488, 0x94264880,
+    0x01c3664b, 0x95274485, 0xddab466c, 0x0061be70, 0x01400100, 0x02c00280,
+    0x05000340, 0x06800600, 0x09800780, 0xa4c00c40, 0xa6e7a5e7, 0xa8e7a867,
+    0xa967a927, 0xaa67aa27, 0xad67ad27, 0xaea7ae27, 0xb0a7aee7, 0xb1a7b127,
+    0xb267b1e7, 0x284060a7, 0x0b0f1c18, 0xcd4a2407, 0xaedc366a, 0x8505fbe7,
+    0x09f36644, 0x59ad5695, 0x8f0b8786, 0x18141392, 0x1e9e1d1c, 0xa221a01f,
+    0x2fa8a322, 0xb736b3b1, 0xbe3bbab8, 0x00c1bf3e, 0x284060a1, 0xa509111a,
+    0x4688d992, 0xb509d324, 0x3466c562, 0x44278e5b, 0x81019526, 0x6cd0e162,
+    0x8ad4263c, 0x78e99af5, 0x98909fbe, 0x57ab325c, 0x4e4bd6ed, 0x438203af,
+    0x3c68c142, 0x86cd1724, 0x54a121e3, 0x664c572b, 0x407ee5bb, 0x549911e1,
+    0x44070c12, 0x4c88c162, 0x88d1172a, 0x68c15264, 0x17cf1c35, 0xcd8d161c,
+    0x0d4a74a7, 0xc4070a0c, 0x4c88d182, 0xe68c962a, 0x4e991a03, 0xf5cad528,
+    0xc484edba, 0x4079b222, 0x088f1c24, 0x70d192a5, 0x68909f3a, 0x509d3254,
+    0x568c97ab, 0xbe7af1b3, 0x0400301f, 0x1e024040, 0x54098110, 0xe01802e0,
+    0x30440740, 0x80ac1402, 0xc1902f05, 0x03b0700d, 0x08c1101f, 0xbb3746e7,
+    0x796f1ddd, 0x05880c17, 0x68991203, 0x280f1d36, 0x62b94a84, 0xc97261c0,
+    0xdcb34a7c, 0x0e6c986f, 0xc0a03820, 0x352514fc, 0xd5bd554d, 0x261dfddd,
+    0x867e5e46, 0x06ceb69e, 0x472f270f, 0x140f776f, 0x65878c12, 0x4c9521f3,
+    0xb74c1729, 0xc180f9e3, 0xcd8a53a6, 0xb4e3b76a, 0x10181d7a, 0x8284060a,
+    0x2e5470d1, 0x14078e1a, 0x2c509922, 0xc366acd8, 0x27ce8ef1, 0x6a804514,
+    0x58e0d580, 0xf8a275a1, 0x0e630322, 0xeaa33643, 0xc2576976, 0xe3b7df37,
+    0xe7d7e677, 0x02780257, 0x21581438, 0x3b5832d8, 0x75985038, 0x32f8cb38,
+    0x35f93459, 0x70f93a99, 0x01797f59, 0xca544512, 0x09987b85, 0xbbaa469e,
+    0x18c40bcc, 0x0c003412, 0x305922bb, 0x45621a90, 0xf12d495c, 0xc065d72d,
+    0x432f9954, 0xe70d826b, 0x48003ef9, 0x6b219500, 0x00229a44, 0x600014c0,
+    0x01a00003, 0x500041a0, 0x01260008, 0xb0002580, 0x00c20005, 0x4b0019c0,
+    0x006d0003, 0xd9800e2c, 0x0042e001, 0x440009de, 0x00291001, 0xafe00561,
+    0x0016d800, 0x69c002f4, 0x55d3b600, 0x541aba7e, 0x2aea9057, 0xaa795d52,
+    0xa57566ab, 0x0cf0af01, 0x901280eb, 0x31c01ad1, 0x2fa2a529, 0xc038f313,
+    0xe4ea4633, 0x5205044e, 0x3e53c539, 0xb5b95af5, 0x64060d5d, 0x3d68b685,
+    0x000875c7, 0x33000110, 0x0007b000, 0x0e9000dd, 0x20011100, 0x020f001a,
+    0x50002120, 0x0025b002, 0x34a0032f, 0x40036500, 0x03e1003b, 0xfc003fb0,
+    0x0051b004, 0x642005ba, 0x90069d00, 0x0782006e, 0xce007930, 0x5335e007,
+    0x3d3533b4, 0xf5343553, 0x0502d807, 0x1c705ac1, 0xc24e0860, 0x3829f0a2,
+    0x05c3510d, 0x13844bd1, 0x214284f1, 0xd6171052, 0x63217785, 0xd6ac5a45,
+    0x9973d5c1, 0x2397675d, 0x638d8de6, 0x00269933, 0x041c009e, 0x77001b50,
+    0x54024f00, 0x4027e009, 0x02d800a2, 0x32c00c88, 0xcd00f000, 0x000f8003,
+    0x0104c041, 0x507013a1, 0x36814510, 0xbc14e405, 0x41531053, 0x15ba054d,
+    0x610057cc, 0xd205a001, 0xf62b7816, 0x1d410c06, 0x3e3e4386, 0x36c55f25,
+    0x00e2000a, 0x450013b0, 0x00189001, 0x1af001a9, 0x3001b200, 0x01f5001d,
+    0x44002040, 0x00260002, 0x29f00271, 0xe7aa3300, 0xab5d7aae, 0xa87ab797,
+    0x7ac7b7ab, 0xca87ac7f, 0x47acb97a, 0xacda7acc, 0x2d7ad1e7, 0x7ad6e7ad,
+    0xdaf7ad9f, 0x00004e7a, 0x8100007c, 0x00960000, 0x00009f00, 0xd60001a7,
+    0x01d70001, 0x5f405b00, 0xcf5f4096, 0x40d15f40, 0x5f40db5f, 0x4b5f412f,
+    0x414d5f41, 0x5f41745f, 0xab5f4198, 0x41bc5f41, 0x5f41bf5f, 0x3e5f41ed,
+    0x42f05f42, 0x5f43075f, 0x625f4347, 0x43655f43, 0x5f43755f, 0x9b5f4384,
+    0xd9b15f43, 0x800bc005, 0x006a0022, 0x03b40136, 0x15300878, 0x58c02b40,
+    0xa800bf80, 0x10035c01, 0xa0104807, 0xc04c0023, 0x013d009a, 0x6925b1ce,
+    0xb1d6d8d7, 0xc91b640d, 0x276d9276, 0xa1b64fdb, 0xaed9476c, 0x1300bdb2,
+    0xc0910150, 0x4633fe3d, 0x498446b6, 0x085f85c8, 0x86386286, 0x6d86a868,
+    0x387186f8, 0x88287687, 0x59957954, 0x99669659, 0x96e96c96, 0xf182c301,
+    0x9a284c80, 0x5a94e84e, 0x19b260b9, 0xf5db96ad, 0x31a24180, 0x093e6cc9,
+    0x52360e0c, 0x68665e58, 0x78747270, 0x82807e7c, 0xb4a49084, 0x897b6f68,
+    0x9b958f8b, 0x0403a9a1, 0x1e140e06, 0x48463c20, 0xc0baa658, 0x0702d8c2,
+    0x5543312f, 0x6b67635d, 0xf9ef8b77, 0x848505ff, 0x5ca121e3, 0x274e1a30,
+    0x4c952224, 0x15ab15a9, 0x4178e9bb, 0x8cd8b121, 0x8587080e, 0x609901e3,
+    0xa7ce9b32, 0x5cb55a84, 0x970cd8b0, 0x45870a0b, 0x0d09f325, 0x8b091018,
+    0xb562a527, 0x0ddb305c, 0x97222c38, 0xcaf4a84f, 0xe9cd8aed, 0x483edcf7,
+    0x078e1628, 0x70c97264, 0x09929f3c, 0x70c972b5, 0x37af1db9, 0x509f3244,
+    0x407074e9, 0xc9911e38, 0x8901a305, 0xcad5284a, 0x6ed59b15, 0x2a1262b8,
+    0x59b15e9d, 0x70d1606d, 0x4d9a3058, 0xb53253e7, 0x0ddab362, 0x8f1213b7,
+    0xaa52e548, 0xf5d37ae5, 0x6890e101, 0xcf182e38, 0x99223427, 0x4b96ac50,
+    0x6ed9ab36, 0xe992a13e, 0x81a74a84, 0x991141c1, 0x119f3050, 0xbd5aa4c9,
+    0x4e1bb566, 0x8b0a03e7, 0x4c776c57, 0x1007ab2e, 0x8220d030, 0x2c150a04,
+    0xc1d0d864, 0x2d1208c3, 0x91b8d85e, 0x208f8783, 0xb9288a44, 0x51644fe2,
+    0xb21035ad, 0xb8b22848, 0xf97c90b3, 0x7f9fd7ed, 0xa0681601, 0xf83a0c82,
+    0x5e1484a0, 0x1b866188, 0x89a2087a, 0x62c8ae28, 0x02402001, 0x5004402c,
+    0xc0600580, 0x09007806, 0xbc0a80a0, 0x97380c80, 0xa759258e, 0x8db75af5,
+    0x24edc11b, 0x6de6aa5d, 0x92716712, 0x00068c67, 0x41a02c03, 0x8be14e22,
+    0x1f23d46a, 0x5d8b890e, 0x0d2103dc, 0x3045e88d, 0x289a12b2, 0x915aaa85,
+    0xc3ef61cb, 0x78891061, 0x160003c4, 0x20007000, 0xfc7f800a, 0xc827f207,
+    0x87ff217f, 0xaff225fc, 0x7f235fc8, 0xf247fc8e, 0x24ffc927, 0x57fc94ff,
+    0xffc99ff2, 0xfcb17f2a, 0xcb5ff2d3, 0x267f2e9f, 0x6ff4dbfd, 0x7f58dfd4,
+    0xf5e3fd6a, 0x0b1fd81f, 0x704981f0, 0x51c2680a, 0x02341108, 0x33098c4b,
+    0xc51626e1, 0xe215a0aa, 0x8ca862a2, 0xe4371195, 0x35099f4c, 0x70e2c6fc,
+    0xf503c49c, 0x043f5eaa, 0x43100389, 0x0cc0f619, 0x2ee4cc7f, 0x710d0189,
+    0xbe36d5c8, 0x7f8b2e05, 0x9f30658c, 0x8288cf39, 0xc7d2c9b4, 0x8fcff9be,
+    0x7fb3f5fe, 0x1e3860a0, 0x74c94c11, 0x3262b95a, 0xc376cd5a, 0x5f3d78e5,
+    0x76cd39d3, 0x0071dfbd, 0x08005004, 0x15026048, 0x92310600, 0xb0738e61,
+    0xa8f31da3, 0xd2784007, 0x8518a093, 0xca894f29, 0x1602be54, 0x33c5c8b2,
+    0x48401466, 0xa0605850, 0xaa8a2a00, 0x3302c2b2, 0xbbb3433b, 0x9463fbf3,
+    0xb40001c6, 0x00920000, 0xf00046c0, 0x06080014, 0x0001cf00, 0x2f900074,
+    0x000de800, 0xe4c0038e, 0x0039a000, 0x3f001100, 0x61b38005, 0x85fa0ff3,
+    0xa2547e88, 0x07e8f19f, 0x942dfa46, 0x9fa66e7e, 0xb427ea85, 0x7eae25fa,
+    0x091faffe, 0xfb2fc7ec, 0x4e7ed301, 0x013e3fb5, 0x9800a9e0, 0x583c0081,
+    0xa6b7c400, 0x16d35e36, 0xd88ee9b1, 0x2a8b6c14, 0x3bdd4602, 0x51a8b6a3,
+    0x6ca8dac9, 0x36b7d46d, 0x752026aa, 0xed3aa97c, 0xaaa95d54, 0x795554ca,
+    0x5666aaaa, 0xeaabcb55, 0x7715568b, 0x563eeaab, 0xd6ab353d, 0xe325559f,
+    0xd572e8aa, 0x582ab979, 0x68ae86ac, 0x029b112a, 0x52b0a71b, 0x92341e33,
+    0x0b249e29, 0x7d9a19f6, 0x4aa384ea, 0x38afe8e2, 0xc2d0bee2, 0xd46173a8,
+    0xe40068b9, 0x00804007, 0x08000bd4, 0xc014e001, 0x16500159, 0x98016d00,
+    0x89860017, 0x95a89922, 0xe89c2689, 0xa7fa89e3, 0xa29429e8, 0x942ba942,
+    0x2ea942c2, 0xe942f294, 0x432a9430, 0x3a9432e9, 0x9433e943, 0x35e94356,
+    0x29436a94, 0x3c269437, 0x64504c44, 0x289c9484, 0x65615539, 0x897d7571,
+    0xb9a5958d, 0x3b363dc9, 0x8f736f5b, 0x1c140f97, 0x84786034, 0x2d290888,
+    0x65614535, 0x91857d6d, 0xcda19d95, 0xfdf9d5d1, 0x221a0601, 0x80301006,
+    0x0d038140, 0x10e86828, 0x13890442, 0x78ac5429, 0x0cc64301, 0xf86c351a,
+    0xbd7c79b8, 0x09f3f87b, 0x1202c405, 0x992e5491, 0x9ae569d0, 0xa03f76dd,
+    0x3a64b951, 0xd569d29f, 0x3016cd8a, 0x868280a0, 0x9c462210, 0x0742c158,
+    0x8c411f0f, 0x05725924, 0xc54a18cb, 0x96c34da4, 0x82409d6d, 0x0c060308,
+    0x281e1612, 0x6056524a, 0xbcb67470, 0xd2d0c8c2, 0xf8f2eae2, 0x0902fcfa,
+    0x9389390f, 0x0380600b, 0x11020030, 0x3e0740c8, 0xc8188300, 0xf83b0680,
+    0x708810c1, 0x452c4784, 0x5572ac55, 0xab656aac, 0xa4d4815b, 0x22e95527,
+    0x1374d0d8, 0x25653e4f, 0x66128319, 0x288861f8, 0x8de2f8b6, 0x6749a666,
+    0x99f2769d, 0xd2e5a4a8, 0x47d0b3dc, 0x01e05d2f, 0x3e160a04, 0xf0481bf1,
+    0x148742a0, 0xc8cc622d, 0x92c923b1, 0x5caa5127, 0x4d267309, 0x26893c9d,
+    0x02806015, 0x02e0901c, 0xe0f0360c, 0x08b22b84, 0xde368d03, 0xc4ac0908,
+    0xb1ec5b14, 0x4d834ace, 0x5394e037, 0x070cc02f, 0x3222200e, 0x4d38423e,
+    0x5b59574f, 0x716f6b5f, 0x83817d73, 0xa38f8987, 0xbbaba9a7, 0xa003c7bf,
+    0x01a00e00, 0xb636801e, 0xb0410064, 0x06705d05, 0x9d08d079, 0xf0b90a70,
+    0x0e50cb0b, 0x3721d0f7, 0x60185552, 0x9e20d4f7, 0x8738411d, 0x44d91e63,
+    0xb227191d, 0x8fcbc78c, 0x6a325068, 0x748b8e29, 0x323aac25, 0xacd7f22c,
+    0x52ad255a, 0x702eedff, 0x708952ce, 0x213108ee, 0x1d48b5dd, 0xd9e04576,
+    0x211ca5df, 0xd591bdc1, 0x8062019d, 0x1ee12a0c, 0x543482d8, 0xa4e84303,
+    0x5da5c84e, 0xf279c6e4, 0xe83282c7, 0x91e8cc8a, 0x54b04952, 0xcc4abeab,
+    0xd86c8cc4, 0xdb1370e2, 0x4820fd81, 0x05861428, 0xa0726173, 0x7788241c,
+    0x2b30a842, 0x22b98ad4, 0x8631f8b5, 0xf8e3be8d, 0x11be4608, 0xa121a483,
+    0xe7133c49, 0x56d956e4, 0xb15195f0, 0x04801454, 0xa0070060, 0x00c00b80,
+    0x1b813810, 0x78258250, 0x82a02802, 0x3282f82a, 0x90388358, 0x49736d03,
+    0x15d06ce5, 0x7d1d5195, 0xd6253b53, 0x8a85d04d, 0xfdbf0940, 0x5c2dc1db,
+    0xc4dc3dc3, 0xa5c95c85, 0xdccdcc5c, 0xcf5cedcd, 0x25d1dcfd, 0xdd35d2dd,
+    0xd6dd45d3, 0xe5dddd95, 0x0c15e1dd, 0x02c5080a, 0x325ca942, 0x74884f9d,
+    0xaf5ab15a, 0xcb86ed59, 0x203e78ed, 0x603018b1, 0x10e0a090, 0xc1914121,
+    0x321201d1, 0xc2927252, 0x16f6b332, 0x67574737, 0x77f7e7a7, 0x7bf43de9,
+    0xf550f9a8, 0xe943f3a1, 0xed0fd687, 0xf43fea1f, 0xd100287f, 0x4404a200,
+    0x10428817, 0x416a2095, 0x06a882f4, 0x1ea20e51, 0x96884344, 0xaa213d10,
+    0x28857442, 0xa217d10b, 0x88654431, 0x101d10ce, 0xa284860a, 0x2c5480e1,
+    0xf3864c17, 0x264a8901, 0x8b05eb94, 0xe33c6ed1, 0xb0908911, 0xf17120d0,
+    0x94746401, 0x958514b4, 0xd5c5b5a5, 0x473726e6, 0xe7d79777, 0x48d87867,
+    0x101c3059, 0x6282c509, 0x25447cc1, 0x62a52a13, 0x9c3364b5, 0x0a03c76e,
+    0x32e54589, 0x40e30610, 0x9a616512, 0xee34aa67, 0x4d134503, 0xe99e5655,
+    0x017ff73a, 0x01a0400e, 0x60901e07, 0xf03a0d02, 0x4c1283e0, 0x16054148,
+    0x0661905a, 0xa1e0761b, 0x28801f07, 0x362f8942, 0x4040558d, 0x4a0f1828,
+    0x80e9c325, 0x6c172a48, 0x78e9cb76, 0x3850603e, 0x478d1624, 0xf7800dd7,
+    0x1654b057, 0xff16b234, 0xb023d8f2, 0x840c4082, 0x6384b448, 0xa48186f0,
+    0x8da4cf89, 0xfccf78f2, 0xd91b9190, 0x12d928d1, 0x53548133, 0x85561539,
+    0x16c96855, 0x8a980173, 0x4412004d, 0xc18c1501, 0x40c3001b, 0x404ac42c,
+    0x86dc5a45, 0x78071c6e, 0x8c894784, 0xca4c9f09, 0xce0cc8b2, 0x9cd74d1c,
+    0x0fa8f68e, 0x0110a4ff, 0x000ae000, 0x800008a0, 0x03a80005, 0x00040c00,
+    0x2600021d, 0x009d8001, 0xd0005000, 0x18480028, 0x000ce800, 0x4a00067a,
+    0x01aa0003, 0xc000e040, 0x39a00071, 0x001d7000, 0x2a00104c, 0x046a0008,
+    0xc1c92d80, 0x4c00e497, 0x04bb3072, 0x9d025f02, 0x97ea812f, 0xa04c0040,
+    0x7585a843, 0x38e608e0, 0x11f8fe8f, 0x4892e921, 0x121d1f59, 0x262a5fa3,
+    0x9ea93a8f, 0x72c12b0a, 0xaecaebae, 0x15312311, 0xb34c33ab, 0x83838536,
+    0x72059851, 0x88918790, 0x0bb0b109, 0xe20d30bd, 0x68f58e70, 0x9110f80f,
+    0x4112511a, 0x19571561, 0x9c11b398, 0xea1d89cb, 0x4a3e22c1, 0xc15c00a4,
+    0x0980be0c, 0x9df3966e, 0x40069500, 0x3e8923e1, 0x01247412, 0x24d4d24b,
+    0x04924d95, 0x0008e000, 0xc91ab930, 0xaf308d5d, 0x2357b046, 0xf691abe8,
+    0x6b0008d5, 0x02359624, 0x67b11acc, 0x46b4088d, 0x3d235a38, 0xd6b891ad,
+    0xa46b6b08, 0xdd9235ba, 0x8d6fb91a, 0x1446b810, 0xae19235c, 0x88d70d91,
+    0xcd046b96, 0x1ae78235, 0xb48d7659, 0xa4b646bb, 0xa6d26f4d, 0x2c01e80f,
+    0x306304e0, 0x88187907, 0x9088b889, 0xa8a98a60, 0x8dd0be8b, 0x0a1020df,
+    0x416011b9, 0x17797696, 0xdb1aa989, 0xe9f21e81, 0x0052049f, 0x50b82b08,
+    0x01921f26, 0x09000800, 0x1d001600, 0x1f001e00, 0x2b002000, 0x2f002d00,
+    0x31003000, 0x37003200, 0x3f003d00, 0x51004000, 0xc603c500, 0x26c72303,
+    0x2dc72ac7, 0x35c72ec7, 0x5dc738c7, 0x64c762c7, 0x080704c7, 0x1f19160a,
+    0x29252220, 0x3a372f2d, 0x5b59453e, 0xa2817c70, 0xb9b6afac, 0xd2cdc1bc,
+    0x0a070503, 0x251d160d, 0x49423a37, 0x5f5e4f4e, 0xadaba961, 0xb4b1b0af,
+    0xc1b9b6b5, 0x06cbc7c2, 0x00007000, 0x00c0000a, 0xf0001a00, 0x008d0007,
+    0x98000950, 0x00099000, 0x1110009b, 0x5a0e3300, 0x0e36a0e3, 0x39a0e37a,
+    0xa0ee9a0e, 0xef5a0eea, 0x9a0ef6a0, 0x0efba0ef, 0x01a0effa, 0xa0f06a0f,
+    0xf0ca0f0b, 0x1a0f13a0, 0x0f2ca0f2, 0x407cc8fa, 0xc52a12a3, 0xb360bd72,
+    0xf3970dda, 0x224282fd, 0x3e74c932, 0x576c56a7, 0x4000a000, 0xc0018001,
+    0x2001e001, 0x40024002, 0xa0036003, 0xa0040003, 0x60052004, 0x8005e005,
+    0x000f8007, 0xa0126011, 0x98816012, 0x3881f881, 0xd8829882, 0x98835882,
+    0x9883d883, 0x04005884, 0x8c441c0a, 0xcf46b341, 0x12833e9e, 0x69147a31,
+    0x9b4aa512, 0x55127938, 0xacd5a96a, 0x3d8abd5d, 0x0a10182b, 0x42648789,
+    0x2a509d21, 0x2c476e56, 0x27cd972a, 0x72dd8af4, 0x3a73dfbb, 0x14203850,
+    0xb2a4c88f, 0x283e78e9, 0x82f5ab15, 0x9ab466c5, 0x0a03f72d, 0x00e5c987,
+    0x00012000, 0x680000b0, 0x00d00000, 0x00007200, 0x1f00003d, 0x00108000,
+    0x50000880, 0x02700004, 0x00014c00, 0x720000c2, 0x003a8000, 0x40001e40,
+    0x0ac00015, 0xe7208800, 0x3173905a, 0xe41cb9c8, 0xee720fdc, 0x84973908,
+    0xce427b9c, 0xaee72155, 0xc8597390, 0x5ce433b9, 0xb13a4d02, 0x56cb559a,
+    0x84c15faf, 0x8ca63b11, 0xcf673359, 0xd6ab51a6, 0x75b85c0d, 0xfbe9f0f7,
+    0xe0e0b007, 0x284c9090, 0x44078d95, 0xba72d57a, 0x3c58505f, 0x6bd6a746,
+    0x8705cb56, 0x0180eed3, 0x1c3460b1, 0xc364c90f, 0x274a90f9, 0x9b156a54,
+    0xdd396cd1, 0x0603d78e, 0xc1010185, 0x263c4870, 0xe3668c96, 0xa74a80f9,
+    0xb3466c55, 0xdebc76dd, 0x2614180f, 0x43868c13, 0x4484f1c3, 0xe54a1324,
+    0x3d72d9a2, 0x6c684fdf, 0x29d2a13a, 0x0add9ab5, 0x34001400, 0x50004400,
+    0x34012000, 0x44013c01, 0x50014801, 0x64015c01, 0xb4019c01, 0xf802f402,
+    0x24030802, 0x48034003, 0x50054c05, 0x60055c05, 0x78057005, 0x8c058805,
+    0x8805a405, 0x00c00f3b, 0x504c1204, 0x881c0641, 0x2b0a8250, 0x0c42f0b8,
+    0xc3a0d834, 0x12b0a324, 0xd8b42ccb, 0xdb43cc12, 0x8f63b7a5, 0xfacf2011,
+    0x680b3fd9, 0x3da1ad03, 0xd1d688b4, 0x1b485a3e, 0xa52d2569, 0x1697b4ad,
+    0x505a66d3, 0xad5d6a1b, 0xe7b6a5ac, 0xdbbeddd6, 0xf96fbb78, 0x0c15bf6d,
+    0xc3458a12, 0x7ae9c362, 0xf9526340, 0xe4bf4a84, 0x86edbaf2, 0xbc75e5c7,
+    0xa0601fde, 0xd150f0c0, 0x827251f1, 0x03f36302, 0x94745434, 0xa514c4a4,
+    0xca965605, 0x4b1aeada, 0x8070603b, 0xc0b0a090, 0x514130e0, 0x01f17161,
+    0xf2e28242, 0x23e36332, 0xd8a84594, 0x3b6b1b08, 0xc0908040, 0x311100e0,
+    0xb1915141, 0xa2622201, 0xf3c342b2, 0x2cdcbc8b, 0xfdcd5d4d, 0x302e5e3d,
+    0xa1413050, 0xe1d1c1b1, 0xe2825241, 0x75650472, 0xe5d5c5a5, 0x26663605,
+    0x28179757, 0x000048e8, 0x2b00009c, 0x000b0000, 0xe0000320, 0x00510000,
+    0x30005880, 0xdf4a55b7, 0xe677d499, 0x7e499df8, 0x99dfa267, 0xfae677e9,
+    0x677ec99d, 0xf499dfba, 0x9dfe2677, 0xee677fa9, 0x77ff99df, 0xe99e0026,
+    0xe0466780, 0xe6781699, 0x82d99e07, 0x99e0ba67, 0xa066782f, 0x14243860,
+    0x82e4478c, 0xa53e6cc9, 0x8ae5aa94, 0xa63c76e9, 0x8f15bab3, 0x014167cb,
+    0x427c58a1, 0x25eb54a7, 0x376cd19b, 0x1bf7ce9c, 0x66cb951e, 0x82d57ab4,
+    0xa18283c5, 0x264480f1, 0xf3a6cc17, 0x294e9101, 0x92f5cb15, 0x1c376acd,
+    0x161c17af, 0x42440605, 0x2a5080f1, 0xf3a64b96, 0x2b54a529, 0xb3464c56,
+    0x9e3b70dd, 0x060c07ef, 0x091c5102, 0x44d24503, 0x75c6da5d, 0xa796485f,
+    0x0badb2ba, 0x008db5cb, 0x02e03005, 0x47a8ecd2, 0x90d20a3f, 0x2ba4f49a,
+    0x694c297d, 0xeab756ca, 0x057fafd5, 0xab11606c, 0xf63ac5d8, 0xac9591b1,
+    0x44040765, 0x4470b142, 0xe54a1324, 0x407ce192, 0x94c911a2, 0x396ec162,
+    0x33f7cf1d, 0xc2840606, 0x3c58a121, 0x260b9520, 0x4c7cf1c3, 0xb9322345,
+    0xdaa74a74, 0x1debb72d, 0x8401a060, 0x783a1608, 0xead54a90, 0xc55bad55,
+    0xf66b2d8e, 0x6cb55a6c, 0xcba5bedd, 0xc0dfefd7, 0x18070983, 0x03c14090,
+    0xa03e1108, 0x9deee76b, 0xf8fa7cbc, 0x3007fbf5, 0x07834160, 0xf8642611,
+    0x8d452250, 0x0838091c, 0x2dd66af4, 0x0580bc5c, 0x994c7613, 0xb2f87b34,
+    0x387b9d9e, 0xb4d8eb74, 0x2ddedf6b, 0xef76399c, 0x140c0805, 0x25211f19,
+    0x46452a28, 0x59584a47, 0x6d6c6b65, 0x77767574, 0x817c7b7a, 0x01888783,
+    0x78c16241, 0xcc962848, 0x95223446, 0x0bd4274c, 0x6cd5a336, 0x978e9cb8,
+    0xc2894a7c, 0x59449038, 0xb49a071a, 0x91c303ad, 0x65544d2c, 0xed9e57db,
+    0xc1f0cfdd, 0x3f1f0e86, 0xa2290480, 0x2a1489c4, 0x1984c05e, 0x9a8d2653,
+    0x0d047d3d, 0x9a6b853a, 0x0d047fbe, 0x860b0c0e, 0x68c161e3, 0x88cf9c36,
+    0x56a54274, 0x280fdd2f, 0x488b121c, 0x1d09f325, 0x83814040, 0xc0562813,
+    0x87439188, 0x5080200f, 0xac45ead5, 0x6f673198, 0x1bf5f6f5, 0xc5e1f098,
+    0x180b1f8c, 0x5284c90d, 0x234278b1, 0x6aa509d2, 0x5a305eb9, 0x01dba6cd,
+    0xb2e54483, 0x40002509, 0x00058001, 0x00900018, 0xa8000380, 0x95c0cb6c,
+    0xdc0ef703, 0xc0f7703c, 0x115703e5, 0x47704f5c, 0xd70525c1, 0x7053dc14,
+    0x0565c151, 0x585c15b7, 0xc5c16970, 0x5c187705, 0xc1a37063, 0x26f70725,
+    0x0970ae5c, 0xa121c305, 0x0f1a3058, 0xb962a509, 0x4d9a3260, 0x05322407,
+    0x94e84789, 0x0606bd5a, 0xf1a30588, 0xa4345490, 0xe3a64b95, 0xa03f7cf5,
+    0x36446870, 0x1529d29f, 0x38100dcb, 0x88786848, 0xb0a89890, 0xd2b2a8b8,
+    0x230b02ea, 0x5b3b332b, 0x13ab7b63, 0xec544c34, 0x78685827, 0xb0a09888,
+    0x30e8d8c8, 0x6a625a42, 0xaaa29a7a, 0xab22eada, 0x1bebc3b3, 0x2c443c2c,
+    0x11880060, 0x409a4b25, 0xcb85b2a9, 0xd2673197, 0x06d361ac, 0x7d3e1e4f,
+    0xb42204fe, 0x9348e409, 0x20073b29, 0x368200d0, 0x01f8f574, 0xe9f4c874,
+    0xd164afd6, 0x174b7dae, 0x94bedf2f, 0x9d0e6f35, 0xdc6bb55a, 0x660061cc,
+    0xa4008400, 0xa800a600, 0xae00ac00, 0xc001b001, 0xd001ca01, 0xde01d601,
+    0xea01e001, 0xd601fc01, 0xe5bcdbbc, 0xfdbcedbc, 0x05bcffbc, 0xf7bd0dbd,
+    0x18161bbf, 0x4547528b, 0x3e07ba05, 0x1d662044, 0x477e8ecf, 0xf281e3cc,
+    0x7d5ee941, 0x1d5f96b0, 0x7f5c7db0, 0x06784b2f, 0xc27f84bf, 0xf4ffe14b,
+    0x7fd07aa8, 0x5ff63feb, 0x1bfeeffb, 0x0312c031, 0xbd403b40, 0x803bf803,
+    0x759003c4, 0x0c076700, 0x319d2312, 0xa6e319fe, 0x24097631, 0x10c640a2,
+    0x1e411d64, 0x43b4e43b, 0xb9643b92, 0x6463d643, 0x08ca46ef, 0x8e611a26,
+    0x635de61a, 0x3ea63e7a, 0xe6445a64, 0x509a6447, 0x8000f166, 0x1804003e,
+    0x80061300, 0xb2700185, 0xf1c063c6, 0xeafc72f0, 0xc7bf4f1e, 0xbff1f017,
+    0x2050bc7e, 0xc7c8159f, 0x8cd8f20f, 0x1f24143c, 0x5bebc96b, 0x7c9d0cf2,
+    0xdfaf274e, 0xf3193fcb, 0xc5bccdd5, 0xcde30f35, 0x29f38387, 0x7c1e7ce4,
+    0x4fdf641f, 0x0003f822, 0x33400080, 0x3d033f40, 0x10815414, 0x09288247,
+    0xd4402936, 0x08038160, 0x5c420f0e, 0xc5eac109, 0x68c419bc, 0x5251a40c,
+    0xc51d4d47, 0xdd3b2b42, 0xe99df6f3, 0x2fe3ab8e, 0x106eec14, 0x8ea735c9,
+    0x952969f2, 0xe4254f0e, 0xc489cb0e, 0x9e0dc0f2, 0xe4fb9ae2, 0x00006ec7,
+    0x00000000,
+};
@@ -0,0 +1,87 @@
+// Generated by tools/gen_signatures.py from tools/signatures.json and
+// datasets/ - do not edit, re-run the generator instead.
+
+#pragma once
+#include <stdint.h>
+
+struct GenRavenService {
+    uint8_t uuid[16];               // Big endian, as printed
+    uint8_t fw_mask;                // Bit i = firmware version i exposes it
+    const char* description;
+};
+
+struct GenRavenCharacteristic {
+    uint8_t uuid[16];
+    uint8_t service;                // Index into GEN_RAVEN_SERVICES
+    uint8_t fw_mask;
+    const char* name;
+};
+
+#define GEN_RAVEN_FIRMWARE_COUNT 3  // Oldest first: 1.1.7, 1.2.0, 1.3.1
+static constexpr const char* GEN_RAVEN_FIRMWARE_BY_MASK[8] = {
+    "Unknown Version",
+    "1.1.x (Legacy)",
+    "1.2.x",
+    "1.1.x (Legacy) or 1.2.x",
+    "1.3.x (Latest)",
+    "1.1.x (Legacy) or 1.3.x (Latest)",
+    "1.2.x or 1.3.x (Latest)",
+    "1.1.x (Legacy) or 1.2.x or 1.3.x (Latest)",
+};
+
+// Sorted by UUID
+static constexpr GenRavenService GEN_RAVEN_SERVICES[] = {
+    { { 0x00, 0x00, 0x18, 0x09, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 0x01, "Health/Temperature Service (Legacy)" },  // 00001809-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x18, 0x0a, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 0x07, "Device Information (Serial, Model, Firmware)" },  // 0000180a-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x18, 0x19, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 0x01, "Location Service (Legacy)" },  // 00001819-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x31, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 0x06, "GPS Location Service (Lat/Lon/Alt)" },  // 00003100-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x32, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 0x06, "Power Management (Battery/Solar)" },  // 00003200-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x33, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 0x06, "Network Status (LTE/WiFi)" },  // 00003300-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x34, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 0x06, "Upload Statistics Service" },  // 00003400-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x35, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 0x06, "Error/Failure Tracking Service" },  // 00003500-0000-1000-8000-00805f9b34fb
+};
+
+// Sorted by UUID, then service
+static constexpr GenRavenCharacteristic GEN_RAVEN_CHARACTERISTICS[] = {
+    { { 0x00, 0x00, 0x2a, 0x03, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 1, 0x01, "Reconnect Address" },  // 00002a03-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x2a, 0x07, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 0, 0x01, "TX Power Level" },  // 00002a07-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x2a, 0x19, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 0, 0x01, "Battery Level" },  // 00002a19-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x2a, 0x24, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 1, 0x01, "Model Number" },  // 00002a24-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x2a, 0x25, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 1, 0x01, "Serial Number" },  // 00002a25-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x2a, 0x26, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 1, 0x07, "Firmware Version" },  // 00002a26-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x2a, 0x5d, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 0, 0x01, "Sensor Location" },  // 00002a5d-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x2a, 0x6e, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 0, 0x01, "Temperature" },  // 00002a6e-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x2a, 0xae, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 2, 0x01, "Latitude" },  // 00002aae-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x2a, 0xaf, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 2, 0x01, "Longitude" },  // 00002aaf-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x2a, 0xb3, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 2, 0x01, "Altitude" },  // 00002ab3-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x2a, 0xb8, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 1, 0x01, "HTTP Status Code" },  // 00002ab8-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x30, 0x01, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 1, 0x06, "Part Number" },  // 00003001-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x30, 0x02, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 1, 0x06, "Serial Number" },  // 00003002-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x30, 0x04, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 1, 0x06, "MAC Address" },  // 00003004-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x31, 0x01, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 3, 0x06, "GPS Latitude" },  // 00003101-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x31, 0x02, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 3, 0x06, "GPS Longitude" },  // 00003102-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x31, 0x03, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 3, 0x06, "GPS Altitude" },  // 00003103-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x32, 0x01, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 4, 0x06, "Board Temperature" },  // 00003201-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x32, 0x02, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 4, 0x06, "Battery Voltage" },  // 00003202-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x32, 0x03, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 4, 0x06, "Charge/Discharge Current" },  // 00003203-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x32, 0x04, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 4, 0x06, "10 W Solar Voltage" },  // 00003204-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x32, 0x05, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 4, 0x04, "Battery State" },  // 00003205-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x33, 0x01, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 5, 0x06, "Last Connected" },  // 00003301-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x33, 0x02, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 5, 0x06, "LTE Network Type" },  // 00003302-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x33, 0x03, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 5, 0x06, "LTE Operator" },  // 00003303-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x33, 0x04, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 5, 0x06, "LTE RSSI" },  // 00003304-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x33, 0x05, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 5, 0x06, "LTE RSRQ" },  // 00003305-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x33, 0x06, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 5, 0x06, "LTE RSRP" },  // 00003306-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x33, 0x07, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 5, 0x06, "LTE SINR" },  // 00003307-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x33, 0x08, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 5, 0x06, "Last Connected WiFi SSID" },  // 00003308-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x33, 0x09, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 5, 0x06, "WiFi RSSI" },  // 00003309-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x33, 0x0a, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 5, 0x06, "Network Connection Status" },  // 0000330a-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x34, 0x01, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 6, 0x06, "Average Upload Time" },  // 00003401-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x34, 0x02, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 6, 0x06, "Most Recent Upload Time" },  // 00003402-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x34, 0x03, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 6, 0x06, "Number of Audio Uploads Since Boot" },  // 00003403-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x35, 0x01, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 7, 0x06, "Identity Check Failures" },  // 00003501-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x35, 0x02, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 7, 0x06, "Status Update Failures" },  // 00003502-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x35, 0x03, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 7, 0x06, "Heartbeat Failures" },  // 00003503-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x35, 0x04, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 7, 0x06, "OTA Update Failures" },  // 00003504-0000-1000-8000-00805f9b34fb
+    { { 0x00, 0x00, 0x35, 0x05, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb }, 7, 0x06, "Audio Upload Failures" },  // 00003505-0000-1000-8000-00805f9b34fb
+};
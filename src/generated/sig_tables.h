@@ -0,0 +1,238 @@
+// Generated by tools/gen_signatures.py from tools/signatures.json and
+// datasets/ - do not edit, re-run the generator instead.
+
+#pragma once
+#include <stdint.h>
+
+#define GEN_VENDOR_ALERT 0x01       // OUI alone is enough to alert
+#define GEN_PATTERN_ALERT 0x01      // Match alone is enough to alert
+
+struct GenVendor {
+    uint8_t category;               // DetectionType
+    uint8_t flags;
+    const char* name;
+};
+
+struct GenPattern {
+    const char* text;               // Case-insensitive substring
+    uint8_t category;               // DetectionType
+    uint8_t priority;               // Lower wins when several patterns match
+    uint8_t flags;
+};
+
+static constexpr GenVendor GEN_VENDORS[] = {
+    {  2, GEN_VENDOR_ALERT, "Axon Enterprise" },  // AXON
+    {  5, GEN_VENDOR_ALERT, "Cradlepoint" },  // CRADLEPOINT
+    { 12, GEN_VENDOR_ALERT, "Aruba Networks" },  // ARUBA
+    {  1, GEN_VENDOR_ALERT, "Flock Safety" },  // FLOCK_SAFETY
+    {  4, GEN_VENDOR_ALERT, "Ring/Amazon" },  // RING
+    {  6, GEN_VENDOR_ALERT, "DJI" },  // DRONE
+    {  6, GEN_VENDOR_ALERT, "Parrot" },  // DRONE
+    {  6, GEN_VENDOR_ALERT, "Skydio" },  // DRONE
+    {  7, 0, "Nest/Google" },  // NEST_GOOGLE
+    {  8, 0, "Arlo" },  // ARLO
+    {  9, 0, "Eufy" },  // EUFY
+    { 10, 0, "Wyze" },  // WYZE
+    { 11, 0, "Blink/Amazon" },  // BLINK
+};
+
+// (oui << 8) | vendor index, sorted by OUI
+static constexpr uint32_t GEN_OUIS[] = {
+    0x000b8602,  // 00:0b:86 Aruba Networks
+    0x00121c06,  // 00:12:1c Parrot
+    0x001a1e02,  // 00:1a:1e Aruba Networks
+    0x001a3a09,  // 00:1a:3a Arlo
+    0x0025df00,  // 00:25:df Axon Enterprise
+    0x00267e06,  // 00:26:7e Parrot
+    0x00304401,  // 00:30:44 Cradlepoint
+    0x00e01c01,  // 00:e0:1c Cradlepoint
+    0x040d8403,  // 04:0d:84 Flock Safety
+    0x04a85a05,  // 04:a8:5a DJI
+    0x083a8803,  // 08:3a:88 Flock Safety
+    0x0c9ae605,  // 0c:9a:e6 DJI
+    0x10d7b00a,  // 10:d7:b0 Eufy
+    0x145afc03,  // 14:5a:fc Flock Safety
+    0x183a2d0a,  // 18:3a:2d Eufy
+    0x187f8804,  // 18:7f:88 Ring/Amazon
+    0x18b43008,  // 18:b4:30 Nest/Google
+    0x18e74a0c,  // 18:e7:4a Blink/Amazon
+    0x1c1b680a,  // 1c:1b:68 Eufy
+    0x1c34f103,  // 1c:34:f1 Flock Safety
+    0x1cf29a08,  // 1c:f2:9a Nest/Google
+    0x20dfb909,  // 20:df:b9 Arlo
+    0x242bd604,  // 24:2b:d6 Ring/Amazon
+    0x2462ab0c,  // 24:62:ab Blink/Amazon
+    0x24dec602,  // 24:de:c6 Aruba Networks
+    0x28b46609,  // 28:b4:66 Arlo
+    0x2caa8e0b,  // 2c:aa:8e Wyze
+    0x343ea404,  // 34:3e:a4 Ring/Amazon
+    0x344b500c,  // 34:4b:50 Blink/Amazon
+    0x34d26205,  // 34:d2:62 DJI
+    0x381d1407,  // 38:1d:14 Skydio
+    0x385b4403,  // 38:5b:44 Flock Safety
+    0x3c378609,  // 3c:37:86 Arlo
+    0x3c918003,  // 3c:91:80 Flock Safety
+    0x44070b08,  // 44:07:0b Nest/Google
+    0x446c2409,  // 44:6c:24 Arlo
+    0x4491600c,  // 44:91:60 Blink/Amazon
+    0x481cb905,  // 48:1c:b9 DJI
+    0x48a9d20a,  // 48:a9:d2 Eufy
+    0x54600908,  // 54:60:09 Nest/Google
+    0x54e01904,  // 54:e0:19 Ring/Amazon
+    0x588e8103,  // 58:8e:81 Flock Safety
+    0x58b85805,  // 58:b8:58 DJI
+    0x5c475e04,  // 5c:47:5e Ring/Amazon
+    0x60601f05,  // 60:60:1f DJI
+    0x60fda80a,  // 60:fd:a8 Eufy
+    0x64166608,  // 64:16:66 Nest/Google
+    0x649a6304,  // 64:9a:63 Ring/Amazon
+    0x689c700c,  // 68:9c:70 Blink/Amazon
+    0x6cb0ce09,  // 6c:b0:ce Arlo
+    0x70c94e03,  // 70:c9:4e Flock Safety
+    0x744ca103,  // 74:4c:a1 Flock Safety
+    0x746ff70c,  // 74:6f:f7 Blink/Amazon
+    0x74fece0a,  // 74:fe:ce Eufy
+    0x7802b10a,  // 78:02:b1 Eufy
+    0x7c78b20b,  // 7c:78:b2 Wyze
+    0x80304903,  // 80:30:49 Flock Safety
+    0x84d6d009,  // 84:d6:d0 Arlo
+    0x8c4b140b,  // 8c:4b:14 Wyze
+    0x8c582305,  // 8c:58:23 DJI
+    0x9003b706,  // 90:03:b7 Parrot
+    0x9035ea03,  // 90:35:ea Flock Safety
+    0x903ae606,  // 90:3a:e6 Parrot
+    0x90486c04,  // 90:48:6c Ring/Amazon
+    0x94085303,  // 94:08:53 Flock Safety
+    0x94346903,  // 94:34:69 Flock Safety
+    0x94942608,  // 94:94:26 Nest/Google
+    0x94b40f02,  // 94:b4:0f Aruba Networks
+    0x98d29308,  // 98:d2:93 Nest/Google
+    0x9c2f9d03,  // 9c:2f:9d Flock Safety
+    0x9c532209,  // 9c:53:22 Arlo
+    0x9c761304,  // 9c:76:13 Ring/Amazon
+    0xa0143d06,  // a0:14:3d Parrot
+    0xa0c58909,  // a0:c5:89 Arlo
+    0xa43bfa0a,  // a4:3b:fa Eufy
+    0xac0d1a08,  // ac:0d:1a Nest/Google
+    0xac9fc304,  // ac:9f:c3 Ring/Amazon
+    0xaca31e02,  // ac:a3:1e Aruba Networks
+    0xacc1ee0a,  // ac:c1:ee Eufy
+    0xb41e5203,  // b4:1e:52 Flock Safety
+    0xb47c9c0c,  // b4:7c:9c Blink/Amazon
+    0xb4e3f903,  // b4:e3:f9 Flock Safety
+    0xc4041509,  // c4:04:15 Arlo
+    0xc4411e09,  // c4:41:1e Arlo
+    0xc4dbad04,  // c4:db:ad Ring/Amazon
+    0xcc3bfb04,  // cc:3b:fb Ring/Amazon
+    0xcccccc03,  // cc:cc:cc Flock Safety
+    0xd03f270b,  // d0:3f:27 Wyze
+    0xd4a6510a,  // d4:a6:51 Eufy
+    0xd4a92808,  // d4:a9:28 Nest/Google
+    0xd8c7c802,  // d8:c7:c8 Aruba Networks
+    0xd8f3bc03,  // d8:f3:bc Flock Safety
+    0xe47a2c05,  // e4:7a:2c DJI
+    0xe4aaea03,  // e4:aa:ea Flock Safety
+    0xe8eb1108,  // e8:eb:11 Nest/Google
+    0xec1bbd03,  // ec:1b:bd Flock Safety
+    0xf082c003,  // f0:82:c0 Flock Safety
+    0xf42e7f02,  // f4:2e:7f Aruba Networks
+    0xf4f5d808,  // f4:f5:d8 Nest/Google
+    0xf4f5e808,  // f4:f5:e8 Nest/Google
+};
+
+// Sorted by priority: the first match in table order is the best one
+static constexpr GenPattern GEN_SSID_PATTERNS[] = {
+    { "raven", 3, 0, 0 },  // RAVEN
+    { "Axon", 2, 1, GEN_PATTERN_ALERT },  // AXON
+    { "Axon Body", 2, 1, GEN_PATTERN_ALERT },  // AXON
+    { "Axon Fleet", 2, 1, GEN_PATTERN_ALERT },  // AXON
+    { "body 2", 2, 1, 0 },  // AXON
+    { "body 3", 2, 1, 0 },  // AXON
+    { "Ring", 4, 2, GEN_PATTERN_ALERT },  // RING
+    { "Ring-", 4, 2, GEN_PATTERN_ALERT },  // RING
+    { "CP ", 5, 3, GEN_PATTERN_ALERT },  // CRADLEPOINT
+    { "Cradlepoint", 5, 3, GEN_PATTERN_ALERT },  // CRADLEPOINT
+    { "Aruba", 12, 4, GEN_PATTERN_ALERT },  // ARUBA
+    { "Aruba-Instant", 12, 4, GEN_PATTERN_ALERT },  // ARUBA
+    { "instant", 12, 4, GEN_PATTERN_ALERT },  // ARUBA
+    { "SetMeUp", 12, 4, GEN_PATTERN_ALERT },  // ARUBA
+    { "Air", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "Anafi", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "Bebop", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "Disco", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "DJI", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "FPV", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "Mavic", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "Mini", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "Parrot", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "Phantom", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "Skydio", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "inspire", 6, 5, 0 },  // DRONE
+    { "matrice", 6, 5, 0 },  // DRONE
+    { "Google Nest", 7, 6, GEN_PATTERN_ALERT },  // NEST_GOOGLE
+    { "Nest", 7, 6, GEN_PATTERN_ALERT },  // NEST_GOOGLE
+    { "google", 7, 6, 0 },  // NEST_GOOGLE
+    { "Arlo", 8, 7, GEN_PATTERN_ALERT },  // ARLO
+    { "VMC", 8, 7, GEN_PATTERN_ALERT },  // ARLO
+    { "Eufy", 9, 8, GEN_PATTERN_ALERT },  // EUFY
+    { "eufyCam", 9, 8, GEN_PATTERN_ALERT },  // EUFY
+    { "SoloCam", 9, 8, GEN_PATTERN_ALERT },  // EUFY
+    { "Wyze", 10, 9, GEN_PATTERN_ALERT },  // WYZE
+    { "Blink", 11, 10, GEN_PATTERN_ALERT },  // BLINK
+    { "Falcon", 1, 11, GEN_PATTERN_ALERT },  // FLOCK_SAFETY
+    { "flock", 1, 11, GEN_PATTERN_ALERT },  // FLOCK_SAFETY
+    { "FS Ext Battery", 1, 11, GEN_PATTERN_ALERT },  // FLOCK_SAFETY
+    { "Penguin", 1, 11, GEN_PATTERN_ALERT },  // FLOCK_SAFETY
+    { "Pigvision", 1, 11, GEN_PATTERN_ALERT },  // FLOCK_SAFETY
+};
+
+// Sorted by priority: the first match in table order is the best one
+static constexpr GenPattern GEN_NAME_PATTERNS[] = {
+    { "Raven", 3, 0, GEN_PATTERN_ALERT },  // RAVEN
+    { "Axon", 2, 1, GEN_PATTERN_ALERT },  // AXON
+    { "Axon Body", 2, 1, GEN_PATTERN_ALERT },  // AXON
+    { "Axon Fleet", 2, 1, GEN_PATTERN_ALERT },  // AXON
+    { "Body 2", 2, 1, GEN_PATTERN_ALERT },  // AXON
+    { "Body 3", 2, 1, GEN_PATTERN_ALERT },  // AXON
+    { "Body 4", 2, 1, GEN_PATTERN_ALERT },  // AXON
+    { "Ring", 4, 2, GEN_PATTERN_ALERT },  // RING
+    { "Ring-", 4, 2, GEN_PATTERN_ALERT },  // RING
+    { "AER", 5, 3, GEN_PATTERN_ALERT },  // CRADLEPOINT
+    { "Cradlepoint", 5, 3, GEN_PATTERN_ALERT },  // CRADLEPOINT
+    { "IBR", 5, 3, GEN_PATTERN_ALERT },  // CRADLEPOINT
+    { "Aruba", 12, 4, GEN_PATTERN_ALERT },  // ARUBA
+    { "Instant", 12, 4, GEN_PATTERN_ALERT },  // ARUBA
+    { "Air", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "Anafi", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "Bebop", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "Disco", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "DJI", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "FPV", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "Inspire", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "Matrice", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "Mavic", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "Mini", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "Parrot", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "Phantom", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "S2", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "Skydio", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "X2", 6, 5, GEN_PATTERN_ALERT },  // DRONE
+    { "google", 7, 6, 0 },  // NEST_GOOGLE
+    { "nest", 7, 6, 0 },  // NEST_GOOGLE
+    { "arlo", 8, 7, 0 },  // ARLO
+    { "vmc", 8, 7, 0 },  // ARLO
+    { "eufy", 9, 8, 0 },  // EUFY
+    { "solocam", 9, 8, 0 },  // EUFY
+    { "wyze", 10, 9, 0 },  // WYZE
+    { "blink", 11, 10, 0 },  // BLINK
+    { "Falcon", 1, 11, GEN_PATTERN_ALERT },  // FLOCK_SAFETY
+    { "Flock", 1, 11, GEN_PATTERN_ALERT },  // FLOCK_SAFETY
+    { "FS Ext Battery", 1, 11, GEN_PATTERN_ALERT },  // FLOCK_SAFETY
+    { "Penguin", 1, 11, GEN_PATTERN_ALERT },  // FLOCK_SAFETY
+    { "Pigvision", 1, 11, GEN_PATTERN_ALERT },  // FLOCK_SAFETY
+};
+
+// Known Flock access points per 2.4 GHz channel in the datasets (index = channel)
+static constexpr uint16_t GEN_DATASET_CHANNEL_COUNTS[15] = {
+    0, 239, 1, 1, 0, 1, 195, 26, 3, 0, 1, 182, 0, 0, 0
+};
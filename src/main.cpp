@@ -6,13 +6,24 @@
 #include <NimBLEServer.h>
 #include <NimBLEUtils.h>
 #include <ArduinoJson.h>
-#include <Adafruit_NeoPixel.h>
 #include <string.h>
 #include <ctype.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <math.h>
 #include "esp_wifi.h"
 #include "esp_wifi_types.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "driver/rmt.h"
+#include <Preferences.h>
+#include "generated/sig_tables.h"
+#include "generated/raven_tables.h"
+#include "generated/known_macs.h"
+#include "threat_arbiter.h"
+#include "rate_limit.h"
 
 // Mutex to protect BLE notifications
 SemaphoreHandle_t bleMutex = NULL;
@@ -21,17 +32,18 @@ SemaphoreHandle_t bleMutex = NULL;
 // CONFIGURATION
 // ============================================================================
 
-// LED Configuration - Using Adafruit NeoPixel on Pin 21 (Common for Waveshare S3 Zero)
+// LED Configuration - WS2812B on Pin 21 (Common for Waveshare S3 Zero), driven by RMT
 // The datasheet confirms it's a WS2812B compatible RGB LED
 #define NEOPIXEL_PIN 21
 #define NUMPIXELS 1
-
-Adafruit_NeoPixel pixel(NUMPIXELS, NEOPIXEL_PIN, NEO_GRB + NEO_KHZ800);
+#define LED_BRIGHTNESS 20         // Low-ish brightness (max 255)
 
 // BLE Notification Configuration
 #define SERVICE_UUID           "6E400001-B5A3-F393-E0A9-E50E24DCCA9E" // UART Service
 #define CHARACTERISTIC_UUID_RX "6E400002-B5A3-F393-E0A9-E50E24DCCA9E"
 #define CHARACTERISTIC_UUID_TX "6E400003-B5A3-F393-E0A9-E50E24DCCA9E"
+#define CHARACTERISTIC_UUID_LOG "6E400004-B5A3-F393-E0A9-E50E24DCCA9E" // Detection log offload
+#define BLE_PREFERRED_MTU 247
 
 // WiFi Promiscuous Mode Configuration
 #define MAX_CHANNEL 13
@@ -40,12 +52,151 @@ Adafruit_NeoPixel pixel(NUMPIXELS, NEOPIXEL_PIN, NEO_GRB + NEO_KHZ800);
 // BLE SCANNING CONFIGURATION
 #define BLE_SCAN_DURATION 1    // Seconds
 #define BLE_SCAN_INTERVAL 5000 // Milliseconds between scans
+#define BLE_CODED_EVERY 0      // Every Nth scan on LE Coded PHY, 0 = 1M only (extended advertising builds)
 static unsigned long last_ble_scan = 0;
 
+// Task Layout Configuration
+// Radio control runs next to the WiFi/BT controller on core 0, classification,
+// output and UI run on core 1. Single-core parts (ESP32-C3) put every task on
+// core 0 and rely on priorities alone.
+#if CONFIG_FREERTOS_UNICORE
+#define RADIO_TASK_CORE  0
+#define DETECT_TASK_CORE 0
+#else
+#define RADIO_TASK_CORE  0
+#define DETECT_TASK_CORE 1
+#endif
+#define UI_TASK_CORE DETECT_TASK_CORE
+
+#define RADIO_TASK_PRIORITY  4
+#define DETECT_TASK_PRIORITY 3
+#define UI_TASK_PRIORITY     1
+
+#define RADIO_TASK_STACK  3072  // Bytes
+#define DETECT_TASK_STACK 8192
+#define UI_TASK_STACK     6144
+
+#define DETECTION_QUEUE_LENGTH 16     // Matched frames waiting for classification/output
+#define UI_FRAME_MS 25                // Longest ui task sleep (Serial polling)
+#define HEARTBEAT_INTERVAL_MS 10000   // "Still Detected" notification period
+#define OUT_OF_RANGE_TIMEOUT_MS 30000 // No detection for this long = out of range
+
+// Detection Log Configuration (append-only ring in the "detlog" flash partition)
+#define LOG_PARTITION_LABEL "detlog"
+#define LOG_PARTITION_SUBTYPE 0x40      // Custom data subtype, see partitions_*.csv
+#define LOG_MAX_SECTORS 768             // Sector index capacity (3 MB partition)
+#define LOG_BATCH_RECORDS 16            // Records buffered in RAM per flash write
+#define LOG_FLUSH_INTERVAL_MS 15000     // Flush partial batches at least this often
+#define LOG_DUMP_RECORDS_PER_FRAME 64   // Serial offload chunk per ui frame
+#define LOG_DUMP_NOTIFIES_PER_FRAME 8   // BLE offload chunk per ui frame
+
+// Warm Start Configuration (state snapshot in NVS)
+#define STATE_NVS_NAMESPACE "flockyou"
+#define STATE_SNAPSHOT_INTERVAL_MS 60000  // Write a snapshot at most this often, if changed
+
+// Signature Database Configuration (A/B slots, built by tools/sigdb.py)
+#define SIGDB_PARTITION_SUBTYPE 0x41    // Custom data subtype, see partitions_*.csv
+#define SIGDB_SLOT_A_LABEL "sigdb_a"
+#define SIGDB_SLOT_B_LABEL "sigdb_b"
+#define SIGDB_LOAD_TIMEOUT_MS 5000      // Abort a Serial upload after this much silence
+
 // Detection Debouncing Configuration
 #define DEBOUNCE_WINDOW_MS 30000  // Don't re-alert same device within 30 seconds
 #define MAX_SEEN_DEVICES 50       // Cache size for debouncing
 
+// Arrival Interval Estimation (see noteDeviceArrival)
+#define ARRIVAL_SAMPLES 8           // Intervals kept per device
+#define ARRIVAL_MIN_SAMPLES 4       // Before an interval is reported
+#define ARRIVAL_MIN_US 15000        // Closer frames are one event (BLE scan response)
+#define ARRIVAL_MAX_US 12000000     // Longest plausible period (BLE allows 10.24 s)
+#define ARRIVAL_MAX_FOLD 16         // Longest run of missed frames bridged
+
+// Alert Thresholds (see THREAT ARBITRATION)
+#define THREAT_ENTER_SCORE 60   // Raises a new threat (MEDIUM confidence)
+#define THREAT_HOLD_SCORE 40    // Keeps an active threat alive
+
+// Runtime Configuration (see CONFIGURATION REGISTRY)
+#define CONFIG_NVS_NAMESPACE "flockcfg"
+
+enum Verbosity {
+    VERBOSITY_QUIET = 0,        // Detections and command output only
+    VERBOSITY_NORMAL = 1,       // Plus the periodic "System active" line
+    VERBOSITY_VERBOSE = 2       // Plus every channel hop, BLE scan and notification
+};
+
+// Detection JSON field sets per sink (see OUTPUT PROFILES)
+enum OutputProfile {
+    PROFILE_MINIMAL = 0,        // Category, identity, score
+    PROFILE_STANDARD = 1,       // Plus time, range, vendor and match details
+    PROFILE_FORENSIC = 2        // Everything, including score_features
+};
+
+// Channel survey (see CHANNEL SURVEY)
+#define SURVEY_REPORT_MS 10000
+
+enum SurveyMode {
+    SURVEY_OFF = 0,
+    SURVEY_REPORT = 1,          // Count every frame, report per channel
+    SURVEY_HOP = 2              // Plus weight hop dwell by channel occupancy
+};
+
+// Raven GATT interrogation (see RAVEN GATT INTERROGATION)
+#define GATT_GROUP_IDENTITY 0x01    // Device Information: serial, model, firmware
+#define GATT_GROUP_GPS      0x02
+#define GATT_GROUP_POWER    0x04    // Battery, solar, temperature
+#define GATT_GROUP_NETWORK  0x08    // LTE / WiFi status
+#define GATT_GROUP_UPLOADS  0x10
+#define GATT_GROUP_ERRORS   0x20
+#define GATT_GROUPS_DEFAULT (GATT_GROUP_IDENTITY | GATT_GROUP_POWER | GATT_GROUP_NETWORK)
+
+enum GattMode {
+    GATT_OFF = 0,
+    GATT_ON = 1                 // Connect to detected Raven units and read them
+};
+
+enum BleScanPolicy {
+    BLE_SCAN_PASSIVE = 0,       // Never send scan requests
+    BLE_SCAN_ADAPTIVE = 1,      // Active only for candidates (see BLE SCAN POLICY)
+    BLE_SCAN_ACTIVE = 2         // Every scan active
+};
+
+enum LoadShedMode {
+    LOAD_SHED_OFF = 0,
+    LOAD_SHED_ON = 1            // Degrade under overload (see LOAD SHEDDING)
+};
+
+// Output rate limits per category and sink (see OUTPUT RATE LIMITING)
+#define OUTPUT_SERIAL_RATE 60       // Messages per minute, 0 = unlimited
+#define OUTPUT_SERIAL_BURST 10
+#define OUTPUT_BLE_RATE 20
+#define OUTPUT_BLE_BURST 5
+
+// Live-tunable settings, registered in CONFIGURATION REGISTRY and saved in
+// NVS. The defines above are their defaults.
+static int32_t hop_interval_ms = CHANNEL_HOP_INTERVAL;
+static int32_t ble_scan_duration_s = BLE_SCAN_DURATION;
+static int32_t ble_scan_interval_ms = BLE_SCAN_INTERVAL;
+static int32_t debounce_window_ms = DEBOUNCE_WINDOW_MS;
+static int32_t out_of_range_ms = OUT_OF_RANGE_TIMEOUT_MS;
+static int32_t heartbeat_interval_ms = HEARTBEAT_INTERVAL_MS;
+static int32_t led_brightness = LED_BRIGHTNESS;
+static int32_t threat_enter_score = THREAT_ENTER_SCORE;
+static int32_t threat_hold_score = THREAT_HOLD_SCORE;
+static int32_t verbosity = VERBOSITY_VERBOSE;
+static int32_t serial_profile = PROFILE_FORENSIC;
+static int32_t ble_profile = PROFILE_STANDARD;
+static int32_t survey_mode = SURVEY_OFF;
+static int32_t survey_report_ms = SURVEY_REPORT_MS;
+static int32_t gatt_mode = GATT_OFF;
+static int32_t gatt_groups = GATT_GROUPS_DEFAULT;
+static int32_t ble_scan_policy = BLE_SCAN_ADAPTIVE;
+static int32_t ble_coded_every = BLE_CODED_EVERY;
+static int32_t load_shed_mode = LOAD_SHED_ON;
+static int32_t output_serial_rate = OUTPUT_SERIAL_RATE;
+static int32_t output_serial_burst = OUTPUT_SERIAL_BURST;
+static int32_t output_ble_rate = OUTPUT_BLE_RATE;
+static int32_t output_ble_burst = OUTPUT_BLE_BURST;
+
 // Detection Pattern Limits
 #define MAX_SSID_PATTERNS 10
 #define MAX_MAC_PATTERNS 50
@@ -54,10 +205,30 @@ static unsigned long last_ble_scan = 0;
 // ============================================================================
 // DETECTION DEBOUNCE CACHE
 // ============================================================================
+// Advertising / beacon interval of one device, from the gaps between its
+// frames: median and median absolute deviation over the last few gaps
+struct ArrivalStats {
+    uint32_t last_us;       // Receive time of the previous frame
+    uint16_t last_epoch;    // WiFi dwell / BLE scan it arrived in
+    bool have_last;
+    uint8_t count;          // Gaps in interval_us, up to ARRIVAL_SAMPLES
+    uint8_t next;
+    uint32_t interval_us[ARRIVAL_SAMPLES];
+    uint32_t median_us;     // 0 until ARRIVAL_MIN_SAMPLES gaps
+    uint32_t mad_us;
+};
+
+struct ArrivalEstimate {
+    uint32_t interval_us;   // 0 = not known yet
+    uint32_t jitter_us;     // Median absolute deviation
+};
+
 struct SeenDevice {
     char mac[18];           // MAC address string
     unsigned long lastSeen; // millis() timestamp
     int detectionCount;     // How many times seen
+    uint8_t category;       // DetectionType of the last full detection
+    ArrivalStats arrivals;
 };
 
 static SeenDevice seenDevices[MAX_SEEN_DEVICES];
@@ -95,301 +266,9 @@ static int seenDeviceCount = 0;
 //
 // ============================================================================
 
-// WiFi SSID patterns to detect (case-insensitive)
-// These patterns maximize detection across all vendors
-static const char* wifi_ssid_patterns[] = {
-    // Flock Safety & Surveillance
-    "flock", "Flock", "FLOCK",
-    "FS Ext Battery",
-    "Falcon",           // Flock Falcon cameras
-    "Penguin",          // Penguin surveillance devices
-    "Pigvision",        // Pigvision surveillance systems
-
-    // Axon (Law Enforcement)
-    "Axon", "axon",
-    "Axon Body",
-    "Axon Fleet",
-
-    // Ring (Security Cameras)
-    "Ring", "ring",
-    "Ring-",            // Ring devices often use "Ring-XXXXX"
-
-    // Cradlepoint (Network Equipment)
-    "Cradlepoint", "cradlepoint",
-    "CP ",              // Cradlepoint prefix
-
-    // Aruba Networks
-    "Aruba", "aruba",
-    "instant",          // Aruba Instant
-    "SetMeUp",          // Aruba SetMeUp
-    "Aruba-Instant",    // Aruba Instant SSID
-
-    // DJI Drones
-    "DJI", "dji",
-    "Mavic",
-    "Phantom",
-    "Mini",
-    "Air",              // DJI Air series
-    "FPV",              // DJI FPV
-
-    // Parrot Drones
-    "Parrot", "parrot",
-    "Anafi",
-    "Bebop",
-    "Disco",
-
-    // Skydio Drones
-    "Skydio", "skydio",
-    "SKYDIO",
-
-    // Nest/Google Cameras
-    "Nest", "nest",
-    "Google Nest",
-
-    // Arlo Cameras
-    "Arlo", "arlo",
-    "VMC",              // Arlo model prefix
-
-    // Eufy Cameras
-    "Eufy", "eufy",
-    "eufyCam",
-    "SoloCam",
-
-    // Wyze Cameras
-    "Wyze", "wyze",
-    "WYZE",
-
-    // Blink Cameras
-    "Blink", "blink"
-};
-
-// ============================================================================
-// COMPREHENSIVE OUI DATABASE (Organizationally Unique Identifiers)
-// ============================================================================
-
-// FLOCK SAFETY & SURVEILLANCE SYSTEMS
-static const char* flock_safety_ouis[] = {
-    // FS Ext Battery devices
-    "58:8e:81", "cc:cc:cc", "ec:1b:bd", "90:35:ea", "04:0d:84",
-    "f0:82:c0", "1c:34:f1", "38:5b:44", "94:34:69", "b4:e3:f9",
-
-    // Flock WiFi devices
-    "70:c9:4e", "3c:91:80", "d8:f3:bc", "80:30:49", "14:5a:fc",
-    "74:4c:a1", "08:3a:88", "9c:2f:9d", "94:08:53", "e4:aa:ea",
-
-    // Flock Safety official OUI (ALPR/Falcon/Raven)
-    "b4:1e:52"
-};
-
-// CRADLEPOINT (Network Equipment - used by surveillance systems)
-// Cradlepoint routers are commonly used in Flock Safety and other surveillance deployments
-// They should be detected and correctly identified as "Cradlepoint" manufacturer
-static const char* cradlepoint_ouis[] = {
-    "00:30:44", "00:e0:1c"
-};
-
-// ARUBA NETWORKS (HPE)
-static const char* aruba_ouis[] = {
-    "00:0b:86", // Aruba Networks
-    "00:1a:1e", // Aruba Networks
-    "d8:c7:c8", // Aruba Networks
-    "ac:a3:1e", // Aruba Networks
-    "24:de:c6", // Aruba Networks (HPE)
-    "94:b4:0f", // Aruba Networks
-    "f4:2e:7f"  // Aruba Networks (HPE)
-};
-
-// AXON ENTERPRISE (Law Enforcement Body Cameras)
-static const char* axon_ouis[] = {
-    "00:25:df"  // Axon Body 2/3, Axon Fleet
-};
-
-// RING (Doorbell & Security Cameras)
-static const char* ring_ouis[] = {
-    "18:7f:88", "24:2b:d6", "34:3e:a4", "54:e0:19",
-    "5c:47:5e", "64:9a:63", "90:48:6c", "9c:76:13",
-    "ac:9f:c3", "c4:db:ad", "cc:3b:fb"
-};
-
-// DJI (Consumer & Commercial Drones)
-static const char* dji_ouis[] = {
-    "0c:9a:e6", "8c:58:23", "04:a8:5a", "58:b8:58",
-    "e4:7a:2c", "60:60:1f", "48:1c:b9", "34:d2:62"
-};
-
-// PARROT (Consumer & Commercial Drones)
-static const char* parrot_ouis[] = {
-    "00:12:1c", "00:26:7e", "90:03:b7",
-    "90:3a:e6", "a0:14:3d"
-};
-
-// SKYDIO (Commercial & Enterprise Drones)
-static const char* skydio_ouis[] = {
-    "38:1d:14"
-};
-
-// NEST/GOOGLE (Security Cameras & Doorbells)
-static const char* nest_ouis[] = {
-    "18:b4:30", "1c:f2:9a", "44:07:0b", "54:60:09",
-    "64:16:66", "94:94:26", "98:d2:93", "ac:0d:1a",
-    "d4:a9:28", "e8:eb:11", "f4:f5:d8", "f4:f5:e8"
-};
-
-// ARLO (Security Cameras)
-static const char* arlo_ouis[] = {
-    "00:1a:3a", "20:df:b9", "28:b4:66", "3c:37:86",
-    "44:6c:24", "6c:b0:ce", "84:d6:d0", "9c:53:22",
-    "a0:c5:89", "c4:04:15", "c4:41:1e"
-};
-
-// EUFY (Security Cameras & Doorbells)
-static const char* eufy_ouis[] = {
-    "10:d7:b0", "18:3a:2d", "1c:1b:68", "48:a9:d2",
-    "60:fd:a8", "74:fe:ce", "78:02:b1", "a4:3b:fa",
-    "ac:c1:ee", "d4:a6:51"
-};
-
-// WYZE (Budget Security Cameras)
-static const char* wyze_ouis[] = {
-    "2c:aa:8e", "d0:3f:27", "7c:78:b2", "8c:4b:14"
-};
-
-// BLINK (Amazon Security Cameras)
-static const char* blink_ouis[] = {
-    "18:e7:4a", "24:62:ab", "34:4b:50", "44:91:60",
-    "68:9c:70", "74:6f:f7", "b4:7c:9c"
-};
-
-// Combined list for quick iteration (legacy compatibility)
-// Includes Cradlepoint as they're network equipment used in surveillance infrastructure
-static const char* mac_prefixes[] = {
-    // Flock Safety & Surveillance
-    "58:8e:81", "cc:cc:cc", "ec:1b:bd", "90:35:ea", "04:0d:84",
-    "f0:82:c0", "1c:34:f1", "38:5b:44", "94:34:69", "b4:e3:f9",
-    "70:c9:4e", "3c:91:80", "d8:f3:bc", "80:30:49", "14:5a:fc",
-    "74:4c:a1", "08:3a:88", "9c:2f:9d", "94:08:53", "e4:aa:ea",
-    "b4:1e:52",
-
-    // Cradlepoint (Network Equipment used by surveillance systems)
-    "00:30:44", "00:e0:1c",
-
-    // Aruba Networks (HPE)
-    "00:0b:86", "00:1a:1e", "d8:c7:c8", "ac:a3:1e", "24:de:c6", "94:b4:0f", "f4:2e:7f",
-
-    // Axon
-    "00:25:df",
-
-    // Ring
-    "18:7f:88", "24:2b:d6", "34:3e:a4", "54:e0:19",
-    "5c:47:5e", "64:9a:63", "90:48:6c", "9c:76:13",
-    "ac:9f:c3", "c4:db:ad", "cc:3b:fb",
-
-    // DJI
-    "0c:9a:e6", "8c:58:23", "04:a8:5a", "58:b8:58",
-    "e4:7a:2c", "60:60:1f", "48:1c:b9", "34:d2:62",
-
-    // Parrot
-    "00:12:1c", "00:26:7e", "90:03:b7", "90:3a:e6", "a0:14:3d",
-
-    // Skydio
-    "38:1d:14"
-};
-
-// Device name patterns for BLE advertisement detection
-// BLE has shorter range (10-100m) so these are HIGH CONFIDENCE close-range detections
-static const char* device_name_patterns[] = {
-    // Flock Safety & Surveillance
-    "FS Ext Battery",  // Flock Safety Extended Battery
-    "Flock",           // Standard Flock Safety devices
-    "Falcon",          // Flock Falcon cameras
-    "Raven",           // Flock Raven gunshot detection
-    "Penguin",         // Penguin surveillance devices
-    "Pigvision",       // Pigvision surveillance systems
-
-    // Axon (Law Enforcement)
-    "Axon",            // Axon Body Cam / Fleet
-    "Axon Body",       // Axon Body Cam specific
-    "Axon Fleet",      // Axon Fleet system
-    "Body 2",          // Axon Body 2
-    "Body 3",          // Axon Body 3
-    "Body 4",          // Axon Body 4
-
-    // Ring (Security Cameras)
-    "Ring",            // Ring Doorbell / Camera
-    "Ring-",           // Ring devices with suffix
-
-    // Cradlepoint (Network Equipment)
-    "Cradlepoint",     // Cradlepoint routers
-    "IBR",             // Cradlepoint IBR series
-    "AER",             // Cradlepoint AER series
-
-    // Aruba Networks
-    "Aruba",           // Aruba devices
-    "Instant",         // Aruba Instant
-
-    // DJI Drones
-    "DJI",             // DJI drones
-    "Mavic",           // DJI Mavic series
-    "Phantom",         // DJI Phantom series
-    "Mini",            // DJI Mini series
-    "Air",             // DJI Air series
-    "FPV",             // DJI FPV
-    "Inspire",         // DJI Inspire
-    "Matrice",         // DJI Matrice (commercial)
-
-    // Parrot Drones
-    "Parrot",          // Parrot drones
-    "Anafi",           // Parrot Anafi
-    "Bebop",           // Parrot Bebop
-    "Disco",           // Parrot Disco
-
-    // Skydio Drones
-    "Skydio",          // Skydio drones
-    "S2",              // Skydio 2
-    "X2"               // Skydio X2 (commercial/enterprise)
-};
-
-// ============================================================================
-// RAVEN SURVEILLANCE DEVICE UUID PATTERNS
-// ============================================================================
-// These UUIDs are specific to Raven surveillance devices (acoustic gunshot detection)
-// Source: raven_configurations.json - firmware versions 1.1.7, 1.2.0, 1.3.1
-
-// Raven Device Information Service (used across all firmware versions)
-#define RAVEN_DEVICE_INFO_SERVICE       "0000180a-0000-1000-8000-00805f9b34fb"
-
-// Raven GPS Location Service (firmware 1.2.0+)
-#define RAVEN_GPS_SERVICE               "00003100-0000-1000-8000-00805f9b34fb"
-
-// Raven Power/Battery Service (firmware 1.2.0+)
-#define RAVEN_POWER_SERVICE             "00003200-0000-1000-8000-00805f9b34fb"
-
-// Raven Network Status Service (firmware 1.2.0+)
-#define RAVEN_NETWORK_SERVICE           "00003300-0000-1000-8000-00805f9b34fb"
-
-// Raven Upload Statistics Service (firmware 1.2.0+)
-#define RAVEN_UPLOAD_SERVICE            "00003400-0000-1000-8000-00805f9b34fb"
-
-// Raven Error/Failure Service (firmware 1.2.0+)
-#define RAVEN_ERROR_SERVICE             "00003500-0000-1000-8000-00805f9b34fb"
-
-// Health Thermometer Service (firmware 1.1.7)
-#define RAVEN_OLD_HEALTH_SERVICE        "00001809-0000-1000-8000-00805f9b34fb"
-
-// Location and Navigation Service (firmware 1.1.7)
-#define RAVEN_OLD_LOCATION_SERVICE      "00001819-0000-1000-8000-00805f9b34fb"
-
-// Known Raven service UUIDs for detection
-static const char* raven_service_uuids[] = {
-    RAVEN_DEVICE_INFO_SERVICE,    // Device info (all versions)
-    RAVEN_GPS_SERVICE,            // GPS data (1.2.0+)
-    RAVEN_POWER_SERVICE,          // Battery/Solar (1.2.0+)
-    RAVEN_NETWORK_SERVICE,        // LTE/WiFi status (1.2.0+)
-    RAVEN_UPLOAD_SERVICE,         // Upload stats (1.2.0+)
-    RAVEN_ERROR_SERVICE,          // Error tracking (1.2.0+)
-    RAVEN_OLD_HEALTH_SERVICE,     // Old health service (1.1.7)
-    RAVEN_OLD_LOCATION_SERVICE    // Old location service (1.1.7)
-};
+// The OUI, SSID, BLE name and Raven UUID tables live in src/generated/ and
+// are compiled from datasets/ and tools/signatures.json before every build by
+// tools/gen_signatures.py. Edit signatures.json, not the generated headers.
 
 // ============================================================================
 // GLOBAL VARIABLES
@@ -411,10 +290,10 @@ enum DetectionType {
     ARUBA = 12
 };
 
-static DetectionType current_detection_type = NONE;
 static uint8_t current_channel = 1;
 static unsigned long last_channel_hop = 0;
-static bool triggered = false;
+static volatile uint16_t wifi_dwell_epoch = 0;   // Channel hops since boot
+static volatile uint16_t ble_scan_epoch = 0;     // BLE scans since boot
 static bool device_in_range = false;
 static unsigned long last_detection_time = 0;
 static unsigned long last_heartbeat = 0;
@@ -422,13 +301,108 @@ static int last_rssi = -100;
 static NimBLEScan* pBLEScan;
 static NimBLEServer* pServer = NULL;
 static NimBLECharacteristic* pTxCharacteristic = NULL;
+static NimBLECharacteristic* pLogCharacteristic = NULL;
 static bool deviceConnected = false;
+static uint16_t ble_peer_mtu = 23;      // Negotiated ATT MTU of the connected phone
 
 // Session statistics
 static unsigned long session_start_time = 0;
 static int total_wifi_detections = 0;
 static int total_ble_detections = 0;
-static int unique_devices_seen = 0;
+
+// Per-channel statistics (index = channel number)
+static volatile uint32_t channel_frames[MAX_CHANNEL + 1];   // Mgmt frames seen
+static uint16_t channel_detections[MAX_CHANNEL + 1];        // WiFi detections
+
+// Boot timing, microseconds since boot (0 = not yet)
+static int64_t boot_scan_ready_us = 0;       // Promiscuous mode + BLE scan running
+static volatile int64_t boot_first_wifi_frame_us = 0;
+static volatile int64_t boot_first_ble_adv_us = 0;
+
+// ============================================================================
+// TASKS AND DETECTION EVENTS
+// ============================================================================
+//
+// Task graph:
+//   WiFi driver callback --+
+//                          +--> detection_queue --> detect task (classify, JSON, BLE notify)
+//   NimBLE scan callback --+
+//   hop_timer / ble_scan_timer --notify--> radio task (channel hop, BLE scan start)
+//   heartbeat_timer / range_timer --notify--> ui task (heartbeat, out of range)
+//   ui task also services Serial every UI_FRAME_MS and wakes for each LED change.
+//
+// The radio callbacks only match and copy; nothing in them blocks.
+
+#define MAX_EVENT_SERVICE_UUIDS 4
+#define BLE_FP_PARTS 5             // See BLE ADDRESS ROTATION
+
+enum DetectionEventSource {
+    EVENT_WIFI = 0,
+    EVENT_BLE = 1,
+    EVENT_RAVEN = 2,
+    EVENT_PROBED_SSID = 3,     // Log records only: an SSID the device probed for
+    EVENT_GATT_VALUE = 4       // Log records only: "name=value" read from a Raven unit
+};
+
+struct DetectionEvent {
+    uint8_t source;            // DetectionEventSource
+    uint8_t channel;           // WiFi channel the frame was received on
+    int8_t rssi;
+    uint8_t mac[6];
+    const char* method;        // Static detection method string
+    char text[33];             // SSID (WiFi) or device name (BLE)
+    uint16_t epoch;            // Radio epoch, see noteDeviceArrival()
+    uint32_t rx_us;            // Receive time, microseconds
+    uint8_t category;          // DetectionType of the match the radio callback made
+    bool known_device;         // Matched an exact surveyed MAC
+    // BLE only
+    uint8_t addr_type;         // BLE_ADDR_PUBLIC / BLE_ADDR_RANDOM
+    bool addr_rotating;        // Resolvable / non-resolvable private address
+    uint8_t phy;               // BLE_HCI_LE_PHY_* primary | secondary << 4 (0 = legacy)
+    uint16_t fingerprint[BLE_FP_PARTS];
+    // WiFi only
+    uint16_t beacon_interval;  // TU, 0 for probe requests
+    uint8_t ie_flags;          // WIFI_IE_* seen in the frame body
+    // Raven only
+    const char* raven_fw_version;
+    const char* raven_service_desc;
+    char raven_service_uuid[41];
+    uint8_t service_uuid_count;
+    char service_uuids[MAX_EVENT_SERVICE_UUIDS][37];
+};
+
+#define WIFI_IE_RSN  (1u << 0)     // RSN element (WPA2/WPA3)
+#define WIFI_IE_WPA1 (1u << 1)     // Microsoft WPA vendor element
+
+// Notification bits
+#define NOTIFY_CHANNEL_HOP  (1u << 0)  // radio task
+#define NOTIFY_BLE_SCAN     (1u << 1)  // radio task
+#define NOTIFY_BLE_CANDIDATES (1u << 2) // radio task: a regular BLE scan ended
+#define NOTIFY_HEARTBEAT    (1u << 0)  // ui task
+#define NOTIFY_OUT_OF_RANGE (1u << 1)  // ui task
+#define NOTIFY_LOG_FLUSH    (1u << 2)  // ui task
+#define NOTIFY_SNAPSHOT     (1u << 3)  // ui task
+#define NOTIFY_CONTROL      (1u << 4)  // ui task: BLE control request queued
+#define NOTIFY_TELEMETRY    (1u << 5)  // ui task
+#define NOTIFY_CAPTURE      (1u << 6)  // ui task: a capture buffer is full
+#define NOTIFY_SURVEY       (1u << 7)  // ui task
+
+static QueueHandle_t detection_queue = NULL;
+static TaskHandle_t radio_task_handle = NULL;
+static TaskHandle_t detect_task_handle = NULL;
+static TaskHandle_t ui_task_handle = NULL;
+static TimerHandle_t hop_timer = NULL;
+static TimerHandle_t ble_scan_timer = NULL;
+static TimerHandle_t heartbeat_timer = NULL;
+static TimerHandle_t range_timer = NULL;
+static TimerHandle_t log_flush_timer = NULL;
+static TimerHandle_t snapshot_timer = NULL;
+static TimerHandle_t telemetry_timer = NULL;
+static TimerHandle_t survey_timer = NULL;
+static SemaphoreHandle_t device_table_mutex = NULL;  // seenDevices + session counters
+static SemaphoreHandle_t threat_mutex = NULL;        // threat_slots
+static volatile bool state_dirty = false;            // Snapshot out of date
+static volatile uint32_t detection_events_dropped = 0;  // Queue full
 
 // ============================================================================
 // DEBOUNCE HELPER FUNCTIONS
@@ -442,7 +416,7 @@ bool isDeviceDebounced(const char* mac) {
     for (int i = 0; i < seenDeviceCount; i++) {
         if (strcasecmp(seenDevices[i].mac, mac) == 0) {
             // Found it - check if within debounce window
-            if (now - seenDevices[i].lastSeen < DEBOUNCE_WINDOW_MS) {
+            if (now - seenDevices[i].lastSeen < (unsigned long)debounce_window_ms) {
                 seenDevices[i].detectionCount++;
                 seenDevices[i].lastSeen = now;
                 return true;  // Debounce - skip alert
@@ -461,8 +435,9 @@ bool isDeviceDebounced(const char* mac) {
         seenDevices[seenDeviceCount].mac[17] = '\0';
         seenDevices[seenDeviceCount].lastSeen = now;
         seenDevices[seenDeviceCount].detectionCount = 1;
+        seenDevices[seenDeviceCount].category = NONE;
+        memset(&seenDevices[seenDeviceCount].arrivals, 0, sizeof(ArrivalStats));
         seenDeviceCount++;
-        unique_devices_seen++;
     } else {
         // Cache full - find oldest entry and replace
         int oldestIdx = 0;
@@ -477,7 +452,8 @@ bool isDeviceDebounced(const char* mac) {
         seenDevices[oldestIdx].mac[17] = '\0';
         seenDevices[oldestIdx].lastSeen = now;
         seenDevices[oldestIdx].detectionCount = 1;
-        unique_devices_seen++;
+        seenDevices[oldestIdx].category = NONE;
+        memset(&seenDevices[oldestIdx].arrivals, 0, sizeof(ArrivalStats));
     }
     
     return false;  // New device - allow alert
@@ -493,981 +469,7213 @@ int getDeviceDetectionCount(const char* mac) {
     return 0;
 }
 
-// ============================================================================
-// FORWARD DECLARATIONS
-// ============================================================================
-DetectionType categorize_by_mac(const char* mac_prefix);
-const char* get_manufacturer_name(const char* mac_prefix);
-
-// ============================================================================
-// BLE NOTIFICATION SYSTEM
-// ============================================================================
-
-class MyServerCallbacks: public NimBLEServerCallbacks {
-    void onConnect(NimBLEServer* pServer) {
-        deviceConnected = true;
-        printf("Client connected\n");
-    };
-
-    void onDisconnect(NimBLEServer* pServer) {
-        deviceConnected = false;
-        printf("Client disconnected\n");
-        pServer->startAdvertising(); // Restart advertising
+// Category of a device's last full detection, for its debounced repeats
+DetectionType getDeviceCategory(const char* mac) {
+    for (int i = 0; i < seenDeviceCount; i++) {
+        if (strcasecmp(seenDevices[i].mac, mac) == 0) {
+            return (DetectionType)seenDevices[i].category;
+        }
     }
-};
+    return NONE;
+}
 
-void send_notification(String message) {
-    if (deviceConnected && pTxCharacteristic != NULL) {
-        // Take mutex to ensure atomic transmission
-        // unique_lock would be nicer but we are in C-ish land
-        if (bleMutex != NULL) {
-            xSemaphoreTake(bleMutex, portMAX_DELAY);
+void setDeviceCategory(const char* mac, DetectionType category) {
+    for (int i = 0; i < seenDeviceCount; i++) {
+        if (strcasecmp(seenDevices[i].mac, mac) == 0) {
+            seenDevices[i].category = category;
+            return;
         }
+    }
+}
 
-        // Append newline as delimiter
-        message += "\n";
-        
-        size_t length = message.length();
-        const char* data = message.c_str();
-        size_t offset = 0;
-        
-        // Use a safe chunk size (20 bytes is standard BLE MTU safe limit)
-        // We could negotiate higher, but 20 ensures compatibility
-        const size_t chunk_size = 20;
-        
-        while (offset < length) {
-            size_t len = (length - offset) > chunk_size ? chunk_size : (length - offset);
-            std::string chunk(data + offset, len);
-            pTxCharacteristic->setValue(chunk);
-            pTxCharacteristic->notify();
-            offset += len;
-            delay(5); // Small delay to prevent congestion
+// Median of n values, sorts v
+static uint32_t arrival_median(uint32_t* v, int n)
+{
+    for (int i = 1; i < n; i++) {
+        uint32_t x = v[i];
+        int j = i;
+        for (; j > 0 && v[j - 1] > x; j--) {
+            v[j] = v[j - 1];
         }
-        printf("Notification sent (chunked): %d bytes\n", length);
+        v[j] = x;
+    }
+    return v[n / 2];
+}
 
-        if (bleMutex != NULL) {
-            xSemaphoreGive(bleMutex);
+// Feed one frame's receive time into the device's interval estimate. Only
+// gaps inside one epoch (a WiFi channel dwell, a BLE scan) are intervals: a
+// gap across a hop is mostly time the radio spent listening elsewhere.
+// Frames lost inside a dwell show up as a whole multiple of the interval
+// and are folded back once an estimate exists. Fixed work per frame: the
+// median and MAD are recomputed over ARRIVAL_SAMPLES gaps.
+void noteDeviceArrival(const char* mac, uint16_t epoch, uint32_t rx_us) {
+    for (int i = 0; i < seenDeviceCount; i++) {
+        if (strcasecmp(seenDevices[i].mac, mac) != 0) {
+            continue;
+        }
+        ArrivalStats& a = seenDevices[i].arrivals;
+        bool same_epoch = a.have_last && a.last_epoch == epoch;
+        uint32_t gap = rx_us - a.last_us;
+        if (same_epoch && gap < ARRIVAL_MIN_US) {
+            return;
+        }
+        a.last_us = rx_us;
+        a.last_epoch = epoch;
+        a.have_last = true;
+        if (!same_epoch || gap > ARRIVAL_MAX_US) {
+            return;
+        }
+        if (a.median_us > 0) {
+            uint32_t k = (gap + a.median_us / 2) / a.median_us;
+            if (k >= 2 && k <= ARRIVAL_MAX_FOLD) {
+                uint32_t folded = gap / k;
+                uint32_t diff = folded > a.median_us ? folded - a.median_us : a.median_us - folded;
+                if (diff <= a.median_us / 8) {
+                    gap = folded;
+                }
+            }
+        }
+        a.interval_us[a.next] = gap;
+        a.next = (a.next + 1) % ARRIVAL_SAMPLES;
+        if (a.count < ARRIVAL_SAMPLES) {
+            a.count++;
+        }
+        if (a.count >= ARRIVAL_MIN_SAMPLES) {
+            uint32_t v[ARRIVAL_SAMPLES];
+            memcpy(v, a.interval_us, a.count * sizeof(uint32_t));
+            a.median_us = arrival_median(v, a.count);
+            for (int j = 0; j < a.count; j++) {
+                v[j] = v[j] > a.median_us ? v[j] - a.median_us : a.median_us - v[j];
+            }
+            a.mad_us = arrival_median(v, a.count);
         }
+        return;
     }
 }
 
-void flock_detected_notification(String details)
-{
-    // This function is now deprecated in favor of sending full JSON
-    // But we keep it for the heartbeat logic
-    printf("FLOCK SAFETY DEVICE DETECTED!\n");
+ArrivalEstimate getDeviceArrivals(const char* mac) {
+    ArrivalEstimate e = {0, 0};
+    for (int i = 0; i < seenDeviceCount; i++) {
+        if (strcasecmp(seenDevices[i].mac, mac) == 0) {
+            e.interval_us = seenDevices[i].arrivals.median_us;
+            e.jitter_us = seenDevices[i].arrivals.mad_us;
+            break;
+        }
+    }
+    return e;
 }
 
 // ============================================================================
-// JSON OUTPUT FUNCTIONS
+// SESSION SKETCHES
 // ============================================================================
+//
+// Session statistics (until 'clear') in constant memory, however many
+// devices pass by:
+//
+//   - HyperLogLog distinct counts of detected devices per category. The
+//     session total is the register-wise max of the category sketches, so
+//     it no longer depends on the debounce cache size
+//   - HyperLogLog distinct counts of every WiFi transmitter and BLE
+//     advertiser heard, detected or not. Randomized addresses (locally
+//     administered WiFi, random BLE) are left out: one phone would count as
+//     many devices
+//   - Space-Saving top-K of the most often detected MACs and SSIDs. Any item
+//     seen more than N/K times is in the table, and a count overestimates
+//     the true one by at most its error
+//
+// The detect task updates the detection sketches under device_table_mutex.
+// The radio callbacks update the heard sketches with plain byte stores; a
+// lost race only delays a register until the next frame from that device.
+// The sketches are saved to NVS at most every SKETCH_SAVE_INTERVAL_MS and
+// on a software restart.
+
+#define SKETCH_CATEGORY_P 7             // 128 registers per category, ~9% error
+#define SKETCH_HEARD_P 9                // 512 registers, ~5% error
+#define SKETCH_CATEGORIES (ARUBA + 1)   // Indexed by DetectionType, NONE = uncategorized
+#define SKETCH_TOP_MACS 16
+#define SKETCH_TOP_SSIDS 8
+#define STATS_TOP_N 5                   // Entries of each top list in 'stats'
+#define SKETCH_SAVE_INTERVAL_MS 600000  // Limits NVS wear to one save per 10 minutes
+#define SKETCH_VERSION 1
+
+struct __attribute__((packed)) TopMac {
+    uint8_t mac[6];
+    uint32_t count;
+    uint32_t error;             // Count inherited from the entry it replaced
+};
 
-void update_detection_state(DetectionType new_type) {
-    device_in_range = true; // Enable LED and Heartbeat
-    if (!triggered) {
-        triggered = true;
-        current_detection_type = new_type;
-    } else {
-        // Upgrade priority if new detection is more critical
-        if (new_type > current_detection_type) {
-            current_detection_type = new_type;
-        }
+struct __attribute__((packed)) TopSsid {
+    char ssid[33];
+    uint32_t count;
+    uint32_t error;
+};
+
+// Saved to NVS as one blob
+struct __attribute__((packed)) SessionSketches {
+    uint16_t version;
+    uint8_t top_mac_count;
+    uint8_t top_ssid_count;
+    uint8_t category_hll[SKETCH_CATEGORIES][1 << SKETCH_CATEGORY_P];
+    uint8_t wifi_heard_hll[1 << SKETCH_HEARD_P];
+    uint8_t ble_heard_hll[1 << SKETCH_HEARD_P];
+    TopMac top_macs[SKETCH_TOP_MACS];
+    TopSsid top_ssids[SKETCH_TOP_SSIDS];
+};
+
+static SessionSketches sketches = { SKETCH_VERSION };
+static volatile bool sketch_dirty = false;     // Changed since the last save
+
+static inline uint64_t sketch_hash_mac(const uint8_t* mac)
+{
+    uint64_t h = 0;
+    for (int i = 0; i < 6; i++) {
+        h = (h << 8) | mac[i];
     }
-    // Update timestamps
-    last_detection_time = millis();
+    // MurmurHash3 finalizer
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
 }
 
-void output_wifi_detection_json(const char* ssid, const uint8_t* mac, int rssi, const char* detection_type)
+static inline void hll_add(uint8_t* regs, int p, uint64_t h)
 {
-    char mac_prefix[9];
-    snprintf(mac_prefix, sizeof(mac_prefix), "%02x:%02x:%02x", mac[0], mac[1], mac[2]);
-    
-    // Categorize by MAC address
-    DetectionType resolved_type = categorize_by_mac(mac_prefix);
-    
-    // Override with SSID if it gives us more specific info
-    // WiFi detection = longer range (100-300m+), medium-high confidence
-    if (ssid && strlen(ssid) > 0) {
-        // Check Raven first (highest priority)
-        if (strcasestr(ssid, "raven")) {
-            resolved_type = RAVEN;
-        }
-        // Check Axon (law enforcement)
-        else if (strcasestr(ssid, "axon") || strcasestr(ssid, "body 2") || strcasestr(ssid, "body 3")) {
-            resolved_type = AXON;
-        }
-        // Check Ring
-        else if (strcasestr(ssid, "ring")) {
-            resolved_type = RING;
-        }
-        // Check Cradlepoint
-        else if (strcasestr(ssid, "cradlepoint") || strcasestr(ssid, "cp ")) {
-            resolved_type = CRADLEPOINT;
-        }
-        // Check Aruba
-        else if (strcasestr(ssid, "aruba") || strcasestr(ssid, "instant") || strcasestr(ssid, "setmeup")) {
-            resolved_type = ARUBA;
-        }
-        // Check Drones (DJI, Parrot, Skydio)
-        else if (strcasestr(ssid, "dji") || strcasestr(ssid, "mavic") || strcasestr(ssid, "phantom") ||
-                 strcasestr(ssid, "mini") || strcasestr(ssid, "air") || strcasestr(ssid, "fpv") ||
-                 strcasestr(ssid, "inspire") || strcasestr(ssid, "matrice") ||
-                 strcasestr(ssid, "parrot") || strcasestr(ssid, "anafi") || strcasestr(ssid, "bebop") ||
-                 strcasestr(ssid, "disco") || strcasestr(ssid, "skydio")) {
-            resolved_type = DRONE;
-        }
-        // Check Nest/Google
-        else if (strcasestr(ssid, "nest") || strcasestr(ssid, "google")) {
-            resolved_type = NEST_GOOGLE;
-        }
-        // Check Arlo
-        else if (strcasestr(ssid, "arlo") || strcasestr(ssid, "vmc")) {
-            resolved_type = ARLO;
-        }
-        // Check Eufy
-        else if (strcasestr(ssid, "eufy") || strcasestr(ssid, "solocam")) {
-            resolved_type = EUFY;
-        }
-        // Check Wyze
-        else if (strcasestr(ssid, "wyze")) {
-            resolved_type = WYZE;
-        }
-        // Check Blink
-        else if (strcasestr(ssid, "blink")) {
-            resolved_type = BLINK;
-        }
-        // Check Flock Safety (keep this last as it's most common)
-        else if (strcasestr(ssid, "flock") || strcasestr(ssid, "falcon") ||
-                 strcasestr(ssid, "penguin") || strcasestr(ssid, "pigvision") ||
-                 strcasestr(ssid, "fs ext battery")) {
-            resolved_type = FLOCK_SAFETY;
-        }
+    uint32_t idx = h >> (64 - p);
+    uint64_t rest = h << p;
+    uint8_t rank = rest ? __builtin_clzll(rest) + 1 : 64 - p + 1;
+    if (rank > regs[idx]) {
+        regs[idx] = rank;
+        sketch_dirty = true;
     }
+}
 
-    // Default to NONE if no specific match (don't force Flock Safety)
-    /* 
-    if (resolved_type == NONE) {
-        resolved_type = FLOCK_SAFETY;
-    } 
-    */
+static uint32_t hll_estimate(const uint8_t* regs, int p)
+{
+    int m = 1 << p;
+    float sum = 0;
+    int zeros = 0;
+    for (int i = 0; i < m; i++) {
+        sum += ldexpf(1.0f, -regs[i]);
+        zeros += regs[i] == 0;
+    }
+    float estimate = 0.7213f / (1 + 1.079f / m) * m * m / sum;
+    if (estimate <= 2.5f * m && zeros > 0) {
+        estimate = m * logf((float)m / zeros);  // Linear counting for small sets
+    }
+    return (uint32_t)lroundf(estimate);
+}
 
-    update_detection_state(resolved_type);
-    last_rssi = rssi;
-    
-    const char* manufacturer = get_manufacturer_name(mac_prefix);
+// Distinct detected devices of one category, or of all (category < 0)
+uint32_t sketch_unique_devices(int category = -1)
+{
+    if (category >= 0) {
+        return hll_estimate(sketches.category_hll[category], SKETCH_CATEGORY_P);
+    }
+    uint8_t merged[1 << SKETCH_CATEGORY_P] = {};
+    for (int c = 0; c < SKETCH_CATEGORIES; c++) {
+        for (int i = 0; i < (1 << SKETCH_CATEGORY_P); i++) {
+            merged[i] = max(merged[i], sketches.category_hll[c][i]);
+        }
+    }
+    return hll_estimate(merged, SKETCH_CATEGORY_P);
+}
 
-    DynamicJsonDocument doc(2048);
+uint32_t sketch_heard_wifi_estimate() { return hll_estimate(sketches.wifi_heard_hll, SKETCH_HEARD_P); }
+uint32_t sketch_heard_ble_estimate() { return hll_estimate(sketches.ble_heard_hll, SKETCH_HEARD_P); }
 
-    // Core detection info
-    doc["timestamp"] = millis();
-    doc["detection_time"] = String(millis() / 1000.0, 3) + "s";
-    doc["protocol"] = "wifi";
-    doc["detection_method"] = detection_type;
+// WiFi driver task, every management frame
+static inline void sketch_heard_wifi(const uint8_t* mac)
+{
+    if (!(mac[0] & 0x02)) {
+        hll_add(sketches.wifi_heard_hll, SKETCH_HEARD_P, sketch_hash_mac(mac));
+    }
+}
 
-    // Detection range and confidence
-    // WiFi = longer range (100-300m+), medium-high confidence
-    doc["detection_range"] = "MEDIUM_TO_FAR";
-    doc["estimated_distance"] = "100-300m";
+// NimBLE host task, every advertisement from a public address
+static inline void sketch_heard_ble(const uint8_t* mac)
+{
+    hll_add(sketches.ble_heard_hll, SKETCH_HEARD_P, sketch_hash_mac(mac));
+}
 
-    doc["alert_level"] = "HIGH";
-    doc["device_category"] = "FLOCK_SAFETY";
-    
-    // WiFi specific info
-    doc["ssid"] = ssid;
-    doc["ssid_length"] = strlen(ssid);
-    doc["rssi"] = rssi;
-    doc["signal_strength"] = rssi > -50 ? "STRONG" : (rssi > -70 ? "MEDIUM" : "WEAK");
-    doc["channel"] = current_channel;
-    
-    // MAC address info
-    char mac_str[18];
-    snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x:%02x:%02x:%02x", 
-             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
-    doc["mac_address"] = mac_str;
-    
-    // mac_prefix already calculated above
-    doc["mac_prefix"] = mac_prefix;
-    doc["vendor_oui"] = mac_prefix;
-    doc["manufacturer"] = manufacturer;
-    
-    // Device category based on detection type (vendor-specific with grouping)
-    const char* device_category_str;
-    switch(resolved_type) {
-        case FLOCK_SAFETY: device_category_str = "FLOCK_SAFETY"; break;
-        case AXON: device_category_str = "AXON"; break;
-        case RAVEN: device_category_str = "RAVEN"; break;
-        case RING: device_category_str = "RING"; break;
-        case CRADLEPOINT: device_category_str = "CRADLEPOINT"; break;
-        case ARUBA: device_category_str = "ARUBA"; break;
-        case DRONE: device_category_str = "DRONE"; break;
-        default: device_category_str = "UNKNOWN"; break;
-    }
-    doc["device_category"] = device_category_str;
-    
-    // Detection pattern matching
-    bool ssid_match = false;
-    bool mac_match = false;
-    
-    for (int i = 0; i < sizeof(wifi_ssid_patterns)/sizeof(wifi_ssid_patterns[0]); i++) {
-        if (strcasestr(ssid, wifi_ssid_patterns[i])) {
-            doc["matched_ssid_pattern"] = wifi_ssid_patterns[i];
-            doc["ssid_match_confidence"] = "HIGH";
-            ssid_match = true;
-            break;
+// Detect task, device_table_mutex held
+void sketch_note_category(const uint8_t* mac, DetectionType category)
+{
+    hll_add(sketches.category_hll[category], SKETCH_CATEGORY_P, sketch_hash_mac(mac));
+}
+
+// Space-Saving: count a hit, or replace the smallest entry once the table is full
+void sketch_note_mac(const uint8_t* mac)
+{
+    int smallest = 0;
+    for (int i = 0; i < sketches.top_mac_count; i++) {
+        if (memcmp(sketches.top_macs[i].mac, mac, 6) == 0) {
+            sketches.top_macs[i].count++;
+            sketch_dirty = true;
+            return;
         }
-    }
-    
-    for (int i = 0; i < sizeof(mac_prefixes)/sizeof(mac_prefixes[0]); i++) {
-        if (strncasecmp(mac_prefix, mac_prefixes[i], 8) == 0) {
-            doc["matched_mac_pattern"] = mac_prefixes[i];
-            doc["mac_match_confidence"] = "HIGH";
-            mac_match = true;
-            break;
+        if (sketches.top_macs[i].count < sketches.top_macs[smallest].count) {
+            smallest = i;
         }
     }
-    
-    // Detection summary and confidence scoring
-    // Highest confidence = both MAC and SSID match
-    // High confidence = MAC match only (OUI is reliable)
-    // Medium confidence = SSID match only (can be spoofed)
-    if (ssid_match && mac_match) {
-        doc["detection_criteria"] = "SSID_AND_MAC";
-        doc["detection_confidence"] = "HIGHEST";
-        doc["threat_score"] = 100;
-    } else if (mac_match) {
-        doc["detection_criteria"] = "MAC_ONLY";
-        doc["detection_confidence"] = "HIGH";
-        doc["threat_score"] = 90;
-    } else if (ssid_match) {
-        doc["detection_criteria"] = "SSID_ONLY";
-        doc["detection_confidence"] = "MEDIUM";
-        doc["threat_score"] = 75;
-    } else {
-        doc["detection_criteria"] = "PATTERN_MATCH";
-        doc["detection_confidence"] = "MEDIUM";
-        doc["threat_score"] = 70;
-    }
-    
-    // Frame type details
-    if (strcmp(detection_type, "probe_request") == 0 || strcmp(detection_type, "probe_request_mac") == 0) {
-        doc["frame_type"] = "PROBE_REQUEST";
-        doc["frame_description"] = "Device actively scanning for networks";
+    TopMac* e;
+    if (sketches.top_mac_count < SKETCH_TOP_MACS) {
+        e = &sketches.top_macs[sketches.top_mac_count++];
+        e->count = 1;
+        e->error = 0;
     } else {
-        doc["frame_type"] = "BEACON";
-        doc["frame_description"] = "Device advertising its network";
+        e = &sketches.top_macs[smallest];
+        e->error = e->count;
+        e->count++;
     }
-    
-    String json_output;
-    serializeJson(doc, json_output);
-    Serial.println(json_output);
-    
-    // Send full JSON over BLE
-    send_notification(json_output);
+    memcpy(e->mac, mac, 6);
+    sketch_dirty = true;
 }
 
-void output_ble_detection_json(const char* mac, const char* name, int rssi, const char* detection_method)
+void sketch_note_ssid(const char* ssid)
 {
-    // Extract MAC prefix for categorization
-    char mac_prefix[9];
-    strncpy(mac_prefix, mac, 8);
-    mac_prefix[8] = '\0';
-
-    DetectionType resolved_type = categorize_by_mac(mac_prefix);
-
-    // Override with name if it gives us more specific info
-    // BLE detection = shorter range (10-100m), HIGH CONFIDENCE close proximity
-    if (name && strlen(name) > 0) {
-        // Check Raven first (highest priority - gunshot detection)
-        if (strcasestr(name, "raven")) {
-            resolved_type = RAVEN;
-        }
-        // Check Axon (law enforcement body cams)
-        else if (strcasestr(name, "axon") || strcasestr(name, "body 2") ||
-                 strcasestr(name, "body 3") || strcasestr(name, "body 4")) {
-            resolved_type = AXON;
-        }
-        // Check Ring (security cameras)
-        else if (strcasestr(name, "ring")) {
-            resolved_type = RING;
-        }
-        // Check Cradlepoint (network equipment)
-        else if (strcasestr(name, "cradlepoint") || strcasestr(name, "ibr") || strcasestr(name, "aer")) {
-            resolved_type = CRADLEPOINT;
-        }
-        // Check Aruba (network equipment)
-        else if (strcasestr(name, "aruba") || strcasestr(name, "instant")) {
-            resolved_type = ARUBA;
-        }
-        // Check Drones (DJI, Parrot, Skydio)
-        else if (strcasestr(name, "dji") || strcasestr(name, "mavic") || strcasestr(name, "phantom") ||
-                 strcasestr(name, "mini") || strcasestr(name, "air") || strcasestr(name, "fpv") ||
-                 strcasestr(name, "inspire") || strcasestr(name, "matrice") ||
-                 strcasestr(name, "parrot") || strcasestr(name, "anafi") || strcasestr(name, "bebop") ||
-                 strcasestr(name, "disco") || strcasestr(name, "skydio") ||
-                 strcasestr(name, "s2") || strcasestr(name, "x2")) {
-            resolved_type = DRONE;
-        }
-        // Check Nest/Google
-        else if (strcasestr(name, "nest") || strcasestr(name, "google")) {
-            resolved_type = NEST_GOOGLE;
-        }
-        // Check Arlo
-        else if (strcasestr(name, "arlo") || strcasestr(name, "vmc")) {
-            resolved_type = ARLO;
-        }
-        // Check Eufy
-        else if (strcasestr(name, "eufy") || strcasestr(name, "solocam")) {
-            resolved_type = EUFY;
+    int smallest = 0;
+    for (int i = 0; i < sketches.top_ssid_count; i++) {
+        if (strcmp(sketches.top_ssids[i].ssid, ssid) == 0) {
+            sketches.top_ssids[i].count++;
+            sketch_dirty = true;
+            return;
         }
-        // Check Wyze
-        else if (strcasestr(name, "wyze")) {
-            resolved_type = WYZE;
+        if (sketches.top_ssids[i].count < sketches.top_ssids[smallest].count) {
+            smallest = i;
         }
-        // Check Blink
-        else if (strcasestr(name, "blink")) {
-            resolved_type = BLINK;
+    }
+    TopSsid* e;
+    if (sketches.top_ssid_count < SKETCH_TOP_SSIDS) {
+        e = &sketches.top_ssids[sketches.top_ssid_count++];
+        e->count = 1;
+        e->error = 0;
+    } else {
+        e = &sketches.top_ssids[smallest];
+        e->error = e->count;
+        e->count++;
+    }
+    strncpy(e->ssid, ssid, sizeof(e->ssid) - 1);
+    e->ssid[sizeof(e->ssid) - 1] = '\0';
+    sketch_dirty = true;
+}
+
+// Indices of the top entries, highest count first
+static int sketch_rank_macs(uint8_t* order)
+{
+    int n = sketches.top_mac_count;
+    for (int i = 0; i < n; i++) {
+        int j = i;
+        for (; j > 0 && sketches.top_macs[order[j - 1]].count < sketches.top_macs[i].count; j--) {
+            order[j] = order[j - 1];
         }
-        // Check Flock Safety (surveillance cameras)
-        else if (strcasestr(name, "flock") || strcasestr(name, "falcon") ||
-                 strcasestr(name, "penguin") || strcasestr(name, "pigvision") ||
-                 strcasestr(name, "fs ext battery")) {
-            resolved_type = FLOCK_SAFETY;
+        order[j] = i;
+    }
+    return n;
+}
+
+static int sketch_rank_ssids(uint8_t* order)
+{
+    int n = sketches.top_ssid_count;
+    for (int i = 0; i < n; i++) {
+        int j = i;
+        for (; j > 0 && sketches.top_ssids[order[j - 1]].count < sketches.top_ssids[i].count; j--) {
+            order[j] = order[j - 1];
         }
+        order[j] = i;
     }
+    return n;
+}
 
-    // Default to NONE if no specific match (don't force Flock Safety)
-    /*
-    if (resolved_type == NONE) {
-        resolved_type = FLOCK_SAFETY;
+// "top_macs" and "top_ssids", at most limit each; device_table_mutex held
+void add_top_json(JsonDocument& doc, int limit)
+{
+    uint8_t order[SKETCH_TOP_MACS];
+    JsonArray macs = doc.createNestedArray("top_macs");
+    int n = min(sketch_rank_macs(order), limit);
+    for (int i = 0; i < n; i++) {
+        const TopMac& e = sketches.top_macs[order[i]];
+        char mac_str[18];
+        snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x:%02x:%02x:%02x",
+                 e.mac[0], e.mac[1], e.mac[2], e.mac[3], e.mac[4], e.mac[5]);
+        JsonObject o = macs.createNestedObject();
+        o["mac"] = mac_str;
+        o["count"] = e.count;
+        o["error"] = e.error;
     }
-    */
+    JsonArray ssids = doc.createNestedArray("top_ssids");
+    n = min(sketch_rank_ssids(order), limit);
+    for (int i = 0; i < n; i++) {
+        const TopSsid& e = sketches.top_ssids[order[i]];
+        JsonObject o = ssids.createNestedObject();
+        o["ssid"] = e.ssid;
+        o["count"] = e.count;
+        o["error"] = e.error;
+    }
+}
 
-    update_detection_state(resolved_type);
-    last_rssi = rssi;
+// device_table_mutex held
+void print_top()
+{
+    uint8_t order[SKETCH_TOP_MACS];
+    printf("\nMost detected MACs       Count   (+/-)\n");
+    int n = sketch_rank_macs(order);
+    for (int i = 0; i < n; i++) {
+        const TopMac& e = sketches.top_macs[order[i]];
+        printf("%02x:%02x:%02x:%02x:%02x:%02x  %8lu  %6lu\n", e.mac[0], e.mac[1], e.mac[2],
+               e.mac[3], e.mac[4], e.mac[5], (unsigned long)e.count, (unsigned long)e.error);
+    }
+    printf("\nMost detected SSIDs              Count   (+/-)\n");
+    n = sketch_rank_ssids(order);
+    for (int i = 0; i < n; i++) {
+        const TopSsid& e = sketches.top_ssids[order[i]];
+        printf("%-32s %6lu  %6lu\n", e.ssid, (unsigned long)e.count, (unsigned long)e.error);
+    }
+    printf("\n");
+}
 
-    DynamicJsonDocument doc(2048);
+// ============================================================================
+// FORWARD DECLARATIONS
+// ============================================================================
+DetectionType categorize_by_mac(const char* mac_prefix);
+DetectionType categorize_by_ssid(const char* ssid);
+DetectionType categorize_by_name(const char* name);
+const char* get_manufacturer_name(const char* mac_prefix);
+bool check_mac_prefix(const uint8_t* mac, DetectionType* category = NULL);
+DetectionType known_device_category(const uint8_t* mac);
+static const GenRavenService* gen_lookup_raven_service(const char* uuid_str);
+const char* match_ssid_pattern(const char* ssid, DetectionType* category = NULL);
+const char* match_device_name_pattern(const char* name, DetectionType* category = NULL);
+struct SignatureDb;
+void build_wifi_prefilters(const SignatureDb* db);
+void log_append(const DetectionEvent& ev, DetectionType category);
 
-    // Core detection info
-    doc["timestamp"] = millis();
-    doc["detection_time"] = String(millis() / 1000.0, 3) + "s";
-    doc["protocol"] = "bluetooth_le";
-    doc["detection_method"] = detection_method;
+// ============================================================================
+// SIGNATURE DATABASE (flash, A/B slots)
+// ============================================================================
+//
+// The pattern tables above are compiled in and act as the fallback. A
+// signature database built by tools/sigdb.py can be uploaded at runtime
+// ('sigdb load') and replaces them without a reflash:
+//
+//   - Two slots (sigdb_a / sigdb_b). A new image is written to the slot not
+//     in use, validated, then activated with a single pointer store. At boot
+//     the valid slot with the highest generation wins, so a torn upload just
+//     leaves the previous database active
+//   - Images are mapped with esp_partition_mmap and read in place, nothing
+//     is copied into RAM
+//   - Layout: 176 byte header (magic, format, generation, CRC32, section
+//     table) followed by 4-byte aligned sections:
+//       STRINGS         NUL terminated string pool
+//       VENDORS         {category, flags, name} per vendor
+//       OUIS            sorted u32 (oui << 8 | vendor index), binary searched
+//       SSID / NAME     Aho-Corasick DFA over a case folded alphabet; one
+//                       pass over the text yields the best matching pattern
+//       UUIDS           sorted 128-bit service UUIDs with flags and description
+//   - Every offset and index is bounds checked once when a slot is opened,
+//     the lookups below trust a database that passed sigdb_open_slot()
+
+#define SIGDB_MAGIC 0x47535946          // "FYSG"
+#define SIGDB_FORMAT_VERSION 1
+#define SIGDB_MAX_SECTIONS 8
+#define SIGDB_SECTOR_SIZE 4096
+#define SIGDB_NO_PATTERN 0xFFFF
+
+enum SigdbSectionType {
+    SIGDB_SECTION_STRINGS = 1,
+    SIGDB_SECTION_VENDORS = 2,
+    SIGDB_SECTION_OUIS = 3,
+    SIGDB_SECTION_SSID_AUTOMATON = 4,
+    SIGDB_SECTION_NAME_AUTOMATON = 5,
+    SIGDB_SECTION_UUIDS = 6
+};
 
-    // Detection range and confidence
-    // BLE = shorter range (10-100m), HIGH CONFIDENCE close proximity
-    doc["detection_range"] = "CLOSE";
-    doc["estimated_distance"] = "10-100m";
-    doc["proximity_confidence"] = "HIGH";
+struct __attribute__((packed)) SigdbSection {
+    uint16_t type;              // SigdbSectionType
+    uint16_t reserved;
+    uint32_t offset;            // From the start of the image
+    uint32_t size;              // Bytes
+    uint32_t count;             // Entries
+};
 
-    doc["alert_level"] = "HIGH";
+struct __attribute__((packed)) SigdbHeader {
+    uint32_t magic;
+    uint16_t format_version;
+    uint16_t section_count;
+    uint32_t total_size;        // Header + sections
+    uint32_t crc;               // CRC32 over bytes [16, total_size)
+    uint32_t generation;        // Newest valid slot wins
+    uint32_t build_time;        // Unix time, informational
+    char label[24];
+    SigdbSection sections[SIGDB_MAX_SECTIONS];
+};
+static_assert(sizeof(SigdbHeader) == 176, "SigdbHeader must be 176 bytes");
 
-    // Device category based on detection type (vendor-specific with grouping)
-    const char* device_category_str;
-    switch(resolved_type) {
-        case FLOCK_SAFETY: device_category_str = "FLOCK_SAFETY"; break;
-        case AXON: device_category_str = "AXON"; break;
-        case RAVEN: device_category_str = "RAVEN"; break;
-        case RING: device_category_str = "RING"; break;
-        case CRADLEPOINT: device_category_str = "CRADLEPOINT"; break;
-        case ARUBA: device_category_str = "ARUBA"; break;
-        case DRONE: device_category_str = "DRONE"; break;
-        default: device_category_str = "UNKNOWN"; break;
-    }
-    doc["device_category"] = device_category_str;
+#define SIGDB_VENDOR_ALERT 0x01         // OUI alone is enough to alert
+struct __attribute__((packed)) SigdbVendor {
+    uint8_t category;           // DetectionType
+    uint8_t flags;
+    uint16_t name;              // String pool offset
+};
 
-    // BLE specific info
-    doc["mac_address"] = mac;
-    doc["rssi"] = rssi;
-    doc["signal_strength"] = rssi > -50 ? "STRONG" : (rssi > -70 ? "MEDIUM" : "WEAK");
+#define SIGDB_PATTERN_ALERT 0x01        // Match alone is enough to alert
+struct __attribute__((packed)) SigdbPattern {
+    uint8_t category;           // DetectionType
+    uint8_t priority;           // Lower wins when several patterns match
+    uint8_t flags;
+    uint8_t reserved;
+    uint16_t text;              // String pool offset
+    uint16_t reserved2;
+};
 
-    // Get manufacturer name from OUI
-    const char* manufacturer = get_manufacturer_name(mac_prefix);
-    doc["manufacturer"] = manufacturer;
-    
-    // Device name info
-    if (name && strlen(name) > 0) {
-        doc["device_name"] = name;
-        doc["device_name_length"] = strlen(name);
-        doc["has_device_name"] = true;
-    } else {
-        doc["device_name"] = "";
-        doc["device_name_length"] = 0;
-        doc["has_device_name"] = false;
-    }
+// Followed by SigdbPattern[num_patterns], uint16_t next[num_states][num_classes]
+// and uint16_t best[num_states][2] (best pattern overall, best alerting pattern)
+struct __attribute__((packed)) SigdbAutomatonHeader {
+    uint16_t num_states;
+    uint16_t num_patterns;
+    uint16_t num_classes;
+    uint16_t reserved;
+    uint8_t class_map[256];     // Byte -> character class (case folded)
+};
 
-    // MAC address analysis (mac_prefix already extracted at top of function)
-    doc["mac_prefix"] = mac_prefix;
-    doc["vendor_oui"] = mac_prefix;
-    
-    // Detection pattern matching
-    bool name_match = false;
-    bool mac_match = false;
-    
-    // Check MAC prefix patterns
-    for (int i = 0; i < sizeof(mac_prefixes)/sizeof(mac_prefixes[0]); i++) {
-        if (strncasecmp(mac, mac_prefixes[i], strlen(mac_prefixes[i])) == 0) {
-            doc["matched_mac_pattern"] = mac_prefixes[i];
-            doc["mac_match_confidence"] = "HIGH";
-            mac_match = true;
-            break;
-        }
+#define SIGDB_UUID_RAVEN 0x01
+struct __attribute__((packed)) SigdbUuid {
+    uint8_t uuid[16];           // Big endian, as printed
+    uint8_t flags;
+    uint8_t reserved;
+    uint16_t desc;              // String pool offset
+};
+
+struct SigdbAutomaton {
+    const SigdbAutomatonHeader* header;
+    const SigdbPattern* patterns;
+    const uint16_t* next;
+    const uint16_t* best;
+};
+
+struct SignatureDb {
+    const SigdbHeader* header;
+    esp_partition_mmap_handle_t map;
+    const char* strings;
+    uint32_t strings_size;
+    const SigdbVendor* vendors;
+    uint32_t vendor_count;
+    const uint32_t* ouis;
+    uint32_t oui_count;
+    SigdbAutomaton ssid;
+    SigdbAutomaton name;
+    const SigdbUuid* uuids;
+    uint32_t uuid_count;
+};
+
+struct SigdbMatch {
+    uint16_t any;               // Best pattern, for categorization
+    uint16_t alert;             // Best pattern with SIGDB_PATTERN_ALERT
+};
+
+static const esp_partition_t* sigdb_partitions[2] = { NULL, NULL };
+static SignatureDb sigdb_slots[2];
+static bool sigdb_mapped[2] = { false, false };
+static SignatureDb* volatile active_sigdb = NULL;   // NULL = compiled-in tables
+static int active_sigdb_slot = -1;
+
+// Serial upload in progress (ui task), sigdb_load_slot = -1 when idle
+static int sigdb_load_slot = -1;
+static uint32_t sigdb_load_size = 0;
+static uint32_t sigdb_load_offset = 0;
+static unsigned long sigdb_load_last_ms = 0;
+static uint8_t* sigdb_load_buf = NULL;    // One sector, allocated for the upload only
+static uint32_t sigdb_load_buf_len = 0;
+
+// Parse "aa:bb:cc" into a 24-bit OUI
+static uint32_t parse_oui(const char* prefix)
+{
+    unsigned int b0 = 0, b1 = 0, b2 = 0;
+    sscanf(prefix, "%02x:%02x:%02x", &b0, &b1, &b2);
+    return (b0 << 16) | (b1 << 8) | b2;
+}
+
+static inline uint32_t mac_to_oui(const uint8_t* mac)
+{
+    return ((uint32_t)mac[0] << 16) | ((uint32_t)mac[1] << 8) | mac[2];
+}
+
+// Parse a 128-bit UUID string; NimBLE prints 16-bit UUIDs as "0xXXXX",
+// those are expanded onto the Bluetooth base UUID
+static bool parse_uuid128(const char* s, uint8_t out[16])
+{
+    static const uint8_t base[16] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+                                      0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb };
+    if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X') && strlen(s) == 6) {
+        unsigned int short_uuid = 0;
+        if (sscanf(s + 2, "%4x", &short_uuid) != 1) return false;
+        memcpy(out, base, 16);
+        out[2] = short_uuid >> 8;
+        out[3] = short_uuid & 0xFF;
+        return true;
     }
-    
-    // Check device name patterns
-    if (name && strlen(name) > 0) {
-        for (int i = 0; i < sizeof(device_name_patterns)/sizeof(device_name_patterns[0]); i++) {
-            if (strcasestr(name, device_name_patterns[i])) {
-                doc["matched_name_pattern"] = device_name_patterns[i];
-                doc["name_match_confidence"] = "HIGH";
-                name_match = true;
-                break;
-            }
+    int n = 0;
+    for (; *s && n < 32; s++) {
+        if (*s == '-') continue;
+        if (!isxdigit((unsigned char)*s)) return false;
+        int v = isdigit((unsigned char)*s) ? *s - '0' : (tolower((unsigned char)*s) - 'a' + 10);
+        if (n & 1) {
+            out[n / 2] |= v;
+        } else {
+            out[n / 2] = v << 4;
         }
+        n++;
     }
-    
-    // Detection summary and confidence scoring
-    // BLE = close range detection = inherently higher confidence
-    // Highest confidence = both MAC and name match
-    // High confidence = MAC match only (OUI is reliable)
-    // High confidence = Name match only (BLE names are fairly reliable at close range)
-    if (name_match && mac_match) {
-        doc["detection_criteria"] = "NAME_AND_MAC";
-        doc["detection_confidence"] = "HIGHEST";
-        doc["threat_score"] = 100;
-    } else if (mac_match) {
-        doc["detection_criteria"] = "MAC_ONLY";
-        doc["detection_confidence"] = "HIGH";
-        doc["threat_score"] = 90;
-    } else if (name_match) {
-        doc["detection_criteria"] = "NAME_ONLY";
-        doc["detection_confidence"] = "HIGH";
-        doc["threat_score"] = 85;
-    } else {
-        doc["detection_criteria"] = "PATTERN_MATCH";
-        doc["detection_confidence"] = "MEDIUM";
-        doc["threat_score"] = 70;
+    return n == 32 && *s == '\0';
+}
+
+static inline const char* sigdb_string(const SignatureDb* db, uint16_t offset)
+{
+    return db->strings + offset;
+}
+
+// Locate a section and check it lies inside the image
+static const uint8_t* sigdb_section(const SignatureDb* db, uint16_t type, uint32_t min_size,
+                                    const SigdbSection** out)
+{
+    const SigdbHeader* h = db->header;
+    for (int i = 0; i < h->section_count; i++) {
+        const SigdbSection* s = &h->sections[i];
+        if (s->type != type) {
+            continue;
+        }
+        if ((s->offset & 3) || s->offset < sizeof(SigdbHeader) || s->offset > h->total_size ||
+            s->size > h->total_size - s->offset || s->size < min_size) {
+            return NULL;
+        }
+        *out = s;
+        return (const uint8_t*)h + s->offset;
     }
-    
-    // BLE advertisement type analysis
-    doc["advertisement_type"] = "BLE_ADVERTISEMENT";
-    doc["advertisement_description"] = "Bluetooth Low Energy device advertisement";
-    
-    // Detection method details
-    if (strcmp(detection_method, "mac_prefix") == 0) {
-        doc["primary_indicator"] = "MAC_ADDRESS";
-        doc["detection_reason"] = "MAC address matches known Flock Safety prefix";
-    } else if (strcmp(detection_method, "device_name") == 0) {
-        doc["primary_indicator"] = "DEVICE_NAME";
-        doc["detection_reason"] = "Device name matches Flock Safety pattern";
+    return NULL;
+}
+
+static bool sigdb_parse_automaton(const SignatureDb* db, uint16_t type, SigdbAutomaton* a)
+{
+    const SigdbSection* s;
+    const uint8_t* p = sigdb_section(db, type, sizeof(SigdbAutomatonHeader), &s);
+    if (p == NULL) return false;
+
+    const SigdbAutomatonHeader* h = (const SigdbAutomatonHeader*)p;
+    uint32_t cells = (uint32_t)h->num_states * h->num_classes;
+    if (h->num_states == 0 || h->num_classes == 0 ||
+        sizeof(*h) + h->num_patterns * sizeof(SigdbPattern) + cells * 2 + h->num_states * 4u > s->size) {
+        return false;
     }
-    
-    String json_output;
-    serializeJson(doc, json_output);
-    Serial.println(json_output);
-    
-    // Set global state to triggered
-    device_in_range = true; 
-    last_detection_time = millis();
-    triggered = true;
+    a->header = h;
+    a->patterns = (const SigdbPattern*)(p + sizeof(*h));
+    a->next = (const uint16_t*)(a->patterns + h->num_patterns);
+    a->best = a->next + cells;
 
-    // Send full JSON over BLE
-    send_notification(json_output);
+    for (int i = 0; i < 256; i++) {
+        if (h->class_map[i] >= h->num_classes) return false;
+    }
+    for (uint32_t i = 0; i < h->num_patterns; i++) {
+        if (a->patterns[i].text >= db->strings_size) return false;
+        if (a->patterns[i].category > ARUBA) return false;     // Indexes per-category tables
+    }
+    for (uint32_t i = 0; i < cells; i++) {
+        if (a->next[i] >= h->num_states) return false;
+    }
+    for (uint32_t i = 0; i < h->num_states * 2u; i++) {
+        if (a->best[i] != SIGDB_NO_PATTERN && a->best[i] >= h->num_patterns) return false;
+    }
+    return true;
 }
 
-// ============================================================================
-// DETECTION HELPER FUNCTIONS
-// ============================================================================
-
-// Categorize device by MAC prefix
-DetectionType categorize_by_mac(const char* mac_prefix)
+// Resolve and bounds check every section of a mapped, CRC-valid image
+static bool sigdb_parse(SignatureDb* db)
 {
-    // Check Raven (highest priority for gunshot detection)
-    // This should be handled separately via BLE service UUIDs
+    const SigdbSection* s;
+    const uint8_t* p;
 
-    // Check Axon
-    for (int i = 0; i < sizeof(axon_ouis)/sizeof(axon_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, axon_ouis[i], 8) == 0) {
-            return AXON;
-        }
+    if ((p = sigdb_section(db, SIGDB_SECTION_STRINGS, 1, &s)) == NULL || p[s->size - 1] != '\0') {
+        return false;
     }
+    db->strings = (const char*)p;
+    db->strings_size = s->size;
 
-    // Check Cradlepoint (must be before Flock Safety check)
-    // Network equipment used by surveillance systems - detect and alert
-    for (int i = 0; i < sizeof(cradlepoint_ouis)/sizeof(cradlepoint_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, cradlepoint_ouis[i], 8) == 0) {
-            return CRADLEPOINT;
-        }
+    if ((p = sigdb_section(db, SIGDB_SECTION_VENDORS, 0, &s)) == NULL ||
+        s->count > s->size / sizeof(SigdbVendor) || s->count > 256) {
+        return false;
+    }
+    db->vendors = (const SigdbVendor*)p;
+    db->vendor_count = s->count;
+    for (uint32_t i = 0; i < db->vendor_count; i++) {
+        if (db->vendors[i].name >= db->strings_size) return false;
+        if (db->vendors[i].category > ARUBA) return false;
     }
 
-    // Check Aruba
-    for (int i = 0; i < sizeof(aruba_ouis)/sizeof(aruba_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, aruba_ouis[i], 8) == 0) {
-            return ARUBA;
-        }
+    if ((p = sigdb_section(db, SIGDB_SECTION_OUIS, 0, &s)) == NULL || s->count > s->size / 4) {
+        return false;
+    }
+    db->ouis = (const uint32_t*)p;
+    db->oui_count = s->count;
+    for (uint32_t i = 0; i < db->oui_count; i++) {
+        if ((db->ouis[i] & 0xFF) >= db->vendor_count) return false;
+        if (i > 0 && (db->ouis[i] >> 8) <= (db->ouis[i - 1] >> 8)) return false;  // Must be sorted
     }
 
-    // Check Flock Safety
-    for (int i = 0; i < sizeof(flock_safety_ouis)/sizeof(flock_safety_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, flock_safety_ouis[i], 8) == 0) {
-            return FLOCK_SAFETY;
-        }
+    if (!sigdb_parse_automaton(db, SIGDB_SECTION_SSID_AUTOMATON, &db->ssid) ||
+        !sigdb_parse_automaton(db, SIGDB_SECTION_NAME_AUTOMATON, &db->name)) {
+        return false;
     }
 
-    // Check Ring
-    for (int i = 0; i < sizeof(ring_ouis)/sizeof(ring_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, ring_ouis[i], 8) == 0) {
-            return RING;
-        }
+    if ((p = sigdb_section(db, SIGDB_SECTION_UUIDS, 0, &s)) == NULL || s->count > s->size / sizeof(SigdbUuid)) {
+        return false;
     }
+    db->uuids = (const SigdbUuid*)p;
+    db->uuid_count = s->count;
+    for (uint32_t i = 0; i < db->uuid_count; i++) {
+        if (db->uuids[i].desc >= db->strings_size) return false;
+        if (i > 0 && memcmp(db->uuids[i].uuid, db->uuids[i - 1].uuid, 16) <= 0) return false;
+    }
+    return true;
+}
 
-    // Check DJI (Drones)
-    for (int i = 0; i < sizeof(dji_ouis)/sizeof(dji_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, dji_ouis[i], 8) == 0) {
-            return DRONE;
-        }
+static void sigdb_close_slot(int slot)
+{
+    if (sigdb_mapped[slot]) {
+        esp_partition_munmap(sigdb_slots[slot].map);
+        sigdb_mapped[slot] = false;
     }
+    memset(&sigdb_slots[slot], 0, sizeof(sigdb_slots[slot]));
+}
 
-    // Check Parrot (Drones)
-    for (int i = 0; i < sizeof(parrot_ouis)/sizeof(parrot_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, parrot_ouis[i], 8) == 0) {
-            return DRONE;
-        }
+// Map a slot and validate it; the slot stays mapped only if it is usable
+static bool sigdb_open_slot(int slot)
+{
+    const esp_partition_t* part = sigdb_partitions[slot];
+    sigdb_close_slot(slot);
+    if (part == NULL) return false;
+
+    SigdbHeader h;
+    if (esp_partition_read(part, 0, &h, sizeof(h)) != ESP_OK ||
+        h.magic != SIGDB_MAGIC || h.format_version != SIGDB_FORMAT_VERSION ||
+        h.total_size < sizeof(h) || h.total_size > part->size || h.section_count > SIGDB_MAX_SECTIONS) {
+        return false;
     }
 
-    // Check Skydio (Drones)
-    for (int i = 0; i < sizeof(skydio_ouis)/sizeof(skydio_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, skydio_ouis[i], 8) == 0) {
-            return DRONE;
-        }
+    const void* ptr = NULL;
+    SignatureDb* db = &sigdb_slots[slot];
+    if (esp_partition_mmap(part, 0, h.total_size, ESP_PARTITION_MMAP_DATA, &ptr, &db->map) != ESP_OK) {
+        return false;
     }
+    db->header = (const SigdbHeader*)ptr;
+    sigdb_mapped[slot] = true;
+
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t*)ptr + 16, h.total_size - 16);
+    if (crc != db->header->crc || !sigdb_parse(db)) {
+        printf("[SIGDB] Slot %c invalid (%s)\n", 'A' + slot, crc != db->header->crc ? "CRC" : "layout");
+        sigdb_close_slot(slot);
+        return false;
+    }
+    return true;
+}
+
+// Make a mapped slot (or the compiled-in tables, slot -1) the active database
+static void sigdb_activate(int slot)
+{
+    SignatureDb* db = slot >= 0 ? &sigdb_slots[slot] : NULL;
+    build_wifi_prefilters(db);
+    active_sigdb = db;
+    active_sigdb_slot = slot;
+}
 
-    // Check Nest/Google
-    for (int i = 0; i < sizeof(nest_ouis)/sizeof(nest_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, nest_ouis[i], 8) == 0) {
-            return NEST_GOOGLE;
+// Newest valid slot, -1 if neither holds a database
+static int sigdb_newest_slot()
+{
+    int best = -1;
+    for (int slot = 0; slot < 2; slot++) {
+        if (sigdb_mapped[slot] && (best < 0 ||
+            sigdb_slots[slot].header->generation > sigdb_slots[best].header->generation)) {
+            best = slot;
         }
     }
+    return best;
+}
 
-    // Check Arlo
-    for (int i = 0; i < sizeof(arlo_ouis)/sizeof(arlo_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, arlo_ouis[i], 8) == 0) {
-            return ARLO;
-        }
+// Called from setup() before the radios start
+void sigdb_init()
+{
+    sigdb_partitions[0] = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+        (esp_partition_subtype_t)SIGDB_PARTITION_SUBTYPE, SIGDB_SLOT_A_LABEL);
+    sigdb_partitions[1] = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+        (esp_partition_subtype_t)SIGDB_PARTITION_SUBTYPE, SIGDB_SLOT_B_LABEL);
+    sigdb_open_slot(0);
+    sigdb_open_slot(1);
+
+    int slot = sigdb_newest_slot();
+    sigdb_activate(slot);
+    if (slot >= 0) {
+        printf("[SIGDB] Using slot %c: '%.24s' generation %lu\n", 'A' + slot,
+               active_sigdb->header->label, (unsigned long)active_sigdb->header->generation);
+    } else {
+        printf("[SIGDB] No signature database, using compiled-in tables\n");
     }
+}
 
-    // Check Eufy
-    for (int i = 0; i < sizeof(eufy_ouis)/sizeof(eufy_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, eufy_ouis[i], 8) == 0) {
-            return EUFY;
+static const SigdbVendor* sigdb_lookup_oui(const SignatureDb* db, uint32_t oui)
+{
+    uint32_t lo = 0, hi = db->oui_count;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if ((db->ouis[mid] >> 8) < oui) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
         }
     }
+    if (lo < db->oui_count && (db->ouis[lo] >> 8) == oui) {
+        return &db->vendors[db->ouis[lo] & 0xFF];
+    }
+    return NULL;
+}
 
-    // Check Wyze
-    for (int i = 0; i < sizeof(wyze_ouis)/sizeof(wyze_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, wyze_ouis[i], 8) == 0) {
-            return WYZE;
+static const SigdbUuid* sigdb_lookup_uuid(const SignatureDb* db, const char* uuid_str)
+{
+    uint8_t uuid[16];
+    if (!parse_uuid128(uuid_str, uuid)) return NULL;
+    uint32_t lo = 0, hi = db->uuid_count;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        int cmp = memcmp(db->uuids[mid].uuid, uuid, 16);
+        if (cmp == 0) return &db->uuids[mid];
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
         }
     }
+    return NULL;
+}
 
-    // Check Blink
-    for (int i = 0; i < sizeof(blink_ouis)/sizeof(blink_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, blink_ouis[i], 8) == 0) {
-            return BLINK;
+// Run text through a pattern automaton, one table lookup per byte
+static SigdbMatch sigdb_match(const SigdbAutomaton* a, const char* text)
+{
+    SigdbMatch m = { SIGDB_NO_PATTERN, SIGDB_NO_PATTERN };
+    const SigdbAutomatonHeader* h = a->header;
+    uint32_t state = 0;
+    for (const uint8_t* p = (const uint8_t*)text; *p; p++) {
+        state = a->next[state * h->num_classes + h->class_map[*p]];
+        uint16_t any = a->best[state * 2];
+        uint16_t alert = a->best[state * 2 + 1];
+        if (any != SIGDB_NO_PATTERN &&
+            (m.any == SIGDB_NO_PATTERN || a->patterns[any].priority < a->patterns[m.any].priority)) {
+            m.any = any;
+        }
+        if (alert != SIGDB_NO_PATTERN &&
+            (m.alert == SIGDB_NO_PATTERN || a->patterns[alert].priority < a->patterns[m.alert].priority)) {
+            m.alert = alert;
         }
     }
+    return m;
+}
 
-    return NONE;
+// Category of the best pattern found in text, NONE if nothing matched
+static DetectionType sigdb_categorize_text(const SigdbAutomaton* a, const char* text)
+{
+    uint16_t idx = sigdb_match(a, text).any;
+    return idx != SIGDB_NO_PATTERN ? (DetectionType)a->patterns[idx].category : NONE;
 }
 
-// Get manufacturer name from MAC prefix
-const char* get_manufacturer_name(const char* mac_prefix)
+void print_sigdb_stats()
 {
-    // Check all OUI arrays - order matters for specificity
-    for (int i = 0; i < sizeof(axon_ouis)/sizeof(axon_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, axon_ouis[i], 8) == 0) return "Axon Enterprise";
-    }
-    for (int i = 0; i < sizeof(cradlepoint_ouis)/sizeof(cradlepoint_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, cradlepoint_ouis[i], 8) == 0) return "Cradlepoint";
-    }
-    for (int i = 0; i < sizeof(aruba_ouis)/sizeof(aruba_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, aruba_ouis[i], 8) == 0) return "Aruba Networks";
-    }
-    for (int i = 0; i < sizeof(flock_safety_ouis)/sizeof(flock_safety_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, flock_safety_ouis[i], 8) == 0) return "Flock Safety";
-    }
-    for (int i = 0; i < sizeof(ring_ouis)/sizeof(ring_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, ring_ouis[i], 8) == 0) return "Ring/Amazon";
-    }
-    for (int i = 0; i < sizeof(dji_ouis)/sizeof(dji_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, dji_ouis[i], 8) == 0) return "DJI";
-    }
-    for (int i = 0; i < sizeof(parrot_ouis)/sizeof(parrot_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, parrot_ouis[i], 8) == 0) return "Parrot";
-    }
-    for (int i = 0; i < sizeof(skydio_ouis)/sizeof(skydio_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, skydio_ouis[i], 8) == 0) return "Skydio";
+    const SignatureDb* db = active_sigdb;
+    if (db == NULL) {
+        printf("Signatures: compiled-in tables\n");
+    } else {
+        printf("Signatures: slot %c, '%.24s' generation %lu\n", 'A' + active_sigdb_slot,
+               db->header->label, (unsigned long)db->header->generation);
+        printf("  %lu vendors, %lu OUIs, %u/%u SSID/name patterns, %lu UUIDs, %lu bytes\n",
+               (unsigned long)db->vendor_count, (unsigned long)db->oui_count,
+               db->ssid.header->num_patterns, db->name.header->num_patterns,
+               (unsigned long)db->uuid_count, (unsigned long)db->header->total_size);
     }
-    for (int i = 0; i < sizeof(nest_ouis)/sizeof(nest_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, nest_ouis[i], 8) == 0) return "Nest/Google";
+    for (int slot = 0; slot < 2; slot++) {
+        if (sigdb_partitions[slot] == NULL) {
+            printf("  Slot %c: no partition\n", 'A' + slot);
+        } else if (sigdb_mapped[slot]) {
+            printf("  Slot %c: generation %lu%s\n", 'A' + slot,
+                   (unsigned long)sigdb_slots[slot].header->generation,
+                   slot == active_sigdb_slot ? " (active)" : "");
+        } else {
+            printf("  Slot %c: empty or invalid\n", 'A' + slot);
+        }
     }
-    for (int i = 0; i < sizeof(arlo_ouis)/sizeof(arlo_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, arlo_ouis[i], 8) == 0) return "Arlo";
+    if (sigdb_load_slot >= 0) {
+        printf("  Upload: %lu / %lu bytes into slot %c\n", (unsigned long)sigdb_load_offset,
+               (unsigned long)sigdb_load_size, 'A' + sigdb_load_slot);
     }
-    for (int i = 0; i < sizeof(eufy_ouis)/sizeof(eufy_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, eufy_ouis[i], 8) == 0) return "Eufy";
+    printf("Known devices: %d exact MACs in %u bytes of flash\n", GEN_KNOWN_MAC_COUNT,
+           (unsigned)(sizeof(GEN_KNOWN_MAC_BLOCKS) + sizeof(GEN_KNOWN_MAC_BITS)));
+}
+
+// Start a Serial upload of a size byte image into the slot not in use.
+// The active database keeps serving lookups until the new one validates.
+bool sigdb_load_begin(uint32_t size)
+{
+    int slot = active_sigdb_slot >= 0 ? 1 - active_sigdb_slot :
+               !sigdb_mapped[0] ? 0 : !sigdb_mapped[1] ? 1 : 1 - sigdb_newest_slot();
+    const esp_partition_t* part = sigdb_partitions[slot];
+    if (part == NULL) {
+        printf("[SIGDB] No partition for slot %c\n", 'A' + slot);
+        return false;
     }
-    for (int i = 0; i < sizeof(wyze_ouis)/sizeof(wyze_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, wyze_ouis[i], 8) == 0) return "Wyze";
+    if (size < sizeof(SigdbHeader) || size > part->size) {
+        printf("[SIGDB] Image size must be %u - %lu bytes\n", (unsigned)sizeof(SigdbHeader),
+               (unsigned long)part->size);
+        return false;
     }
-    for (int i = 0; i < sizeof(blink_ouis)/sizeof(blink_ouis[0]); i++) {
-        if (strncasecmp(mac_prefix, blink_ouis[i], 8) == 0) return "Blink/Amazon";
+    sigdb_load_buf = (uint8_t*)malloc(SIGDB_SECTOR_SIZE);
+    if (sigdb_load_buf == NULL) {
+        printf("[SIGDB] Out of memory\n");
+        return false;
     }
-    return "Unknown";
+
+    // Not the active slot, so nothing is reading through this mapping
+    sigdb_close_slot(slot);
+    sigdb_load_slot = slot;
+    sigdb_load_size = size;
+    sigdb_load_offset = 0;
+    sigdb_load_buf_len = 0;
+    sigdb_load_last_ms = millis();
+    printf("[SIGDB] Ready for %lu bytes into slot %c\n", (unsigned long)size, 'A' + slot);
+    return true;
 }
 
-bool check_mac_prefix(const uint8_t* mac)
+static void sigdb_load_end()
 {
-    char mac_str[9];  // Only need first 3 octets for prefix check
-    snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x", mac[0], mac[1], mac[2]);
-    
-    for (int i = 0; i < sizeof(mac_prefixes)/sizeof(mac_prefixes[0]); i++) {
-        if (strncasecmp(mac_str, mac_prefixes[i], 8) == 0) {
+    free(sigdb_load_buf);
+    sigdb_load_buf = NULL;
+    sigdb_load_slot = -1;
+}
+
+// Erase and program the buffered sector
+static bool sigdb_load_flush_sector()
+{
+    const esp_partition_t* part = sigdb_partitions[sigdb_load_slot];
+    uint32_t sector_offset = sigdb_load_offset - sigdb_load_buf_len;
+    if (esp_partition_erase_range(part, sector_offset, SIGDB_SECTOR_SIZE) != ESP_OK ||
+        esp_partition_write(part, sector_offset, sigdb_load_buf, sigdb_load_buf_len) != ESP_OK) {
+        return false;
+    }
+    sigdb_load_buf_len = 0;
+    return true;
+}
+
+// Validate the uploaded slot and switch to it
+static void sigdb_load_finish()
+{
+    int slot = sigdb_load_slot;
+    sigdb_load_end();
+    if (!sigdb_open_slot(slot)) {
+        printf("[SIGDB] Upload rejected, keeping current database\n");
+        return;
+    }
+    const SignatureDb* other = sigdb_mapped[1 - slot] ? &sigdb_slots[1 - slot] : NULL;
+    if (other != NULL && sigdb_slots[slot].header->generation <= other->header->generation) {
+        printf("[SIGDB] Generation %lu is not newer than %lu, not activated\n",
+               (unsigned long)sigdb_slots[slot].header->generation,
+               (unsigned long)other->header->generation);
+        return;
+    }
+    unsigned long start = micros();
+    sigdb_activate(slot);
+    printf("[SIGDB] Slot %c active: '%.24s' generation %lu (switched in %lu us)\n", 'A' + slot,
+           active_sigdb->header->label, (unsigned long)active_sigdb->header->generation,
+           micros() - start);
+}
+
+// Consume upload bytes from Serial (ui task); false when no upload is running
+bool continue_sigdb_load()
+{
+    if (sigdb_load_slot < 0) {
+        return false;
+    }
+    int avail = Serial.available();
+    if (avail <= 0) {
+        if (millis() - sigdb_load_last_ms > SIGDB_LOAD_TIMEOUT_MS) {
+            printf("[SIGDB] Upload timed out at %lu / %lu bytes\n",
+                   (unsigned long)sigdb_load_offset, (unsigned long)sigdb_load_size);
+            sigdb_load_end();
+        }
+        return true;
+    }
+
+    // At most one sector per ui frame
+    uint32_t want = min((uint32_t)avail, min(SIGDB_SECTOR_SIZE - sigdb_load_buf_len,
+                                             sigdb_load_size - sigdb_load_offset));
+    size_t got = Serial.readBytes(sigdb_load_buf + sigdb_load_buf_len, want);
+    sigdb_load_buf_len += got;
+    sigdb_load_offset += got;
+    sigdb_load_last_ms = millis();
+
+    if (sigdb_load_buf_len == SIGDB_SECTOR_SIZE || sigdb_load_offset == sigdb_load_size) {
+        if (!sigdb_load_flush_sector()) {
+            printf("[SIGDB] Flash write failed at %lu\n", (unsigned long)sigdb_load_offset);
+            sigdb_load_end();
+            return true;
+        }
+    }
+    if (sigdb_load_offset == sigdb_load_size) {
+        sigdb_load_finish();
+    }
+    return true;
+}
+
+// ============================================================================
+// BLE NOTIFICATION SYSTEM
+// ============================================================================
+
+class MyServerCallbacks: public NimBLEServerCallbacks {
+    void onConnect(NimBLEServer* pServer) {
+        deviceConnected = true;
+        ble_peer_mtu = 23;
+        printf("Client connected\n");
+    };
+
+    void onMTUChange(uint16_t MTU, ble_gap_conn_desc* desc) {
+        ble_peer_mtu = MTU;
+        printf("MTU updated: %u\n", MTU);
+    }
+
+    void onDisconnect(NimBLEServer* pServer) {
+        deviceConnected = false;
+        printf("Client disconnected\n");
+#if CONFIG_BT_NIMBLE_EXT_ADV
+        pServer->startAdvertising(0); // Restart advertising (instance 0)
+#else
+        pServer->startAdvertising(); // Restart advertising
+#endif
+    }
+};
+
+// Detect task only: time spent in send_notification, left out of its load
+static uint64_t detect_notify_us = 0;
+
+void send_notification(String message) {
+    int64_t start_us = esp_timer_get_time();
+    if (deviceConnected && pTxCharacteristic != NULL) {
+        // Take mutex to ensure atomic transmission
+        // unique_lock would be nicer but we are in C-ish land
+        if (bleMutex != NULL) {
+            xSemaphoreTake(bleMutex, portMAX_DELAY);
+        }
+
+        // Append newline as delimiter
+        message += "\n";
+        
+        size_t length = message.length();
+        const char* data = message.c_str();
+        size_t offset = 0;
+        
+        // Use a safe chunk size (20 bytes is standard BLE MTU safe limit)
+        // We could negotiate higher, but 20 ensures compatibility
+        const size_t chunk_size = 20;
+        
+        while (offset < length) {
+            size_t len = (length - offset) > chunk_size ? chunk_size : (length - offset);
+            std::string chunk(data + offset, len);
+            pTxCharacteristic->setValue(chunk);
+            pTxCharacteristic->notify();
+            offset += len;
+            delay(5); // Small delay to prevent congestion
+        }
+        if (verbosity >= VERBOSITY_VERBOSE) {
+            printf("Notification sent (chunked): %d bytes\n", length);
+        }
+
+        if (bleMutex != NULL) {
+            xSemaphoreGive(bleMutex);
+        }
+    }
+    if (xTaskGetCurrentTaskHandle() == detect_task_handle) {
+        detect_notify_us += esp_timer_get_time() - start_us;
+    }
+}
+
+void flock_detected_notification(String details)
+{
+    // This function is now deprecated in favor of sending full JSON
+    // But we keep it for the heartbeat logic
+    printf("FLOCK SAFETY DEVICE DETECTED!\n");
+}
+
+// ============================================================================
+// DETECTION SCORING
+// ============================================================================
+//
+// Every detection is scored from weighted evidence instead of a fixed ladder:
+//
+//   logit = sum(weight[i] * x[i])   (Q8 fixed point, 256 = 1.0)
+//   threat_score = 100 * sigmoid(logit)
+//
+// x[i] are small integers extracted per frame (SCORE_BIAS is always 1). The
+// weights are a logistic regression fitted by tools/tune_scores.py against
+// labelled captures, so the score is a calibrated probability in percent.
+// Detections print their feature vector as "score_features" for exactly
+// that purpose. Fixed work per detection: one pass over the table, one
+// interpolated table lookup.
+
+enum ScoreFeature {
+    SCORE_BIAS,               // Always 1
+    SCORE_OUI_ALERT,          // OUI of an alerting vendor
+    SCORE_OUI_VENDOR,         // OUI of a tracked, non-alerting vendor
+    SCORE_KNOWN_MAC,          // Exact MAC of a surveyed unit
+    SCORE_SSID_PATTERN,       // Alerting SSID pattern, x = pattern length (max 8)
+    SCORE_NAME_PATTERN,       // Alerting BLE name pattern, x = pattern length (max 8)
+    SCORE_CATEGORY_HINT,      // Only a non-alerting pattern matched
+    SCORE_IE_PROFILE,         // RSN without WPA1, like the surveyed APs
+    SCORE_BEACON_INTERVAL,    // Beacon interval other than 100 TU
+    SCORE_CHANNEL_PRIOR,      // log2(1 + surveyed APs on this channel)
+    SCORE_RSSI,               // (rssi + 100) / 10, 0..7
+    SCORE_REPEAT,             // log2 of sightings of this MAC
+    SCORE_RAVEN_CUSTOM,       // Raven-specific service UUIDs advertised
+    SCORE_RAVEN_STANDARD,     // SIG-standard services Raven also advertises
+    SCORE_BLE,                // Seen over BLE
+    SCORE_INTERVAL,           // log2 of the measured frame interval in ms, 0..13
+    SCORE_REGULARITY,         // log2(interval / jitter), 0..7
+    SCORE_FEATURE_COUNT
+};
+
+// Q8 logit weights, regenerate with tools/tune_scores.py. The starting values
+// reproduce the old ladder (MAC 90, SSID 75, BLE name 85, both ~100)
+static const int16_t score_weights[SCORE_FEATURE_COUNT] = {
+    -512,   // SCORE_BIAS
+    1075,   // SCORE_OUI_ALERT
+    256,    // SCORE_OUI_VENDOR
+    1536,   // SCORE_KNOWN_MAC
+    159,    // SCORE_SSID_PATTERN
+    178,    // SCORE_NAME_PATTERN
+    128,    // SCORE_CATEGORY_HINT
+    64,     // SCORE_IE_PROFILE
+    0,      // SCORE_BEACON_INTERVAL
+    8,      // SCORE_CHANNEL_PRIOR
+    16,     // SCORE_RSSI
+    77,     // SCORE_REPEAT
+    768,    // SCORE_RAVEN_CUSTOM
+    128,    // SCORE_RAVEN_STANDARD
+    64,     // SCORE_BLE
+    0,      // SCORE_INTERVAL
+    0,      // SCORE_REGULARITY
+};
+
+// 1000 * sigmoid(x) for x = -8.0, -7.5, ... 8.0
+static const uint16_t score_sigmoid_permille[33] = {
+    0, 1, 1, 2, 2, 4, 7, 11, 18, 29, 47, 76, 119, 182, 269, 378, 500,
+    622, 731, 818, 881, 924, 953, 971, 982, 989, 993, 996, 998, 998, 999, 999, 1000
+};
+
+struct ScoreFeatures {
+    int8_t x[SCORE_FEATURE_COUNT];
+};
+
+static inline int8_t score_log2(uint32_t v)
+{
+    int8_t n = 0;
+    while (v > 1) {
+        v >>= 1;
+        n++;
+    }
+    return n;
+}
+
+static inline int8_t score_clamp(int v, int lo, int hi)
+{
+    return (int8_t)(v < lo ? lo : (v > hi ? hi : v));
+}
+
+// Evidence shared by every protocol; the caller adds pattern/IE/UUID features
+static void score_init(ScoreFeatures* f, const uint8_t* mac, int rssi, int sightings)
+{
+    memset(f, 0, sizeof(*f));
+    f->x[SCORE_BIAS] = 1;
+    if (known_device_category(mac) != NONE) {
+        f->x[SCORE_KNOWN_MAC] = 1;
+    }
+    if (check_mac_prefix(mac)) {
+        f->x[SCORE_OUI_ALERT] = 1;
+    } else {
+        char mac_prefix[9];
+        snprintf(mac_prefix, sizeof(mac_prefix), "%02x:%02x:%02x", mac[0], mac[1], mac[2]);
+        if (categorize_by_mac(mac_prefix) != NONE) {
+            f->x[SCORE_OUI_VENDOR] = 1;
+        }
+    }
+    f->x[SCORE_RSSI] = score_clamp((rssi + 100) / 10, 0, 7);
+    f->x[SCORE_REPEAT] = score_clamp(score_log2(sightings > 0 ? sightings : 1), 0, 6);
+}
+
+// Temporal fingerprint: units on a fixed schedule behind a generic OUI
+static void score_arrivals(ScoreFeatures* f, const ArrivalEstimate& arrivals)
+{
+    if (arrivals.interval_us == 0) {
+        return;
+    }
+    f->x[SCORE_INTERVAL] = score_clamp(score_log2(arrivals.interval_us / 1000), 0, 13);
+    f->x[SCORE_REGULARITY] = score_clamp(score_log2(arrivals.interval_us / (arrivals.jitter_us + 1)), 0, 7);
+}
+
+static void score_wifi_frame(ScoreFeatures* f, uint8_t channel, uint16_t beacon_interval, uint8_t ie_flags)
+{
+    if ((ie_flags & WIFI_IE_RSN) && !(ie_flags & WIFI_IE_WPA1)) {
+        f->x[SCORE_IE_PROFILE] = 1;
+    }
+    if (beacon_interval != 0 && beacon_interval != 100) {
+        f->x[SCORE_BEACON_INTERVAL] = 1;
+    }
+    if (channel < 15) {
+        f->x[SCORE_CHANNEL_PRIOR] = score_log2(1 + GEN_DATASET_CHANNEL_COUNTS[channel]);
+    }
+}
+
+// Calibrated score 0..100
+static int score_compute(const ScoreFeatures* f)
+{
+    int32_t logit = 0;
+    for (int i = 0; i < SCORE_FEATURE_COUNT; i++) {
+        logit += (int32_t)score_weights[i] * f->x[i];
+    }
+    // Interpolate the sigmoid table, 128 = 0.5 in Q8 per step
+    int32_t pos = logit + 8 * 256;
+    if (pos <= 0) return 0;
+    if (pos >= 16 * 256) return 100;
+    int idx = pos >> 7;
+    int32_t frac = pos & 127;
+    int32_t permille = score_sigmoid_permille[idx] +
+                       (((int32_t)score_sigmoid_permille[idx + 1] - score_sigmoid_permille[idx]) * frac >> 7);
+    return (permille + 5) / 10;
+}
+
+static const char* score_confidence(int score)
+{
+    if (score >= 95) return "HIGHEST";
+    if (score >= 85) return "HIGH";
+    if (score >= 60) return "MEDIUM";
+    return "LOW";
+}
+
+static void score_add_json(JsonDocument& doc, const ScoreFeatures* f, int score, bool with_features)
+{
+    doc["threat_score"] = score;
+    if (!with_features) {
+        return;
+    }
+    JsonArray features = doc.createNestedArray("score_features");
+    for (int i = 0; i < SCORE_FEATURE_COUNT; i++) {
+        features.add(f->x[i]);
+    }
+}
+
+static const char* ble_phy_name(uint8_t phy)
+{
+    switch (phy) {
+        case BLE_HCI_LE_PHY_1M: return "1M";
+        case BLE_HCI_LE_PHY_2M: return "2M";
+        case BLE_HCI_LE_PHY_CODED: return "coded";
+        default: return "unknown";
+    }
+}
+
+// PHY an advertisement arrived on; extended advertisements also name the
+// PHY of their auxiliary packets
+static void add_phy_json(JsonDocument& doc, uint8_t phy)
+{
+    doc["ble_phy"] = ble_phy_name(phy & 0x0F);
+    if (phy >> 4) {
+        doc["ble_secondary_phy"] = ble_phy_name(phy >> 4);
+    }
+}
+
+static void add_interval_json(JsonDocument& doc, const ArrivalEstimate& arrivals)
+{
+    if (arrivals.interval_us == 0) {
+        return;
+    }
+    doc["interval_us"] = arrivals.interval_us;
+    doc["interval_jitter_us"] = arrivals.jitter_us;
+}
+
+// Log-distance path loss with exponent 2.7: metres from dB below the 1 m
+// reference, 10 * 10^(dB / 27) per 5 dB step
+static const uint16_t distance_decimetres[17] = {
+    10, 15, 23, 36, 55, 84, 129, 198, 303, 464, 711, 1089, 1668, 2555, 3914, 5995, 9183
+};
+
+#define WIFI_RSSI_AT_1M (-40)   // Typical 20 dBm access point
+#define BLE_RSSI_AT_1M  (-59)   // Typical 0 dBm advertiser
+
+static void add_distance_json(JsonDocument& doc, int rssi, int rssi_at_1m)
+{
+    int loss = rssi_at_1m - rssi;
+    uint32_t dm;
+    if (loss <= 0) {
+        dm = distance_decimetres[0];
+    } else if (loss >= 80) {
+        dm = distance_decimetres[16];
+    } else {
+        int idx = loss / 5;
+        dm = distance_decimetres[idx] + (distance_decimetres[idx + 1] - distance_decimetres[idx]) * (loss % 5) / 5;
+    }
+    uint32_t metres = (dm + 5) / 10;
+    doc["detection_range"] = metres < 10 ? "CLOSE" : (metres < 50 ? "MEDIUM" : "FAR");
+    doc["estimated_distance"] = String("~") + String((unsigned long)metres) + "m";
+}
+
+// ============================================================================
+// THREAT ARBITRATION
+// ============================================================================
+//
+// Each category has one slot, so a detection updates its threat in O(1). The
+// LED shows the highest-priority active threat and the heartbeat and status
+// list the top THREAT_TOP_N. A threat is raised by one detection scoring at
+// least threat_enter_score and stays active while detections scoring at least
+// threat_hold_score keep arriving within the category's expiry time; the gap
+// between the two thresholds stops a marginal device flapping the alert.
+// Weaker detections are still reported, they just don't raise an alert.
+// The slot logic is in threat_arbiter.h, covered by test/test_threat.
+
+#define THREAT_TOP_N 4          // Threats listed in heartbeat/status/stats
+
+// Indexed by DetectionType
+static const ThreatClass threat_classes[] = {
+    {"UNKNOWN",      10, 100},  // NONE: pattern hit without a category
+    {"FLOCK_SAFETY", 80, 100},
+    {"AXON",         90, 100},
+    {"RAVEN",       100, 200},  // Fixed install, only seen during BLE scan windows
+    {"RING",         40, 100},
+    {"CRADLEPOINT",  60, 100},
+    {"DRONE",        20, 100},
+    {"NEST_GOOGLE",  30, 100},
+    {"ARLO",         30, 100},
+    {"EUFY",         30, 100},
+    {"WYZE",         30, 100},
+    {"BLINK",        30, 100},
+    {"ARUBA",        50, 100},
+};
+
+#define THREAT_CLASS_COUNT (sizeof(threat_classes) / sizeof(threat_classes[0]))
+
+static ThreatSlot threat_slots[THREAT_CLASS_COUNT];
+
+static unsigned long threat_expiry_ms(int type)
+{
+    return threat_class_expiry_ms(threat_classes[type], out_of_range_ms);
+}
+
+// Returns true if the category has an active threat afterwards
+bool threat_update(DetectionType type, int score, int rssi, unsigned long now)
+{
+    if ((unsigned)type >= THREAT_CLASS_COUNT) type = NONE;
+    xSemaphoreTake(threat_mutex, portMAX_DELAY);
+    bool active = threat_slot_update(threat_slots[type], threat_expiry_ms(type), score, rssi,
+                                     threat_enter_score, threat_hold_score, now);
+    xSemaphoreGive(threat_mutex);
+    return active;
+}
+
+// Debounced repeat sighting: keeps an active threat alive, never raises one
+bool threat_refresh(DetectionType type, int rssi, unsigned long now)
+{
+    if ((unsigned)type >= THREAT_CLASS_COUNT) return false;
+    xSemaphoreTake(threat_mutex, portMAX_DELAY);
+    bool active = threat_slot_refresh(threat_slots[type], threat_expiry_ms(type), rssi, now);
+    xSemaphoreGive(threat_mutex);
+    return active;
+}
+
+// Active threats by priority (most recent first on a tie); returns the count
+int threat_top(ThreatView* out, int n, unsigned long now)
+{
+    xSemaphoreTake(threat_mutex, portMAX_DELAY);
+    int count = threat_rank(threat_classes, threat_slots, THREAT_CLASS_COUNT, out_of_range_ms, out, n, now);
+    xSemaphoreGive(threat_mutex);
+    return count;
+}
+
+// Milliseconds until the last active threat expires, 0 if none is active
+unsigned long threat_remaining_ms(unsigned long now)
+{
+    xSemaphoreTake(threat_mutex, portMAX_DELAY);
+    unsigned long remaining = threat_rank_remaining_ms(threat_classes, threat_slots, THREAT_CLASS_COUNT,
+                                                       out_of_range_ms, now);
+    xSemaphoreGive(threat_mutex);
+    return remaining;
+}
+
+void threat_add_json(JsonDocument& doc, unsigned long now)
+{
+    ThreatView top[THREAT_TOP_N];
+    int count = threat_top(top, THREAT_TOP_N, now);
+    JsonArray threats = doc.createNestedArray("active_threats");
+    for (int i = 0; i < count; i++) {
+        JsonObject t = threats.createNestedObject();
+        t["category"] = threat_classes[top[i].type].name;
+        t["priority"] = threat_classes[top[i].type].priority;
+        t["score"] = top[i].slot.score;
+        t["detections"] = top[i].slot.detections;
+        t["rssi"] = top[i].slot.rssi;
+        t["active_s"] = (now - top[i].slot.first_seen) / 1000;
+        t["last_seen_s"] = (now - top[i].slot.last_seen) / 1000;
+    }
+}
+
+// ============================================================================
+// OUTPUT PROFILES
+// ============================================================================
+//
+// Detection JSON fields are grouped, and a profile is a mask of groups. Serial
+// and BLE each pick a profile (config 'serial_profile' / 'ble_profile'). A
+// detection document is only built with the groups some connected sink wants;
+// output_emit() then strips it down for each sink. The profiles are nested,
+// so the wider sink is written first and the strip only ever removes keys.
+// Which sinks a detection goes to at all is decided before it is built (see
+// OUTPUT RATE LIMITING); a detection no sink takes is built with OUT_CORE
+// only, for its category and score.
+
+enum OutputGroup {
+    OUT_CORE     = 1u << 0,     // What, where, how sure: the alert itself
+    OUT_TIME     = 1u << 1,     // timestamp, detection_time
+    OUT_RANGE    = 1u << 2,     // Distance estimate, signal strength
+    OUT_VENDOR   = 1u << 3,     // Manufacturer, OUI
+    OUT_MATCH    = 1u << 4,     // Which patterns / services matched, frame interval
+    OUT_FEATURES = 1u << 5,     // score_features (training data for tune_scores.py)
+    OUT_DETAIL   = 1u << 6,     // Prose, duplicates and derived fields
+};
+
+static const uint32_t output_profile_masks[] = {
+    OUT_CORE,
+    OUT_CORE | OUT_TIME | OUT_RANGE | OUT_VENDOR | OUT_MATCH,
+    OUT_CORE | OUT_TIME | OUT_RANGE | OUT_VENDOR | OUT_MATCH | OUT_FEATURES | OUT_DETAIL,
+};
+
+// Group of every key outside OUT_CORE, for stripping
+struct OutputKey {
+    const char* key;
+    uint8_t group;
+};
+
+static const OutputKey output_keys[] = {
+    { "timestamp",                 OUT_TIME },
+    { "detection_time",            OUT_TIME },
+    { "detection_range",           OUT_RANGE },
+    { "estimated_distance",        OUT_RANGE },
+    { "signal_strength",           OUT_RANGE },
+    { "ble_phy",                   OUT_RANGE },
+    { "ble_secondary_phy",         OUT_RANGE },
+    { "manufacturer",              OUT_VENDOR },
+    { "mac_prefix",                OUT_VENDOR },
+    { "matched_ssid_pattern",      OUT_MATCH },
+    { "ssid_match_confidence",     OUT_MATCH },
+    { "matched_mac_pattern",       OUT_MATCH },
+    { "mac_match_confidence",      OUT_MATCH },
+    { "matched_name_pattern",      OUT_MATCH },
+    { "name_match_confidence",     OUT_MATCH },
+    { "detection_criteria",        OUT_MATCH },
+    { "raven_service_uuid",        OUT_MATCH },
+    { "raven_service_description", OUT_MATCH },
+    { "raven_firmware_version",    OUT_MATCH },
+    { "service_uuids",             OUT_MATCH },
+    { "interval_us",               OUT_MATCH },
+    { "interval_jitter_us",        OUT_MATCH },
+    { "score_features",            OUT_FEATURES },
+    { "alert_level",               OUT_DETAIL },
+    { "threat_level",              OUT_DETAIL },
+    { "vendor_oui",                OUT_DETAIL },
+    { "ssid_length",               OUT_DETAIL },
+    { "frame_type",                OUT_DETAIL },
+    { "frame_description",         OUT_DETAIL },
+    { "device_name_length",        OUT_DETAIL },
+    { "has_device_name",           OUT_DETAIL },
+    { "advertisement_type",        OUT_DETAIL },
+    { "advertisement_description", OUT_DETAIL },
+    { "primary_indicator",         OUT_DETAIL },
+    { "detection_reason",          OUT_DETAIL },
+};
+
+static uint32_t output_bytes[2] = {0, 0};     // Serial, BLE
+static uint32_t output_messages[2] = {0, 0};
+
+// Groups worth building for the current detection
+static uint32_t output_fields(const OutputSinks& sinks)
+{
+    uint32_t fields = 0;
+    if (sinks.mask & (1u << OUT_SINK_SERIAL)) {
+        fields |= output_profile_masks[serial_profile];
+    }
+    if ((sinks.mask & (1u << OUT_SINK_BLE)) && deviceConnected) {
+        fields |= output_profile_masks[ble_profile];
+    }
+    return fields != 0 ? fields : OUT_CORE;
+}
+
+static void output_strip(JsonDocument& doc, uint32_t fields)
+{
+    for (size_t i = 0; i < sizeof(output_keys) / sizeof(output_keys[0]); i++) {
+        if (!(fields & output_keys[i].group)) {
+            doc.remove(output_keys[i].key);
+        }
+    }
+}
+
+// Writes a detection document to the sinks that take it: Serial and/or the
+// phone. "suppressed" carries the sink's own count of dropped messages
+void output_emit(JsonDocument& doc, const OutputSinks& sinks)
+{
+    bool serial = sinks.mask & (1u << OUT_SINK_SERIAL);
+    bool ble = (sinks.mask & (1u << OUT_SINK_BLE)) && deviceConnected;
+    uint32_t serial_fields = output_profile_masks[serial_profile];
+    uint32_t ble_fields = output_profile_masks[ble_profile];
+    bool serial_first = !ble || (serial_fields & ble_fields) == ble_fields;
+    for (int pass = 0; pass < 2; pass++) {
+        bool serial_pass = (pass == 0) == serial_first;
+        if (serial_pass ? !serial : !ble) {
+            continue;
+        }
+        output_strip(doc, serial_pass ? serial_fields : ble_fields);
+        uint16_t suppressed = sinks.suppressed[serial_pass ? OUT_SINK_SERIAL : OUT_SINK_BLE];
+        if (suppressed > 0) {
+            doc["suppressed"] = suppressed;
+        } else {
+            doc.remove("suppressed");
+        }
+        String json_output;
+        serializeJson(doc, json_output);
+        if (serial_pass) {
+            Serial.println(json_output);
+        } else {
+            send_notification(json_output);
+        }
+        output_bytes[!serial_pass] += json_output.length();
+        output_messages[!serial_pass]++;
+    }
+}
+
+// ============================================================================
+// JSON OUTPUT FUNCTIONS
+// ============================================================================
+
+// Restart the out-of-range countdown, start heartbeats on first contact
+static void restart_range_timer(bool was_in_range)
+{
+    if (range_timer != NULL) {
+        xTimerChangePeriod(range_timer, pdMS_TO_TICKS(out_of_range_ms), 0);
+    }
+    if (!was_in_range && heartbeat_timer != NULL) {
+        xTimerStart(heartbeat_timer, 0);
+    }
+}
+
+void update_detection_state(DetectionType new_type, int score, int rssi) {
+    unsigned long now = millis();
+    last_detection_time = now;
+    last_rssi = rssi;
+    if (!threat_update(new_type, score, rssi, now)) {
+        return;  // Reported, but too weak to raise an alert
+    }
+    bool was_in_range = device_in_range;
+    device_in_range = true; // Enable LED and Heartbeat
+    restart_range_timer(was_in_range);
+}
+
+// Fills doc with the requested groups of a WiFi detection. Returns the
+// category; *score_out is the score that feeds threat arbitration.
+DetectionType build_wifi_detection_json(JsonDocument& doc, const DetectionEvent& ev, int sightings,
+                                        const ArrivalEstimate& arrivals, uint32_t fields, int* score_out)
+{
+    const char* ssid = ev.text;
+    const uint8_t* mac = ev.mac;
+    int rssi = ev.rssi;
+    uint8_t channel = ev.channel;
+    const char* detection_type = ev.method;
+
+    char mac_prefix[9];
+    snprintf(mac_prefix, sizeof(mac_prefix), "%02x:%02x:%02x", mac[0], mac[1], mac[2]);
+    
+    // Categorize by MAC address
+    DetectionType resolved_type = categorize_by_mac(mac_prefix);
+    
+    // Override with SSID if it gives us more specific info
+    // WiFi detection = longer range (100-300m+), medium-high confidence
+    if (ssid && strlen(ssid) > 0) {
+        DetectionType ssid_type = categorize_by_ssid(ssid);
+        if (ssid_type != NONE) {
+            resolved_type = ssid_type;
+        }
+    }
+
+    // A surveyed unit's exact MAC beats any pattern
+    DetectionType known_type = known_device_category(mac);
+    if (known_type != NONE) {
+        resolved_type = known_type;
+    }
+
+    // Default to NONE if no specific match (don't force Flock Safety)
+    /* 
+    if (resolved_type == NONE) {
+        resolved_type = FLOCK_SAFETY;
+    } 
+    */
+
+    // Core detection info
+    if (fields & OUT_TIME) {
+        doc["timestamp"] = millis();
+        doc["detection_time"] = String(millis() / 1000.0, 3) + "s";
+    }
+    doc["protocol"] = "wifi";
+    doc["detection_method"] = detection_type;
+
+    // Detection range from RSSI
+    if (fields & OUT_RANGE) {
+        add_distance_json(doc, rssi, WIFI_RSSI_AT_1M);
+        doc["signal_strength"] = rssi > -50 ? "STRONG" : (rssi > -70 ? "MEDIUM" : "WEAK");
+    }
+    if (fields & OUT_DETAIL) {
+        doc["alert_level"] = "HIGH";
+        doc["ssid_length"] = strlen(ssid);
+    }
+    
+    // WiFi specific info
+    doc["ssid"] = ssid;
+    doc["rssi"] = rssi;
+    doc["channel"] = channel;
+    
+    // MAC address info
+    char mac_str[18];
+    snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x:%02x:%02x:%02x", 
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    doc["mac_address"] = mac_str;
+    
+    // mac_prefix already calculated above
+    if (fields & OUT_VENDOR) {
+        doc["mac_prefix"] = mac_prefix;
+        doc["manufacturer"] = get_manufacturer_name(mac_prefix);
+    }
+    if (fields & OUT_DETAIL) {
+        doc["vendor_oui"] = mac_prefix;
+    }
+    
+    // Device category based on detection type (vendor-specific with grouping)
+    doc["device_category"] = threat_classes[resolved_type].name;
+    
+    // Detection pattern matching
+    bool ssid_match = false;
+    bool mac_match = false;
+    ScoreFeatures features;
+    score_init(&features, mac, rssi, sightings);
+    score_wifi_frame(&features, channel, ev.beacon_interval, ev.ie_flags);
+    score_arrivals(&features, arrivals);
+    if (fields & OUT_MATCH) {
+        add_interval_json(doc, arrivals);
+    }
+    
+    const char* ssid_pattern = match_ssid_pattern(ssid);
+    if (ssid_pattern) {
+        if (fields & OUT_MATCH) {
+            doc["matched_ssid_pattern"] = ssid_pattern;
+            doc["ssid_match_confidence"] = "HIGH";
+        }
+        ssid_match = true;
+        features.x[SCORE_SSID_PATTERN] = score_clamp(strlen(ssid_pattern), 0, 8);
+    } else if (ssid[0] && categorize_by_ssid(ssid) != NONE) {
+        features.x[SCORE_CATEGORY_HINT] = 1;
+    }
+    
+    if (check_mac_prefix(mac)) {
+        if (fields & OUT_MATCH) {
+            doc["matched_mac_pattern"] = mac_prefix;
+            doc["mac_match_confidence"] = "HIGH";
+        }
+        mac_match = true;
+    }
+    
+    if (known_type != NONE) {
+        doc["known_device"] = true;
+    }
+
+    // Detection summary; the score comes from the weighted evidence and
+    // only an exact MAC of a surveyed unit is reported as confirmed
+    if (!(fields & OUT_MATCH)) {
+        // Not reported
+    } else if (known_type != NONE) {
+        doc["detection_criteria"] = "KNOWN_DEVICE";
+    } else if (ssid_match && mac_match) {
+        doc["detection_criteria"] = "SSID_AND_MAC";
+    } else if (mac_match) {
+        doc["detection_criteria"] = "MAC_ONLY";
+    } else if (ssid_match) {
+        doc["detection_criteria"] = "SSID_ONLY";
+    } else {
+        doc["detection_criteria"] = "PATTERN_MATCH";
+    }
+    int score = score_compute(&features);
+    doc["detection_confidence"] = known_type != NONE ? "CONFIRMED" : score_confidence(score);
+    score_add_json(doc, &features, score, fields & OUT_FEATURES);
+    *score_out = known_type != NONE ? 100 : score;
+    
+    // Frame type details
+    if (!(fields & OUT_DETAIL)) {
+        // Not reported
+    } else if (strcmp(detection_type, "probe_request") == 0 || strcmp(detection_type, "probe_request_mac") == 0) {
+        doc["frame_type"] = "PROBE_REQUEST";
+        doc["frame_description"] = "Device actively scanning for networks";
+    } else {
+        doc["frame_type"] = "BEACON";
+        doc["frame_description"] = "Device advertising its network";
+    }
+    return resolved_type;
+}
+
+DetectionType output_wifi_detection_json(const DetectionEvent& ev, int sightings, const ArrivalEstimate& arrivals,
+                                         const OutputSinks& sinks)
+{
+    DynamicJsonDocument doc(2048);
+    int score;
+    DetectionType resolved_type = build_wifi_detection_json(doc, ev, sightings, arrivals, output_fields(sinks), &score);
+    update_detection_state(resolved_type, score, ev.rssi);
+    output_emit(doc, sinks);
+    return resolved_type;
+}
+
+DetectionType output_ble_detection_json(const char* mac, const char* name, int rssi, uint8_t phy, const char* detection_method,
+                                        int sightings, const ArrivalEstimate& arrivals, const OutputSinks& sinks)
+{
+    // Extract MAC prefix for categorization
+    char mac_prefix[9];
+    strncpy(mac_prefix, mac, 8);
+    mac_prefix[8] = '\0';
+
+    DetectionType resolved_type = categorize_by_mac(mac_prefix);
+
+    // Override with name if it gives us more specific info
+    // BLE detection = shorter range (10-100m), HIGH CONFIDENCE close proximity
+    if (name && strlen(name) > 0) {
+        DetectionType name_type = categorize_by_name(name);
+        if (name_type != NONE) {
+            resolved_type = name_type;
+        }
+    }
+
+    // A surveyed unit's exact MAC beats any pattern
+    uint8_t mac_bytes[6] = {0};
+    sscanf(mac, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
+           &mac_bytes[0], &mac_bytes[1], &mac_bytes[2], &mac_bytes[3], &mac_bytes[4], &mac_bytes[5]);
+    DetectionType known_type = known_device_category(mac_bytes);
+    if (known_type != NONE) {
+        resolved_type = known_type;
+    }
+
+    // Default to NONE if no specific match (don't force Flock Safety)
+    /*
+    if (resolved_type == NONE) {
+        resolved_type = FLOCK_SAFETY;
+    }
+    */
+
+    uint32_t fields = output_fields(sinks);
+    DynamicJsonDocument doc(2048);
+
+    // Core detection info
+    if (fields & OUT_TIME) {
+        doc["timestamp"] = millis();
+        doc["detection_time"] = String(millis() / 1000.0, 3) + "s";
+    }
+    doc["protocol"] = "bluetooth_le";
+    doc["detection_method"] = detection_method;
+
+    // Detection range from RSSI
+    if (fields & OUT_RANGE) {
+        add_distance_json(doc, rssi, BLE_RSSI_AT_1M);
+        doc["signal_strength"] = rssi > -50 ? "STRONG" : (rssi > -70 ? "MEDIUM" : "WEAK");
+        add_phy_json(doc, phy);
+    }
+    if (fields & OUT_DETAIL) {
+        doc["alert_level"] = "HIGH";
+    }
+
+    // Device category based on detection type (vendor-specific with grouping)
+    doc["device_category"] = threat_classes[resolved_type].name;
+
+    // BLE specific info
+    doc["mac_address"] = mac;
+    doc["rssi"] = rssi;
+
+    // Get manufacturer name from OUI
+    if (fields & OUT_VENDOR) {
+        doc["manufacturer"] = get_manufacturer_name(mac_prefix);
+        doc["mac_prefix"] = mac_prefix;
+    }
+    
+    // Device name info
+    bool has_name = name && strlen(name) > 0;
+    doc["device_name"] = has_name ? name : "";
+    if (fields & OUT_DETAIL) {
+        doc["device_name_length"] = has_name ? strlen(name) : 0;
+        doc["has_device_name"] = has_name;
+        doc["vendor_oui"] = mac_prefix;
+    }
+    
+    // Detection pattern matching
+    bool name_match = false;
+    bool mac_match = false;
+    ScoreFeatures features;
+    score_init(&features, mac_bytes, rssi, sightings);
+    features.x[SCORE_BLE] = 1;
+    score_arrivals(&features, arrivals);
+    if (fields & OUT_MATCH) {
+        add_interval_json(doc, arrivals);
+    }
+    
+    // Check MAC prefix patterns
+    uint32_t oui = parse_oui(mac_prefix);
+    uint8_t oui_bytes[3] = { (uint8_t)(oui >> 16), (uint8_t)(oui >> 8), (uint8_t)oui };
+    if (check_mac_prefix(oui_bytes)) {
+        if (fields & OUT_MATCH) {
+            doc["matched_mac_pattern"] = mac_prefix;
+            doc["mac_match_confidence"] = "HIGH";
+        }
+        mac_match = true;
+    }
+    
+    // Check device name patterns
+    const char* name_pattern = (name && strlen(name) > 0) ? match_device_name_pattern(name) : NULL;
+    if (name_pattern) {
+        if (fields & OUT_MATCH) {
+            doc["matched_name_pattern"] = name_pattern;
+            doc["name_match_confidence"] = "HIGH";
+        }
+        name_match = true;
+        features.x[SCORE_NAME_PATTERN] = score_clamp(strlen(name_pattern), 0, 8);
+    } else if (name && name[0] && categorize_by_name(name) != NONE) {
+        features.x[SCORE_CATEGORY_HINT] = 1;
+    }
+    
+    if (known_type != NONE) {
+        doc["known_device"] = true;
+    }
+
+    // Detection summary; the score comes from the weighted evidence and
+    // only an exact MAC of a surveyed unit is reported as confirmed
+    if (!(fields & OUT_MATCH)) {
+        // Not reported
+    } else if (known_type != NONE) {
+        doc["detection_criteria"] = "KNOWN_DEVICE";
+    } else if (name_match && mac_match) {
+        doc["detection_criteria"] = "NAME_AND_MAC";
+    } else if (mac_match) {
+        doc["detection_criteria"] = "MAC_ONLY";
+    } else if (name_match) {
+        doc["detection_criteria"] = "NAME_ONLY";
+    } else {
+        doc["detection_criteria"] = "PATTERN_MATCH";
+    }
+    int score = score_compute(&features);
+    doc["detection_confidence"] = known_type != NONE ? "CONFIRMED" : score_confidence(score);
+    score_add_json(doc, &features, score, fields & OUT_FEATURES);
+    update_detection_state(resolved_type, known_type != NONE ? 100 : score, rssi);
+    
+    // BLE advertisement type analysis
+    if (fields & OUT_DETAIL) {
+        doc["advertisement_type"] = "BLE_ADVERTISEMENT";
+        doc["advertisement_description"] = "Bluetooth Low Energy device advertisement";
+    }
+    
+    // Detection method details
+    if (!(fields & OUT_DETAIL)) {
+        // Not reported
+    } else if (strcmp(detection_method, "known_device") == 0) {
+        doc["primary_indicator"] = "MAC_ADDRESS";
+        doc["detection_reason"] = "MAC address matches a surveyed unit in the datasets";
+    } else if (strcmp(detection_method, "mac_prefix") == 0) {
+        doc["primary_indicator"] = "MAC_ADDRESS";
+        doc["detection_reason"] = "MAC address matches known Flock Safety prefix";
+    } else if (strcmp(detection_method, "device_name") == 0) {
+        doc["primary_indicator"] = "DEVICE_NAME";
+        doc["detection_reason"] = "Device name matches Flock Safety pattern";
+    }
+    
+    output_emit(doc, sinks);
+    return resolved_type;
+}
+
+// ============================================================================
+// DETECTION HELPER FUNCTIONS
+// ============================================================================
+
+// Binary search of the compiled-in OUI table
+static const GenVendor* gen_lookup_oui(uint32_t oui)
+{
+    size_t lo = 0, hi = sizeof(GEN_OUIS) / sizeof(GEN_OUIS[0]);
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if ((GEN_OUIS[mid] >> 8) < oui) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < sizeof(GEN_OUIS) / sizeof(GEN_OUIS[0]) && (GEN_OUIS[lo] >> 8) == oui) {
+        return &GEN_VENDORS[GEN_OUIS[lo] & 0xFF];
+    }
+    return NULL;
+}
+
+// Packed offset 'index' of a known-MAC block (offsets are at most 24 bits wide)
+static inline uint32_t known_mac_offset(const GenMacBlock* block, uint32_t index)
+{
+    uint32_t bit = (block->packed >> 8) + index * block->width;
+    uint64_t v = GEN_KNOWN_MAC_BITS[bit >> 5] | ((uint64_t)GEN_KNOWN_MAC_BITS[(bit >> 5) + 1] << 32);
+    return (uint32_t)((v >> (bit & 31)) & ((1ull << block->width) - 1));
+}
+
+// Category of a surveyed unit whose full MAC is in the datasets, NONE otherwise
+DetectionType known_device_category(const uint8_t* mac)
+{
+    uint64_t key = ((uint64_t)mac[0] << 40) | ((uint64_t)mac[1] << 32) | ((uint32_t)mac[2] << 24) |
+                   ((uint32_t)mac[3] << 16) | ((uint32_t)mac[4] << 8) | mac[5];
+
+    // Last block whose first MAC is <= key
+    size_t lo = 0, hi = sizeof(GEN_KNOWN_MAC_BLOCKS) / sizeof(GEN_KNOWN_MAC_BLOCKS[0]);
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        const GenMacBlock* b = &GEN_KNOWN_MAC_BLOCKS[mid];
+        if ((((uint64_t)b->first_hi << 16) | b->first_lo) <= key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == 0) return NONE;
+    const GenMacBlock* block = &GEN_KNOWN_MAC_BLOCKS[lo - 1];
+    uint64_t delta = key - (((uint64_t)block->first_hi << 16) | block->first_lo);
+    if (delta == 0) return (DetectionType)(block->packed & 0xFF);
+    if (delta >> block->width) return NONE;
+
+    // Offsets of MACs 1..count-1 are sorted
+    uint32_t target = (uint32_t)delta;
+    lo = 0;
+    hi = block->count - 1;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        uint32_t v = known_mac_offset(block, mid);
+        if (v == target) return (DetectionType)(block->packed & 0xFF);
+        if (v < target) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return NONE;
+}
+
+// First pattern found in text; tables are sorted by priority so that is the best one
+static const GenPattern* gen_match_pattern(const GenPattern* table, size_t count,
+                                           const char* text, bool alert_only)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (alert_only && !(table[i].flags & GEN_PATTERN_ALERT)) continue;
+        if (strcasestr(text, table[i].text)) {
+            return &table[i];
+        }
+    }
+    return NULL;
+}
+
+// Categorize device by MAC prefix
+DetectionType categorize_by_mac(const char* mac_prefix)
+{
+    const SignatureDb* db = active_sigdb;
+    if (db != NULL) {
+        const SigdbVendor* vendor = sigdb_lookup_oui(db, parse_oui(mac_prefix));
+        return vendor != NULL ? (DetectionType)vendor->category : NONE;
+    }
+
+    // Raven is identified separately via BLE service UUIDs
+    const GenVendor* vendor = gen_lookup_oui(parse_oui(mac_prefix));
+    return vendor != NULL ? (DetectionType)vendor->category : NONE;
+}
+
+// Get manufacturer name from MAC prefix
+const char* get_manufacturer_name(const char* mac_prefix)
+{
+    const SignatureDb* db = active_sigdb;
+    if (db != NULL) {
+        const SigdbVendor* vendor = sigdb_lookup_oui(db, parse_oui(mac_prefix));
+        return vendor != NULL ? sigdb_string(db, vendor->name) : "Unknown";
+    }
+
+    const GenVendor* vendor = gen_lookup_oui(parse_oui(mac_prefix));
+    return vendor != NULL ? vendor->name : "Unknown";
+}
+
+// Whether the OUI alerts on its own; category, if given, gets its vendor's
+bool check_mac_prefix(const uint8_t* mac, DetectionType* category)
+{
+    const SignatureDb* db = active_sigdb;
+    if (db != NULL) {
+        const SigdbVendor* vendor = sigdb_lookup_oui(db, mac_to_oui(mac));
+        if (vendor == NULL || !(vendor->flags & SIGDB_VENDOR_ALERT)) return false;
+        if (category) *category = (DetectionType)vendor->category;
+        return true;
+    }
+
+    const GenVendor* vendor = gen_lookup_oui(mac_to_oui(mac));
+    if (vendor == NULL || !(vendor->flags & GEN_VENDOR_ALERT)) return false;
+    if (category) *category = (DetectionType)vendor->category;
+    return true;
+}
+
+// First SSID pattern that alerts on its own, NULL if none; category, if
+// given, gets the pattern's
+const char* match_ssid_pattern(const char* ssid, DetectionType* category)
+{
+    if (!ssid) return NULL;
+
+    const SignatureDb* db = active_sigdb;
+    if (db != NULL) {
+        uint16_t idx = sigdb_match(&db->ssid, ssid).alert;
+        if (idx == SIGDB_NO_PATTERN) return NULL;
+        if (category) *category = (DetectionType)db->ssid.patterns[idx].category;
+        return sigdb_string(db, db->ssid.patterns[idx].text);
+    }
+
+    const GenPattern* p = gen_match_pattern(GEN_SSID_PATTERNS, sizeof(GEN_SSID_PATTERNS) / sizeof(GEN_SSID_PATTERNS[0]),
+                                            ssid, true);
+    if (p == NULL) return NULL;
+    if (category) *category = (DetectionType)p->category;
+    return p->text;
+}
+
+// First BLE name pattern that alerts on its own, NULL if none; category, if
+// given, gets the pattern's
+const char* match_device_name_pattern(const char* name, DetectionType* category)
+{
+    if (!name) return NULL;
+
+    const SignatureDb* db = active_sigdb;
+    if (db != NULL) {
+        uint16_t idx = sigdb_match(&db->name, name).alert;
+        if (idx == SIGDB_NO_PATTERN) return NULL;
+        if (category) *category = (DetectionType)db->name.patterns[idx].category;
+        return sigdb_string(db, db->name.patterns[idx].text);
+    }
+
+    const GenPattern* p = gen_match_pattern(GEN_NAME_PATTERNS, sizeof(GEN_NAME_PATTERNS) / sizeof(GEN_NAME_PATTERNS[0]),
+                                            name, true);
+    if (p == NULL) return NULL;
+    if (category) *category = (DetectionType)p->category;
+    return p->text;
+}
+
+// Category of the best SSID pattern, alerting or not; NONE if nothing matched
+DetectionType categorize_by_ssid(const char* ssid)
+{
+    const SignatureDb* db = active_sigdb;
+    if (db != NULL) {
+        return sigdb_categorize_text(&db->ssid, ssid);
+    }
+    const GenPattern* p = gen_match_pattern(GEN_SSID_PATTERNS, sizeof(GEN_SSID_PATTERNS) / sizeof(GEN_SSID_PATTERNS[0]),
+                                            ssid, false);
+    return p != NULL ? (DetectionType)p->category : NONE;
+}
+
+// Category of the best BLE name pattern, alerting or not; NONE if nothing matched
+DetectionType categorize_by_name(const char* name)
+{
+    const SignatureDb* db = active_sigdb;
+    if (db != NULL) {
+        return sigdb_categorize_text(&db->name, name);
+    }
+    const GenPattern* p = gen_match_pattern(GEN_NAME_PATTERNS, sizeof(GEN_NAME_PATTERNS) / sizeof(GEN_NAME_PATTERNS[0]),
+                                            name, false);
+    return p != NULL ? (DetectionType)p->category : NONE;
+}
+
+bool check_ssid_pattern(const char* ssid, DetectionType* category = NULL)
+{
+    return match_ssid_pattern(ssid, category) != NULL;
+}
+
+bool check_device_name_pattern(const char* name, DetectionType* category = NULL)
+{
+    return match_device_name_pattern(name, category) != NULL;
+}
+
+// ============================================================================
+// WIFI FRAME PREFILTER
+// ============================================================================
+//
+// The promiscuous callback runs in the WiFi driver task for every frame on
+// the channel, so anything that cannot possibly match is rejected here before
+// any string formatting or pattern matching happens:
+//
+//   1. Driver-level filter: only management frames reach the callback
+//   2. Subtype check on the raw frame control byte (probe request / beacon)
+//   3. OUI bloom filter on addr2/addr3 (2 hashes over a 4096-bit set)
+//   4. SSID bigram bloom filter: an SSID that contains none of the leading
+//      bigrams of any alerting SSID pattern cannot match a pattern
+//
+// Both blooms are built from the active pattern tables (compiled-in or
+// signature database) and have no false negatives, so the full checks below
+// still make the final decision. They are double buffered: a new set is
+// built on the side and published with one pointer store when the signature
+// database changes.
+
+#define OUI_BLOOM_BITS 4096
+#define SSID_BIGRAM_BLOOM_BITS 1024
+
+struct WifiPrefilter {
+    uint32_t oui_bloom[OUI_BLOOM_BITS / 32];
+    uint32_t ssid_bigram_bloom[SSID_BIGRAM_BLOOM_BITS / 32];
+};
+
+static WifiPrefilter wifi_prefilters[2];
+static WifiPrefilter* volatile wifi_prefilter = &wifi_prefilters[0];
+
+// Frame counters (written only from the WiFi task)
+static volatile uint32_t wifi_frames_seen = 0;           // Management frames delivered by the driver
+static volatile uint32_t wifi_frames_rejected_subtype = 0;   // Not a probe request or beacon
+static volatile uint32_t wifi_frames_rejected_prefilter = 0; // Failed OUI and SSID prefilters
+static volatile uint32_t wifi_frames_processed = 0;      // Went through full matching
+
+static inline uint32_t oui_hash1(uint32_t oui) { return (oui * 0x9E3779B1u) >> 20; }
+static inline uint32_t oui_hash2(uint32_t oui) { return (oui * 0x85EBCA6Bu) >> 20; }
+
+static inline uint32_t ssid_bigram_index(char a, char b)
+{
+    return ((tolower((unsigned char)a) & 0x1F) << 5) | (tolower((unsigned char)b) & 0x1F);
+}
+
+static void prefilter_add_oui(WifiPrefilter* pf, uint32_t oui)
+{
+    uint32_t h1 = oui_hash1(oui), h2 = oui_hash2(oui);
+    pf->oui_bloom[h1 >> 5] |= 1u << (h1 & 31);
+    pf->oui_bloom[h2 >> 5] |= 1u << (h2 & 31);
+}
+
+static void prefilter_add_ssid_pattern(WifiPrefilter* pf, const char* p)
+{
+    if (p[0] && p[1]) {
+        uint32_t idx = ssid_bigram_index(p[0], p[1]);
+        pf->ssid_bigram_bloom[idx >> 5] |= 1u << (idx & 31);
+    }
+}
+
+// Build the prefilters for db (NULL = compiled-in tables) and publish them
+void build_wifi_prefilters(const SignatureDb* db)
+{
+    WifiPrefilter* pf = (wifi_prefilter == &wifi_prefilters[0]) ? &wifi_prefilters[1] : &wifi_prefilters[0];
+    memset(pf, 0, sizeof(*pf));
+
+    if (db != NULL) {
+        for (uint32_t i = 0; i < db->oui_count; i++) {
+            if (db->vendors[db->ouis[i] & 0xFF].flags & SIGDB_VENDOR_ALERT) {
+                prefilter_add_oui(pf, db->ouis[i] >> 8);
+            }
+        }
+        for (uint32_t i = 0; i < db->ssid.header->num_patterns; i++) {
+            if (db->ssid.patterns[i].flags & SIGDB_PATTERN_ALERT) {
+                prefilter_add_ssid_pattern(pf, sigdb_string(db, db->ssid.patterns[i].text));
+            }
+        }
+    } else {
+        for (size_t i = 0; i < sizeof(GEN_OUIS) / sizeof(GEN_OUIS[0]); i++) {
+            if (GEN_VENDORS[GEN_OUIS[i] & 0xFF].flags & GEN_VENDOR_ALERT) {
+                prefilter_add_oui(pf, GEN_OUIS[i] >> 8);
+            }
+        }
+        for (size_t i = 0; i < sizeof(GEN_SSID_PATTERNS) / sizeof(GEN_SSID_PATTERNS[0]); i++) {
+            if (GEN_SSID_PATTERNS[i].flags & GEN_PATTERN_ALERT) {
+                prefilter_add_ssid_pattern(pf, GEN_SSID_PATTERNS[i].text);
+            }
+        }
+    }
+    // Known devices alert on any OUI; blocks never span two OUIs
+    for (size_t i = 0; i < sizeof(GEN_KNOWN_MAC_BLOCKS) / sizeof(GEN_KNOWN_MAC_BLOCKS[0]); i++) {
+        prefilter_add_oui(pf, GEN_KNOWN_MAC_BLOCKS[i].first_hi >> 8);
+    }
+
+    wifi_prefilter = pf;
+}
+
+static inline bool oui_prefilter_hit(const WifiPrefilter* pf, const uint8_t* mac)
+{
+    uint32_t oui = mac_to_oui(mac);
+    uint32_t h1 = oui_hash1(oui), h2 = oui_hash2(oui);
+    return (pf->oui_bloom[h1 >> 5] & (1u << (h1 & 31))) &&
+           (pf->oui_bloom[h2 >> 5] & (1u << (h2 & 31)));
+}
+
+static inline bool ssid_prefilter_hit(const WifiPrefilter* pf, const uint8_t* ssid, uint8_t len)
+{
+    for (int i = 0; i + 1 < len; i++) {
+        uint32_t idx = ssid_bigram_index(ssid[i], ssid[i + 1]);
+        if (pf->ssid_bigram_bloom[idx >> 5] & (1u << (idx & 31))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// RAVEN UUID DETECTION
+// ============================================================================
+
+// Binary search of the compiled-in Raven service table
+static const GenRavenService* gen_lookup_raven_service(const char* uuid_str)
+{
+    uint8_t uuid[16];
+    if (!parse_uuid128(uuid_str, uuid)) return NULL;
+    size_t lo = 0, hi = sizeof(GEN_RAVEN_SERVICES) / sizeof(GEN_RAVEN_SERVICES[0]);
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int cmp = memcmp(GEN_RAVEN_SERVICES[mid].uuid, uuid, 16);
+        if (cmp == 0) return &GEN_RAVEN_SERVICES[mid];
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return NULL;
+}
+
+// Check if a BLE device advertises any Raven surveillance service UUIDs
+bool check_raven_service_uuid(NimBLEAdvertisedDevice* device, char* detected_service_out = nullptr)
+{
+    if (!device) return false;
+    
+    // Check if device has service UUIDs
+    if (!device->haveServiceUUID()) return false;
+    
+    // Get the number of service UUIDs
+    int serviceCount = device->getServiceUUIDCount();
+    if (serviceCount == 0) return false;
+    
+    // Check each advertised service UUID against known Raven UUIDs
+    const SignatureDb* db = active_sigdb;
+    for (int i = 0; i < serviceCount; i++) {
+        NimBLEUUID serviceUUID = device->getServiceUUID(i);
+        std::string uuidStr = serviceUUID.toString();
+
+        if (db != NULL) {
+            const SigdbUuid* entry = sigdb_lookup_uuid(db, uuidStr.c_str());
+            if (entry != NULL && (entry->flags & SIGDB_UUID_RAVEN)) {
+                if (detected_service_out != nullptr) {
+                    strncpy(detected_service_out, uuidStr.c_str(), 40);
+                }
+                return true;
+            }
+            continue;
+        }
+
+        if (gen_lookup_raven_service(uuidStr.c_str()) != NULL) {
+            // Match found! Store the detected service UUID if requested
+            if (detected_service_out != nullptr) {
+                strncpy(detected_service_out, uuidStr.c_str(), 40);
+            }
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+// Get a human-readable description of the Raven service
+const char* get_raven_service_description(const char* uuid)
+{
+    if (!uuid) return "Unknown Service";
+
+    const SignatureDb* db = active_sigdb;
+    if (db != NULL) {
+        const SigdbUuid* entry = sigdb_lookup_uuid(db, uuid);
+        return entry != NULL ? sigdb_string(db, entry->desc) : "Unknown Raven Service";
+    }
+
+    const GenRavenService* service = gen_lookup_raven_service(uuid);
+    return service != NULL ? service->description : "Unknown Raven Service";
+}
+
+// Estimate firmware version based on detected service UUIDs: every known
+// service narrows the set of firmware versions that expose all of them
+const char* estimate_raven_firmware_version(NimBLEAdvertisedDevice* device)
+{
+    if (!device || !device->haveServiceUUID()) return "Unknown";
+
+    uint8_t fw_mask = (1 << GEN_RAVEN_FIRMWARE_COUNT) - 1;
+    bool any_known = false;
+
+    int serviceCount = device->getServiceUUIDCount();
+    for (int i = 0; i < serviceCount; i++) {
+        NimBLEUUID serviceUUID = device->getServiceUUID(i);
+        std::string uuidStr = serviceUUID.toString();
+
+        const GenRavenService* service = gen_lookup_raven_service(uuidStr.c_str());
+        if (service != NULL && service->fw_mask != 0) {
+            fw_mask &= service->fw_mask;
+            any_known = true;
+        }
+    }
+
+    return any_known ? GEN_RAVEN_FIRMWARE_BY_MASK[fw_mask] : "Unknown Version";
+}
+
+// ============================================================================
+// RAVEN GATT INTERROGATION
+// ============================================================================
+//
+// With 'config gatt on', a Raven detection queues the unit for a GATT read of
+// the characteristics in datasets/raven_configurations.json (serial, model,
+// firmware, GPS, battery, LTE status...), limited to the groups selected by
+// 'gatt_groups'. Results are printed as a {"type":"raven_gatt"} JSON line,
+// appended to the detection log as EVENT_GATT_VALUE records and kept for
+// the 'gatt' command.
+//
+// Scanning always has priority:
+//   - GATT_POOL_SIZE worker tasks, each owning one NimBLEClient, take jobs
+//     from a short queue. A full queue drops the request, a unit is not
+//     read again within GATT_REFRESH_MS. The pool is created the first time
+//     'gatt' is on and then kept (idle while off), so it costs nothing
+//     until used
+//   - Starting a connection conflicts with an active scan, so workers
+//     connect one at a time and only in the gap between two BLE scans,
+//     with a connect timeout that ends well before the next scan is due
+//   - Once connected, scanning goes on alongside a slow connection interval
+//   - A one-shot timer disconnects an interrogation after GATT_TIMEOUT_MS;
+//     that also releases a worker blocked in a read
+
+#define GATT_POOL_SIZE 2                // Concurrent interrogations
+#define GATT_QUEUE_LENGTH 4
+#define GATT_TASK_STACK 4096
+#define GATT_TASK_PRIORITY 2            // Below detect, above ui
+#define GATT_CONNECT_TIMEOUT_S 2
+#define GATT_SCAN_MARGIN_MS 500         // Keep this clear of the next scan
+#define GATT_WAIT_MS 30000              // Give up on a job that finds no scan gap
+#define GATT_TIMEOUT_MS 15000           // Whole interrogation, connect included
+#define GATT_REFRESH_MS 600000          // Don't re-read a unit more often
+#define GATT_RESULT_SLOTS 4
+#define GATT_MAX_VALUES 16
+#define GATT_VALUE_MAX 24               // Bytes kept per value (printable text, else hex)
+
+enum GattState {
+    GATT_FREE = 0,
+    GATT_QUEUED,
+    GATT_RUNNING,
+    GATT_DONE,
+    GATT_FAILED
+};
+
+static const char* const gatt_mode_names[] = { "off", "on" };
+static const char* const gatt_state_names[] = { "free", "queued", "running", "done", "failed" };
+
+struct GattJob {
+    char address[18];           // Over-the-air address to connect to
+    uint8_t addr_type;
+    int slot;                   // Result slot
+};
+
+struct GattValue {
+    uint8_t characteristic;     // Index into GEN_RAVEN_CHARACTERISTICS
+    char value[GATT_VALUE_MAX + 1];
+};
+
+struct GattResult {
+    uint8_t mac[6];             // Device identity, as in detections
+    uint8_t state;              // GattState
+    const char* error;
+    unsigned long updated_ms;
+    uint8_t value_count;
+    GattValue values[GATT_MAX_VALUES];
+};
+
+static GattResult gatt_results[GATT_RESULT_SLOTS];     // Under gatt_mutex
+static QueueHandle_t gatt_queue = NULL;
+static SemaphoreHandle_t gatt_mutex = NULL;
+static SemaphoreHandle_t gatt_connect_mutex = NULL;     // One connection attempt at a time
+static uint32_t gatt_requests_dropped = 0;
+static TaskHandle_t gatt_task_handles[GATT_POOL_SIZE];
+
+static uint8_t gatt_service_group(const GenRavenService* service)
+{
+    uint16_t short_uuid = (service->uuid[2] << 8) | service->uuid[3];
+    switch (short_uuid) {
+        case 0x180A: return GATT_GROUP_IDENTITY;
+        case 0x1819: case 0x3100: return GATT_GROUP_GPS;
+        case 0x1809: case 0x3200: return GATT_GROUP_POWER;
+        case 0x3300: return GATT_GROUP_NETWORK;
+        case 0x3400: return GATT_GROUP_UPLOADS;
+        case 0x3500: return GATT_GROUP_ERRORS;
+    }
+    return 0;
+}
+
+static void gatt_uuid_string(const uint8_t* uuid, char* out)
+{
+    snprintf(out, 37, "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
+             uuid[0], uuid[1], uuid[2], uuid[3], uuid[4], uuid[5], uuid[6], uuid[7],
+             uuid[8], uuid[9], uuid[10], uuid[11], uuid[12], uuid[13], uuid[14], uuid[15]);
+}
+
+// Printable values as text, anything else as hex, truncated
+static void gatt_format_value(const std::string& raw, char* out)
+{
+    bool printable = !raw.empty();
+    for (char c : raw) {
+        if ((c < 0x20 || c > 0x7E) && c != '\0') {
+            printable = false;
+            break;
+        }
+    }
+    if (printable) {
+        strncpy(out, raw.c_str(), GATT_VALUE_MAX);
+        out[GATT_VALUE_MAX] = '\0';
+        return;
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < raw.size() && n + 2 <= GATT_VALUE_MAX; i++) {
+        n += snprintf(out + n, 3, "%02x", (uint8_t)raw[i]);
+    }
+    out[n] = '\0';
+}
+
+// Detect task, on a full Raven detection. Never blocks
+void gatt_request(const uint8_t* air_mac, uint8_t addr_type, const uint8_t* identity)
+{
+    if (gatt_mode == GATT_OFF || gatt_queue == NULL) {
+        return;
+    }
+    unsigned long now = millis();
+    xSemaphoreTake(gatt_mutex, portMAX_DELAY);
+    int slot = -1;
+    for (int i = 0; i < GATT_RESULT_SLOTS; i++) {
+        GattResult& r = gatt_results[i];
+        if (r.state != GATT_FREE && memcmp(r.mac, identity, 6) == 0) {
+            if (r.state == GATT_QUEUED || r.state == GATT_RUNNING || now - r.updated_ms < GATT_REFRESH_MS) {
+                xSemaphoreGive(gatt_mutex);
+                return;
+            }
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        // Free slot, else the oldest finished one
+        for (int i = 0; i < GATT_RESULT_SLOTS; i++) {
+            const GattResult& r = gatt_results[i];
+            if (r.state == GATT_QUEUED || r.state == GATT_RUNNING) continue;
+            if (slot < 0 || r.state == GATT_FREE ||
+                (gatt_results[slot].state != GATT_FREE && r.updated_ms < gatt_results[slot].updated_ms)) {
+                slot = i;
+            }
+        }
+    }
+    GattJob job;
+    snprintf(job.address, sizeof(job.address), "%02x:%02x:%02x:%02x:%02x:%02x",
+             air_mac[0], air_mac[1], air_mac[2], air_mac[3], air_mac[4], air_mac[5]);
+    job.addr_type = addr_type;
+    job.slot = slot;
+    if (slot < 0 || xQueueSend(gatt_queue, &job, 0) != pdTRUE) {
+        gatt_requests_dropped++;
+        xSemaphoreGive(gatt_mutex);
+        return;
+    }
+    GattResult& r = gatt_results[slot];
+    memcpy(r.mac, identity, 6);
+    r.state = GATT_QUEUED;
+    r.error = NULL;
+    r.updated_ms = now;
+    r.value_count = 0;
+    xSemaphoreGive(gatt_mutex);
+}
+
+// A connection attempt may start now and time out before the next BLE scan
+static bool gatt_scan_gap()
+{
+    if (pBLEScan->isScanning()) {
+        return false;
+    }
+    unsigned long since_scan = millis() - last_ble_scan;
+    return since_scan + GATT_CONNECT_TIMEOUT_S * 1000 + GATT_SCAN_MARGIN_MS < (unsigned long)ble_scan_interval_ms;
+}
+
+static void gatt_watchdog_callback(TimerHandle_t timer)
+{
+    NimBLEClient* client = (NimBLEClient*)pvTimerGetTimerID(timer);
+    if (client->isConnected()) {
+        client->disconnect();
+    }
+}
+
+static void gatt_finish(int slot, const char* error)
+{
+    DetectionEvent rec = {};
+    rec.source = EVENT_GATT_VALUE;
+    DynamicJsonDocument doc(2048);
+
+    xSemaphoreTake(gatt_mutex, portMAX_DELAY);
+    GattResult& r = gatt_results[slot];
+    r.state = error ? GATT_FAILED : GATT_DONE;
+    r.error = error;
+    r.updated_ms = millis();
+    char mac_str[18];
+    snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x:%02x:%02x:%02x",
+             r.mac[0], r.mac[1], r.mac[2], r.mac[3], r.mac[4], r.mac[5]);
+    memcpy(rec.mac, r.mac, 6);
+    doc["type"] = "raven_gatt";
+    doc["mac_address"] = mac_str;
+    if (error) {
+        doc["error"] = error;
+    }
+    JsonObject values = doc.createNestedObject("values");
+    for (int i = 0; i < r.value_count; i++) {
+        const GattValue& v = r.values[i];
+        const char* name = GEN_RAVEN_CHARACTERISTICS[v.characteristic].name;
+        values[name] = v.value;
+        snprintf(rec.text, sizeof(rec.text), "%s=%s", name, v.value);
+        log_append(rec, RAVEN);
+    }
+    xSemaphoreGive(gatt_mutex);
+
+    String json_output;
+    serializeJson(doc, json_output);
+    Serial.println(json_output);
+}
+
+static void gatt_interrogate(NimBLEClient* client, TimerHandle_t watchdog, const GattJob& job)
+{
+    xSemaphoreTake(gatt_mutex, portMAX_DELAY);
+    gatt_results[job.slot].state = GATT_RUNNING;
+    xSemaphoreGive(gatt_mutex);
+
+    // Wait for a gap between scans
+    unsigned long start = millis();
+    xSemaphoreTake(gatt_connect_mutex, portMAX_DELAY);
+    while (!gatt_scan_gap()) {
+        if (millis() - start > GATT_WAIT_MS) {
+            xSemaphoreGive(gatt_connect_mutex);
+            gatt_finish(job.slot, "no gap between BLE scans");
+            return;
+        }
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    xTimerChangePeriod(watchdog, pdMS_TO_TICKS(GATT_TIMEOUT_MS), 0);
+    bool connected = client->connect(NimBLEAddress(std::string(job.address), job.addr_type), true);
+    xSemaphoreGive(gatt_connect_mutex);
+    if (!connected) {
+        xTimerStop(watchdog, 0);
+        gatt_finish(job.slot, "connect failed");
+        return;
+    }
+
+    int last_service = -1;
+    NimBLERemoteService* service = NULL;
+    for (size_t i = 0; i < sizeof(GEN_RAVEN_CHARACTERISTICS) / sizeof(GEN_RAVEN_CHARACTERISTICS[0]); i++) {
+        const GenRavenCharacteristic& c = GEN_RAVEN_CHARACTERISTICS[i];
+        if (!(gatt_service_group(&GEN_RAVEN_SERVICES[c.service]) & gatt_groups)) continue;
+        if (!client->isConnected()) break;
+        char uuid[37];
+        if (c.service != last_service) {
+            gatt_uuid_string(GEN_RAVEN_SERVICES[c.service].uuid, uuid);
+            service = client->getService(NimBLEUUID(uuid));
+            last_service = c.service;
+        }
+        if (service == NULL) continue;
+        gatt_uuid_string(c.uuid, uuid);
+        NimBLERemoteCharacteristic* chr = service->getCharacteristic(NimBLEUUID(uuid));
+        if (chr == NULL || !chr->canRead()) continue;
+        std::string raw = chr->readValue();
+        if (!client->isConnected()) break;
+
+        xSemaphoreTake(gatt_mutex, portMAX_DELAY);
+        GattResult& r = gatt_results[job.slot];
+        if (r.value_count < GATT_MAX_VALUES) {
+            GattValue& v = r.values[r.value_count++];
+            v.characteristic = i;
+            gatt_format_value(raw, v.value);
+        }
+        xSemaphoreGive(gatt_mutex);
+    }
+    bool timed_out = !client->isConnected();
+    client->disconnect();
+    xTimerStop(watchdog, 0);
+    gatt_finish(job.slot, timed_out ? "timeout or disconnected" : NULL);
+}
+
+void gatt_task(void* param)
+{
+    NimBLEClient* client = NimBLEDevice::createClient();
+    client->setConnectTimeout(GATT_CONNECT_TIMEOUT_S);
+    // 50-100 ms connection interval, 4 s supervision timeout: leaves the
+    // radio to the scanner most of the time
+    client->setConnectionParams(40, 80, 0, 400);
+    TimerHandle_t watchdog = xTimerCreate("gatt_wd", pdMS_TO_TICKS(GATT_TIMEOUT_MS), pdFALSE,
+                                          client, gatt_watchdog_callback);
+    GattJob job;
+    for (;;) {
+        if (xQueueReceive(gatt_queue, &job, portMAX_DELAY) == pdTRUE) {
+            gatt_interrogate(client, watchdog, job);
+        }
+    }
+}
+
+// Worker tasks, on the first switch to 'gatt on' (ui task, or setup)
+static void gatt_start_pool()
+{
+    if (gatt_mode == GATT_OFF || gatt_queue == NULL || gatt_task_handles[0] != NULL) {
+        return;
+    }
+    for (int i = 0; i < GATT_POOL_SIZE; i++) {
+        xTaskCreatePinnedToCore(gatt_task, "gatt", GATT_TASK_STACK, NULL,
+                                GATT_TASK_PRIORITY, &gatt_task_handles[i], DETECT_TASK_CORE);
+    }
+    printf("[GATT] Started %d interrogation workers\n", GATT_POOL_SIZE);
+}
+
+// After NimBLEDevice::init()
+void gatt_init()
+{
+    gatt_queue = xQueueCreate(GATT_QUEUE_LENGTH, sizeof(GattJob));
+    gatt_mutex = xSemaphoreCreateMutex();
+    gatt_connect_mutex = xSemaphoreCreateMutex();
+    gatt_start_pool();
+}
+
+void print_gatt_results()
+{
+    unsigned long now = millis();
+    printf("\n=== RAVEN GATT ===\n");
+    printf("Mode: %s  groups: 0x%02lx  dropped requests: %lu\n", gatt_mode_names[gatt_mode],
+           (unsigned long)gatt_groups, (unsigned long)gatt_requests_dropped);
+    xSemaphoreTake(gatt_mutex, portMAX_DELAY);
+    for (int i = 0; i < GATT_RESULT_SLOTS; i++) {
+        const GattResult& r = gatt_results[i];
+        if (r.state == GATT_FREE) continue;
+        printf("%02x:%02x:%02x:%02x:%02x:%02x  %s%s%s  %lus ago\n", r.mac[0], r.mac[1], r.mac[2],
+               r.mac[3], r.mac[4], r.mac[5], gatt_state_names[r.state], r.error ? ": " : "",
+               r.error ? r.error : "", (now - r.updated_ms) / 1000);
+        for (int k = 0; k < r.value_count; k++) {
+            printf("  %-28s %s\n", GEN_RAVEN_CHARACTERISTICS[r.values[k].characteristic].name,
+                   r.values[k].value);
+        }
+    }
+    xSemaphoreGive(gatt_mutex);
+    printf("==================\n\n");
+}
+
+// ============================================================================
+// PCAP CAPTURE (USB serial)
+// ============================================================================
+//
+// 'capture matched' streams every WiFi frame that produced a detection event,
+// 'capture mgmt' every management frame the radio hears, as a pcap file with
+// radiotap headers. tools/pcap_capture.py starts a capture and writes the
+// .pcap on the host.
+//
+//   - The promiscuous callback writes the pcap record header, the radiotap
+//     header and the frame (truncated to the snap length) straight into one
+//     of two chunk buffers. The ui task sends a full buffer to Serial in one
+//     write while the callback fills the other, so a frame is copied once
+//   - If both buffers are taken the frame is dropped and counted. Every
+//     chunk carries the running drop count, so loss shows up in the stream
+//   - Chunks are framed like detection log records (magic, sequence number,
+//     CRC32), so JSON lines printed in between are skipped by the reader
+//   - A partly filled buffer goes out after CAPTURE_FLUSH_MS
+//
+// The first chunk of a capture starts with the pcap file header. Records
+// never span chunks. Timestamps are microseconds since boot.
+
+#define CAPTURE_CHUNK_SIZE 4096         // Bytes per Serial write, header included
+#define CAPTURE_FLUSH_MS 200            // Longest a captured frame waits in a buffer
+#define CAPTURE_MAX_SNAPLEN 2400        // Longest 802.11 management frame plus FCS
+#define CAPTURE_DEFAULT_SNAPLEN 256     // Headers and the usual IEs
+#define CAPTURE_CHUNK_MAGIC 0x5046      // "FP"
+#define CAPTURE_CHUNK_START 0x01        // First chunk of a capture (has the pcap file header)
+#define SERIAL_TX_BUFFER_SIZE 8192      // Two capture chunks
+
+enum CaptureMode {
+    CAPTURE_OFF = 0,
+    CAPTURE_MATCHED = 1,    // Frames that produced a detection event
+    CAPTURE_MGMT = 2        // Every management frame
+};
+static const char* const capture_mode_names[] = { "off", "matched", "mgmt" };
+
+struct __attribute__((packed)) CaptureChunkHeader {
+    uint16_t magic;
+    uint8_t flags;              // CAPTURE_CHUNK_*
+    uint8_t reserved;
+    uint16_t len;               // Payload bytes
+    uint16_t frames;            // Records in the payload
+    uint32_t seq;               // Chunk number since the capture started
+    uint32_t dropped;           // Frames dropped since the capture started
+    uint32_t crc;               // CRC32 over the preceding header bytes and the payload
+};
+
+struct CaptureChunk {
+    CaptureChunkHeader header;
+    uint8_t payload[CAPTURE_CHUNK_SIZE - sizeof(CaptureChunkHeader)];
+};
+
+struct __attribute__((packed)) PcapFileHeader {
+    uint32_t magic;             // 0xA1B2C3D4, microsecond timestamps
+    uint16_t version_major;
+    uint16_t version_minor;
+    int32_t thiszone;
+    uint32_t sigfigs;
+    uint32_t snaplen;
+    uint32_t network;           // 127 = LINKTYPE_IEEE802_11_RADIOTAP
+};
+
+struct __attribute__((packed)) PcapRecordHeader {
+    uint32_t ts_sec;
+    uint32_t ts_usec;
+    uint32_t incl_len;
+    uint32_t orig_len;
+};
+
+// Radiotap fields in present-bit order, each naturally aligned
+#define RADIOTAP_PRESENT ((1u << 1) | (1u << 2) | (1u << 3) | (1u << 5) | (1u << 6))
+#define RADIOTAP_FLAG_FCS 0x10
+#define RADIOTAP_CHAN_CCK 0x0020
+#define RADIOTAP_CHAN_OFDM 0x0040
+#define RADIOTAP_CHAN_2GHZ 0x0080
+
+struct __attribute__((packed)) CaptureRadiotap {
+    uint8_t version;
+    uint8_t pad;
+    uint16_t len;
+    uint32_t present;           // RADIOTAP_PRESENT
+    uint8_t flags;              // RADIOTAP_FLAG_FCS when the frame still ends with its FCS
+    uint8_t rate;               // 500 kb/s units, 0 for HT frames
+    uint16_t channel_freq;      // MHz
+    uint16_t channel_flags;
+    int8_t antenna_signal;      // dBm
+    int8_t antenna_noise;       // dBm
+};
+static_assert(sizeof(CaptureRadiotap) == 16, "radiotap header layout");
+
+#define CAPTURE_RECORD_OVERHEAD (sizeof(PcapRecordHeader) + sizeof(CaptureRadiotap))
+static_assert(sizeof(PcapFileHeader) + CAPTURE_RECORD_OVERHEAD + CAPTURE_MAX_SNAPLEN <=
+              sizeof(((CaptureChunk*)0)->payload), "a full-length frame must fit in an empty chunk");
+
+// Legacy rx_ctrl.rate codes to 500 kb/s units
+static const uint8_t capture_rate_units[16] = {
+    2, 4, 11, 22, 2, 4, 11, 22, 96, 48, 24, 12, 108, 72, 36, 18
+};
+
+// Both buffers are allocated by the first 'capture' command
+static CaptureChunk* capture_bufs = NULL;
+static portMUX_TYPE capture_mux = portMUX_INITIALIZER_UNLOCKED;  // Guards everything below
+static volatile uint8_t capture_mode = CAPTURE_OFF;
+static uint16_t capture_snaplen = CAPTURE_DEFAULT_SNAPLEN;
+static uint8_t capture_fill = 0;            // Buffer the callback appends to
+static uint16_t capture_used[2];            // Payload bytes; the non-fill buffer is ready when > 0
+static uint16_t capture_chunk_frames[2];
+static uint32_t capture_fill_ms = 0;        // When the fill buffer got its first record
+static uint32_t capture_frames = 0;         // Frames written to a buffer
+static uint32_t capture_dropped = 0;        // Frames lost because both buffers were taken
+
+// Written only by the ui task
+static uint32_t capture_seq = 0;
+static uint32_t capture_bytes_sent = 0;
+
+// WiFi driver task: append one frame to the fill buffer, never blocks
+static void capture_frame(const wifi_promiscuous_pkt_t* ppkt)
+{
+    uint32_t orig_len = ppkt->rx_ctrl.sig_len;
+    uint32_t incl_len = min(orig_len, (uint32_t)capture_snaplen);
+    uint32_t record_len = CAPTURE_RECORD_OVERHEAD + incl_len;
+    int64_t now_us = esp_timer_get_time();
+    bool handed_over = false;
+
+    portENTER_CRITICAL(&capture_mux);
+    if (capture_mode == CAPTURE_OFF) {
+        portEXIT_CRITICAL(&capture_mux);
+        return;
+    }
+    uint8_t fill = capture_fill;
+    if (capture_used[fill] + record_len > sizeof(capture_bufs[fill].payload)) {
+        if (capture_used[fill ^ 1] > 0) {
+            // The ui task is still sending the other buffer
+            capture_dropped++;
+            portEXIT_CRITICAL(&capture_mux);
+            return;
+        }
+        fill ^= 1;
+        capture_fill = fill;
+        handed_over = true;
+    }
+    if (capture_used[fill] == 0) {
+        capture_fill_ms = (uint32_t)(now_us / 1000);
+    }
+
+    uint8_t* p = capture_bufs[fill].payload + capture_used[fill];
+    PcapRecordHeader* rec = (PcapRecordHeader*)p;
+    rec->ts_sec = (uint32_t)(now_us / 1000000);
+    rec->ts_usec = (uint32_t)(now_us % 1000000);
+    rec->incl_len = sizeof(CaptureRadiotap) + incl_len;
+    rec->orig_len = sizeof(CaptureRadiotap) + orig_len;
+
+    CaptureRadiotap* rt = (CaptureRadiotap*)(p + sizeof(PcapRecordHeader));
+    uint8_t channel = ppkt->rx_ctrl.channel;
+    bool legacy = ppkt->rx_ctrl.sig_mode == 0;
+    rt->version = 0;
+    rt->pad = 0;
+    rt->len = sizeof(CaptureRadiotap);
+    rt->present = RADIOTAP_PRESENT;
+    rt->flags = incl_len == orig_len ? RADIOTAP_FLAG_FCS : 0;
+    rt->rate = legacy ? capture_rate_units[ppkt->rx_ctrl.rate & 0x0F] : 0;
+    rt->channel_freq = channel == 14 ? 2484 : 2407 + 5 * channel;
+    rt->channel_flags = RADIOTAP_CHAN_2GHZ |
+                        (legacy && (ppkt->rx_ctrl.rate & 0x0F) < 8 ? RADIOTAP_CHAN_CCK : RADIOTAP_CHAN_OFDM);
+    rt->antenna_signal = ppkt->rx_ctrl.rssi;
+    rt->antenna_noise = ppkt->rx_ctrl.noise_floor;
+
+    memcpy(p + CAPTURE_RECORD_OVERHEAD, ppkt->payload, incl_len);
+    capture_used[fill] += record_len;
+    capture_chunk_frames[fill]++;
+    capture_frames++;
+    portEXIT_CRITICAL(&capture_mux);
+
+    if (handed_over && ui_task_handle != NULL) {
+        xTaskNotify(ui_task_handle, NOTIFY_CAPTURE, eSetBits);
+    }
+}
+
+// Index of a buffer ready to send, -1 if none. force also hands over a
+// partly filled buffer, as long as the other one is free.
+static int capture_take_ready(bool force)
+{
+    int ready = -1;
+    portENTER_CRITICAL(&capture_mux);
+    uint8_t other = capture_fill ^ 1;
+    if (capture_used[other] > 0) {
+        ready = other;
+    } else if (force && capture_used[capture_fill] > 0) {
+        ready = capture_fill;
+        capture_fill = other;
+    }
+    portEXIT_CRITICAL(&capture_mux);
+    return ready;
+}
+
+// Frame a ready buffer and write it in one go, then give it back to the callback
+static void capture_send(int i)
+{
+    CaptureChunk* chunk = &capture_bufs[i];
+    CaptureChunkHeader* h = &chunk->header;
+    h->magic = CAPTURE_CHUNK_MAGIC;
+    h->flags = capture_seq == 0 ? CAPTURE_CHUNK_START : 0;
+    h->reserved = 0;
+    h->len = capture_used[i];
+    h->frames = capture_chunk_frames[i];
+    h->seq = capture_seq++;
+    h->dropped = capture_dropped;
+    h->crc = esp_rom_crc32_le(esp_rom_crc32_le(0, (const uint8_t*)h, offsetof(CaptureChunkHeader, crc)),
+                              chunk->payload, h->len);
+    Serial.write((const uint8_t*)chunk, sizeof(CaptureChunkHeader) + h->len);
+    capture_bytes_sent += sizeof(CaptureChunkHeader) + h->len;
+
+    portENTER_CRITICAL(&capture_mux);
+    capture_used[i] = 0;
+    capture_chunk_frames[i] = 0;
+    portEXIT_CRITICAL(&capture_mux);
+}
+
+// Ui task: send full buffers, and a partly filled one once it is old enough
+void continue_capture()
+{
+    if (capture_bufs == NULL) {
+        return;
+    }
+    bool force = capture_mode == CAPTURE_OFF || millis() - capture_fill_ms >= CAPTURE_FLUSH_MS;
+    for (int n = 0; n < 2; n++) {
+        int ready = capture_take_ready(force);
+        if (ready < 0) {
+            break;
+        }
+        capture_send(ready);
+    }
+}
+
+// Starts a capture, or changes the mode and snap length of the running one
+bool capture_start(uint8_t mode, uint16_t snaplen)
+{
+    if (capture_bufs == NULL) {
+        capture_bufs = (CaptureChunk*)malloc(2 * sizeof(CaptureChunk));
+        if (capture_bufs == NULL) {
+            return false;
+        }
+    }
+    portENTER_CRITICAL(&capture_mux);
+    if (capture_mode == CAPTURE_OFF) {
+        // Buffers are empty: capture_stop() sent everything
+        PcapFileHeader fh = { 0xA1B2C3D4, 2, 4, 0, 0, sizeof(CaptureRadiotap) + CAPTURE_MAX_SNAPLEN, 127 };
+        capture_fill = 0;
+        memcpy(capture_bufs[0].payload, &fh, sizeof(fh));
+        capture_used[0] = sizeof(fh);
+        capture_fill_ms = millis();
+        capture_frames = 0;
+        capture_dropped = 0;
+        capture_seq = 0;
+        capture_bytes_sent = 0;
+    }
+    capture_snaplen = snaplen;
+    capture_mode = mode;
+    portEXIT_CRITICAL(&capture_mux);
+    return true;
+}
+
+// Stops capturing and sends whatever is still buffered (ui task)
+void capture_stop()
+{
+    portENTER_CRITICAL(&capture_mux);
+    capture_mode = CAPTURE_OFF;
+    portEXIT_CRITICAL(&capture_mux);
+    continue_capture();
+}
+
+void print_capture_stats()
+{
+    printf("[CAPTURE] Mode: %s, snaplen %u, %lu frames, %lu dropped, %lu chunks, %lu bytes\n",
+           capture_mode_names[capture_mode], (unsigned)capture_snaplen, (unsigned long)capture_frames,
+           (unsigned long)capture_dropped, (unsigned long)capture_seq, (unsigned long)capture_bytes_sent);
+}
+
+// ============================================================================
+// CHANNEL SURVEY
+// ============================================================================
+//
+// With 'config survey report' the callback also counts every frame the radio
+// hears, and the driver filter lets data and control frames through. Each
+// channel keeps cumulative counters: frames by type and subtype, estimated
+// airtime and an RSSI histogram. It also keeps a bitmap of beaconing BSSIDs
+// for the current window. Only the WiFi task writes the counters and the radio
+// task adds dwell time, so no locks are needed. Every survey_ms the ui task
+// turns the change since the last report into a compact report on Serial (JSON)
+// and BLE (CTRL_SURVEY telemetry).
+//
+// 'config survey hop' also lets the report steer the hopper: each channel's
+// dwell is weighted by BSSIDs seen plus the dataset channel prior, and the
+// weights are normalised so a full cycle still takes about 13 * hop_ms.
+// Airtime is preamble plus payload at the received rate. It leaves out
+// SIFS, ACKs and frames the radio missed, so it understates load somewhat.
+
+#define SURVEY_RSSI_BUCKETS 8           // 10 dB wide, from <= -91 to >= -30 dBm
+#define SURVEY_BSSID_BITS 256           // Linear counting bitmap per channel
+#define SURVEY_WEIGHT_BASE 4            // Dwell weight of an empty channel
+#define SURVEY_WEIGHT_MAX_BSSIDS 32     // BSSIDs beyond this add no dwell
+
+enum SurveyFrameType {
+    SURVEY_MGMT = 0,
+    SURVEY_CTRL = 1,
+    SURVEY_DATA = 2,
+    SURVEY_TYPES = 3
+};
+
+struct SurveyChannel {
+    uint32_t frames[SURVEY_TYPES][16];  // By type and subtype
+    uint32_t airtime_us;                // Wraps; reports use differences
+    uint32_t dwell_us;                  // Radio task
+    uint32_t rssi_hist[SURVEY_RSSI_BUCKETS];
+    uint32_t bssid_bitmap[SURVEY_BSSID_BITS / 32];  // Cleared by each report
+};
+
+// Totals at the previous report
+struct SurveyBaseline {
+    uint32_t frames[SURVEY_TYPES];
+    uint32_t airtime_us;
+    uint32_t dwell_us;
+    uint32_t rssi_hist[SURVEY_RSSI_BUCKETS];
+};
+
+// One report window per channel
+struct SurveyReport {
+    uint32_t frames[SURVEY_TYPES];
+    uint32_t dwell_ms;
+    uint16_t busy_permille;
+    uint16_t bssids;
+    uint32_t rssi_hist[SURVEY_RSSI_BUCKETS];
+};
+
+// HT MCS 0-7, 20 MHz long GI, in 100 kb/s units
+static const uint16_t survey_ht_rate[8] = { 65, 130, 195, 260, 390, 520, 585, 650 };
+
+static const char* const survey_mode_names[] = { "off", "report", "hop" };
+
+static const char* const survey_mgmt_names[16] = {
+    "assoc_req", "assoc_resp", "reassoc_req", "reassoc_resp", "probe_req", "probe_resp",
+    "timing_adv", "mgmt_7", "beacon", "atim", "disassoc", "auth", "deauth", "action",
+    "action_noack", "mgmt_15"
+};
+
+static SurveyChannel survey[MAX_CHANNEL + 1];          // Index = channel, 0 = anything else
+static SurveyBaseline survey_baseline[MAX_CHANNEL + 1];
+static SurveyReport survey_report[MAX_CHANNEL + 1];
+static uint32_t survey_report_window_ms = 0;           // 0 = no report yet
+static uint32_t survey_last_report_ms = 0;
+static uint16_t survey_dwell_ms[MAX_CHANNEL + 1];      // Hop dwell per channel (survey hop)
+static uint32_t survey_hop_us = 0;                     // When the radio last changed channel
+static volatile bool control_survey_due = false;       // BLE telemetry pending
+
+static inline uint32_t survey_bssid_hash(const uint8_t* mac)
+{
+    uint32_t lo = ((uint32_t)mac[3] << 16) | ((uint32_t)mac[4] << 8) | mac[5];
+    return ((mac_to_oui(mac) * 0x9E3779B1u) ^ (lo * 0x85EBCA6Bu)) >> 24;
+}
+
+// WiFi driver task, every frame while the survey is on
+static void survey_count(const wifi_promiscuous_pkt_t* ppkt, wifi_promiscuous_pkt_type_t type)
+{
+    if (type > WIFI_PKT_DATA) {
+        return;  // WIFI_PKT_MISC: no usable header
+    }
+    uint8_t channel = ppkt->rx_ctrl.channel;
+    SurveyChannel* s = &survey[channel <= MAX_CHANNEL ? channel : 0];
+    uint8_t subtype = ppkt->payload[0] >> 4;
+    s->frames[type][subtype]++;
+
+    // Airtime: preamble plus payload at the received rate (100 kb/s units)
+    uint32_t rate, preamble_us;
+    if (ppkt->rx_ctrl.sig_mode == 0) {
+        uint8_t code = ppkt->rx_ctrl.rate & 0x0F;
+        rate = capture_rate_units[code] * 5;
+        preamble_us = code < 8 ? 192 : 20;  // CCK long preamble, OFDM
+    } else {
+        uint8_t mcs = ppkt->rx_ctrl.mcs;
+        rate = survey_ht_rate[mcs & 7] * ((mcs >> 3) + 1) * (ppkt->rx_ctrl.cwb ? 2 : 1);
+        preamble_us = 36;   // HT mixed format
+    }
+    s->airtime_us += preamble_us + ppkt->rx_ctrl.sig_len * 80 / rate;
+
+    int bucket = (ppkt->rx_ctrl.rssi + 100) / 10;
+    s->rssi_hist[bucket < 0 ? 0 : (bucket >= SURVEY_RSSI_BUCKETS ? SURVEY_RSSI_BUCKETS - 1 : bucket)]++;
+
+    if (type == WIFI_PKT_MGMT && subtype == 8 && ppkt->rx_ctrl.sig_len >= 24) {
+        uint32_t h = survey_bssid_hash(ppkt->payload + 16);  // addr3 = BSSID
+        s->bssid_bitmap[h >> 5] |= 1u << (h & 31);
+    }
+}
+
+// Radio task: credit the time spent on the channel being left
+static void survey_note_hop(uint8_t leaving)
+{
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+    survey[leaving].dwell_us += now_us - survey_hop_us;
+    survey_hop_us = now_us;
+}
+
+// Start the next window from the current totals
+static void survey_take_baseline()
+{
+    for (int c = 0; c <= MAX_CHANNEL; c++) {
+        SurveyBaseline& b = survey_baseline[c];
+        for (int t = 0; t < SURVEY_TYPES; t++) {
+            b.frames[t] = 0;
+            for (int st = 0; st < 16; st++) {
+                b.frames[t] += survey[c].frames[t][st];
+            }
+        }
+        b.airtime_us = survey[c].airtime_us;
+        b.dwell_us = survey[c].dwell_us;
+        memcpy(b.rssi_hist, survey[c].rssi_hist, sizeof(b.rssi_hist));
+        memset(survey[c].bssid_bitmap, 0, sizeof(survey[c].bssid_bitmap));
+    }
+    survey_last_report_ms = millis();
+}
+
+// Distinct BSSIDs from the share of bits still clear (linear counting)
+static uint16_t survey_estimate_bssids(const uint32_t* bitmap)
+{
+    int set = 0;
+    for (int i = 0; i < SURVEY_BSSID_BITS / 32; i++) {
+        set += __builtin_popcount(bitmap[i]);
+    }
+    if (set == 0) {
+        return 0;
+    }
+    int clear = max(SURVEY_BSSID_BITS - set, 1);
+    return (uint16_t)lroundf(SURVEY_BSSID_BITS * logf((float)SURVEY_BSSID_BITS / clear));
+}
+
+// Dwell per channel for 'survey hop', from the last report
+static void survey_update_dwell()
+{
+    uint32_t weight[MAX_CHANNEL + 1];
+    uint32_t total = 0;
+    for (int c = 1; c <= MAX_CHANNEL; c++) {
+        weight[c] = SURVEY_WEIGHT_BASE + min(survey_report[c].bssids, (uint16_t)SURVEY_WEIGHT_MAX_BSSIDS) +
+                    score_log2(1 + GEN_DATASET_CHANNEL_COUNTS[c]);
+        total += weight[c];
+    }
+    for (int c = 1; c <= MAX_CHANNEL; c++) {
+        uint32_t ms = (uint32_t)hop_interval_ms * MAX_CHANNEL * weight[c] / total;
+        survey_dwell_ms[c] = min(max(ms, (uint32_t)hop_interval_ms / 4), (uint32_t)hop_interval_ms * 3);
+    }
+}
+
+static void survey_reset_dwell()
+{
+    for (int c = 0; c <= MAX_CHANNEL; c++) {
+        survey_dwell_ms[c] = hop_interval_ms;
+    }
+}
+
+// Ui task, every survey_ms: close the window and send the report
+void survey_send_report()
+{
+    unsigned long now = millis();
+    survey_report_window_ms = now - survey_last_report_ms;
+    for (int c = 0; c <= MAX_CHANNEL; c++) {
+        const SurveyChannel& s = survey[c];
+        const SurveyBaseline& b = survey_baseline[c];
+        SurveyReport& r = survey_report[c];
+        for (int t = 0; t < SURVEY_TYPES; t++) {
+            uint32_t sum = 0;
+            for (int st = 0; st < 16; st++) {
+                sum += s.frames[t][st];
+            }
+            r.frames[t] = sum - b.frames[t];
+        }
+        uint32_t dwell_us = s.dwell_us - b.dwell_us;
+        r.dwell_ms = dwell_us / 1000;
+        r.busy_permille = dwell_us ? min((uint64_t)(s.airtime_us - b.airtime_us) * 1000 / dwell_us, (uint64_t)1000) : 0;
+        r.bssids = survey_estimate_bssids(s.bssid_bitmap);
+        for (int i = 0; i < SURVEY_RSSI_BUCKETS; i++) {
+            r.rssi_hist[i] = s.rssi_hist[i] - b.rssi_hist[i];
+        }
+    }
+    survey_take_baseline();
+    if (survey_mode == SURVEY_HOP) {
+        survey_update_dwell();
+    }
+
+    DynamicJsonDocument doc(4096);
+    doc["type"] = "survey";
+    doc["window_ms"] = survey_report_window_ms;
+    JsonArray channels = doc.createNestedArray("channels");
+    for (int c = 1; c <= MAX_CHANNEL; c++) {
+        const SurveyReport& r = survey_report[c];
+        if (r.dwell_ms == 0) {
+            continue;
+        }
+        JsonObject ch = channels.createNestedObject();
+        ch["ch"] = c;
+        ch["dwell_ms"] = r.dwell_ms;
+        ch["mgmt"] = r.frames[SURVEY_MGMT];
+        ch["ctrl"] = r.frames[SURVEY_CTRL];
+        ch["data"] = r.frames[SURVEY_DATA];
+        ch["busy"] = r.busy_permille;
+        ch["bssids"] = r.bssids;
+        JsonArray hist = ch.createNestedArray("rssi");
+        for (int i = 0; i < SURVEY_RSSI_BUCKETS; i++) {
+            hist.add(r.rssi_hist[i]);
+        }
+    }
+    String json_output;
+    serializeJson(doc, json_output);
+    Serial.println(json_output);
+    control_survey_due = true;
+}
+
+static uint32_t survey_filter_mask()
+{
+    return WIFI_PROMIS_FILTER_MASK_MGMT |
+           (survey_mode != SURVEY_OFF ? WIFI_PROMIS_FILTER_MASK_DATA | WIFI_PROMIS_FILTER_MASK_CTRL : 0);
+}
+
+void print_survey_stats(int channel)
+{
+    if (channel > 0) {
+        // Totals by subtype since boot
+        const SurveyChannel& s = survey[channel];
+        printf("\nChannel %d frames since boot, busy %lu ms of %lu ms on channel\n", channel,
+               (unsigned long)(s.airtime_us / 1000), (unsigned long)(s.dwell_us / 1000));
+        for (int st = 0; st < 16; st++) {
+            if (s.frames[SURVEY_MGMT][st]) {
+                printf("  %-13s %lu\n", survey_mgmt_names[st], (unsigned long)s.frames[SURVEY_MGMT][st]);
+            }
+        }
+        for (int t = SURVEY_CTRL; t <= SURVEY_DATA; t++) {
+            for (int st = 0; st < 16; st++) {
+                if (s.frames[t][st]) {
+                    printf("  %s %-8d %lu\n", t == SURVEY_CTRL ? "ctrl" : "data", st,
+                           (unsigned long)s.frames[t][st]);
+                }
+            }
+        }
+        return;
+    }
+    if (survey_report_window_ms == 0) {
+        printf("[SURVEY] No report yet (%s, every %ld ms)\n", survey_mode_names[survey_mode],
+               (long)survey_report_ms);
+        return;
+    }
+    printf("\nLast %lu ms (%s)\n", (unsigned long)survey_report_window_ms, survey_mode_names[survey_mode]);
+    printf("Ch  Dwell ms   Mgmt   Ctrl   Data  Busy%%  BSSIDs  Hop ms\n");
+    for (int c = 1; c <= MAX_CHANNEL; c++) {
+        const SurveyReport& r = survey_report[c];
+        printf("%2d %9lu %6lu %6lu %6lu %6.1f %7u %7u\n", c, (unsigned long)r.dwell_ms,
+               (unsigned long)r.frames[SURVEY_MGMT], (unsigned long)r.frames[SURVEY_CTRL],
+               (unsigned long)r.frames[SURVEY_DATA], r.busy_permille / 10.0, (unsigned)r.bssids,
+               (unsigned)(survey_mode == SURVEY_HOP ? survey_dwell_ms[c] : hop_interval_ms));
+    }
+    printf("\n");
+}
+
+// ============================================================================
+// PROBE HISTORY
+// ============================================================================
+//
+// Directed probe requests name networks the client has joined before, which
+// ties fleet devices to their home SSIDs. Every client that probes for a
+// named network keeps a short list of them, in fixed memory however many
+// clients are around:
+//
+//   - SSIDs are interned once in a table of PROBE_SSID_SLOTS strings. When
+//     it is full the least recently probed SSID is reclaimed and its
+//     generation bumped, so lists still pointing at it skip it
+//   - Clients live in a PROBE_CLIENTS table, least recently probing evicted.
+//     Each keeps its last PROBE_SSIDS_PER_CLIENT SSIDs as (slot, generation)
+//   - Randomized (locally administered) addresses are skipped: phones probe
+//     from a new one every scan and would only churn the tables
+//
+// Only the WiFi callback changes which client or SSID a slot holds (apart
+// from clear_probe_history), so it looks both up unlocked, comparing hashes
+// first. probe_mux covers just the final update, which rechecks the two
+// slots in case a clear ran in between; readers copy out under the lock.
+//
+// 'devices' shows the SSIDs of detected devices, and a full detection logs
+// those not logged yet as EVENT_PROBED_SSID records.
+
+#define PROBE_SSID_SLOTS 128
+#define PROBE_CLIENTS 64
+#define PROBE_SSIDS_PER_CLIENT 6
+
+struct ProbeSsid {
+    char ssid[33];
+    uint8_t len;
+    uint8_t gen;                // Bumped when the slot is reused
+    uint16_t hash;
+    uint32_t last_used;         // probe_clock of the last probe, 0 = free
+};
+
+struct ProbeClient {
+    uint8_t mac[6];
+    uint16_t hash;              // Of mac
+    uint8_t next;               // Ring position in ssids
+    uint8_t logged;             // Bit per ssids[] entry already in the log
+    uint32_t last_used;         // 0 = free
+    uint16_t ssids[PROBE_SSIDS_PER_CLIENT];   // slot | gen << 8, 0xFFFF = empty
+};
+
+static ProbeSsid probe_ssids[PROBE_SSID_SLOTS];
+static ProbeClient probe_clients[PROBE_CLIENTS];
+static uint32_t probe_clock = 0;
+static uint32_t probe_ssids_reclaimed = 0;
+static portMUX_TYPE probe_mux = portMUX_INITIALIZER_UNLOCKED;
+
+#define PROBE_REF_EMPTY 0xFFFF
+
+static inline uint32_t fnv1a(uint32_t h, const uint8_t* data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ data[i]) * 16777619u;
+    }
+    return h;
+}
+
+static inline uint16_t probe_ssid_hash(const uint8_t* ssid, uint8_t len)
+{
+    uint32_t h = fnv1a(2166136261u, ssid, len);
+    return (uint16_t)(h ^ (h >> 16));
+}
+
+// Slot holding an SSID, or the least recently used one to reclaim.
+// WiFi task, unlocked
+static int probe_find_ssid(const uint8_t* ssid, uint8_t len, uint16_t hash, bool* found)
+{
+    int victim = 0;
+    for (int i = 0; i < PROBE_SSID_SLOTS; i++) {
+        const ProbeSsid& e = probe_ssids[i];
+        if (e.hash == hash && e.last_used != 0 && e.len == len && memcmp(e.ssid, ssid, len) == 0) {
+            *found = true;
+            return i;
+        }
+        if (e.last_used < probe_ssids[victim].last_used) {
+            victim = i;
+        }
+    }
+    *found = false;
+    return victim;
+}
+
+// Slot holding a client, or the least recently probing one to evict.
+// WiFi task, unlocked
+static int probe_find_client(const uint8_t* mac, uint16_t hash, bool* found)
+{
+    int victim = 0;
+    for (int i = 0; i < PROBE_CLIENTS; i++) {
+        const ProbeClient& c = probe_clients[i];
+        if (c.hash == hash && c.last_used != 0 && memcmp(c.mac, mac, 6) == 0) {
+            *found = true;
+            return i;
+        }
+        if (c.last_used < probe_clients[victim].last_used) {
+            victim = i;
+        }
+    }
+    *found = false;
+    return victim;
+}
+
+static inline bool probe_ref_valid(uint16_t ref)
+{
+    if (ref == PROBE_REF_EMPTY) return false;
+    const ProbeSsid& e = probe_ssids[ref & 0xFF];
+    return e.last_used != 0 && e.gen == (ref >> 8);
+}
+
+// WiFi task, every directed probe request
+static void probe_note(const uint8_t* mac, const uint8_t* ssid, uint8_t len)
+{
+    if (mac[0] & 0x02) {
+        return;
+    }
+    uint16_t hash = probe_ssid_hash(ssid, len);
+    uint16_t mac_hash = probe_ssid_hash(mac, 6);
+    bool client_found, ssid_found;
+    int c = probe_find_client(mac, mac_hash, &client_found);
+    int slot = probe_find_ssid(ssid, len, hash, &ssid_found);
+
+    portENTER_CRITICAL(&probe_mux);
+    probe_clock++;
+    ProbeClient& client = probe_clients[c];
+    if (!client_found || client.last_used == 0) {
+        memcpy(client.mac, mac, 6);
+        client.hash = mac_hash;
+        client.next = 0;
+        client.logged = 0;
+        memset(client.ssids, 0xFF, sizeof(client.ssids));
+    }
+    client.last_used = probe_clock;
+
+    ProbeSsid& e = probe_ssids[slot];
+    if (!ssid_found || e.last_used == 0) {
+        if (e.last_used != 0) {
+            probe_ssids_reclaimed++;
+        }
+        memcpy(e.ssid, ssid, len);
+        e.ssid[len] = '\0';
+        e.len = len;
+        e.gen++;
+        e.hash = hash;
+    }
+    e.last_used = probe_clock;
+
+    uint16_t ref = slot | (e.gen << 8);
+    bool listed = false;
+    for (int i = 0; i < PROBE_SSIDS_PER_CLIENT; i++) {
+        if (client.ssids[i] == ref) {
+            listed = true;
+            break;
+        }
+    }
+    if (!listed) {
+        client.ssids[client.next] = ref;
+        client.logged &= ~(1u << client.next);
+        client.next = (client.next + 1) % PROBE_SSIDS_PER_CLIENT;
+    }
+    portEXIT_CRITICAL(&probe_mux);
+}
+
+// Copies the SSIDs a client probed for, oldest first; with only_unlogged,
+// just those not logged yet, and marks them logged
+int probe_history(const uint8_t* mac, char out[][33], bool only_unlogged)
+{
+    int n = 0;
+    portENTER_CRITICAL(&probe_mux);
+    for (int c = 0; c < PROBE_CLIENTS; c++) {
+        ProbeClient& client = probe_clients[c];
+        if (client.last_used == 0 || memcmp(client.mac, mac, 6) != 0) continue;
+        for (int k = 0; k < PROBE_SSIDS_PER_CLIENT; k++) {
+            int i = (client.next + k) % PROBE_SSIDS_PER_CLIENT;
+            if (!probe_ref_valid(client.ssids[i])) continue;
+            if (only_unlogged && (client.logged & (1u << i))) continue;
+            strcpy(out[n++], probe_ssids[client.ssids[i] & 0xFF].ssid);
+            if (only_unlogged) {
+                client.logged |= 1u << i;
+            }
+        }
+        break;
+    }
+    portEXIT_CRITICAL(&probe_mux);
+    return n;
+}
+
+void print_probe_history()
+{
+    int clients = 0, ssids = 0;
+    portENTER_CRITICAL(&probe_mux);
+    for (int i = 0; i < PROBE_CLIENTS; i++) {
+        clients += probe_clients[i].last_used != 0;
+    }
+    for (int i = 0; i < PROBE_SSID_SLOTS; i++) {
+        ssids += probe_ssids[i].last_used != 0;
+    }
+    portEXIT_CRITICAL(&probe_mux);
+    printf("\n=== PROBE HISTORY ===\n");
+    printf("Clients: %d/%d  SSIDs: %d/%d  reclaimed: %lu\n", clients, PROBE_CLIENTS, ssids,
+           PROBE_SSID_SLOTS, (unsigned long)probe_ssids_reclaimed);
+    for (int i = 0; i < PROBE_CLIENTS; i++) {
+        uint8_t mac[6];
+        portENTER_CRITICAL(&probe_mux);
+        bool used = probe_clients[i].last_used != 0;
+        memcpy(mac, probe_clients[i].mac, 6);
+        portEXIT_CRITICAL(&probe_mux);
+        if (!used) continue;
+        char history[PROBE_SSIDS_PER_CLIENT][33];
+        int n = probe_history(mac, history, false);
+        printf("%02x:%02x:%02x:%02x:%02x:%02x ", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+        for (int k = 0; k < n; k++) {
+            printf(" \"%s\"", history[k]);
+        }
+        printf("\n");
+    }
+    printf("=====================\n\n");
+}
+
+void clear_probe_history()
+{
+    portENTER_CRITICAL(&probe_mux);
+    memset(probe_ssids, 0, sizeof(probe_ssids));
+    memset(probe_clients, 0, sizeof(probe_clients));
+    probe_clock = 0;
+    probe_ssids_reclaimed = 0;
+    portEXIT_CRITICAL(&probe_mux);
+}
+
+// ============================================================================
+// LOAD SHEDDING
+// ============================================================================
+//
+// In dense RF (downtown, a street of doorbells) matched frames can arrive
+// faster than the detect task classifies and prints them. The queue then
+// fills and events are dropped with no regard for what they were. Instead the
+// detect task measures its queue depth and its own CPU time every
+// LOAD_PERIOD_MS and moves one level at a time:
+//
+//   0 normal
+//   1 early     frames that match nothing are rejected at the prefilter
+//               before any per-frame bookkeeping (session sketch, probe
+//               history, BLE scan candidates)
+//   2 sample    non-critical detections are sampled at the radio, one in
+//               LOAD_SAMPLE_EVERY is queued
+//   3 summary   non-critical detections are still classified, scored and
+//               logged but not printed; a per-category count goes out every
+//               LOAD_SUMMARY_MS instead
+//
+// Raven, Axon and exact-MAC hits are critical and always kept. They skip
+// sampling and summaries, and at every level the last LOAD_CRITICAL_RESERVE
+// queue slots are held for them. A level is raised after one period over a
+// high mark (or with events dropped) and lowered after LOAD_CALM_PERIODS
+// periods under both low marks.
+//
+// BLE notifications are left out of the CPU time: they mostly wait, on
+// bleMutex and between chunks, and shedding would not make the link faster.
+
+#define LOAD_PERIOD_MS 500
+#define LOAD_QUEUE_HIGH 12              // Peak queue depth in a period
+#define LOAD_QUEUE_LOW 4
+#define LOAD_CPU_HIGH 80                // Percent of the period the detect task was busy
+#define LOAD_CPU_LOW 50
+#define LOAD_CALM_PERIODS 4
+#define LOAD_SAMPLE_EVERY 4
+#define LOAD_CRITICAL_RESERVE 4
+#define LOAD_SUMMARY_MS 5000
+#define LOAD_CRITICAL_CATEGORIES ((1u << RAVEN) | (1u << AXON))
+
+enum LoadLevel {
+    LOAD_NORMAL = 0,
+    LOAD_EARLY,
+    LOAD_SAMPLE,
+    LOAD_SUMMARY,
+    LOAD_LEVELS
+};
+
+static const char* const load_level_names[] = { "normal", "early", "sample", "summary" };
+static const char* const load_shed_names[] = { "off", "on" };
+
+// Read by the WiFi and NimBLE callbacks, written by the detect task
+static volatile uint8_t load_level = LOAD_NORMAL;
+
+// Shed at the radio
+static volatile uint32_t load_frames_early = 0;       // Rejected before bookkeeping
+static volatile uint32_t load_events_sampled = 0;     // Non-critical, not sampled
+static volatile uint32_t load_events_reserved = 0;    // Non-critical, queue slots held for critical ones
+static volatile uint32_t load_sample_counter = 0;
+
+// Detect task only
+static uint32_t load_events_summarized = 0;
+static uint32_t load_transitions = 0;
+static uint32_t load_level_ms[LOAD_LEVELS];
+static uint16_t load_summary_counts[SKETCH_CATEGORIES];
+static unsigned long load_summary_start_ms = 0;
+static unsigned long load_period_start_ms = 0;
+static uint64_t load_busy_us = 0;
+static uint8_t load_queue_peak = 0;
+static uint8_t load_calm_periods = 0;
+static uint32_t load_dropped_seen = 0;
+static uint8_t load_last_cpu_pct = 0;
+static uint8_t load_last_queue_peak = 0;
+
+// From the match the radio callback already made, so shedding adds no
+// pattern matching of its own
+static bool load_event_critical(const DetectionEvent* ev)
+{
+    if (ev->source == EVENT_RAVEN || ev->known_device) {
+        return true;
+    }
+    return (LOAD_CRITICAL_CATEGORIES >> ev->category) & 1;
+}
+
+// Whether an event may be queued (WiFi / NimBLE callbacks)
+static bool load_admit(const DetectionEvent* ev)
+{
+    if (load_shed_mode == LOAD_SHED_OFF || detection_queue == NULL) {
+        return true;
+    }
+    bool reserve = uxQueueSpacesAvailable(detection_queue) <= LOAD_CRITICAL_RESERVE;
+    if (load_level < LOAD_SAMPLE && !reserve) {
+        return true;
+    }
+    if (load_event_critical(ev)) {
+        return true;
+    }
+    if (reserve) {
+        load_events_reserved++;
+        return false;
+    }
+    if (load_sample_counter++ % LOAD_SAMPLE_EVERY != 0) {
+        load_events_sampled++;
+        return false;
+    }
+    return true;
+}
+
+// Detect task: print this detection in full, or only count it
+static bool load_summarize(const DetectionEvent& ev)
+{
+    return load_level >= LOAD_SUMMARY && !load_event_critical(&ev);
+}
+
+static void load_note_summarized(DetectionType category)
+{
+    load_events_summarized++;
+    load_summary_counts[category]++;
+}
+
+// Counts of the detections that were not printed since the last summary
+static void load_emit_summary(unsigned long now)
+{
+    uint32_t total = 0;
+    for (int c = 0; c < SKETCH_CATEGORIES; c++) {
+        total += load_summary_counts[c];
+    }
+    if (total > 0) {
+        StaticJsonDocument<512> doc;
+        doc["type"] = "load_summary";
+        doc["window_ms"] = now - load_summary_start_ms;
+        JsonObject counts = doc.createNestedObject("suppressed");
+        for (int c = 0; c < SKETCH_CATEGORIES; c++) {
+            if (load_summary_counts[c] > 0) {
+                counts[threat_classes[c].name] = load_summary_counts[c];
+            }
+        }
+        String json_output;
+        serializeJson(doc, json_output);
+        Serial.println(json_output);
+    }
+    memset(load_summary_counts, 0, sizeof(load_summary_counts));
+    load_summary_start_ms = now;
+}
+
+static void load_set_level(uint8_t level, uint8_t cpu_pct, uint8_t queue_peak, unsigned long now)
+{
+    if (load_level == LOAD_SUMMARY) {
+        load_emit_summary(now);
+    }
+    load_level = level;
+    load_transitions++;
+    load_summary_start_ms = now;
+    printf("{\"type\":\"load\",\"level\":\"%s\",\"cpu_pct\":%u,\"queue_peak\":%u}\n",
+           load_level_names[level], cpu_pct, queue_peak);
+}
+
+// Detect task: a dequeued event found depth events waiting, itself included
+static void load_note_event(uint32_t depth, uint32_t busy_us)
+{
+    if (depth > load_queue_peak) {
+        load_queue_peak = depth;
+    }
+    load_busy_us += busy_us;
+}
+
+// Detect task, at least every LOAD_PERIOD_MS
+static void load_tick()
+{
+    unsigned long now = millis();
+    unsigned long elapsed = now - load_period_start_ms;
+    if (elapsed < LOAD_PERIOD_MS) {
+        return;
+    }
+    uint8_t cpu_pct = min(load_busy_us / 10 / elapsed, (uint64_t)100);
+    uint8_t queue_peak = load_queue_peak;
+    uint32_t dropped = detection_events_dropped;
+    bool dropping = dropped != load_dropped_seen;
+    load_level_ms[load_level] += elapsed;
+    load_dropped_seen = dropped;
+    load_last_cpu_pct = cpu_pct;
+    load_last_queue_peak = queue_peak;
+    load_period_start_ms = now;
+    load_busy_us = 0;
+    load_queue_peak = 0;
+
+    if (load_shed_mode == LOAD_SHED_OFF) {
+        if (load_level != LOAD_NORMAL) {
+            load_set_level(LOAD_NORMAL, cpu_pct, queue_peak, now);
+        }
+        return;
+    }
+    if (queue_peak >= LOAD_QUEUE_HIGH || cpu_pct >= LOAD_CPU_HIGH || dropping) {
+        load_calm_periods = 0;
+        if (load_level < LOAD_SUMMARY) {
+            load_set_level(load_level + 1, cpu_pct, queue_peak, now);
+        }
+    } else if (queue_peak <= LOAD_QUEUE_LOW && cpu_pct <= LOAD_CPU_LOW) {
+        if (load_level > LOAD_NORMAL && ++load_calm_periods >= LOAD_CALM_PERIODS) {
+            load_calm_periods = 0;
+            load_set_level(load_level - 1, cpu_pct, queue_peak, now);
+        }
+    } else {
+        load_calm_periods = 0;
+    }
+    if (load_level == LOAD_SUMMARY && now - load_summary_start_ms >= LOAD_SUMMARY_MS) {
+        load_emit_summary(now);
+    }
+}
+
+void add_load_json(JsonDocument& doc)
+{
+    JsonObject load = doc.createNestedObject("load");
+    load["level"] = load_level_names[load_level];
+    load["cpu_pct"] = load_last_cpu_pct;
+    load["queue_peak"] = load_last_queue_peak;
+    load["transitions"] = load_transitions;
+    load["frames_early"] = (uint32_t)load_frames_early;
+    load["events_sampled"] = (uint32_t)load_events_sampled;
+    load["events_reserved"] = (uint32_t)load_events_reserved;
+    load["events_summarized"] = load_events_summarized;
+    JsonObject level_ms = load.createNestedObject("level_ms");
+    for (int i = 0; i < LOAD_LEVELS; i++) {
+        level_ms[load_level_names[i]] = load_level_ms[i];
+    }
+}
+
+void clear_load_stats()
+{
+    load_frames_early = 0;
+    load_events_sampled = 0;
+    load_events_reserved = 0;
+    load_events_summarized = 0;
+    load_transitions = 0;
+    memset(load_level_ms, 0, sizeof(load_level_ms));
+}
+
+void print_load_stats()
+{
+    printf("Load: %s (%s), cpu %u%%, queue peak %u, %lu level changes\n",
+           load_level_names[load_level], load_shed_names[load_shed_mode],
+           load_last_cpu_pct, load_last_queue_peak, (unsigned long)load_transitions);
+    printf("Shed: %lu frames early, %lu events sampled, %lu held back for critical, %lu summarized\n",
+           (unsigned long)load_frames_early, (unsigned long)load_events_sampled,
+           (unsigned long)load_events_reserved, (unsigned long)load_events_summarized);
+    printf("Time per level:");
+    for (int i = 0; i < LOAD_LEVELS; i++) {
+        printf(" %s %lus", load_level_names[i], (unsigned long)(load_level_ms[i] / 1000));
+    }
+    printf("\n");
+}
+
+// ============================================================================
+// OUTPUT RATE LIMITING
+// ============================================================================
+//
+// Debounce holds back repeats of one device, but many devices of one kind
+// (Ring and Nest cameras along a residential street) still fire one after
+// another and can saturate the 115200 baud Serial link or the BLE link. Each
+// category has a token bucket per sink, refilled at serial_rate / ble_rate
+// messages a minute and holding up to serial_burst / ble_burst. The buckets
+// are checked before a detection is built, so a message no sink takes is
+// built with the core fields only and never serialized. The number a sink
+// dropped goes out as "suppressed" in the next message of that category it
+// takes.
+//
+// Critical detections (see LOAD SHEDDING) are never rate limited. A rate of
+// 0 turns the limit off for that sink. The buckets are in rate_limit.h,
+// covered by test/test_rate_limit.
+
+// Detect task only
+static RateBucket rate_buckets[SKETCH_CATEGORIES][OUT_SINK_COUNT];
+static uint32_t rate_suppressed_total[OUT_SINK_COUNT];
+
+// Sinks a detection goes to, with the suppressed counts it carries
+static OutputSinks output_gate(const DetectionEvent* ev, bool summarize)
+{
+    RateLimits limits = {
+        { output_serial_rate, output_ble_rate },
+        { output_serial_burst, output_ble_burst },
+    };
+    uint8_t sinks_up = (1u << OUT_SINK_SERIAL) | (deviceConnected ? 1u << OUT_SINK_BLE : 0);
+    return rate_gate(rate_buckets[ev->category], rate_suppressed_total, limits, sinks_up,
+                     load_event_critical(ev), summarize, millis());
+}
+
+void add_rate_limit_json(JsonDocument& doc)
+{
+    JsonObject limited = doc.createNestedObject("rate_limited");
+    limited["serial"] = rate_suppressed_total[OUT_SINK_SERIAL];
+    limited["ble"] = rate_suppressed_total[OUT_SINK_BLE];
+}
+
+void print_rate_limit_stats()
+{
+    printf("Rate limited: %lu Serial (%ld/min, burst %ld), %lu BLE (%ld/min, burst %ld)\n",
+           (unsigned long)rate_suppressed_total[OUT_SINK_SERIAL], (long)output_serial_rate, (long)output_serial_burst,
+           (unsigned long)rate_suppressed_total[OUT_SINK_BLE], (long)output_ble_rate, (long)output_ble_burst);
+}
+
+void clear_rate_limits()
+{
+    memset(rate_buckets, 0, sizeof(rate_buckets));
+    memset(rate_suppressed_total, 0, sizeof(rate_suppressed_total));
+}
+
+// ============================================================================
+// WIFI PROMISCUOUS MODE HANDLER
+// ============================================================================
+
+typedef struct {
+    unsigned frame_ctrl:16;
+    unsigned duration_id:16;
+    uint8_t addr1[6]; /* receiver address */
+    uint8_t addr2[6]; /* sender address */
+    uint8_t addr3[6]; /* filtering address */
+    unsigned sequence_ctrl:16;
+    uint8_t addr4[6]; /* optional */
+} wifi_ieee80211_mac_hdr_t;
+
+typedef struct {
+    wifi_ieee80211_mac_hdr_t hdr;
+    uint8_t payload[0]; /* network data ended with 4 bytes csum (CRC32) */
+} wifi_ieee80211_packet_t;
+
+// Hand a matched frame to the detect task. Never blocks: if the queue is
+// full the event is dropped and counted. Under load non-critical events
+// may be shed first (see LOAD SHEDDING).
+static void post_detection_event(const DetectionEvent* ev)
+{
+    if (!load_admit(ev)) {
+        return;
+    }
+    if (detection_queue == NULL || xQueueSend(detection_queue, ev, 0) != pdTRUE) {
+        detection_events_dropped++;
+    }
+}
+
+static void post_wifi_event(const char* method, DetectionType category, bool known_device, const char* ssid,
+                            const uint8_t* mac, int rssi, uint32_t rx_us, uint16_t beacon_interval, uint8_t ie_flags)
+{
+    DetectionEvent ev = {};
+    ev.source = EVENT_WIFI;
+    ev.channel = current_channel;
+    ev.epoch = wifi_dwell_epoch & 0x7FFF;  // Top bit set = BLE scan
+    ev.rx_us = rx_us;
+    ev.rssi = rssi;
+    memcpy(ev.mac, mac, 6);
+    ev.method = method;
+    ev.category = category;
+    ev.known_device = known_device;
+    strncpy(ev.text, ssid, sizeof(ev.text) - 1);
+    ev.beacon_interval = beacon_interval;
+    ev.ie_flags = ie_flags;
+    post_detection_event(&ev);
+}
+
+// Summarize the information elements of a frame body for scoring; bounded
+// to the first 32 elements
+static uint8_t wifi_ie_flags(const uint8_t* ies, int len)
+{
+    uint8_t flags = 0;
+    for (int off = 0, n = 0; off + 2 <= len && n < 32; n++) {
+        uint8_t tag = ies[off];
+        uint8_t tag_len = ies[off + 1];
+        if (off + 2 + tag_len > len) break;
+        if (tag == 48) {
+            flags |= WIFI_IE_RSN;
+        } else if (tag == 221 && tag_len >= 4 && ies[off + 2] == 0x00 && ies[off + 3] == 0x50 &&
+                   ies[off + 4] == 0xF2 && ies[off + 5] == 0x01) {
+            flags |= WIFI_IE_WPA1;
+        }
+        off += 2 + tag_len;
+    }
+    return flags;
+}
+
+void wifi_sniffer_packet_handler(void* buff, wifi_promiscuous_pkt_type_t type)
+{
+    const wifi_promiscuous_pkt_t *ppkt = (wifi_promiscuous_pkt_t *)buff;
+    if (survey_mode != SURVEY_OFF) {
+        survey_count(ppkt, type);
+    }
+    // Data and control frames only get past the driver filter for the survey
+    if (type != WIFI_PKT_MGMT) {
+        return;
+    }
+    wifi_frames_seen++;
+    if (boot_first_wifi_frame_us == 0) {
+        boot_first_wifi_frame_us = esp_timer_get_time();
+    }
+    channel_frames[current_channel]++;
+
+    if (capture_mode == CAPTURE_MGMT) {
+        capture_frame(ppkt);
+    }
+    const wifi_ieee80211_packet_t *ipkt = (wifi_ieee80211_packet_t *)ppkt->payload;
+    const wifi_ieee80211_mac_hdr_t *hdr = &ipkt->hdr;
+    // Under load the bookkeeping waits until the frame passed the prefilter
+    bool shedding = load_level >= LOAD_EARLY;
+    if (!shedding) {
+        sketch_heard_wifi(hdr->addr2);
+    }
+    
+    // Check for probe requests (subtype 0x04) and beacons (subtype 0x08)
+    // straight from the first frame control byte, before touching anything else
+    uint8_t frame_type = (ppkt->payload[0] & 0xFF) >> 2;
+    if (frame_type != 0x10 && frame_type != 0x20) { // Probe request (0x10) or beacon (0x20)
+        wifi_frames_rejected_subtype++;
+        return;
+    }
+
+    // Locate the SSID element (tag 0, length, data) - sig_len includes the 4 byte FCS
+    const uint8_t *payload = ppkt->payload + 24; // Skip MAC header
+    if (frame_type == 0x20) {
+        payload += 12; // Skip fixed parameters in beacon
+    }
+    int body_len = (int)ppkt->rx_ctrl.sig_len - 4 - (int)(payload - ppkt->payload);
+    uint8_t ssid_len = 0;
+    if (body_len >= 2 && payload[0] == 0 && payload[1] <= 32 && payload[1] + 2 <= body_len) {
+        ssid_len = payload[1];
+    }
+    if (!shedding && frame_type == 0x10 && ssid_len > 0) {
+        probe_note(hdr->addr2, &payload[2], ssid_len);
+    }
+
+    // OUI / SSID prefilter - most frames in a busy area stop here
+    const WifiPrefilter* pf = wifi_prefilter;
+    bool oui_candidate = oui_prefilter_hit(pf, hdr->addr2) || oui_prefilter_hit(pf, hdr->addr3);
+    if (!oui_candidate && (ssid_len == 0 || !ssid_prefilter_hit(pf, &payload[2], ssid_len))) {
+        wifi_frames_rejected_prefilter++;
+        if (shedding) {
+            load_frames_early++;
+        }
+        return;
+    }
+    wifi_frames_processed++;
+    if (shedding) {
+        sketch_heard_wifi(hdr->addr2);
+        if (frame_type == 0x10 && ssid_len > 0) {
+            probe_note(hdr->addr2, &payload[2], ssid_len);
+        }
+    }
+
+    // Extract SSID from probe request or beacon
+    char ssid[33] = {0};
+    if (ssid_len > 0) {
+        memcpy(ssid, &payload[2], ssid_len);
+        ssid[ssid_len] = '\0';
+    }
+
+    // Scoring evidence: beacon interval (after the 8 byte timestamp) and IEs
+    uint16_t beacon_interval = 0;
+    if (frame_type == 0x20 && body_len >= 0) {
+        beacon_interval = ppkt->payload[32] | (ppkt->payload[33] << 8);
+    }
+    uint8_t ie_flags = body_len > 0 ? wifi_ie_flags(payload, body_len) : 0;
+
+    // Check if SSID matches our patterns
+    DetectionType category = NONE;
+    if (strlen(ssid) > 0 && check_ssid_pattern(ssid, &category)) {
+        const char* detection_type = (frame_type == 0x10) ? "probe_request" : "beacon";
+        if (capture_mode == CAPTURE_MATCHED) {
+            capture_frame(ppkt);
+        }
+        post_wifi_event(detection_type, category, false, ssid, hdr->addr2, ppkt->rx_ctrl.rssi,
+                        ppkt->rx_ctrl.timestamp, beacon_interval, ie_flags);
+        return;
+    }
+    
+    if (!oui_candidate) {
+        return;
+    }
+
+    // Check MAC address (transmitter first, then BSSID)
+    const uint8_t* matched_mac = NULL;
+    bool known = false;
+    if ((category = known_device_category(hdr->addr2)) != NONE) {
+        matched_mac = hdr->addr2;
+        known = true;
+    } else if (check_mac_prefix(hdr->addr2, &category)) {
+        matched_mac = hdr->addr2;
+    } else if ((category = known_device_category(hdr->addr3)) != NONE) {
+        matched_mac = hdr->addr3;
+        known = true;
+    } else if (check_mac_prefix(hdr->addr3, &category)) {
+        matched_mac = hdr->addr3;
+    }
+    if (matched_mac) {
+        const char* detection_type = (frame_type == 0x10) ? "probe_request_mac" : "beacon_mac";
+        if (capture_mode == CAPTURE_MATCHED) {
+            capture_frame(ppkt);
+        }
+        post_wifi_event(detection_type, category, known, ssid[0] ? ssid : "hidden", matched_mac,
+                        ppkt->rx_ctrl.rssi, ppkt->rx_ctrl.timestamp, beacon_interval, ie_flags);
+        return;
+    }
+}
+
+// ============================================================================
+// BLE ADDRESS ROTATION
+// ============================================================================
+//
+// Phones and many accessories advertise from a private address that changes
+// every ~15 minutes. Each rotation would otherwise be a new device: a new
+// alert, a fresh debounce entry, another unique in the session sketches.
+//
+// A detection from a rotating address carries a fingerprint of the stable
+// parts of its advertisement (BLE_FP_PARTS 16 bit hashes: AD type layout,
+// company ID, service UUIDs, name, flags / TX power / appearance). The
+// detect task links it to a logical device:
+//
+//   - the address it used last time, or else
+//   - a device with a similar fingerprint found through a small LSH index:
+//     pairs of parts ("bands") hash into buckets, any band collision is a
+//     candidate, and the candidate is accepted if enough parts agree, its
+//     old address was not heard in the same scan (two devices of the same
+//     model) and it was heard recently enough to have just rotated
+//
+// The logical device keeps the first address it was seen with; debounce,
+// alerts, the log and the sketches all use that one. Identical units close
+// together can occasionally swap identities, but never multiply.
+
+enum BleFingerprintPart {
+    FP_LAYOUT,          // AD types in order
+    FP_COMPANY,         // Manufacturer data company ID
+    FP_SERVICES,        // Service UUID lists and service data UUIDs
+    FP_NAME,            // Local name
+    FP_MISC             // Flags, TX power, appearance
+};
+
+#define BLE_IDENTITY_SLOTS 32
+#define BLE_FP_BANDS 3
+#define BLE_FP_BUCKETS 64
+#define BLE_FP_MIN_AGREE 3          // Parts that must match, both present
+#define BLE_IDENTITY_LINK_MS 60000  // Longest silence across a rotation
+
+static const uint8_t ble_fp_bands[BLE_FP_BANDS][2] = {
+    { FP_LAYOUT, FP_COMPANY },
+    { FP_SERVICES, FP_MISC },
+    { FP_NAME, FP_LAYOUT },
+};
+
+struct BleIdentity {
+    uint8_t mac[6];             // First address: the identity in detections
+    uint8_t current[6];         // Address in use now
+    uint16_t fingerprint[BLE_FP_PARTS];
+    uint16_t epoch;             // Scan the current address was last heard in
+    unsigned long last_ms;      // 0 = free slot
+    uint16_t rotations;
+};
+
+// Detect task only, under device_table_mutex
+static BleIdentity ble_identities[BLE_IDENTITY_SLOTS];
+static uint8_t ble_fp_index[BLE_FP_BANDS][BLE_FP_BUCKETS];  // Slot + 1, 0 = empty
+static uint32_t ble_rotations_linked = 0;
+
+// Hash the stable parts of an advertisement (plus scan response). Bounded
+// by the payload, at most 62 bytes for legacy advertising
+static void ble_fingerprint(const uint8_t* payload, size_t len, uint16_t* parts)
+{
+    uint32_t h[BLE_FP_PARTS];
+    bool present[BLE_FP_PARTS] = {};
+    for (int i = 0; i < BLE_FP_PARTS; i++) {
+        h[i] = 2166136261u;
+    }
+    for (size_t off = 0; payload != NULL && off + 2 <= len;) {
+        uint8_t ad_len = payload[off];
+        if (ad_len == 0 || off + 1 + ad_len > len) break;
+        uint8_t type = payload[off + 1];
+        const uint8_t* data = &payload[off + 2];
+        size_t data_len = ad_len - 1;
+        h[FP_LAYOUT] = fnv1a(h[FP_LAYOUT], &type, 1);
+        present[FP_LAYOUT] = true;
+        switch (type) {
+            case 0xFF:  // Manufacturer specific: the payload after the company ID changes
+                if (data_len >= 2) {
+                    h[FP_COMPANY] = fnv1a(h[FP_COMPANY], data, 2);
+                    present[FP_COMPANY] = true;
+                }
+                break;
+            case 0x02: case 0x03: case 0x04: case 0x05: case 0x06: case 0x07:
+                h[FP_SERVICES] = fnv1a(h[FP_SERVICES], data, data_len);
+                present[FP_SERVICES] = true;
+                break;
+            case 0x16:  // Service data: UUID only
+                h[FP_SERVICES] = fnv1a(h[FP_SERVICES], data, min(data_len, (size_t)2));
+                present[FP_SERVICES] = true;
+                break;
+            case 0x20:
+                h[FP_SERVICES] = fnv1a(h[FP_SERVICES], data, min(data_len, (size_t)4));
+                present[FP_SERVICES] = true;
+                break;
+            case 0x21:
+                h[FP_SERVICES] = fnv1a(h[FP_SERVICES], data, min(data_len, (size_t)16));
+                present[FP_SERVICES] = true;
+                break;
+            case 0x08: case 0x09:
+                h[FP_NAME] = fnv1a(h[FP_NAME], data, data_len);
+                present[FP_NAME] = true;
+                break;
+            case 0x01: case 0x0A: case 0x19:
+                h[FP_MISC] = fnv1a(h[FP_MISC], &type, 1);
+                h[FP_MISC] = fnv1a(h[FP_MISC], data, data_len);
+                present[FP_MISC] = true;
+                break;
+        }
+        off += 1 + ad_len;
+    }
+    // 0 is reserved for an absent part
+    for (int i = 0; i < BLE_FP_PARTS; i++) {
+        uint16_t v = (uint16_t)(h[i] ^ (h[i] >> 16));
+        parts[i] = present[i] ? (v ? v : 1) : 0;
+    }
+}
+
+static inline uint8_t ble_fp_bucket(const uint16_t* fp, int band)
+{
+    uint16_t a = fp[ble_fp_bands[band][0]];
+    uint16_t b = fp[ble_fp_bands[band][1]];
+    if (a == 0 && b == 0) {
+        return 0xFF;  // Nothing to index
+    }
+    return (uint8_t)((a * 31u + b) * 2654435761u >> 26);
+}
+
+// Parts present in both that agree, or -1 if a part present in one is
+// missing or different in the other more than once
+static int ble_fp_agreement(const uint16_t* a, const uint16_t* b)
+{
+    int agree = 0, disagree = 0;
+    for (int i = 0; i < BLE_FP_PARTS; i++) {
+        if (a[i] == 0 && b[i] == 0) continue;
+        if (a[i] == b[i]) {
+            agree++;
+        } else {
+            disagree++;
+        }
+    }
+    return disagree > 1 ? -1 : agree;
+}
+
+static void ble_fp_index_slot(int slot)
+{
+    for (int band = 0; band < BLE_FP_BANDS; band++) {
+        uint8_t bucket = ble_fp_bucket(ble_identities[slot].fingerprint, band);
+        if (bucket != 0xFF) {
+            ble_fp_index[band][bucket] = slot + 1;
+        }
+    }
+}
+
+// Replace a rotating address with its logical device's identity.
+// device_table_mutex held
+void ble_identity_resolve(DetectionEvent* ev)
+{
+    if (!ev->addr_rotating) {
+        return;
+    }
+    unsigned long now = millis();
+    int slot = -1;
+
+    // Same address as before
+    for (int i = 0; i < BLE_IDENTITY_SLOTS; i++) {
+        if (ble_identities[i].last_ms != 0 && memcmp(ble_identities[i].current, ev->mac, 6) == 0) {
+            slot = i;
+            break;
+        }
+    }
+
+    // A rotation: look up candidates band by band
+    if (slot < 0) {
+        int best_agree = BLE_FP_MIN_AGREE - 1;
+        for (int band = 0; band < BLE_FP_BANDS; band++) {
+            uint8_t bucket = ble_fp_bucket(ev->fingerprint, band);
+            if (bucket == 0xFF || ble_fp_index[band][bucket] == 0) continue;
+            int c = ble_fp_index[band][bucket] - 1;
+            const BleIdentity& cand = ble_identities[c];
+            if (cand.last_ms == 0 || cand.epoch == ev->epoch || now - cand.last_ms > BLE_IDENTITY_LINK_MS) {
+                continue;
+            }
+            int agree = ble_fp_agreement(cand.fingerprint, ev->fingerprint);
+            if (agree > best_agree) {
+                best_agree = agree;
+                slot = c;
+            }
+        }
+        if (slot >= 0) {
+            memcpy(ble_identities[slot].current, ev->mac, 6);
+            ble_identities[slot].rotations++;
+            ble_rotations_linked++;
+        }
+    }
+
+    // A new device: take the least recently heard slot
+    if (slot < 0) {
+        slot = 0;
+        for (int i = 1; i < BLE_IDENTITY_SLOTS && ble_identities[slot].last_ms != 0; i++) {
+            if (ble_identities[i].last_ms < ble_identities[slot].last_ms) {
+                slot = i;
+            }
+        }
+        BleIdentity& fresh = ble_identities[slot];
+        memcpy(fresh.mac, ev->mac, 6);
+        memcpy(fresh.current, ev->mac, 6);
+        fresh.rotations = 0;
+    }
+
+    BleIdentity& id = ble_identities[slot];
+    memcpy(id.fingerprint, ev->fingerprint, sizeof(id.fingerprint));
+    id.epoch = ev->epoch;
+    id.last_ms = now ? now : 1;
+    ble_fp_index_slot(slot);
+    memcpy(ev->mac, id.mac, 6);
+}
+
+// device_table_mutex held
+void print_ble_identities()
+{
+    unsigned long now = millis();
+    printf("\n=== BLE ROTATING ADDRESSES ===\n");
+    printf("Rotations linked: %lu\n", (unsigned long)ble_rotations_linked);
+    for (int i = 0; i < BLE_IDENTITY_SLOTS; i++) {
+        const BleIdentity& id = ble_identities[i];
+        if (id.last_ms == 0) continue;
+        printf("%02x:%02x:%02x:%02x:%02x:%02x  now %02x:%02x:%02x:%02x:%02x:%02x  rotations %u  last %lus ago\n",
+               id.mac[0], id.mac[1], id.mac[2], id.mac[3], id.mac[4], id.mac[5],
+               id.current[0], id.current[1], id.current[2], id.current[3], id.current[4], id.current[5],
+               id.rotations, (now - id.last_ms) / 1000);
+    }
+    printf("==============================\n\n");
+}
+
+void clear_ble_identities()
+{
+    memset(ble_identities, 0, sizeof(ble_identities));
+    memset(ble_fp_index, 0, sizeof(ble_fp_index));
+    ble_rotations_linked = 0;
+}
+
+// ============================================================================
+// BLE SCAN POLICY
+// ============================================================================
+//
+// An active scan sends a scan request to every scannable advertiser and waits
+// for the response, roughly doubling the airtime spent per device, yet the
+// scan response (usually just the name) only matters for a few of them. In
+// the adaptive policy scans are passive unless something asks for more:
+//
+//   - An advertisement that matched nothing and carries no name is a
+//     candidate if its OUI belongs to a known vendor, or its company ID or
+//     a service UUID was seen on a name match before. Candidates go into a
+//     small cache as pending
+//   - The regular scans stay unfiltered, so Raven, Axon and known units are
+//     always heard. While candidates are pending, a short active scan
+//     filtered through the controller white list follows the regular one,
+//     in the gap before the next, so only they get scan requests. It runs
+//     only if it ends BLE_CANDIDATE_MARGIN_MS before the next scan is due
+//     and no GATT connection is being set up; the time it hears nothing
+//     else is counted as blind time
+//   - A candidate is resolved when its name arrives or after
+//     BLE_CANDIDATE_TRIES candidate scans, and is not asked again while it
+//     stays in the cache. With no gap between scans, only discovery scans
+//     resolve candidates
+//   - Every BLE_DISCOVERY_EVERY scans one is active and unfiltered, so devices
+//     that name themselves only in the scan response are still found and
+//     their company IDs / service UUIDs learned
+//
+// The results of each scan are tallied before the next one starts: every
+// scannable advertiser heard is a request an always-active scan would have
+// sent, every one heard in an active scan a request that was sent.
+//
+// Builds with extended advertising (CONFIG_BT_NIMBLE_EXT_ADV, the S3 targets)
+// also receive BLE 5 extended advertisements, and put every ble_coded'th
+// scan on the LE Coded PHY for its longer range. A Coded PHY scan only hears
+// advertisers that use Coded PHY themselves, legacy ones are heard on 1M.
+// Candidate scans stay on 1M, where the candidates were heard.
+
+#define BLE_CANDIDATE_SLOTS 32
+#define BLE_CANDIDATE_TRIES 2
+#define BLE_CANDIDATE_TTL_MS 600000     // Forget resolved addresses after this
+#define BLE_CANDIDATE_WHITELIST 8       // Addresses per candidate scan
+#define BLE_CANDIDATE_WINDOW_S 1        // Candidate scan after a regular one
+#define BLE_CANDIDATE_MARGIN_MS 500     // Keep this clear of the next scan
+#define BLE_DISCOVERY_EVERY 12          // One unfiltered active scan per N scans
+#define BLE_LEARNED_KEYS 16
+
+enum BleScanKind {
+    BLE_SCAN_KIND_PASSIVE = 0,
+    BLE_SCAN_KIND_CANDIDATE,        // Active, white list only
+    BLE_SCAN_KIND_DISCOVERY         // Active, everyone
+};
+
+enum BleCandidateState {
+    BLE_CANDIDATE_FREE = 0,
+    BLE_CANDIDATE_PENDING,
+    BLE_CANDIDATE_NAMED,            // Scan response received
+    BLE_CANDIDATE_SILENT            // Gave up after BLE_CANDIDATE_TRIES
+};
+
+static const char* const ble_scan_policy_names[] = { "passive", "adaptive", "active" };
+static const char* const ble_scan_kind_names[] = { "passive", "candidate", "discovery" };
+
+struct BleCandidate {
+    uint8_t mac[6];
+    uint8_t addr_type;
+    uint8_t state;              // BleCandidateState
+    uint8_t tries;              // Candidate scans it was white listed in
+    unsigned long last_ms;
+};
+
+// Shared by the NimBLE host (onResult) and the radio task, under ble_scan_mux
+static BleCandidate ble_candidates[BLE_CANDIDATE_SLOTS];
+static uint32_t ble_learned_keys[BLE_LEARNED_KEYS];     // 0 = empty
+static int ble_learned_next = 0;
+static portMUX_TYPE ble_scan_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Radio task only
+static BleScanKind ble_scan_kind = BLE_SCAN_KIND_PASSIVE;
+static uint32_t ble_scans_since_discovery = 0;
+static uint32_t ble_scan_count[3] = { 0, 0, 0 };       // By BleScanKind
+static uint32_t ble_scannable_heard = 0;                // Requests if always active
+static uint32_t ble_scan_requests = 0;                  // Requests actually sent
+static uint32_t ble_scan_blind_ms = 0;                  // Scanning white listed candidates only
+static uint32_t ble_candidate_windows_skipped = 0;      // Candidates pending, no gap
+static uint32_t ble_scans_coded = 0;
+static int32_t ble_scans_since_coded = 0;
+static bool ble_scan_on_coded = false;
+
+// NimBLE host task
+static volatile uint32_t ble_ext_adverts = 0;           // Extended (non-legacy) advertisements
+static volatile uint32_t ble_coded_adverts = 0;         // Received on Coded PHY
+
+// Candidate outcomes, under ble_scan_mux
+static uint32_t ble_candidates_found = 0;
+static uint32_t ble_candidate_hits = 0;     // Name matched a pattern
+static uint32_t ble_candidate_named = 0;    // Name received, no match
+static uint32_t ble_candidate_silent = 0;
+
+// Company ID of the first manufacturer data, 0 if none
+static uint32_t ble_company_key(NimBLEAdvertisedDevice* device)
+{
+    if (!device->haveManufacturerData()) return 0;
+    std::string data = device->getManufacturerData();
+    if (data.size() < 2) return 0;
+    return 0x10000 | (uint8_t)data[0] | ((uint32_t)(uint8_t)data[1] << 8);
+}
+
+static uint32_t ble_uuid_key(NimBLEAdvertisedDevice* device, int i)
+{
+    std::string uuid = device->getServiceUUID(i).toString();
+    return 0x80000000u | fnv1a(2166136261u, (const uint8_t*)uuid.data(), uuid.size());
+}
+
+// ble_scan_mux held
+static bool ble_key_learned(uint32_t key)
+{
+    for (int i = 0; i < BLE_LEARNED_KEYS && key != 0; i++) {
+        if (ble_learned_keys[i] == key) return true;
+    }
+    return false;
+}
+
+// ble_scan_mux held
+static void ble_learn_key(uint32_t key)
+{
+    if (key == 0 || ble_key_learned(key)) return;
+    ble_learned_keys[ble_learned_next] = key;
+    ble_learned_next = (ble_learned_next + 1) % BLE_LEARNED_KEYS;
+}
+
+// ble_scan_mux held
+static int ble_candidate_find(const uint8_t* mac)
+{
+    for (int i = 0; i < BLE_CANDIDATE_SLOTS; i++) {
+        if (ble_candidates[i].state != BLE_CANDIDATE_FREE && memcmp(ble_candidates[i].mac, mac, 6) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool ble_is_candidate(const uint8_t* mac, uint8_t addr_type, const uint32_t* keys, int key_count)
+{
+    if (addr_type == BLE_ADDR_PUBLIC) {
+        char prefix[9];
+        snprintf(prefix, sizeof(prefix), "%02x:%02x:%02x", mac[0], mac[1], mac[2]);
+        if (categorize_by_mac(prefix) != NONE) return true;
+    }
+    bool learned = false;
+    portENTER_CRITICAL(&ble_scan_mux);
+    for (int i = 0; i < key_count && !learned; i++) {
+        learned = ble_key_learned(keys[i]);
+    }
+    portEXIT_CRITICAL(&ble_scan_mux);
+    return learned;
+}
+
+// Company ID and up to three service UUIDs of an advertisement
+static int ble_scan_keys(NimBLEAdvertisedDevice* device, uint32_t* keys)
+{
+    int n = 0;
+    uint32_t company = ble_company_key(device);
+    if (company != 0) keys[n++] = company;
+    int services = device->haveServiceUUID() ? device->getServiceUUIDCount() : 0;
+    for (int i = 0; i < services && n < 4; i++) {
+        keys[n++] = ble_uuid_key(device, i);
+    }
+    return n;
+}
+
+// A name pattern matched: remember what the device advertised, so the same
+// kind of device is a candidate even when it only names itself on request
+void ble_scan_name_matched(NimBLEAdvertisedDevice* device, const uint8_t* mac)
+{
+    uint32_t keys[4];
+    int n = ble_scan_keys(device, keys);
+    portENTER_CRITICAL(&ble_scan_mux);
+    for (int i = 0; i < n; i++) {
+        ble_learn_key(keys[i]);
+    }
+    int slot = ble_candidate_find(mac);
+    if (slot >= 0 && ble_candidates[slot].state == BLE_CANDIDATE_PENDING) {
+        ble_candidates[slot].state = BLE_CANDIDATE_NAMED;
+        ble_candidate_hits++;
+    }
+    portEXIT_CRITICAL(&ble_scan_mux);
+}
+
+// An advertisement that matched nothing
+void ble_scan_unmatched(NimBLEAdvertisedDevice* device, const uint8_t* mac, uint8_t addr_type, bool have_name)
+{
+    unsigned long now = millis();
+    portENTER_CRITICAL(&ble_scan_mux);
+    int slot = ble_candidate_find(mac);
+    if (slot >= 0) {
+        BleCandidate& c = ble_candidates[slot];
+        c.last_ms = now;
+        if (c.state == BLE_CANDIDATE_PENDING && have_name) {
+            c.state = BLE_CANDIDATE_NAMED;
+            ble_candidate_named++;
+        }
+    }
+    portEXIT_CRITICAL(&ble_scan_mux);
+    if (slot >= 0 || have_name || ble_scan_policy != BLE_SCAN_ADAPTIVE) {
+        return;
+    }
+
+    uint32_t keys[4];
+    int n = ble_scan_keys(device, keys);
+    if (!ble_is_candidate(mac, addr_type, keys, n)) {
+        return;
+    }
+
+    // Take a free slot, else the least recently heard resolved one; pending
+    // candidates are never evicted for new ones
+    portENTER_CRITICAL(&ble_scan_mux);
+    int victim = -1;
+    for (int i = 0; i < BLE_CANDIDATE_SLOTS; i++) {
+        const BleCandidate& c = ble_candidates[i];
+        if (c.state == BLE_CANDIDATE_FREE) {
+            victim = i;
+            break;
+        }
+        if (c.state != BLE_CANDIDATE_PENDING && (victim < 0 || c.last_ms < ble_candidates[victim].last_ms)) {
+            victim = i;
+        }
+    }
+    if (victim >= 0 && ble_candidate_find(mac) < 0) {
+        BleCandidate& c = ble_candidates[victim];
+        memcpy(c.mac, mac, 6);
+        c.addr_type = addr_type;
+        c.state = BLE_CANDIDATE_PENDING;
+        c.tries = 0;
+        c.last_ms = now;
+        ble_candidates_found++;
+    }
+    portEXIT_CRITICAL(&ble_scan_mux);
+}
+
+// Count the scannable advertisers of the scan that just ended
+static void ble_scan_tally()
+{
+    NimBLEScanResults results = pBLEScan->getResults();
+    uint32_t scannable = 0;
+    for (int i = 0; i < results.getCount(); i++) {
+        uint8_t type = results.getDevice(i).getAdvType();
+        if (type == BLE_HCI_ADV_TYPE_ADV_IND || type == BLE_HCI_ADV_TYPE_ADV_SCAN_IND) {
+            scannable++;
+        }
+    }
+    if (ble_scan_kind == BLE_SCAN_KIND_CANDIDATE) {
+        // Only white listed addresses were heard, the rest of the
+        // neighbourhood is accounted for by the passive scans
+        ble_scan_requests += scannable;
+    } else {
+        ble_scannable_heard += scannable;
+        if (ble_scan_kind == BLE_SCAN_KIND_DISCOVERY) {
+            ble_scan_requests += scannable;
+        }
+    }
+    pBLEScan->clearResults();
+}
+
+static void ble_whitelist_clear()
+{
+    while (NimBLEDevice::getWhiteListCount() > 0) {
+        NimBLEDevice::whiteListRemove(NimBLEDevice::getWhiteListAddress(0));
+    }
+}
+
+// Expire and give up on candidates, and copy up to max pending ones into
+// listed (counting the try). Returns the number listed
+static int ble_candidates_collect(BleCandidate* listed, int max)
+{
+    unsigned long now = millis();
+    int count = 0;
+    portENTER_CRITICAL(&ble_scan_mux);
+    for (int i = 0; i < BLE_CANDIDATE_SLOTS; i++) {
+        BleCandidate& c = ble_candidates[i];
+        if (c.state == BLE_CANDIDATE_FREE) continue;
+        if (now - c.last_ms > BLE_CANDIDATE_TTL_MS) {
+            c.state = BLE_CANDIDATE_FREE;
+            continue;
+        }
+        if (c.state != BLE_CANDIDATE_PENDING) continue;
+        if (c.tries >= BLE_CANDIDATE_TRIES) {
+            c.state = BLE_CANDIDATE_SILENT;
+            ble_candidate_silent++;
+            continue;
+        }
+        if (count < max) {
+            c.tries++;
+            listed[count++] = c;
+        }
+    }
+    portEXIT_CRITICAL(&ble_scan_mux);
+    return count;
+}
+
+// Pick the kind of the next regular scan and set the scanner up for it.
+// Regular scans are never white listed. Radio task, while not scanning
+static void ble_scan_configure()
+{
+    ble_scan_tally();
+    ble_whitelist_clear();
+    ble_candidates_collect(NULL, 0);
+
+    BleScanKind kind = BLE_SCAN_KIND_PASSIVE;
+    if (ble_scan_policy == BLE_SCAN_ACTIVE) {
+        kind = BLE_SCAN_KIND_DISCOVERY;
+    } else if (ble_scan_policy == BLE_SCAN_ADAPTIVE && ++ble_scans_since_discovery >= BLE_DISCOVERY_EVERY) {
+        kind = BLE_SCAN_KIND_DISCOVERY;
+    }
+    if (kind == BLE_SCAN_KIND_DISCOVERY) {
+        ble_scans_since_discovery = 0;
+    }
+
+    pBLEScan->setActiveScan(kind != BLE_SCAN_KIND_PASSIVE);
+    pBLEScan->setFilterPolicy(BLE_HCI_SCAN_FILT_NO_WL);
+    ble_scan_kind = kind;
+    ble_scan_count[kind]++;
+
+#if CONFIG_BT_NIMBLE_EXT_ADV
+    ble_scan_on_coded = false;
+    if (ble_coded_every > 0 && ++ble_scans_since_coded >= ble_coded_every) {
+        ble_scans_since_coded = 0;
+        ble_scan_on_coded = true;
+        ble_scans_coded++;
+    }
+    pBLEScan->setPhy(ble_scan_on_coded ? NimBLEScan::SCAN_CODED : NimBLEScan::SCAN_1M);
+#endif
+}
+
+static bool ble_candidates_pending()
+{
+    bool pending = false;
+    portENTER_CRITICAL(&ble_scan_mux);
+    for (int i = 0; i < BLE_CANDIDATE_SLOTS && !pending; i++) {
+        pending = ble_candidates[i].state == BLE_CANDIDATE_PENDING;
+    }
+    portEXIT_CRITICAL(&ble_scan_mux);
+    return pending;
+}
+
+// White list the pending candidates and set the scanner up for a candidate
+// scan. Radio task, while not scanning; false if none is left to ask
+static bool ble_candidate_scan_configure()
+{
+    BleCandidate listed[BLE_CANDIDATE_WHITELIST];
+    int count = ble_candidates_collect(listed, BLE_CANDIDATE_WHITELIST);
+    if (count == 0) {
+        return false;
+    }
+    ble_whitelist_clear();
+    for (int i = 0; i < count; i++) {
+        char addr[18];
+        snprintf(addr, sizeof(addr), "%02x:%02x:%02x:%02x:%02x:%02x", listed[i].mac[0], listed[i].mac[1],
+                 listed[i].mac[2], listed[i].mac[3], listed[i].mac[4], listed[i].mac[5]);
+        NimBLEDevice::whiteListAdd(NimBLEAddress(std::string(addr), listed[i].addr_type));
+    }
+    pBLEScan->setActiveScan(true);
+    pBLEScan->setFilterPolicy(BLE_HCI_SCAN_FILT_USE_WL);
+#if CONFIG_BT_NIMBLE_EXT_ADV
+    ble_scan_on_coded = false;
+    pBLEScan->setPhy(NimBLEScan::SCAN_1M);
+#endif
+    ble_scan_kind = BLE_SCAN_KIND_CANDIDATE;
+    ble_scan_count[BLE_SCAN_KIND_CANDIDATE]++;
+    ble_scan_blind_ms += BLE_CANDIDATE_WINDOW_S * 1000;
+    return true;
+}
+
+static uint32_t ble_scan_airtime_saved_pct()
+{
+    if (ble_scannable_heard == 0 || ble_scan_requests >= ble_scannable_heard) return 0;
+    return 100 - ble_scan_requests * 100 / ble_scannable_heard;
+}
+
+void add_ble_scan_json(JsonDocument& doc)
+{
+    JsonObject scan = doc.createNestedObject("ble_scan");
+    scan["policy"] = ble_scan_policy_names[ble_scan_policy];
+    scan["passive_scans"] = ble_scan_count[BLE_SCAN_KIND_PASSIVE];
+    scan["candidate_scans"] = ble_scan_count[BLE_SCAN_KIND_CANDIDATE];
+    scan["candidate_scans_skipped"] = ble_candidate_windows_skipped;
+    scan["blind_ms"] = ble_scan_blind_ms;
+    scan["discovery_scans"] = ble_scan_count[BLE_SCAN_KIND_DISCOVERY];
+    scan["scan_requests"] = ble_scan_requests;
+    scan["scan_requests_always_active"] = ble_scannable_heard;
+    scan["airtime_saved_pct"] = ble_scan_airtime_saved_pct();
+    scan["candidates"] = ble_candidates_found;
+    scan["candidate_hits"] = ble_candidate_hits;
+    uint32_t resolved = ble_candidate_hits + ble_candidate_named + ble_candidate_silent;
+    scan["candidate_hit_pct"] = resolved ? ble_candidate_hits * 100 / resolved : 0;
+#if CONFIG_BT_NIMBLE_EXT_ADV
+    scan["coded_scans"] = ble_scans_coded;
+    scan["extended_adverts"] = (uint32_t)ble_ext_adverts;
+    scan["coded_adverts"] = (uint32_t)ble_coded_adverts;
+#endif
+}
+
+void print_ble_scan_policy()
+{
+    printf("\n=== BLE SCAN POLICY ===\n");
+    printf("Policy: %s  last scan: %s\n", ble_scan_policy_names[ble_scan_policy], ble_scan_kind_names[ble_scan_kind]);
+    printf("Scans: %lu passive, %lu candidate, %lu discovery\n",
+           (unsigned long)ble_scan_count[BLE_SCAN_KIND_PASSIVE],
+           (unsigned long)ble_scan_count[BLE_SCAN_KIND_CANDIDATE],
+           (unsigned long)ble_scan_count[BLE_SCAN_KIND_DISCOVERY]);
+    printf("Candidate scans: %lu skipped (no gap), %lu ms blind to everything else\n",
+           (unsigned long)ble_candidate_windows_skipped, (unsigned long)ble_scan_blind_ms);
+    printf("Scan requests: %lu sent, %lu if always active (%lu%% airtime saved)\n",
+           (unsigned long)ble_scan_requests, (unsigned long)ble_scannable_heard,
+           (unsigned long)ble_scan_airtime_saved_pct());
+#if CONFIG_BT_NIMBLE_EXT_ADV
+    printf("Extended advertising: every %ld%s scan on Coded PHY (%lu so far), %lu extended / %lu Coded PHY adverts\n",
+           (long)ble_coded_every, ble_coded_every == 0 ? "th (off)" : "th", (unsigned long)ble_scans_coded,
+           (unsigned long)ble_ext_adverts, (unsigned long)ble_coded_adverts);
+#else
+    printf("Extended advertising: not in this build\n");
+#endif
+
+    BleCandidate snapshot[BLE_CANDIDATE_SLOTS];
+    uint32_t found, hits, named, silent;
+    int learned = 0;
+    portENTER_CRITICAL(&ble_scan_mux);
+    memcpy(snapshot, ble_candidates, sizeof(snapshot));
+    found = ble_candidates_found;
+    hits = ble_candidate_hits;
+    named = ble_candidate_named;
+    silent = ble_candidate_silent;
+    for (int i = 0; i < BLE_LEARNED_KEYS; i++) {
+        if (ble_learned_keys[i] != 0) learned++;
+    }
+    portEXIT_CRITICAL(&ble_scan_mux);
+
+    uint32_t resolved = hits + named + silent;
+    printf("Candidates: %lu found, %lu matched, %lu named, %lu silent (hit rate %lu%%)\n",
+           (unsigned long)found, (unsigned long)hits, (unsigned long)named, (unsigned long)silent,
+           (unsigned long)(resolved ? hits * 100 / resolved : 0));
+    printf("Learned company IDs / service UUIDs: %d\n", learned);
+
+    static const char* const state_names[] = { "free", "pending", "named", "silent" };
+    unsigned long now = millis();
+    for (int i = 0; i < BLE_CANDIDATE_SLOTS; i++) {
+        const BleCandidate& c = snapshot[i];
+        if (c.state == BLE_CANDIDATE_FREE) continue;
+        printf("%02x:%02x:%02x:%02x:%02x:%02x  %-7s  tries %u  last %lus ago\n",
+               c.mac[0], c.mac[1], c.mac[2], c.mac[3], c.mac[4], c.mac[5],
+               state_names[c.state], c.tries, (now - c.last_ms) / 1000);
+    }
+    printf("=======================\n\n");
+}
+
+void clear_ble_scan_policy()
+{
+    portENTER_CRITICAL(&ble_scan_mux);
+    memset(ble_candidates, 0, sizeof(ble_candidates));
+    ble_candidates_found = 0;
+    ble_candidate_hits = 0;
+    ble_candidate_named = 0;
+    ble_candidate_silent = 0;
+    portEXIT_CRITICAL(&ble_scan_mux);
+    memset(ble_scan_count, 0, sizeof(ble_scan_count));
+    ble_scannable_heard = 0;
+    ble_scan_requests = 0;
+    ble_scan_blind_ms = 0;
+    ble_candidate_windows_skipped = 0;
+    ble_scans_coded = 0;
+    ble_ext_adverts = 0;
+    ble_coded_adverts = 0;
+}
+
+// ============================================================================
+// BLE SCANNING
+// ============================================================================
+
+#define BLE_AD_SHORT_NAME 0x08
+#define BLE_AD_COMPLETE_NAME 0x09
+
+// Value of the first AD structure of a type, pointing into the payload
+static const uint8_t* ble_ad_find(const uint8_t* payload, size_t len, uint8_t type, size_t* value_len)
+{
+    size_t pos = 0;
+    while (payload != NULL && pos + 1 < len) {
+        uint8_t field_len = payload[pos];
+        if (field_len == 0 || pos + 1 + field_len > len) {
+            break;
+        }
+        if (payload[pos + 1] == type) {
+            *value_len = field_len - 1;
+            return &payload[pos + 2];
+        }
+        pos += 1 + field_len;
+    }
+    return NULL;
+}
+
+// Primary PHY, plus the secondary one for an extended advertisement
+static uint8_t ble_advert_phy(NimBLEAdvertisedDevice* device)
+{
+#if CONFIG_BT_NIMBLE_EXT_ADV
+    uint8_t phy = device->getPrimaryPhy();
+    if (!device->isLegacyAdvertisement()) {
+        ble_ext_adverts++;
+        phy |= device->getSecondaryPhy() << 4;
+    }
+    if ((phy & 0x0F) == BLE_HCI_LE_PHY_CODED) {
+        ble_coded_adverts++;
+    }
+    return phy;
+#else
+    return BLE_HCI_LE_PHY_1M;
+#endif
+}
+
+// Hand a matched advertisement to the detect task, with a fingerprint if its
+// address rotates
+static void post_ble_event(NimBLEAdvertisedDevice* device, DetectionEvent* ev)
+{
+    NimBLEAddress addr = device->getAddress();
+    // Random static addresses (top bits 11) only change at power up
+    if (addr.getType() == BLE_ADDR_RANDOM && (ev->mac[0] >> 6) != 0x3) {
+        ev->addr_rotating = true;
+        ble_fingerprint(device->getPayload(), device->getPayloadLength(), ev->fingerprint);
+    }
+    post_detection_event(ev);
+}
+
+class AdvertisedDeviceCallbacks: public NimBLEAdvertisedDeviceCallbacks {
+    void onResult(NimBLEAdvertisedDevice* advertisedDevice) {
+        if (boot_first_ble_adv_us == 0) {
+            boot_first_ble_adv_us = esp_timer_get_time();
+        }
+        
+        NimBLEAddress addr = advertisedDevice->getAddress();
+        std::string addrStr = addr.toString();
+        uint8_t mac[6];
+        sscanf(addrStr.c_str(), "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx", 
+               &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5]);
+        if (addr.getType() == BLE_ADDR_PUBLIC) {
+            sketch_heard_ble(mac);
+        }
+        
+        DetectionEvent ev = {};
+        ev.source = EVENT_BLE;
+        ev.rssi = advertisedDevice->getRSSI();
+        ev.epoch = 0x8000 | (ble_scan_epoch & 0x7FFF);
+        ev.addr_type = addr.getType();
+        ev.rx_us = (uint32_t)esp_timer_get_time();
+        memcpy(ev.mac, mac, 6);
+        ev.phy = ble_advert_phy(advertisedDevice);
+
+        // The name straight from the payload, which an extended advertisement
+        // can make 1650 bytes long
+        size_t name_len = 0;
+        const uint8_t* name = ble_ad_find(advertisedDevice->getPayload(), advertisedDevice->getPayloadLength(),
+                                          BLE_AD_COMPLETE_NAME, &name_len);
+        if (name == NULL) {
+            name = ble_ad_find(advertisedDevice->getPayload(), advertisedDevice->getPayloadLength(),
+                               BLE_AD_SHORT_NAME, &name_len);
+        }
+        if (name != NULL) {
+            memcpy(ev.text, name, min(name_len, sizeof(ev.text) - 1));
+        }
+        
+        // Check the exact MAC against surveyed units
+        DetectionType category = known_device_category(mac);
+        if (category != NONE) {
+            ev.method = "known_device";
+            ev.category = category;
+            ev.known_device = true;
+            post_ble_event(advertisedDevice, &ev);
+            return;
+        }
+
+        // Check MAC prefix
+        if (check_mac_prefix(mac, &category)) {
+            ev.method = "mac_prefix";
+            ev.category = category;
+            post_ble_event(advertisedDevice, &ev);
+            return;
+        }
+        
+        // Check device name
+        if (ev.text[0] && check_device_name_pattern(ev.text, &category)) {
+            ev.method = "device_name";
+            ev.category = category;
+            ble_scan_name_matched(advertisedDevice, mac);
+            post_ble_event(advertisedDevice, &ev);
+            return;
+        }
+        
+        // Check for Raven surveillance device service UUIDs
+        if (check_raven_service_uuid(advertisedDevice, ev.raven_service_uuid)) {
+            // Raven device detected! Resolve firmware estimate while we still
+            // have the advertisement; the detect task only sees the copy
+            ev.source = EVENT_RAVEN;
+            ev.method = "raven_service_uuid";
+            ev.category = RAVEN;
+            ev.raven_fw_version = estimate_raven_firmware_version(advertisedDevice);
+            ev.raven_service_desc = get_raven_service_description(ev.raven_service_uuid);
+
+            int serviceCount = advertisedDevice->getServiceUUIDCount();
+            for (int i = 0; i < serviceCount && i < MAX_EVENT_SERVICE_UUIDS; i++) {
+                std::string uuidStr = advertisedDevice->getServiceUUID(i).toString();
+                strncpy(ev.service_uuids[i], uuidStr.c_str(), sizeof(ev.service_uuids[i]) - 1);
+                ev.service_uuid_count++;
+            }
+            post_ble_event(advertisedDevice, &ev);
+            return;
+        }
+
+        if (load_level >= LOAD_EARLY) {
+            load_frames_early++;
+        } else {
+            ble_scan_unmatched(advertisedDevice, mac, ev.addr_type, ev.text[0] != '\0');
+        }
+    }
+};
+
+// ============================================================================
+// DETECTION LOG (flash ring)
+// ============================================================================
+//
+// Every detection is appended to a ring of fixed 64 byte records in the
+// "detlog" partition so nothing is lost while the phone is disconnected.
+//
+//   - Records are batched in RAM (LOG_BATCH_RECORDS) and written in one go,
+//     each 4 KB sector is erased exactly once per lap of the ring
+//   - Each record carries a magic, a monotonic sequence number and a CRC32;
+//     erased slots read back as magic 0xFFFF, torn writes fail the CRC
+//   - A RAM index holds the first record of every sector, so locating a
+//     sequence number or a (boot, uptime) time is a binary search
+//   - Time is (boot_count, uptime_ms); boot_count is recovered from the
+//     newest record at mount, no wall clock needed
+//
+// Offload ('log dump' on Serial, or an 8 byte write to the LOG characteristic
+// over BLE) streams raw records back to back. Readers resynchronise on the
+// magic and validate each record with its CRC, so JSON lines printed by
+// other tasks in the middle of a Serial dump are harmless. One offload runs
+// at a time: BLE requests wait in log_request_queue until the current one
+// has finished, and 'log dump' refuses to start while one is running.
+
+#define LOG_RECORD_MAGIC 0x4C46         // "FL"
+#define LOG_RECORD_SIZE 64
+#define LOG_SECTOR_SIZE 4096
+#define LOG_RECORDS_PER_SECTOR (LOG_SECTOR_SIZE / LOG_RECORD_SIZE)
+
+struct __attribute__((packed)) LogRecord {
+    uint16_t magic;
+    uint16_t boot_count;
+    uint32_t seq;
+    uint32_t uptime_ms;
+    uint8_t source;             // DetectionEventSource
+    uint8_t category;           // DetectionType
+    int8_t rssi;
+    uint8_t channel;
+    uint8_t mac[6];
+    uint8_t phy;                // BLE: primary PHY | secondary << 4, see DetectionEvent
+    uint8_t reserved;
+    char text[36];              // SSID or BLE name, NUL padded
+    uint32_t crc;               // CRC32 over all preceding bytes
+};
+static_assert(sizeof(LogRecord) == LOG_RECORD_SIZE, "LogRecord must be 64 bytes");
+
+// First record of each sector; valid == false for never-written sectors
+struct LogSectorIndex {
+    uint32_t first_seq;
+    uint32_t first_uptime_ms;
+    uint16_t first_boot;
+    uint8_t valid;
+    uint8_t reserved;
+};
+
+enum LogDumpSink {
+    LOG_SINK_NONE = 0,
+    LOG_SINK_SERIAL = 1,
+    LOG_SINK_BLE = 2
+};
+
+static const esp_partition_t* log_partition = NULL;
+static LogSectorIndex log_index[LOG_MAX_SECTORS];
+static uint32_t log_sector_count = 0;
+static uint32_t log_head_sector = 0;    // Sector receiving the next write
+static uint32_t log_head_slot = 0;      // Record slot within log_head_sector
+static uint32_t log_next_seq = 0;
+static uint16_t log_boot_count = 0;
+static uint32_t log_sector_erases = 0;  // This boot, for wear monitoring
+static uint32_t log_flash_writes = 0;
+static uint32_t log_flash_errors = 0;   // Failed erases and writes
+
+static SemaphoreHandle_t log_mutex = NULL;
+static LogRecord log_pending[LOG_BATCH_RECORDS];
+static int log_pending_count = 0;
+static uint32_t log_records_dropped = 0;
+
+// In-progress offload
+static LogDumpSink log_dump_sink = LOG_SINK_NONE;
+static uint32_t log_dump_sector_step = 0;   // Sectors visited, oldest first
+static uint32_t log_dump_slot = 0;
+static uint32_t log_dump_from_seq = 0;
+static uint16_t log_dump_from_boot = 0;
+static uint32_t log_dump_from_ms = 0;
+static uint32_t log_dump_remaining = 0;
+static uint32_t log_dump_sent = 0;
+static uint8_t log_dump_ble_buf[BLE_PREFERRED_MTU];
+static size_t log_dump_ble_len = 0;
+
+// BLE offload requests (LOG characteristic, CTRL_LOG_OFFLOAD), started by
+// the ui task once no offload is running
+#define LOG_REQUEST_QUEUE_LENGTH 2
+
+struct LogOffloadRequest {
+    uint32_t from_seq;
+    uint32_t count;             // 0 = all
+};
+
+static QueueHandle_t log_request_queue = NULL;
+static uint32_t log_requests_dropped = 0;
+
+static uint32_t log_record_crc(const LogRecord* rec)
+{
+    return esp_rom_crc32_le(0, (const uint8_t*)rec, offsetof(LogRecord, crc));
+}
+
+static bool log_record_valid(const LogRecord* rec)
+{
+    return rec->magic == LOG_RECORD_MAGIC && rec->crc == log_record_crc(rec);
+}
+
+static bool log_read_record(uint32_t sector, uint32_t slot, LogRecord* rec)
+{
+    size_t offset = sector * LOG_SECTOR_SIZE + slot * LOG_RECORD_SIZE;
+    return esp_partition_read(log_partition, offset, rec, sizeof(LogRecord)) == ESP_OK;
+}
+
+// Find the head of the ring and rebuild the sector index
+void log_mount()
+{
+    log_mutex = xSemaphoreCreateMutex();
+    log_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                             (esp_partition_subtype_t)LOG_PARTITION_SUBTYPE,
+                                             LOG_PARTITION_LABEL);
+    if (log_partition == NULL) {
+        printf("[LOG] No '%s' partition - detection log disabled\n", LOG_PARTITION_LABEL);
+        return;
+    }
+    log_sector_count = min((uint32_t)(log_partition->size / LOG_SECTOR_SIZE), (uint32_t)LOG_MAX_SECTORS);
+
+    bool found = false;
+    uint32_t newest_sector = 0;
+    for (uint32_t s = 0; s < log_sector_count; s++) {
+        LogRecord rec;
+        log_index[s].valid = 0;
+        if (log_read_record(s, 0, &rec) && log_record_valid(&rec)) {
+            log_index[s].first_seq = rec.seq;
+            log_index[s].first_uptime_ms = rec.uptime_ms;
+            log_index[s].first_boot = rec.boot_count;
+            log_index[s].valid = 1;
+            if (!found || rec.seq > log_index[newest_sector].first_seq) {
+                newest_sector = s;
+                found = true;
+            }
+        }
+    }
+
+    if (!found) {
+        log_head_sector = 0;
+        log_head_slot = 0;
+        log_next_seq = 0;
+        log_boot_count = 1;
+    } else {
+        // Walk the newest sector up to the first erased slot
+        uint32_t slot = 0;
+        LogRecord last = {};
+        for (; slot < LOG_RECORDS_PER_SECTOR; slot++) {
+            LogRecord rec;
+            if (!log_read_record(newest_sector, slot, &rec) || rec.magic == 0xFFFF) {
+                break;
+            }
+            if (log_record_valid(&rec)) {
+                last = rec;
+            }
+        }
+        log_next_seq = last.seq + 1;
+        log_boot_count = last.boot_count + 1;
+        log_head_sector = newest_sector;
+        log_head_slot = slot;
+        if (log_head_slot >= LOG_RECORDS_PER_SECTOR) {
+            log_head_sector = (newest_sector + 1) % log_sector_count;
+            log_head_slot = 0;
+        }
+    }
+
+    printf("[LOG] %u sectors, next seq %lu, boot %u\n", (unsigned)log_sector_count,
+           (unsigned long)log_next_seq, log_boot_count);
+}
+
+// Queue a detection for the next batched flash write (detect task)
+void log_append(const DetectionEvent& ev, DetectionType category)
+{
+    if (log_partition == NULL) {
+        return;
+    }
+
+    LogRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.magic = LOG_RECORD_MAGIC;
+    rec.boot_count = log_boot_count;
+    rec.uptime_ms = millis();
+    rec.source = ev.source;
+    rec.category = category;
+    rec.rssi = ev.rssi;
+    rec.channel = ev.channel;
+    memcpy(rec.mac, ev.mac, 6);
+    rec.phy = ev.phy;
+    strncpy(rec.text, ev.text, sizeof(rec.text));
+
+    bool batch_full = false;
+    xSemaphoreTake(log_mutex, portMAX_DELAY);
+    if (log_pending_count < LOG_BATCH_RECORDS) {
+        rec.seq = log_next_seq++;
+        rec.crc = log_record_crc(&rec);
+        log_pending[log_pending_count++] = rec;
+        batch_full = (log_pending_count == LOG_BATCH_RECORDS);
+    } else {
+        log_records_dropped++;
+    }
+    xSemaphoreGive(log_mutex);
+
+    if (batch_full && ui_task_handle != NULL) {
+        xTaskNotify(ui_task_handle, NOTIFY_LOG_FLUSH, eSetBits);
+    }
+}
+
+// Write buffered records to flash (ui task)
+void log_flush()
+{
+    if (log_partition == NULL) {
+        return;
+    }
+
+    LogRecord batch[LOG_BATCH_RECORDS];
+    xSemaphoreTake(log_mutex, portMAX_DELAY);
+    int count = log_pending_count;
+    memcpy(batch, log_pending, count * sizeof(LogRecord));
+    log_pending_count = 0;
+    xSemaphoreGive(log_mutex);
+
+    int done = 0;
+    int lost = 0;
+    while (done < count) {
+        if (log_head_slot == 0) {
+            // Entering a sector: reclaim it (drops the oldest records in the ring).
+            // If the erase fails its old contents are unknown, so it leaves the
+            // index and the batch is dropped; the next flush retries the sector.
+            log_sector_erases++;
+            if (esp_partition_erase_range(log_partition, log_head_sector * LOG_SECTOR_SIZE,
+                                          LOG_SECTOR_SIZE) != ESP_OK) {
+                log_flash_errors++;
+                log_index[log_head_sector].valid = 0;
+                lost += count - done;
+                break;
+            }
+            log_index[log_head_sector].first_seq = batch[done].seq;
+            log_index[log_head_sector].first_uptime_ms = batch[done].uptime_ms;
+            log_index[log_head_sector].first_boot = batch[done].boot_count;
+            log_index[log_head_sector].valid = 1;
+        }
+        // Write as many records as fit in the current sector in one call
+        int run = min(count - done, (int)(LOG_RECORDS_PER_SECTOR - log_head_slot));
+        size_t offset = log_head_sector * LOG_SECTOR_SIZE + log_head_slot * LOG_RECORD_SIZE;
+        log_flash_writes++;
+        if (esp_partition_write(log_partition, offset, &batch[done], run * sizeof(LogRecord)) != ESP_OK) {
+            // The slots stay used; readers skip them by their CRC
+            log_flash_errors++;
+            lost += run;
+        }
+        done += run;
+        log_head_slot += run;
+        if (log_head_slot >= LOG_RECORDS_PER_SECTOR) {
+            log_head_sector = (log_head_sector + 1) % log_sector_count;
+            log_head_slot = 0;
+        }
+    }
+    if (lost > 0) {
+        xSemaphoreTake(log_mutex, portMAX_DELAY);
+        log_records_dropped += lost;
+        xSemaphoreGive(log_mutex);
+    }
+}
+
+// Physical sector of the i-th oldest sector in the ring. Until the head
+// sector has been written to it still holds the previous lap's (oldest) data.
+static uint32_t log_sector_at(uint32_t step)
+{
+    uint32_t oldest = (log_head_slot == 0) ? log_head_sector : log_head_sector + 1;
+    return (oldest + step) % log_sector_count;
+}
+
+// Ring step of the sector holding the first record at/after the given
+// (boot, uptime) time. Sectors are in time order from oldest to newest.
+uint32_t log_find_time(uint16_t boot, uint32_t uptime_ms)
+{
+    uint32_t lo = 0, hi = log_sector_count;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        const LogSectorIndex& e = log_index[log_sector_at(mid)];
+        bool before = !e.valid ||
+                      e.first_boot < boot ||
+                      (e.first_boot == boot && e.first_uptime_ms <= uptime_ms);
+        if (before) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    // lo is the first sector starting after the target; records at the
+    // target time may still live in the sector before it
+    return lo > 0 ? lo - 1 : 0;
+}
+
+uint32_t log_find_seq(uint32_t seq)
+{
+    uint32_t lo = 0, hi = log_sector_count;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        const LogSectorIndex& e = log_index[log_sector_at(mid)];
+        if (!e.valid || e.first_seq <= seq) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo > 0 ? lo - 1 : 0;
+}
+
+// Start an offload of records at/after from_seq and (from_boot, from_ms),
+// beginning at ring step start_step; count == 0 means everything
+void log_dump_start(LogDumpSink sink, uint32_t start_step, uint32_t from_seq,
+                    uint16_t from_boot, uint32_t from_ms, uint32_t count)
+{
+    if (log_partition == NULL) {
+        printf("[LOG] Detection log disabled\n");
+        return;
+    }
+    if (log_dump_sink != LOG_SINK_NONE) {
+        printf("[LOG] %s offload in progress\n", log_dump_sink == LOG_SINK_BLE ? "BLE" : "Serial");
+        return;
+    }
+    log_flush();
+    log_dump_sink = sink;
+    log_dump_sector_step = start_step;
+    log_dump_slot = 0;
+    log_dump_from_seq = from_seq;
+    log_dump_from_boot = from_boot;
+    log_dump_from_ms = from_ms;
+    log_dump_remaining = count ? count : 0xFFFFFFFF;
+    log_dump_sent = 0;
+    log_dump_ble_len = 0;
+    if (sink == LOG_SINK_SERIAL) {
+        printf("LOGDUMP BEGIN from=%lu record_size=%d\n", (unsigned long)from_seq, LOG_RECORD_SIZE);
+    }
+}
+
+static void log_dump_finish()
+{
+    if (log_dump_sink == LOG_SINK_BLE && log_dump_ble_len > 0 && pLogCharacteristic != NULL) {
+        pLogCharacteristic->setValue(log_dump_ble_buf, log_dump_ble_len);
+        pLogCharacteristic->notify();
+    }
+    if (log_dump_sink == LOG_SINK_SERIAL) {
+        printf("\nLOGDUMP END records=%lu\n", (unsigned long)log_dump_sent);
+    } else {
+        printf("[LOG] BLE offload done, %lu records\n", (unsigned long)log_dump_sent);
+    }
+    log_dump_sink = LOG_SINK_NONE;
+}
+
+// Stream bytes to BLE in MTU sized notifications; false when this frame's budget is spent
+static bool log_dump_ble_write(const uint8_t* data, size_t len, size_t chunk, int* notifies_left)
+{
+    while (len > 0) {
+        size_t n = min(len, chunk - log_dump_ble_len);
+        memcpy(log_dump_ble_buf + log_dump_ble_len, data, n);
+        log_dump_ble_len += n;
+        data += n;
+        len -= n;
+        if (log_dump_ble_len == chunk) {
+            pLogCharacteristic->setValue(log_dump_ble_buf, log_dump_ble_len);
+            pLogCharacteristic->notify();
+            log_dump_ble_len = 0;
+            (*notifies_left)--;
+        }
+    }
+    return *notifies_left > 0;
+}
+
+// Emit the next chunk of a pending offload (ui task)
+void continue_log_dump()
+{
+    LogOffloadRequest req;
+    if (log_dump_sink == LOG_SINK_NONE && xQueueReceive(log_request_queue, &req, 0) == pdTRUE) {
+        log_dump_start(LOG_SINK_BLE, log_find_seq(req.from_seq), req.from_seq, 0, 0, req.count);
+    }
+    if (log_dump_sink == LOG_SINK_NONE) {
+        return;
+    }
+    if (log_dump_sink == LOG_SINK_BLE && (!deviceConnected || pLogCharacteristic == NULL)) {
+        log_dump_sink = LOG_SINK_NONE;
+        return;
+    }
+
+    size_t ble_chunk = min((size_t)(ble_peer_mtu - 3), sizeof(log_dump_ble_buf));
+    int notifies_left = LOG_DUMP_NOTIFIES_PER_FRAME;
+    int records_left = LOG_DUMP_RECORDS_PER_FRAME;
+
+    while (log_dump_sector_step < log_sector_count && log_dump_remaining > 0) {
+        uint32_t sector = log_sector_at(log_dump_sector_step);
+        if (!log_index[sector].valid || log_dump_slot >= LOG_RECORDS_PER_SECTOR) {
+            log_dump_sector_step++;
+            log_dump_slot = 0;
+            continue;
+        }
+        LogRecord rec;
+        if (!log_read_record(sector, log_dump_slot, &rec) || rec.magic == 0xFFFF) {
+            // Rest of this sector is unwritten
+            log_dump_sector_step++;
+            log_dump_slot = 0;
+            continue;
+        }
+        log_dump_slot++;
+        if (!log_record_valid(&rec) || rec.seq < log_dump_from_seq ||
+            rec.boot_count < log_dump_from_boot ||
+            (rec.boot_count == log_dump_from_boot && rec.uptime_ms < log_dump_from_ms)) {
+            continue;
+        }
+
+        log_dump_remaining--;
+        log_dump_sent++;
+        if (log_dump_sink == LOG_SINK_SERIAL) {
+            Serial.write((const uint8_t*)&rec, sizeof(rec));
+            if (--records_left == 0) {
+                return;
+            }
+        } else if (!log_dump_ble_write((const uint8_t*)&rec, sizeof(rec), ble_chunk, &notifies_left)) {
+            return;
+        }
+    }
+    log_dump_finish();
+}
+
+// Queue a BLE offload for the ui task; false if the queue is full
+static bool log_request_offload(const uint8_t* data)
+{
+    LogOffloadRequest req;
+    memcpy(&req.from_seq, data, 4);
+    memcpy(&req.count, data + 4, 4);
+    if (log_request_queue == NULL || xQueueSend(log_request_queue, &req, 0) != pdTRUE) {
+        log_requests_dropped++;
+        return false;
+    }
+    return true;
+}
+
+// BLE offload request: from_seq (u32 LE), count (u32 LE, 0 = all).
+// Called from the NimBLE host task
+class LogCharacteristicCallbacks: public NimBLECharacteristicCallbacks {
+    void onWrite(NimBLECharacteristic* pCharacteristic) {
+        std::string value = pCharacteristic->getValue();
+        if (value.length() < 8) {
+            return;
+        }
+        log_request_offload((const uint8_t*)value.data());
+    }
+};
+
+void print_log_stats()
+{
+    if (log_partition == NULL) {
+        printf("Detection log: disabled (no '%s' partition)\n", LOG_PARTITION_LABEL);
+        return;
+    }
+    uint32_t oldest = log_next_seq;
+    for (uint32_t step = 0; step < log_sector_count; step++) {
+        const LogSectorIndex& e = log_index[log_sector_at(step)];
+        if (e.valid) {
+            oldest = e.first_seq;
+            break;
+        }
+    }
+    printf("Detection log: seq %lu..%lu (%lu records), boot %u\n",
+           (unsigned long)oldest, (unsigned long)(log_next_seq ? log_next_seq - 1 : 0),
+           (unsigned long)(log_next_seq - oldest), log_boot_count);
+    printf("Log capacity: %lu records in %lu sectors, head %lu/%lu\n",
+           (unsigned long)(log_sector_count * LOG_RECORDS_PER_SECTOR), (unsigned long)log_sector_count,
+           (unsigned long)log_head_sector, (unsigned long)log_head_slot);
+    printf("Log pending: %d, dropped: %lu, writes: %lu, erases: %lu, flash errors: %lu\n",
+           log_pending_count, (unsigned long)log_records_dropped, (unsigned long)log_flash_writes,
+           (unsigned long)log_sector_erases, (unsigned long)log_flash_errors);
+    printf("Log offload: %s, BLE requests queued: %lu, dropped: %lu\n",
+           log_dump_sink == LOG_SINK_BLE ? "BLE" : log_dump_sink == LOG_SINK_SERIAL ? "Serial" : "idle",
+           (unsigned long)(log_request_queue ? uxQueueMessagesWaiting(log_request_queue) : 0),
+           (unsigned long)log_requests_dropped);
+}
+
+// ============================================================================
+// DETECTION OUTPUT (detect task)
+// ============================================================================
+
+void output_raven_detection_json(const DetectionEvent& ev, const char* mac_str, int sightings, const ArrivalEstimate& arrivals,
+                                 const OutputSinks& sinks)
+{
+    uint32_t fields = output_fields(sinks);
+
+    // Create enhanced JSON output with Raven-specific data
+    StaticJsonDocument<1536> doc;
+    doc["protocol"] = "bluetooth_le";
+    doc["detection_method"] = ev.method;
+    doc["device_type"] = "RAVEN_GUNSHOT_DETECTOR";
+    if (fields & OUT_VENDOR) {
+        doc["manufacturer"] = "SoundThinking/ShotSpotter";
+    }
+    doc["mac_address"] = mac_str;
+    doc["rssi"] = ev.rssi;
+    
+    if (ev.text[0]) {
+        doc["device_name"] = ev.text;
+    }
+    
+    // Raven-specific information
+    if (fields & OUT_MATCH) {
+        doc["raven_service_uuid"] = ev.raven_service_uuid;
+        doc["raven_service_description"] = ev.raven_service_desc;
+        doc["raven_firmware_version"] = ev.raven_fw_version;
+    }
+    if (fields & OUT_DETAIL) {
+        doc["threat_level"] = "CRITICAL";
+    }
+    if (fields & OUT_RANGE) {
+        add_distance_json(doc, ev.rssi, BLE_RSSI_AT_1M);
+        doc["signal_strength"] = ev.rssi > -50 ? "STRONG" : (ev.rssi > -70 ? "MEDIUM" : "WEAK");
+        add_phy_json(doc, ev.phy);
+    }
+
+    // Raven's own 0x3x00 services are far more specific than the SIG-standard
+    // ones (0x18xx) it shares with every other BLE device
+    ScoreFeatures features;
+    score_init(&features, ev.mac, ev.rssi, sightings);
+    features.x[SCORE_BLE] = 1;
+    score_arrivals(&features, arrivals);
+    if (fields & OUT_MATCH) {
+        add_interval_json(doc, arrivals);
+    }
+    for (int i = 0; i < ev.service_uuid_count; i++) {
+        const GenRavenService* service = gen_lookup_raven_service(ev.service_uuids[i]);
+        if (service == NULL) continue;
+        if (service->uuid[2] == 0x18) {
+            features.x[SCORE_RAVEN_STANDARD]++;
+        } else {
+            features.x[SCORE_RAVEN_CUSTOM]++;
+        }
+    }
+    int score = score_compute(&features);
+    score_add_json(doc, &features, score, fields & OUT_FEATURES);
+    update_detection_state(RAVEN, score, ev.rssi);
+    
+    // List all detected service UUIDs
+    if ((fields & OUT_MATCH) && ev.service_uuid_count > 0) {
+        JsonArray services = doc.createNestedArray("service_uuids");
+        for (int i = 0; i < ev.service_uuid_count; i++) {
+            services.add(ev.service_uuids[i]);
+        }
+    }
+    
+    // Output the detection (Serial only)
+    output_emit(doc, sinks);
+}
+
+void process_detection_event(DetectionEvent& ev)
+{
+    // Repeat sightings inside the debounce window only keep the device "in range"
+    uint8_t air_mac[6];
+    memcpy(air_mac, ev.mac, 6);
+    xSemaphoreTake(device_table_mutex, portMAX_DELAY);
+    ble_identity_resolve(&ev);
+    char mac_str[18];
+    snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x:%02x:%02x:%02x",
+             ev.mac[0], ev.mac[1], ev.mac[2], ev.mac[3], ev.mac[4], ev.mac[5]);
+    bool debounced = isDeviceDebounced(mac_str);
+    noteDeviceArrival(mac_str, ev.epoch, ev.rx_us);
+    int sightings = getDeviceDetectionCount(mac_str);
+    ArrivalEstimate arrivals = getDeviceArrivals(mac_str);
+    DetectionType known_category = getDeviceCategory(mac_str);
+    sketch_note_mac(ev.mac);
+    if (ev.source == EVENT_WIFI && ev.text[0] && strcmp(ev.text, "hidden") != 0) {
+        sketch_note_ssid(ev.text);
+    }
+    if (debounced) {
+        sketch_note_category(ev.mac, known_category);
+    } else {
+        if (ev.source == EVENT_WIFI) {
+            total_wifi_detections++;
+            channel_detections[ev.channel]++;
+        } else {
+            total_ble_detections++;
+        }
+        state_dirty = true;
+    }
+    xSemaphoreGive(device_table_mutex);
+
+    if (debounced) {
+        unsigned long now = millis();
+        last_detection_time = now;
+        last_rssi = ev.rssi;
+        if (threat_refresh(known_category, ev.rssi, now)) {
+            bool was_in_range = device_in_range;
+            device_in_range = true;
+            restart_range_timer(was_in_range);
+        }
+        return;
+    }
+
+    DetectionType category = NONE;
+    bool summarize = load_summarize(ev);
+    OutputSinks sinks = output_gate(&ev, summarize);
+    switch (ev.source) {
+        case EVENT_WIFI:
+            category = output_wifi_detection_json(ev, sightings, arrivals, sinks);
+            break;
+        case EVENT_BLE:
+            category = output_ble_detection_json(mac_str, ev.text, ev.rssi, ev.phy, ev.method, sightings, arrivals, sinks);
+            break;
+        case EVENT_RAVEN:
+            sinks.mask &= 1u << OUT_SINK_SERIAL;
+            output_raven_detection_json(ev, mac_str, sightings, arrivals, sinks);
+            category = RAVEN;
+            break;
+    }
+    if (summarize) {
+        load_note_summarized(category);
+    }
+    log_append(ev, category);
+    if (category == RAVEN && ev.source != EVENT_WIFI) {
+        gatt_request(air_mac, ev.addr_type, ev.mac);
+    }
+    if (ev.source == EVENT_WIFI) {
+        // SSIDs this device probed for that the log doesn't have yet
+        char probed[PROBE_SSIDS_PER_CLIENT][33];
+        int n = probe_history(ev.mac, probed, true);
+        DetectionEvent rec = ev;
+        rec.source = EVENT_PROBED_SSID;
+        for (int i = 0; i < n; i++) {
+            strncpy(rec.text, probed[i], sizeof(rec.text));
+            log_append(rec, category);
+        }
+    }
+
+    xSemaphoreTake(device_table_mutex, portMAX_DELAY);
+    setDeviceCategory(mac_str, category);
+    sketch_note_category(ev.mac, category);
+    xSemaphoreGive(device_table_mutex);
+}
+
+// ============================================================================
+// CHANNEL HOPPING AND BLE SCAN CONTROL (radio task)
+// ============================================================================
+
+void hop_channel()
+{
+    survey_note_hop(current_channel);
+    wifi_dwell_epoch++;
+    current_channel++;
+    if (current_channel > MAX_CHANNEL) {
+        current_channel = 1;
+    }
+    esp_wifi_set_channel(current_channel, WIFI_SECOND_CHAN_NONE);
+    if (survey_mode == SURVEY_HOP) {
+        // Dwell on this channel in proportion to its occupancy
+        xTimerChangePeriod(hop_timer, pdMS_TO_TICKS(survey_dwell_ms[current_channel]), 0);
+    }
+    last_channel_hop = millis();
+    if (verbosity >= VERBOSITY_VERBOSE) {
+        printf("[WiFi] Hopped to channel %d\n", current_channel);
+    }
+}
+
+// NimBLE host task, when a regular scan ends
+static void ble_scan_complete(NimBLEScanResults results)
+{
+    if (ble_scan_policy == BLE_SCAN_ADAPTIVE && radio_task_handle != NULL) {
+        xTaskNotify(radio_task_handle, NOTIFY_BLE_CANDIDATES, eSetBits);
+    }
+}
+
+void start_ble_scan()
+{
+    if (pBLEScan->isScanning()) {
+        return;
+    }
+    ble_scan_configure();
+    pBLEScan->clearResults();
+    if (verbosity >= VERBOSITY_VERBOSE) {
+        printf("[BLE] %s scan%s...\n", ble_scan_kind_names[ble_scan_kind], ble_scan_on_coded ? " (Coded PHY)" : "");
+    }
+    // Non-blocking: results arrive through AdvertisedDeviceCallbacks
+    ble_scan_epoch++;
+    pBLEScan->start(ble_scan_duration_s, ble_scan_complete, false);
+    last_ble_scan = millis();
+}
+
+// Candidate scan in the gap after a passive regular scan, see BLE SCAN
+// POLICY. A discovery scan already reached the candidates
+void start_ble_candidate_scan()
+{
+    if (ble_scan_policy != BLE_SCAN_ADAPTIVE || ble_scan_kind != BLE_SCAN_KIND_PASSIVE ||
+        pBLEScan->isScanning()) {
+        return;
+    }
+    ble_scan_tally();
+    if (!ble_candidates_pending()) {
+        return;
+    }
+    // Must end before the next regular scan, and a GATT connection attempt
+    // must not meet an active scan
+    unsigned long since_scan = millis() - last_ble_scan;
+    if (since_scan + BLE_CANDIDATE_WINDOW_S * 1000 + BLE_CANDIDATE_MARGIN_MS >= (unsigned long)ble_scan_interval_ms ||
+        (gatt_connect_mutex != NULL && xSemaphoreTake(gatt_connect_mutex, 0) != pdTRUE)) {
+        ble_candidate_windows_skipped++;
+        return;
+    }
+    if (ble_candidate_scan_configure()) {
+        if (verbosity >= VERBOSITY_VERBOSE) {
+            printf("[BLE] candidate scan...\n");
+        }
+        ble_scan_epoch++;
+        pBLEScan->start(BLE_CANDIDATE_WINDOW_S, nullptr, false);
+    }
+    if (gatt_connect_mutex != NULL) {
+        xSemaphoreGive(gatt_connect_mutex);
+    }
+}
+
+// ============================================================================
+// WARM START STATE (NVS snapshot)
+// ============================================================================
+//
+// The device table, per-channel statistics and session counters are kept in
+// one compact NVS blob so a power cycle (car ignition) does not reset them.
+// It is written every STATE_SNAPSHOT_INTERVAL_MS when something changed and
+// from the shutdown handler on a software restart. A brown-out reset gives
+// no chance to write flash safely, so at most one interval of changes is lost.
+
+#define STATE_SNAPSHOT_VERSION 2
+
+struct __attribute__((packed)) SnapshotDevice {
+    uint8_t mac[6];
+    uint16_t count;             // Detection count (saturating)
+    uint16_t age_s;             // Seconds since last seen at snapshot time
+};
+
+struct __attribute__((packed)) StateSnapshot {
+    uint16_t version;
+    uint8_t device_count;
+    uint8_t channel;
+    uint32_t total_wifi_detections;
+    uint32_t total_ble_detections;
+    uint32_t channel_frames[MAX_CHANNEL + 1];
+    uint16_t channel_detections[MAX_CHANNEL + 1];
+    SnapshotDevice devices[MAX_SEEN_DEVICES];
+};
+
+static Preferences state_prefs;
+static uint32_t state_snapshots_written = 0;
+
+void save_state_snapshot()
+{
+    static StateSnapshot snap;
+    memset(&snap, 0, sizeof(snap));
+    snap.version = STATE_SNAPSHOT_VERSION;
+    snap.channel = current_channel;
+    unsigned long now = millis();
+
+    xSemaphoreTake(device_table_mutex, portMAX_DELAY);
+    snap.total_wifi_detections = total_wifi_detections;
+    snap.total_ble_detections = total_ble_detections;
+    for (int c = 0; c <= MAX_CHANNEL; c++) {
+        snap.channel_frames[c] = channel_frames[c];
+        snap.channel_detections[c] = channel_detections[c];
+    }
+    snap.device_count = seenDeviceCount;
+    for (int i = 0; i < seenDeviceCount; i++) {
+        SnapshotDevice& d = snap.devices[i];
+        sscanf(seenDevices[i].mac, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
+               &d.mac[0], &d.mac[1], &d.mac[2], &d.mac[3], &d.mac[4], &d.mac[5]);
+        d.count = min(seenDevices[i].detectionCount, 0xFFFF);
+        d.age_s = min((now - seenDevices[i].lastSeen) / 1000, 0xFFFFUL);
+    }
+    state_dirty = false;
+    xSemaphoreGive(device_table_mutex);
+
+    // Only the used part of the device array is stored
+    size_t len = offsetof(StateSnapshot, devices) + snap.device_count * sizeof(SnapshotDevice);
+    state_prefs.putBytes("state", &snap, len);
+    state_snapshots_written++;
+}
+
+// Called before tasks start, so nothing else touches the tables yet
+void restore_state_snapshot()
+{
+    static StateSnapshot snap;
+    memset(&snap, 0, sizeof(snap));
+    size_t len = state_prefs.getBytes("state", &snap, sizeof(snap));
+    size_t header = offsetof(StateSnapshot, devices);
+    if (len < header || snap.version != STATE_SNAPSHOT_VERSION ||
+        snap.device_count > MAX_SEEN_DEVICES ||
+        len != header + snap.device_count * sizeof(SnapshotDevice)) {
+        printf("[STATE] No valid snapshot, starting fresh\n");
+        return;
+    }
+
+    total_wifi_detections = snap.total_wifi_detections;
+    total_ble_detections = snap.total_ble_detections;
+    for (int c = 0; c <= MAX_CHANNEL; c++) {
+        channel_frames[c] = snap.channel_frames[c];
+        channel_detections[c] = snap.channel_detections[c];
+    }
+    if (snap.channel >= 1 && snap.channel <= MAX_CHANNEL) {
+        current_channel = snap.channel;
+    }
+
+    unsigned long now = millis();
+    seenDeviceCount = snap.device_count;
+    for (int i = 0; i < seenDeviceCount; i++) {
+        const SnapshotDevice& d = snap.devices[i];
+        snprintf(seenDevices[i].mac, sizeof(seenDevices[i].mac), "%02x:%02x:%02x:%02x:%02x:%02x",
+                 d.mac[0], d.mac[1], d.mac[2], d.mac[3], d.mac[4], d.mac[5]);
+        seenDevices[i].detectionCount = d.count;
+        unsigned long age_ms = (unsigned long)d.age_s * 1000;
+        seenDevices[i].lastSeen = now > age_ms ? now - age_ms : 0;
+    }
+    printf("[STATE] Restored %d devices, %lu WiFi / %lu BLE detections\n", seenDeviceCount,
+           (unsigned long)total_wifi_detections, (unsigned long)total_ble_detections);
+}
+
+void clear_state_snapshot()
+{
+    state_prefs.remove("state");
+    state_prefs.remove("sketch");
+}
+
+// Session sketches go in their own blob, written less often than the snapshot
+void save_session_sketches(bool force)
+{
+    static unsigned long last_save = 0;
+    if (!sketch_dirty || (!force && millis() - last_save < SKETCH_SAVE_INTERVAL_MS)) {
+        return;
+    }
+    // Copy under the mutex and write NVS after releasing it, so the detect
+    // task never waits on a flash write
+    static SessionSketches copy;
+    xSemaphoreTake(device_table_mutex, portMAX_DELAY);
+    sketch_dirty = false;
+    memcpy(&copy, &sketches, sizeof(copy));
+    xSemaphoreGive(device_table_mutex);
+    state_prefs.putBytes("sketch", &copy, sizeof(copy));
+    last_save = millis();
+}
+
+// Called before tasks start
+void restore_session_sketches()
+{
+    static SessionSketches saved;
+    if (state_prefs.getBytes("sketch", &saved, sizeof(saved)) != sizeof(saved) ||
+        saved.version != SKETCH_VERSION || saved.top_mac_count > SKETCH_TOP_MACS ||
+        saved.top_ssid_count > SKETCH_TOP_SSIDS) {
+        return;
+    }
+    memcpy(&sketches, &saved, sizeof(sketches));
+    printf("[STATE] Restored session sketches: ~%lu devices detected\n",
+           (unsigned long)sketch_unique_devices());
+}
+
+void clear_session_sketches()
+{
+    memset(&sketches, 0, sizeof(sketches));
+    sketches.version = SKETCH_VERSION;
+    sketch_dirty = false;
+}
+
+static void state_shutdown_handler()
+{
+    save_state_snapshot();
+    save_session_sketches(true);
+}
+
+void print_boot_timing()
+{
+    printf("Boot to scanning: %lu ms\n", (unsigned long)(boot_scan_ready_us / 1000));
+    printf("Boot to first WiFi frame: %lu ms\n", (unsigned long)(boot_first_wifi_frame_us / 1000));
+    printf("Boot to first BLE advert: %lu ms\n", (unsigned long)(boot_first_ble_adv_us / 1000));
+}
+
+// ============================================================================
+// CONFIGURATION REGISTRY
+// ============================================================================
+//
+// Each live-tunable setting is one row: its name (also its NVS key), its BLE
+// control key, storage, default and bounds, and an optional hook that applies
+// a new value to its subsystem. Changes from Serial ('config') or BLE
+// (CONFIG_SET) take effect at once and are saved in NVS, so a unit keeps its
+// tuning across power cycles. Settings without a hook are read where used.
+
+struct ConfigEntry {
+    const char* name;           // Serial name and NVS key (max 15 chars)
+    uint8_t key;                // BLE control protocol id, never reused
+    int32_t* value;
+    int32_t def;
+    int32_t min;
+    int32_t max;
+    const char* const* names;   // Value names for enumerated settings, else NULL
+    void (*on_change)();
+};
+
+static const char* const verbosity_names[] = { "quiet", "normal", "verbose" };
+static const char* const profile_names[] = { "minimal", "standard", "forensic" };
+
+static Preferences config_prefs;
+
+// Applies a new period to a timer without starting it if it was stopped
+static void config_retime(TimerHandle_t timer, int32_t ms)
+{
+    if (timer == NULL) {
+        return;  // Not created yet; start_tasks() uses the current value
+    }
+    bool active = xTimerIsTimerActive(timer);
+    xTimerChangePeriod(timer, pdMS_TO_TICKS(ms), 0);
+    if (!active) {
+        xTimerStop(timer, 0);
+    }
+}
+
+static void config_apply_hop() { config_retime(hop_timer, hop_interval_ms); }
+static void config_apply_ble_scan() { config_retime(ble_scan_timer, ble_scan_interval_ms); }
+static void config_apply_heartbeat() { config_retime(heartbeat_timer, heartbeat_interval_ms); }
+static void config_apply_survey_ms() { config_retime(survey_timer, survey_report_ms); }
+
+static void config_apply_survey()
+{
+    wifi_promiscuous_filter_t promisc_filter = {};
+    promisc_filter.filter_mask = survey_filter_mask();
+    esp_wifi_set_promiscuous_filter(&promisc_filter);
+    survey_reset_dwell();
+    survey_take_baseline();
+    if (survey_mode != SURVEY_HOP) {
+        config_apply_hop();
+    }
+    if (survey_timer == NULL) {
+        return;
+    }
+    if (survey_mode == SURVEY_OFF) {
+        xTimerStop(survey_timer, 0);
+    } else {
+        xTimerChangePeriod(survey_timer, pdMS_TO_TICKS(survey_report_ms), 0);
+    }
+}
+
+static const ConfigEntry config_entries[] = {
+    { "led_bright",   1, &led_brightness,        LED_BRIGHTNESS,          0,     255,    NULL, NULL },
+    { "enter_score",  2, &threat_enter_score,    THREAT_ENTER_SCORE,      1,     100,    NULL, NULL },
+    { "hold_score",   3, &threat_hold_score,     THREAT_HOLD_SCORE,       0,     100,    NULL, NULL },
+    { "hop_ms",       4, &hop_interval_ms,       CHANNEL_HOP_INTERVAL,    50,    10000,  NULL, config_apply_hop },
+    { "ble_scan_s",   5, &ble_scan_duration_s,   BLE_SCAN_DURATION,       1,     30,     NULL, NULL },
+    { "ble_every_ms", 6, &ble_scan_interval_ms,  BLE_SCAN_INTERVAL,       1000,  120000, NULL, config_apply_ble_scan },
+    { "debounce_ms",  7, &debounce_window_ms,    DEBOUNCE_WINDOW_MS,      1000,  600000, NULL, NULL },
+    { "range_ms",     8, &out_of_range_ms,       OUT_OF_RANGE_TIMEOUT_MS, 5000,  600000, NULL, NULL },
+    { "heartbeat_ms", 9, &heartbeat_interval_ms, HEARTBEAT_INTERVAL_MS,   1000,  120000, NULL, config_apply_heartbeat },
+    { "verbosity",   10, &verbosity,             VERBOSITY_VERBOSE,       0,     2,      verbosity_names, NULL },
+    { "serial_profile", 11, &serial_profile,     PROFILE_FORENSIC,        0,     2,      profile_names, NULL },
+    { "ble_profile", 12, &ble_profile,           PROFILE_STANDARD,        0,     2,      profile_names, NULL },
+    { "survey",      13, &survey_mode,           SURVEY_OFF,              0,     2,      survey_mode_names, config_apply_survey },
+    { "survey_ms",   14, &survey_report_ms,      SURVEY_REPORT_MS,        1000,  3600000, NULL, config_apply_survey_ms },
+    { "gatt",        15, &gatt_mode,             GATT_OFF,                0,     1,      gatt_mode_names, gatt_start_pool },
+    { "gatt_groups", 16, &gatt_groups,           GATT_GROUPS_DEFAULT,     1,     0x3F,   NULL, NULL },
+    { "ble_active",  17, &ble_scan_policy,       BLE_SCAN_ADAPTIVE,       0,     2,      ble_scan_policy_names, NULL },
+    { "ble_coded",   18, &ble_coded_every,       BLE_CODED_EVERY,         0,     16,     NULL, NULL },
+    { "load_shed",   19, &load_shed_mode,        LOAD_SHED_ON,            0,     1,      load_shed_names, NULL },
+    { "serial_rate", 20, &output_serial_rate,    OUTPUT_SERIAL_RATE,      0,     6000,   NULL, NULL },
+    { "serial_burst", 21, &output_serial_burst,  OUTPUT_SERIAL_BURST,     1,     100,    NULL, NULL },
+    { "ble_rate",    22, &output_ble_rate,       OUTPUT_BLE_RATE,         0,     6000,   NULL, NULL },
+    { "ble_burst",   23, &output_ble_burst,      OUTPUT_BLE_BURST,        1,     100,    NULL, NULL },
+};
+
+#define CONFIG_ENTRY_COUNT (sizeof(config_entries) / sizeof(config_entries[0]))
+
+const ConfigEntry* config_find(const char* name)
+{
+    for (size_t i = 0; i < CONFIG_ENTRY_COUNT; i++) {
+        if (strcasecmp(config_entries[i].name, name) == 0) {
+            return &config_entries[i];
+        }
+    }
+    return NULL;
+}
+
+const ConfigEntry* config_find_key(uint8_t key)
+{
+    for (size_t i = 0; i < CONFIG_ENTRY_COUNT; i++) {
+        if (config_entries[i].key == key) {
+            return &config_entries[i];
+        }
+    }
+    return NULL;
+}
+
+// Accepts a number or, for enumerated settings, one of the value names
+bool config_parse_value(const ConfigEntry* entry, const char* text, int32_t* out)
+{
+    if (entry->names != NULL) {
+        for (int32_t v = entry->min; v <= entry->max; v++) {
+            if (strcasecmp(entry->names[v], text) == 0) {
+                *out = v;
+                return true;
+            }
+        }
+    }
+    char* end = NULL;
+    long v = strtol(text, &end, 0);
+    if (*text == '\0' || *end != '\0') {
+        return false;
+    }
+    *out = v;
+    return true;
+}
+
+// Constraints between settings: a threat must be able to stay active, so
+// the hold score may not exceed the enter score
+static bool config_cross_check(const ConfigEntry* entry, int32_t value)
+{
+    if (entry->value == &threat_hold_score) {
+        return value <= threat_enter_score;
+    }
+    if (entry->value == &threat_enter_score) {
+        return value >= threat_hold_score;
+    }
+    return true;
+}
+
+// Bounds-checks, stores, applies and persists a value
+bool config_set(const ConfigEntry* entry, int32_t value)
+{
+    if (value < entry->min || value > entry->max || !config_cross_check(entry, value)) {
+        return false;
+    }
+    if (*entry->value == value) {
+        return true;
+    }
+    *entry->value = value;
+    if (value == entry->def) {
+        config_prefs.remove(entry->name);
+    } else {
+        config_prefs.putInt(entry->name, value);
+    }
+    if (entry->on_change != NULL) {
+        entry->on_change();
+    }
+    return true;
+}
+
+// Called before tasks start; values outside the current bounds are ignored
+void config_load()
+{
+    config_prefs.begin(CONFIG_NVS_NAMESPACE, false);
+    int loaded = 0;
+    for (size_t i = 0; i < CONFIG_ENTRY_COUNT; i++) {
+        const ConfigEntry& e = config_entries[i];
+        if (!config_prefs.isKey(e.name)) {
+            continue;
+        }
+        int32_t v = config_prefs.getInt(e.name, e.def);
+        if (v >= e.min && v <= e.max) {
+            *e.value = v;
+            loaded++;
+        }
+    }
+    if (loaded > 0) {
+        printf("[CONFIG] %d setting(s) loaded from NVS\n", loaded);
+    }
+    if (threat_hold_score > threat_enter_score) {
+        printf("[CONFIG] hold_score %ld above enter_score, using %ld\n", (long)threat_hold_score,
+               (long)threat_enter_score);
+        threat_hold_score = threat_enter_score;
+    }
+}
+
+void config_reset()
+{
+    config_prefs.clear();
+    for (size_t i = 0; i < CONFIG_ENTRY_COUNT; i++) {
+        const ConfigEntry& e = config_entries[i];
+        *e.value = e.def;
+        if (e.on_change != NULL) {
+            e.on_change();
+        }
+    }
+}
+
+void config_print_entry(const ConfigEntry& e)
+{
+    if (e.names != NULL) {
+        printf("%-15s %-8s (default %s)\n", e.name, e.names[*e.value], e.names[e.def]);
+    } else {
+        printf("%-15s %-8ld (default %ld, %ld..%ld)\n", e.name, (long)*e.value, (long)e.def,
+               (long)e.min, (long)e.max);
+    }
+}
+
+// ============================================================================
+// SERIAL COMMANDS, LED AND HEARTBEAT (ui task)
+// ============================================================================
+
+// Per-task stack headroom (bytes never touched since boot)
+void print_task_stats()
+{
+    printf("\n--- Tasks ---\n");
+    printf("radio  (core %d): %u bytes stack free\n", RADIO_TASK_CORE,
+           (unsigned)uxTaskGetStackHighWaterMark(radio_task_handle));
+    printf("detect (core %d): %u bytes stack free\n", DETECT_TASK_CORE,
+           (unsigned)uxTaskGetStackHighWaterMark(detect_task_handle));
+    printf("ui     (core %d): %u bytes stack free\n", UI_TASK_CORE,
+           (unsigned)uxTaskGetStackHighWaterMark(ui_task_handle));
+    for (int i = 0; i < GATT_POOL_SIZE && gatt_task_handles[i] != NULL; i++) {
+        printf("gatt%d  (core %d): %u bytes stack free\n", i, DETECT_TASK_CORE,
+               (unsigned)uxTaskGetStackHighWaterMark(gatt_task_handles[i]));
+    }
+    printf("Detection queue: %u / %d, dropped: %lu\n",
+           (unsigned)uxQueueMessagesWaiting(detection_queue), DETECTION_QUEUE_LENGTH,
+           (unsigned long)detection_events_dropped);
+    print_load_stats();
+    print_rate_limit_stats();
+}
+
+// Non-blocking line reader: bytes are consumed as they arrive and a command
+// is dispatched only once its terminating newline has been seen, so a partial
+// line never stalls the ui task the way Serial.readStringUntil() did.
+#define SERIAL_LINE_MAX 128
+#define SERIAL_MAX_ARGS 8
+#define SERIAL_READ_BUDGET 64       // Max bytes consumed per ui frame
+#define DEVICES_LINES_PER_FRAME 8   // 'devices' output streamed in chunks
+
+static char serial_line[SERIAL_LINE_MAX];
+static size_t serial_line_len = 0;
+static bool serial_line_overflow = false;
+
+// 'devices' dump state: next index to print, -1 when idle
+static int devices_dump_cursor = -1;
+static int devices_dump_limit = 0;
+
+typedef void (*SerialCommandHandler)(int argc, char** argv);
+
+struct SerialCommand {
+    const char* name;
+    const char* usage;          // Argument synopsis for help
+    const char* description;
+    SerialCommandHandler handler;
+};
+
+// Parse an integer argument within [min_val, max_val]
+bool parse_int_arg(const char* arg, long min_val, long max_val, long* out)
+{
+    if (!arg || !*arg) return false;
+    char* end = NULL;
+    long v = strtol(arg, &end, 0);
+    if (*end != '\0' || v < min_val || v > max_val) return false;
+    *out = v;
+    return true;
+}
+
+void cmd_test(int argc, char** argv)
+{
+    printf("\n[TEST] Simulating Axon Body Cam detection...\n");
+    
+    // Create fake Axon BLE detection
+    DynamicJsonDocument doc(2048);
+    doc["timestamp"] = millis();
+    doc["detection_time"] = String(millis() / 1000.0, 3) + "s";
+    doc["protocol"] = "bluetooth_le";
+    doc["detection_method"] = "test_console";
+    doc["alert_level"] = "HIGH";
+    doc["device_category"] = "AXON";
+    doc["mac_address"] = "00:25:df:aa:bb:cc";
+    doc["device_name"] = "Axon Body 3";
+    doc["rssi"] = -55;
+    doc["signal_strength"] = "STRONG";
+    doc["threat_score"] = 95;
+    doc["vendor_oui"] = "00:25:df";
+    doc["manufacturer"] = "Axon Enterprise";
+    doc["test_mode"] = true;
+
+    String json_output;
+    serializeJson(doc, json_output);
+    Serial.println(json_output);
+    send_notification(json_output);
+
+    // Update detection state
+    update_detection_state(AXON, 95, -55);
+    
+    printf("[TEST] Axon detection simulated successfully\n\n");
+}
+
+void cmd_status(int argc, char** argv)
+{
+    // Display current status
+    unsigned long uptime = millis() / 1000;
+    printf("\n========== FLOCK-YOU STATUS ==========\n");
+    printf("Uptime: %lu seconds\n", uptime);
+    printf("Session start: %lu ms ago\n", millis() - session_start_time);
+    printf("WiFi Channel: %d / %d\n", current_channel, MAX_CHANNEL);
+    printf("BLE Connected: %s\n", deviceConnected ? "YES" : "NO");
+    printf("Device in range: %s\n", device_in_range ? "YES" : "NO");
+    ThreatView threats[THREAT_TOP_N];
+    int threat_count = threat_top(threats, THREAT_TOP_N, millis());
+    printf("Active threats: %d\n", threat_count);
+    for (int i = 0; i < threat_count; i++) {
+        printf("  %-12s priority %3u, score %3u, %lu detections, last %lus ago\n",
+               threat_classes[threats[i].type].name, threat_classes[threats[i].type].priority,
+               threats[i].slot.score, (unsigned long)threats[i].slot.detections,
+               (millis() - threats[i].slot.last_seen) / 1000);
+    }
+    printf("Last RSSI: %d dBm\n", last_rssi);
+    printf("\n--- Detection Stats ---\n");
+    printf("Total WiFi detections: %d\n", total_wifi_detections);
+    printf("Total BLE detections: %d\n", total_ble_detections);
+    printf("Unique devices detected: ~%lu\n", (unsigned long)sketch_unique_devices());
+    for (int c = 0; c < SKETCH_CATEGORIES; c++) {
+        uint32_t n = sketch_unique_devices(c);
+        if (n > 0) {
+            printf("  %-12s ~%lu\n", threat_classes[c].name, (unsigned long)n);
+        }
+    }
+    printf("Devices heard: ~%lu WiFi, ~%lu BLE (public addresses)\n",
+           (unsigned long)sketch_heard_wifi_estimate(), (unsigned long)sketch_heard_ble_estimate());
+    printf("Debounce cache: %d / %d\n", seenDeviceCount, MAX_SEEN_DEVICES);
+    printf("\n--- WiFi Frame Filter ---\n");
+    printf("Mgmt frames seen: %lu\n", (unsigned long)wifi_frames_seen);
+    printf("Rejected (subtype): %lu\n", (unsigned long)wifi_frames_rejected_subtype);
+    printf("Rejected (prefilter): %lu\n", (unsigned long)wifi_frames_rejected_prefilter);
+    printf("Fully processed: %lu (%.1f%%)\n", (unsigned long)wifi_frames_processed,
+           wifi_frames_seen ? 100.0 * wifi_frames_processed / wifi_frames_seen : 0.0);
+    print_task_stats();
+    printf("\n--- Boot ---\n");
+    print_boot_timing();
+    printf("State snapshots written: %lu\n", (unsigned long)state_snapshots_written);
+    printf("\n--- Detection Log ---\n");
+    print_log_stats();
+    printf("\n--- Signature Database ---\n");
+    print_sigdb_stats();
+    printf("\n--- Memory ---\n");
+    printf("Free heap: %d bytes\n", ESP.getFreeHeap());
+    printf("Min free heap: %d bytes\n", ESP.getMinFreeHeap());
+    printf("=======================================\n\n");
+}
+
+void cmd_stats(int argc, char** argv)
+{
+    // JSON stats output (for app consumption)
+    DynamicJsonDocument doc(4096);
+    doc["uptime_seconds"] = millis() / 1000;
+    doc["wifi_channel"] = current_channel;
+    doc["ble_connected"] = deviceConnected;
+    doc["device_in_range"] = device_in_range;
+    ThreatView top;
+    doc["current_detection"] = threat_top(&top, 1, millis()) ? top.type : NONE;
+    threat_add_json(doc, millis());
+    doc["last_rssi"] = last_rssi;
+    doc["total_wifi_detections"] = total_wifi_detections;
+    doc["total_ble_detections"] = total_ble_detections;
+    xSemaphoreTake(device_table_mutex, portMAX_DELAY);
+    doc["unique_devices"] = sketch_unique_devices();
+    JsonObject by_category = doc.createNestedObject("unique_by_category");
+    for (int c = 0; c < SKETCH_CATEGORIES; c++) {
+        uint32_t n = sketch_unique_devices(c);
+        if (n > 0) {
+            by_category[threat_classes[c].name] = n;
+        }
+    }
+    add_top_json(doc, STATS_TOP_N);
+    xSemaphoreGive(device_table_mutex);
+    doc["heard_wifi"] = sketch_heard_wifi_estimate();
+    doc["heard_ble"] = sketch_heard_ble_estimate();
+    doc["ble_rotations_linked"] = ble_rotations_linked;
+    add_ble_scan_json(doc);
+    doc["debounce_cache_size"] = seenDeviceCount;
+    doc["wifi_frames_seen"] = (uint32_t)wifi_frames_seen;
+    doc["wifi_frames_rejected_subtype"] = (uint32_t)wifi_frames_rejected_subtype;
+    doc["wifi_frames_rejected_prefilter"] = (uint32_t)wifi_frames_rejected_prefilter;
+    doc["wifi_frames_processed"] = (uint32_t)wifi_frames_processed;
+    doc["free_heap"] = ESP.getFreeHeap();
+    doc["detection_events_dropped"] = (uint32_t)detection_events_dropped;
+    add_load_json(doc);
+    add_rate_limit_json(doc);
+    doc["boot_to_scan_ms"] = (uint32_t)(boot_scan_ready_us / 1000);
+    doc["boot_to_first_wifi_frame_ms"] = (uint32_t)(boot_first_wifi_frame_us / 1000);
+    doc["boot_to_first_ble_adv_ms"] = (uint32_t)(boot_first_ble_adv_us / 1000);
+    doc["log_next_seq"] = log_next_seq;
+    doc["log_boot_count"] = log_boot_count;
+    doc["log_records_dropped"] = log_records_dropped;
+    doc["log_flash_errors"] = log_flash_errors;
+    doc["sigdb_generation"] = active_sigdb ? active_sigdb->header->generation : 0;
+    JsonObject stack_free = doc.createNestedObject("task_stack_free");
+    stack_free["radio"] = uxTaskGetStackHighWaterMark(radio_task_handle);
+    stack_free["detect"] = uxTaskGetStackHighWaterMark(detect_task_handle);
+    stack_free["ui"] = uxTaskGetStackHighWaterMark(ui_task_handle);
+    
+    String json_output;
+    serializeJson(doc, json_output);
+    Serial.println(json_output);
+}
+
+void cmd_devices(int argc, char** argv)
+{
+    long limit = seenDeviceCount;
+    if (argc > 1 && !parse_int_arg(argv[1], 1, MAX_SEEN_DEVICES, &limit)) {
+        printf("Usage: devices [1-%d]\n", MAX_SEEN_DEVICES);
+        return;
+    }
+    // List seen devices - the rows are emitted by continue_devices_dump()
+    printf("\n========== SEEN DEVICES ==========\n");
+    devices_dump_cursor = 0;
+    devices_dump_limit = limit;
+}
+
+void cmd_clear(int argc, char** argv)
+{
+    // Clear debounce cache and detection counters; the detect task updates
+    // these under the mutex
+    xSemaphoreTake(device_table_mutex, portMAX_DELAY);
+    seenDeviceCount = 0;
+    clear_session_sketches();
+    clear_ble_identities();
+    total_wifi_detections = 0;
+    total_ble_detections = 0;
+    memset(channel_detections, 0, sizeof(channel_detections));
+    xSemaphoreGive(device_table_mutex);
+    clear_probe_history();
+    clear_ble_scan_policy();
+    clear_load_stats();
+    clear_rate_limits();
+    wifi_frames_seen = 0;
+    wifi_frames_rejected_subtype = 0;
+    wifi_frames_rejected_prefilter = 0;
+    wifi_frames_processed = 0;
+    memset((void*)channel_frames, 0, sizeof(channel_frames));
+    clear_state_snapshot();
+    printf("[OK] Stats and debounce cache cleared\n");
+}
+
+void cmd_log(int argc, char** argv)
+{
+    const char* sub = argc > 1 ? argv[1] : "info";
+    long a = 0, b = 0, c = 0;
+    if (strcasecmp(sub, "info") == 0) {
+        print_log_stats();
+    } else if (strcasecmp(sub, "flush") == 0) {
+        log_flush();
+        printf("[OK] Detection log flushed\n");
+    } else if (strcasecmp(sub, "dump") == 0) {
+        // log dump [from_seq] [count]
+        if ((argc > 2 && !parse_int_arg(argv[2], 0, 0x7FFFFFFF, &a)) ||
+            (argc > 3 && !parse_int_arg(argv[3], 0, 0x7FFFFFFF, &b))) {
+            printf("Usage: log dump [from_seq] [count]\n");
+            return;
+        }
+        log_dump_start(LOG_SINK_SERIAL, log_find_seq(a), a, 0, 0, b);
+    } else if (strcasecmp(sub, "since") == 0) {
+        // log since <boot> [uptime_s] [count]
+        if (argc < 3 || !parse_int_arg(argv[2], 0, 0xFFFF, &a) ||
+            (argc > 3 && !parse_int_arg(argv[3], 0, 0x3FFFFF, &b)) ||
+            (argc > 4 && !parse_int_arg(argv[4], 0, 0x7FFFFFFF, &c))) {
+            printf("Usage: log since <boot> [uptime_s] [count]\n");
+            return;
+        }
+        uint32_t since_ms = (uint32_t)b * 1000;
+        log_dump_start(LOG_SINK_SERIAL, log_find_time(a, since_ms), 0, a, since_ms, c);
+    } else {
+        printf("Usage: log [info|flush|dump|since]\n");
+    }
+}
+
+void cmd_sigdb(int argc, char** argv)
+{
+    const char* sub = argc > 1 ? argv[1] : "info";
+    long size = 0;
+    if (strcasecmp(sub, "info") == 0) {
+        print_sigdb_stats();
+    } else if (strcasecmp(sub, "load") == 0) {
+        // sigdb load <size>, then the raw image follows on Serial
+        if (argc < 3 || !parse_int_arg(argv[2], 1, 0x7FFFFFFF, &size)) {
+            printf("Usage: sigdb load <size>\n");
+            return;
+        }
+        sigdb_load_begin(size);
+    } else if (strcasecmp(sub, "use") == 0) {
+        int slot = sigdb_newest_slot();
+        sigdb_activate(slot);
+        print_sigdb_stats();
+    } else if (strcasecmp(sub, "builtin") == 0) {
+        sigdb_activate(-1);
+        printf("[OK] Using compiled-in tables until reboot or 'sigdb use'\n");
+    } else {
+        printf("Usage: sigdb [info|load|use|builtin]\n");
+    }
+}
+
+void cmd_config(int argc, char** argv)
+{
+    if (argc == 1) {
+        printf("\n========== CONFIGURATION ==========\n");
+        for (size_t i = 0; i < CONFIG_ENTRY_COUNT; i++) {
+            config_print_entry(config_entries[i]);
+        }
+        printf("===================================\n\n");
+        return;
+    }
+    if (argc == 2 && strcasecmp(argv[1], "reset") == 0) {
+        config_reset();
+        printf("[OK] All settings back to defaults\n");
+        return;
+    }
+    const ConfigEntry* entry = config_find(argv[1]);
+    if (entry == NULL) {
+        printf("Unknown setting: %s (type 'config' for the list)\n", argv[1]);
+        return;
+    }
+    int32_t value = entry->def;
+    if (argc == 2) {
+        config_print_entry(*entry);
+    } else if (!config_parse_value(entry, argv[2], &value) || !config_set(entry, value)) {
+        printf("Invalid value for %s (%ld..%ld)\n", entry->name, (long)entry->min, (long)entry->max);
+        if (value >= entry->min && value <= entry->max && !config_cross_check(entry, value)) {
+            printf("hold_score may not exceed enter_score (now %ld/%ld)\n", (long)threat_hold_score,
+                   (long)threat_enter_score);
+        }
+    } else {
+        config_print_entry(*entry);
+    }
+}
+
+// Builds and serializes a typical WiFi detection in each profile
+static void output_bench()
+{
+    DetectionEvent ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.source = EVENT_WIFI;
+    ev.channel = 6;
+    ev.rssi = -62;
+    uint32_t oui = GEN_OUIS[0] >> 8;
+    uint8_t mac[6] = { (uint8_t)(oui >> 16), (uint8_t)(oui >> 8), (uint8_t)oui, 0x12, 0x34, 0x56 };
+    memcpy(ev.mac, mac, 6);
+    ev.method = "probe_request";
+    strcpy(ev.text, "Flock-A1B2C3");
+    ArrivalEstimate arrivals = { 102400, 250 };
+
+    const int rounds = 20;
+    printf("\nProfile    Bytes   Build us   Serialize us\n");
+    for (int p = PROFILE_MINIMAL; p <= PROFILE_FORENSIC; p++) {
+        int64_t build_us = 0, serialize_us = 0;
+        size_t bytes = 0;
+        for (int r = 0; r < rounds; r++) {
+            DynamicJsonDocument doc(2048);
+            int score;
+            int64_t t0 = esp_timer_get_time();
+            build_wifi_detection_json(doc, ev, 1, arrivals, output_profile_masks[p], &score);
+            int64_t t1 = esp_timer_get_time();
+            String json_output;
+            serializeJson(doc, json_output);
+            int64_t t2 = esp_timer_get_time();
+            build_us += t1 - t0;
+            serialize_us += t2 - t1;
+            bytes = json_output.length();
+        }
+        printf("%-9s %6u %10lu %14lu\n", profile_names[p], (unsigned)bytes,
+               (unsigned long)(build_us / rounds), (unsigned long)(serialize_us / rounds));
+    }
+    printf("\n");
+}
+
+void cmd_output(int argc, char** argv)
+{
+    if (argc > 1 && strcasecmp(argv[1], "bench") == 0) {
+        output_bench();
+        return;
+    }
+    const char* sinks[2] = { "Serial", "BLE" };
+    int32_t profiles[2] = { serial_profile, ble_profile };
+    for (int i = 0; i < 2; i++) {
+        printf("%-6s profile %-8s %lu detections, %lu bytes", sinks[i], profile_names[profiles[i]],
+               (unsigned long)output_messages[i], (unsigned long)output_bytes[i]);
+        if (output_messages[i] > 0) {
+            printf(" (avg %lu)", (unsigned long)(output_bytes[i] / output_messages[i]));
+        }
+        printf("\n");
+    }
+}
+
+void cmd_capture(int argc, char** argv)
+{
+    const char* sub = argc > 1 ? argv[1] : "info";
+    long snaplen = capture_snaplen;
+    if (strcasecmp(sub, "info") == 0) {
+        print_capture_stats();
+    } else if (strcasecmp(sub, "off") == 0) {
+        capture_stop();
+        print_capture_stats();
+    } else if (strcasecmp(sub, "matched") == 0 || strcasecmp(sub, "mgmt") == 0) {
+        // capture <matched|mgmt> [snaplen]
+        if (argc > 2 && !parse_int_arg(argv[2], 24, CAPTURE_MAX_SNAPLEN, &snaplen)) {
+            printf("Usage: capture <matched|mgmt> [snaplen 24..%d]\n", CAPTURE_MAX_SNAPLEN);
+            return;
+        }
+        uint8_t mode = strcasecmp(sub, "mgmt") == 0 ? CAPTURE_MGMT : CAPTURE_MATCHED;
+        if (!capture_start(mode, (uint16_t)snaplen)) {
+            printf("[CAPTURE] Out of memory\n");
+            return;
+        }
+        printf("[CAPTURE] Streaming %s frames, snaplen %ld\n", capture_mode_names[mode], snaplen);
+    } else {
+        printf("Usage: capture [info|off|matched|mgmt] [snaplen]\n");
+    }
+}
+
+void cmd_survey(int argc, char** argv)
+{
+    long channel = 0;
+    if (argc > 1 && !parse_int_arg(argv[1], 1, MAX_CHANNEL, &channel)) {
+        printf("Usage: survey [channel]\n");
+        return;
+    }
+    print_survey_stats(channel);
+}
+
+void cmd_top(int argc, char** argv)
+{
+    xSemaphoreTake(device_table_mutex, portMAX_DELAY);
+    print_top();
+    xSemaphoreGive(device_table_mutex);
+}
+
+void cmd_ids(int argc, char** argv)
+{
+    xSemaphoreTake(device_table_mutex, portMAX_DELAY);
+    print_ble_identities();
+    xSemaphoreGive(device_table_mutex);
+}
+
+void cmd_probes(int argc, char** argv)
+{
+    print_probe_history();
+}
+
+void cmd_gatt(int argc, char** argv)
+{
+    print_gatt_results();
+}
+
+void cmd_scan(int argc, char** argv)
+{
+    print_ble_scan_policy();
+}
+
+void cmd_help(int argc, char** argv);
+
+static const SerialCommand serial_commands[] = {
+    { "status",  "",        "Show detailed system status",     cmd_status },
+    { "stats",   "",        "Output stats as JSON",            cmd_stats },
+    { "devices", "[limit]", "List recently seen devices",      cmd_devices },
+    { "top",     "",        "Most detected MACs and SSIDs",    cmd_top },
+    { "ids",     "",        "BLE devices with rotating addresses", cmd_ids },
+    { "probes",  "",        "SSIDs probed for by nearby clients", cmd_probes },
+    { "gatt",    "",        "Raven GATT interrogation results", cmd_gatt },
+    { "scan",    "",        "BLE scan policy and scan request counts", cmd_scan },
+    { "clear",   "",        "Clear detection cache and stats", cmd_clear },
+    { "log",     "[info|flush|dump|since]", "Detection log info and offload", cmd_log },
+    { "sigdb",   "[info|load|use|builtin]", "Signature database", cmd_sigdb },
+    { "config",  "[name [value]|reset]", "Show or change settings", cmd_config },
+    { "output",  "[bench]", "Output profile stats / benchmark", cmd_output },
+    { "capture", "[off|matched|mgmt]", "PCAP stream of WiFi frames", cmd_capture },
+    { "survey",  "[channel]", "Channel survey report / subtypes", cmd_survey },
+    { "test",    "",        "Simulate Axon detection",         cmd_test },
+    { "axon",    "",        "Simulate Axon detection",         cmd_test },
+    { "help",    "",        "Show this help message",          cmd_help },
+};
+
+void cmd_help(int argc, char** argv)
+{
+    printf("\n========== FLOCK-YOU COMMANDS ==========\n");
+    for (size_t i = 0; i < sizeof(serial_commands)/sizeof(serial_commands[0]); i++) {
+        char synopsis[32];
+        snprintf(synopsis, sizeof(synopsis), "%s %s", serial_commands[i].name, serial_commands[i].usage);
+        printf("%-16s - %s\n", synopsis, serial_commands[i].description);
+    }
+    printf("=========================================\n\n");
+}
+
+// Split a line in place into whitespace separated arguments and run it
+void dispatch_serial_command(char* line)
+{
+    char* argv[SERIAL_MAX_ARGS];
+    int argc = 0;
+    char* save = NULL;
+    for (char* tok = strtok_r(line, " \t", &save); tok && argc < SERIAL_MAX_ARGS;
+         tok = strtok_r(NULL, " \t", &save)) {
+        argv[argc++] = tok;
+    }
+    if (argc == 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < sizeof(serial_commands)/sizeof(serial_commands[0]); i++) {
+        if (strcasecmp(argv[0], serial_commands[i].name) == 0) {
+            serial_commands[i].handler(argc, argv);
+            return;
+        }
+    }
+    printf("Unknown command: %s\n", argv[0]);
+    printf("Type 'help' for available commands\n\n");
+}
+
+// Emit the next chunk of a pending 'devices' listing
+void continue_devices_dump()
+{
+    if (devices_dump_cursor < 0) {
+        return;
+    }
+    int end = devices_dump_cursor + DEVICES_LINES_PER_FRAME;
+    int last = min(devices_dump_limit, seenDeviceCount);
+    for (int i = devices_dump_cursor; i < last && i < end; i++) {
+        unsigned long age = (millis() - seenDevices[i].lastSeen) / 1000;
+        printf("%d. %s - Count: %d, Last seen: %lu sec ago",
+            i + 1,
+            seenDevices[i].mac,
+            seenDevices[i].detectionCount,
+            age);
+        const ArrivalStats& a = seenDevices[i].arrivals;
+        if (a.median_us > 0) {
+            printf(", Interval: %lu.%lu ms +/- %lu.%lu", (unsigned long)(a.median_us / 1000),
+                   (unsigned long)(a.median_us % 1000 / 100), (unsigned long)(a.mad_us / 1000),
+                   (unsigned long)(a.mad_us % 1000 / 100));
+        }
+        printf("\n");
+        uint8_t mac[6];
+        sscanf(seenDevices[i].mac, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
+               &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5]);
+        char probed[PROBE_SSIDS_PER_CLIENT][33];
+        int n = probe_history(mac, probed, false);
+        if (n > 0) {
+            printf("   Probes:");
+            for (int k = 0; k < n; k++) {
+                printf(" \"%s\"", probed[k]);
+            }
+            printf("\n");
+        }
+    }
+    if (end >= last) {
+        printf("==================================\n\n");
+        devices_dump_cursor = -1;
+    } else {
+        devices_dump_cursor = end;
+    }
+}
+
+void handle_serial_commands()
+{
+    // A signature upload owns the port until its last byte has arrived
+    if (continue_sigdb_load()) {
+        return;
+    }
+
+    for (int budget = SERIAL_READ_BUDGET; budget > 0 && Serial.available() > 0; budget--) {
+        int c = Serial.read();
+        if (c < 0) {
+            break;
+        }
+        if (c == '\r') {
+            continue;
+        }
+        if (c == '\n') {
+            serial_line[serial_line_len] = '\0';
+            if (serial_line_overflow) {
+                printf("Command too long (max %d chars)\n", SERIAL_LINE_MAX - 1);
+            } else {
+                dispatch_serial_command(serial_line);
+            }
+            serial_line_len = 0;
+            serial_line_overflow = false;
+            continue;
+        }
+        if (serial_line_len < SERIAL_LINE_MAX - 1) {
+            serial_line[serial_line_len++] = (char)c;
+        } else {
+            serial_line_overflow = true;
+        }
+    }
+
+    continue_devices_dump();
+}
+
+// ============================================================================
+// LED PATTERNS
+// ============================================================================
+//
+// Each pattern is a short loop of (color, duration) steps. render_led() works
+// out the color for the current time and only sends a frame when it changes;
+// the RMT peripheral clocks the 24 bits out to the WS2812 in the background.
+// The highest-priority active threat owns the LED. If a second threat is
+// active its color flashes for LED_ACCENT_MS every LED_ACCENT_PERIOD_MS.
+
+#define LED_RMT_CHANNEL RMT_CHANNEL_0
+#define LED_ACCENT_PERIOD_MS 2000
+#define LED_ACCENT_MS 150
+#define LED_MAX_STEPS 4
+
+// WS2812 bit timings in 25 ns RMT ticks (clk_div 2)
+#define WS2812_T0H 16   // 0.40 us
+#define WS2812_T0L 34   // 0.85 us
+#define WS2812_T1H 32   // 0.80 us
+#define WS2812_T1L 18   // 0.45 us
+
+#define LED_RGB(r, g, b) (((uint32_t)(r) << 16) | ((uint32_t)(g) << 8) | (uint32_t)(b))
+
+struct LedStep {
+    uint32_t color;
+    uint16_t ms;
+};
+
+struct LedPattern {
+    uint8_t step_count;
+    LedStep steps[LED_MAX_STEPS];
+};
+
+// Indexed by DetectionType
+static const LedPattern led_patterns[] = {
+    {2, {{LED_RGB(255, 140, 0), 200}, {0, 200}}},                 // NONE: as Flock Safety
+    {2, {{LED_RGB(255, 140, 0), 200}, {0, 200}}},                 // FLOCK_SAFETY: orange blink
+    {2, {{LED_RGB(0, 0, 255), 100}, {LED_RGB(255, 0, 0), 100}}},  // AXON: blue/red police strobe
+    {2, {{LED_RGB(255, 0, 0), 50}, {0, 50}}},                     // RAVEN: fast red strobe
+    {2, {{LED_RGB(0, 255, 255), 300}, {0, 300}}},                 // RING: cyan blink
+    {2, {{LED_RGB(0, 255, 0), 400}, {0, 400}}},                   // CRADLEPOINT: green blink
+    {2, {{LED_RGB(255, 255, 0), 500}, {0, 500}}},                 // DRONE: yellow slow blink
+    {2, {{LED_RGB(255, 255, 255), 400}, {0, 400}}},               // NEST_GOOGLE: white blink
+    {2, {{LED_RGB(0, 255, 100), 400}, {0, 400}}},                 // ARLO: green-teal blink
+    {2, {{LED_RGB(255, 100, 200), 400}, {0, 400}}},               // EUFY: pink blink
+    {2, {{LED_RGB(100, 200, 255), 400}, {0, 400}}},               // WYZE: light blue blink
+    {2, {{LED_RGB(0, 255, 255), 300}, {LED_RGB(255, 255, 255), 300}}},  // BLINK: cyan/white
+    {2, {{LED_RGB(255, 0, 255), 400}, {0, 400}}},                 // ARUBA: magenta blink
+};
+
+static_assert(sizeof(led_patterns) / sizeof(led_patterns[0]) == THREAT_CLASS_COUNT,
+              "led_patterns must have one entry per DetectionType");
+
+// Scanning: dim blue pulse every 2 seconds
+static const LedPattern led_idle_pattern = {2, {{LED_RGB(0, 0, 50), 100}, {0, 1900}}};
+
+static rmt_item32_t led_items[24 * NUMPIXELS];
+static uint32_t led_shown_grb = 0xFFFFFFFF;  // Nothing sent yet
+
+void led_init()
+{
+    rmt_config_t config = RMT_DEFAULT_CONFIG_TX((gpio_num_t)NEOPIXEL_PIN, LED_RMT_CHANNEL);
+    config.clk_div = 2;
+    rmt_config(&config);
+    rmt_driver_install(config.channel, 0, 0);
+}
+
+// Starts sending a frame if the scaled color differs from the one shown.
+// A frame still going out is left alone; the next call retries.
+static void led_show(uint32_t color)
+{
+    uint32_t r = (((color >> 16) & 0xFF) * (led_brightness + 1)) >> 8;
+    uint32_t g = (((color >> 8) & 0xFF) * (led_brightness + 1)) >> 8;
+    uint32_t b = ((color & 0xFF) * (led_brightness + 1)) >> 8;
+    uint32_t grb = (g << 16) | (r << 8) | b;
+    if (grb == led_shown_grb || rmt_wait_tx_done(LED_RMT_CHANNEL, 0) != ESP_OK) {
+        return;
+    }
+    for (int p = 0; p < NUMPIXELS; p++) {
+        for (int bit = 0; bit < 24; bit++) {
+            rmt_item32_t& item = led_items[p * 24 + bit];
+            bool one = grb & (1u << (23 - bit));
+            item.level0 = 1;
+            item.duration0 = one ? WS2812_T1H : WS2812_T0H;
+            item.level1 = 0;
+            item.duration1 = one ? WS2812_T1L : WS2812_T0L;
+        }
+    }
+    rmt_write_items(LED_RMT_CHANNEL, led_items, 24 * NUMPIXELS, false);
+    led_shown_grb = grb;
+}
+
+// Color of a pattern at time now; *next_ms is set to the time left in the step
+static uint32_t led_pattern_color(const LedPattern& pattern, unsigned long now, unsigned long* next_ms)
+{
+    unsigned long cycle = 0;
+    for (int i = 0; i < pattern.step_count; i++) {
+        cycle += pattern.steps[i].ms;
+    }
+    unsigned long t = now % cycle;
+    for (int i = 0; i < pattern.step_count; i++) {
+        if (t < pattern.steps[i].ms) {
+            *next_ms = pattern.steps[i].ms - t;
+            return pattern.steps[i].color;
+        }
+        t -= pattern.steps[i].ms;
+    }
+    *next_ms = 1;
+    return 0;
+}
+
+// Returns the milliseconds until the LED next changes
+unsigned long render_led(unsigned long now)
+{
+    ThreatView top[2];
+    int count = device_in_range ? threat_top(top, 2, now) : 0;
+
+    unsigned long next_ms;
+    uint32_t color;
+    if (count == 0) {
+        color = led_pattern_color(led_idle_pattern, now, &next_ms);
+    } else {
+        color = led_pattern_color(led_patterns[top[0].type], now, &next_ms);
+        if (count > 1) {
+            unsigned long phase = now % LED_ACCENT_PERIOD_MS;
+            unsigned long accent_start = LED_ACCENT_PERIOD_MS - LED_ACCENT_MS;
+            if (phase >= accent_start) {
+                color = led_patterns[top[1].type].steps[0].color;
+                next_ms = LED_ACCENT_PERIOD_MS - phase;
+            } else if (accent_start - phase < next_ms) {
+                next_ms = accent_start - phase;
+            }
+        }
+    }
+
+    led_show(color);
+    return next_ms;
+}
+
+void send_heartbeat()
+{
+    if (!device_in_range) {
+        return;
+    }
+    // Send heartbeat as JSON, with the active threats in priority order
+    DynamicJsonDocument doc(1024);
+    doc["type"] = "heartbeat";
+    doc["message"] = "Still Detected";
+    doc["rssi"] = last_rssi;
+    doc["timestamp"] = millis();
+    threat_add_json(doc, millis());
+    String json_output;
+    serializeJson(doc, json_output);
+    send_notification(json_output);
+    
+    last_heartbeat = millis();
+}
+
+void handle_out_of_range()
+{
+    // range_timer fired: no detection for out_of_range_ms. A category
+    // with a longer expiry (Raven) keeps us in range until it lapses too.
+    unsigned long remaining = threat_remaining_ms(millis());
+    if (remaining > 0) {
+        xTimerChangePeriod(range_timer, pdMS_TO_TICKS(remaining), 0);
+        return;
+    }
+    xTimerStop(heartbeat_timer, 0);
+    if (device_in_range) {
+        printf("Device out of range - stopping heartbeat\n");
+        send_notification("Device out of range");
+        device_in_range = false;
+    }
+}
+
+// ============================================================================
+// BLE CONTROL PROTOCOL
+// ============================================================================
+//
+// Binary request/response on the UART service. A request is one write to RX:
+//   opcode u8, request id u8, payload
+// The response goes out on TX as MTU-sized notifications, each starting with
+//   0xF5, request id u8, opcode u8, status u8, fragment u8 (index | 0x80 on the last)
+// followed by the next part of the payload. 0xF5 never occurs in UTF-8, so a
+// client tells these apart from the JSON text lines on the same characteristic.
+// Request id 0 is reserved for unsolicited telemetry: a STATUS payload when
+// subscribed, a SURVEY payload after each channel survey report.
+// All integers are little-endian. Requests are handled one at a time in the
+// ui task and responses are paced at CONTROL_NOTIFIES_PER_FRAME per frame.
+
+#define CONTROL_FRAME_MARKER 0xF5
+#define CONTROL_FRAME_HEADER 5
+#define CONTROL_LAST_FRAGMENT 0x80
+#define CONTROL_REQUEST_MAX 20          // Fits a default-MTU write
+#define CONTROL_RESPONSE_MAX 768
+#define CONTROL_QUEUE_LENGTH 4
+#define CONTROL_NOTIFIES_PER_FRAME 8
+#define CONTROL_TELEMETRY_MAX_S 3600
+
+enum ControlOpcode {
+    CTRL_STATUS = 0x01,         // -> ControlStatus + ControlThreat[threat_count]
+    CTRL_STATS = 0x02,          // -> ControlStats
+    CTRL_DEVICES = 0x03,        // -> count u8 + ControlDevice[count]
+    CTRL_CLEAR = 0x04,          // Same as the 'clear' command
+    CTRL_CONFIG_GET = 0x05,     // [key u8] -> ControlSetting[] (all without a key)
+    CTRL_CONFIG_SET = 0x06,     // key u8, value i32 -> ControlSetting
+    CTRL_LOG_OFFLOAD = 0x07,    // from_seq u32, count u32 -> oldest u32, next u32; records on LOG
+    CTRL_SUBSCRIBE = 0x08,      // interval_s u16 (0 = stop) -> interval_s u16
+    CTRL_SURVEY = 0x09,         // -> window_ms u32 + ControlSurveyChannel[] (channels with dwell)
+};
+
+enum ControlStatusCode {
+    CTRL_OK = 0,
+    CTRL_ERR_OPCODE = 1,
+    CTRL_ERR_REQUEST = 2,       // Malformed payload
+    CTRL_ERR_RANGE = 3,         // Unknown key or value out of bounds
+    CTRL_ERR_UNAVAILABLE = 4,
+};
+
+struct __attribute__((packed)) ControlStatus {
+    uint32_t uptime_s;
+    uint8_t channel;
+    uint8_t device_in_range;
+    int8_t last_rssi;
+    uint8_t threat_count;
+    uint32_t free_heap;
+};
+
+struct __attribute__((packed)) ControlThreat {
+    uint8_t category;           // DetectionType
+    uint8_t priority;
+    uint8_t score;
+    int8_t rssi;
+    uint16_t detections;        // Saturating
+    uint16_t last_seen_s;
+};
+
+struct __attribute__((packed)) ControlStats {
+    uint32_t total_wifi_detections;
+    uint32_t total_ble_detections;
+    uint32_t unique_devices;
+    uint16_t debounce_cache_size;
+    uint32_t wifi_frames_seen;
+    uint32_t wifi_frames_rejected_subtype;
+    uint32_t wifi_frames_rejected_prefilter;
+    uint32_t wifi_frames_processed;
+    uint32_t detection_events_dropped;
+    uint32_t log_next_seq;
+    uint32_t free_heap;
+    uint32_t min_free_heap;
+};
+
+struct __attribute__((packed)) ControlDevice {
+    uint8_t mac[6];
+    uint16_t count;             // Saturating
+    uint16_t age_s;
+    uint8_t category;           // DetectionType of the last full detection
+};
+
+struct __attribute__((packed)) ControlSetting {
+    uint8_t key;
+    int32_t value;
+    int32_t min;
+    int32_t max;
+};
+
+struct __attribute__((packed)) ControlSurveyChannel {
+    uint8_t channel;
+    uint16_t dwell_ms;          // Saturating, as are the frame counts
+    uint16_t mgmt;
+    uint16_t ctrl;
+    uint16_t data;
+    uint16_t busy_permille;     // Estimated airtime / dwell
+    uint16_t bssids;
+    uint8_t rssi_pct[SURVEY_RSSI_BUCKETS];  // Share of frames per 10 dB bucket
+};
+
+struct ControlRequest {
+    uint8_t len;
+    uint8_t data[CONTROL_REQUEST_MAX];
+};
+
+static QueueHandle_t control_queue = NULL;
+static uint32_t control_requests_dropped = 0;
+static uint16_t control_telemetry_s = 0;
+static volatile bool control_telemetry_due = false;
+
+// Response being sent
+static uint8_t control_response[CONTROL_RESPONSE_MAX];
+static size_t control_response_len = 0;
+static size_t control_response_sent = 0;
+static uint8_t control_response_id = 0;
+static uint8_t control_response_op = 0;
+static uint8_t control_response_status = 0;
+static uint8_t control_response_fragment = 0;
+static bool control_response_pending = false;
+
+// Called from the NimBLE host task: just queue the request for the ui task
+class ControlCharacteristicCallbacks: public NimBLECharacteristicCallbacks {
+    void onWrite(NimBLECharacteristic* pCharacteristic) {
+        std::string value = pCharacteristic->getValue();
+        ControlRequest req;
+        if (value.length() < 2 || value.length() > sizeof(req.data)) {
+            return;
+        }
+        req.len = value.length();
+        memcpy(req.data, value.data(), req.len);
+        if (xQueueSend(control_queue, &req, 0) != pdTRUE) {
+            control_requests_dropped++;
+            return;
+        }
+        if (ui_task_handle != NULL) {
+            xTaskNotify(ui_task_handle, NOTIFY_CONTROL, eSetBits);
+        }
+    }
+};
+
+static bool control_put(const void* data, size_t len)
+{
+    if (control_response_len + len > sizeof(control_response)) {
+        return false;
+    }
+    memcpy(control_response + control_response_len, data, len);
+    control_response_len += len;
+    return true;
+}
+
+static void control_put_setting(const ConfigEntry& entry)
+{
+    ControlSetting out = { entry.key, *entry.value, entry.min, entry.max };
+    control_put(&out, sizeof(out));
+}
+
+static void control_build_status()
+{
+    ThreatView threats[THREAT_CLASS_COUNT];
+    unsigned long now = millis();
+    int count = threat_top(threats, THREAT_CLASS_COUNT, now);
+
+    ControlStatus status;
+    status.uptime_s = now / 1000;
+    status.channel = current_channel;
+    status.device_in_range = device_in_range;
+    status.last_rssi = (int8_t)score_clamp(last_rssi, -128, 127);
+    status.threat_count = count;
+    status.free_heap = ESP.getFreeHeap();
+    control_put(&status, sizeof(status));
+    for (int i = 0; i < count; i++) {
+        ControlThreat t;
+        t.category = threats[i].type;
+        t.priority = threat_classes[threats[i].type].priority;
+        t.score = threats[i].slot.score;
+        t.rssi = threats[i].slot.rssi;
+        t.detections = min(threats[i].slot.detections, (uint32_t)0xFFFF);
+        t.last_seen_s = min((now - threats[i].slot.last_seen) / 1000, 0xFFFFUL);
+        control_put(&t, sizeof(t));
+    }
+}
+
+static void control_build_stats()
+{
+    ControlStats stats;
+    xSemaphoreTake(device_table_mutex, portMAX_DELAY);
+    stats.total_wifi_detections = total_wifi_detections;
+    stats.total_ble_detections = total_ble_detections;
+    stats.unique_devices = sketch_unique_devices();
+    stats.debounce_cache_size = seenDeviceCount;
+    xSemaphoreGive(device_table_mutex);
+    stats.wifi_frames_seen = wifi_frames_seen;
+    stats.wifi_frames_rejected_subtype = wifi_frames_rejected_subtype;
+    stats.wifi_frames_rejected_prefilter = wifi_frames_rejected_prefilter;
+    stats.wifi_frames_processed = wifi_frames_processed;
+    stats.detection_events_dropped = detection_events_dropped;
+    stats.log_next_seq = log_next_seq;
+    stats.free_heap = ESP.getFreeHeap();
+    stats.min_free_heap = ESP.getMinFreeHeap();
+    control_put(&stats, sizeof(stats));
+}
+
+static void control_build_devices()
+{
+    unsigned long now = millis();
+    xSemaphoreTake(device_table_mutex, portMAX_DELAY);
+    uint8_t count = seenDeviceCount;
+    control_put(&count, 1);
+    for (int i = 0; i < count; i++) {
+        ControlDevice d;
+        sscanf(seenDevices[i].mac, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
+               &d.mac[0], &d.mac[1], &d.mac[2], &d.mac[3], &d.mac[4], &d.mac[5]);
+        d.count = min(seenDevices[i].detectionCount, 0xFFFF);
+        d.age_s = min((now - seenDevices[i].lastSeen) / 1000, 0xFFFFUL);
+        d.category = seenDevices[i].category;
+        control_put(&d, sizeof(d));
+    }
+    xSemaphoreGive(device_table_mutex);
+}
+
+static void control_build_survey()
+{
+    if (survey_report_window_ms == 0) {
+        return;
+    }
+    control_put(&survey_report_window_ms, 4);
+    for (int c = 1; c <= MAX_CHANNEL; c++) {
+        const SurveyReport& r = survey_report[c];
+        if (r.dwell_ms == 0) {
+            continue;
+        }
+        ControlSurveyChannel out;
+        out.channel = c;
+        out.dwell_ms = min(r.dwell_ms, (uint32_t)0xFFFF);
+        out.mgmt = min(r.frames[SURVEY_MGMT], (uint32_t)0xFFFF);
+        out.ctrl = min(r.frames[SURVEY_CTRL], (uint32_t)0xFFFF);
+        out.data = min(r.frames[SURVEY_DATA], (uint32_t)0xFFFF);
+        out.busy_permille = r.busy_permille;
+        out.bssids = r.bssids;
+        uint32_t total = 0;
+        for (int i = 0; i < SURVEY_RSSI_BUCKETS; i++) {
+            total += r.rssi_hist[i];
+        }
+        for (int i = 0; i < SURVEY_RSSI_BUCKETS; i++) {
+            out.rssi_pct[i] = total ? (uint8_t)((uint64_t)r.rssi_hist[i] * 100 / total) : 0;
+        }
+        control_put(&out, sizeof(out));
+    }
+}
+
+static void control_subscribe(uint16_t interval_s)
+{
+    control_telemetry_s = interval_s;
+    if (interval_s == 0) {
+        xTimerStop(telemetry_timer, 0);
+    } else {
+        xTimerChangePeriod(telemetry_timer, pdMS_TO_TICKS((uint32_t)interval_s * 1000), 0);
+    }
+}
+
+// Builds the response to one request into control_response
+static uint8_t control_handle(uint8_t op, const uint8_t* payload, size_t len)
+{
+    switch (op) {
+        case CTRL_STATUS:
+            control_build_status();
+            return CTRL_OK;
+
+        case CTRL_STATS:
+            control_build_stats();
+            return CTRL_OK;
+
+        case CTRL_DEVICES:
+            control_build_devices();
+            return CTRL_OK;
+
+        case CTRL_CLEAR:
+            cmd_clear(0, NULL);
+            return CTRL_OK;
+
+        case CTRL_CONFIG_GET: {
+            if (len == 0) {
+                for (size_t i = 0; i < CONFIG_ENTRY_COUNT; i++) {
+                    control_put_setting(config_entries[i]);
+                }
+                return CTRL_OK;
+            }
+            const ConfigEntry* entry = config_find_key(payload[0]);
+            if (entry == NULL) {
+                return CTRL_ERR_RANGE;
+            }
+            control_put_setting(*entry);
+            return CTRL_OK;
+        }
+
+        case CTRL_CONFIG_SET: {
+            if (len < 5) {
+                return CTRL_ERR_REQUEST;
+            }
+            const ConfigEntry* entry = config_find_key(payload[0]);
+            int32_t value;
+            memcpy(&value, payload + 1, 4);
+            if (entry == NULL || !config_set(entry, value)) {
+                return CTRL_ERR_RANGE;
+            }
+            control_put_setting(*entry);
+            return CTRL_OK;
+        }
+
+        case CTRL_LOG_OFFLOAD: {
+            if (len < 8) {
+                return CTRL_ERR_REQUEST;
+            }
+            if (log_partition == NULL) {
+                return CTRL_ERR_UNAVAILABLE;
+            }
+            if (log_dump_sink != LOG_SINK_NONE || !log_request_offload(payload)) {
+                return CTRL_ERR_UNAVAILABLE;
+            }
+            uint32_t oldest = log_next_seq;
+            for (uint32_t step = 0; step < log_sector_count; step++) {
+                const LogSectorIndex& e = log_index[log_sector_at(step)];
+                if (e.valid) {
+                    oldest = e.first_seq;
+                    break;
+                }
+            }
+            control_put(&oldest, 4);
+            control_put(&log_next_seq, 4);
+            return CTRL_OK;
+        }
+
+        case CTRL_SUBSCRIBE: {
+            if (len < 2) {
+                return CTRL_ERR_REQUEST;
+            }
+            uint16_t interval_s;
+            memcpy(&interval_s, payload, 2);
+            if (interval_s > CONTROL_TELEMETRY_MAX_S) {
+                return CTRL_ERR_RANGE;
+            }
+            control_subscribe(interval_s);
+            control_put(&interval_s, 2);
+            return CTRL_OK;
+        }
+
+        case CTRL_SURVEY:
+            if (survey_report_window_ms == 0) {
+                return CTRL_ERR_UNAVAILABLE;
+            }
+            control_build_survey();
+            return CTRL_OK;
+
+        default:
+            return CTRL_ERR_OPCODE;
+    }
+}
+
+static void control_begin_response(uint8_t id, uint8_t op, uint8_t status)
+{
+    control_response_id = id;
+    control_response_op = op;
+    control_response_status = status;
+    control_response_fragment = 0;
+    control_response_sent = 0;
+    control_response_pending = true;
+}
+
+// Sends up to CONTROL_NOTIFIES_PER_FRAME fragments; false while more remain
+static bool control_send_fragments()
+{
+    uint8_t frame[BLE_PREFERRED_MTU];
+    size_t room = min((size_t)(ble_peer_mtu - 3), sizeof(frame)) - CONTROL_FRAME_HEADER;
+    for (int n = 0; n < CONTROL_NOTIFIES_PER_FRAME; n++) {
+        // JSON messages hold the mutex across all their chunks; retry next frame
+        if (bleMutex != NULL && xSemaphoreTake(bleMutex, 0) != pdTRUE) {
+            return false;
+        }
+        size_t part = min(room, control_response_len - control_response_sent);
+        bool last = control_response_sent + part == control_response_len;
+        frame[0] = CONTROL_FRAME_MARKER;
+        frame[1] = control_response_id;
+        frame[2] = control_response_op;
+        frame[3] = control_response_status;
+        frame[4] = (control_response_fragment & 0x7F) | (last ? CONTROL_LAST_FRAGMENT : 0);
+        memcpy(frame + CONTROL_FRAME_HEADER, control_response + control_response_sent, part);
+        pTxCharacteristic->setValue(frame, CONTROL_FRAME_HEADER + part);
+        pTxCharacteristic->notify();
+        if (bleMutex != NULL) {
+            xSemaphoreGive(bleMutex);
+        }
+        control_response_sent += part;
+        control_response_fragment++;
+        if (last) {
+            control_response_pending = false;
             return true;
         }
     }
     return false;
 }
 
-bool check_ssid_pattern(const char* ssid)
+// Ui task: finish the response in flight, then take the next request or telemetry
+void continue_control()
 {
-    if (!ssid) return false;
-    
-    for (int i = 0; i < sizeof(wifi_ssid_patterns)/sizeof(wifi_ssid_patterns[0]); i++) {
-        if (strcasestr(ssid, wifi_ssid_patterns[i])) {
-            return true;
+    if (!deviceConnected || pTxCharacteristic == NULL) {
+        control_response_pending = false;
+        control_telemetry_due = false;
+        control_survey_due = false;
+        if (control_telemetry_s != 0) {
+            control_subscribe(0);
         }
+        xQueueReset(control_queue);
+        return;
+    }
+    if (control_response_pending && !control_send_fragments()) {
+        return;
     }
-    return false;
-}
 
-bool check_device_name_pattern(const char* name)
-{
-    if (!name) return false;
-    
-    for (int i = 0; i < sizeof(device_name_patterns)/sizeof(device_name_patterns[0]); i++) {
-        if (strcasestr(name, device_name_patterns[i])) {
-            return true;
+    ControlRequest req;
+    if (xQueueReceive(control_queue, &req, 0) == pdTRUE) {
+        control_response_len = 0;
+        uint8_t status = control_handle(req.data[0], req.data + 2, req.len - 2);
+        if (status != CTRL_OK) {
+            control_response_len = 0;
         }
+        control_begin_response(req.data[1], req.data[0], status);
+    } else if (control_telemetry_due) {
+        control_telemetry_due = false;
+        control_response_len = 0;
+        control_build_status();
+        control_begin_response(0, CTRL_STATUS, CTRL_OK);
+    } else if (control_survey_due) {
+        control_survey_due = false;
+        control_response_len = 0;
+        control_build_survey();
+        control_begin_response(0, CTRL_SURVEY, CTRL_OK);
+    } else {
+        return;
     }
-    return false;
+    control_send_fragments();
 }
 
 // ============================================================================
-// RAVEN UUID DETECTION
+// TASKS
 // ============================================================================
 
-// Check if a BLE device advertises any Raven surveillance service UUIDs
-bool check_raven_service_uuid(NimBLEAdvertisedDevice* device, char* detected_service_out = nullptr)
+static void radio_timer_callback(TimerHandle_t timer)
 {
-    if (!device) return false;
-    
-    // Check if device has service UUIDs
-    if (!device->haveServiceUUID()) return false;
-    
-    // Get the number of service UUIDs
-    int serviceCount = device->getServiceUUIDCount();
-    if (serviceCount == 0) return false;
-    
-    // Check each advertised service UUID against known Raven UUIDs
-    for (int i = 0; i < serviceCount; i++) {
-        NimBLEUUID serviceUUID = device->getServiceUUID(i);
-        std::string uuidStr = serviceUUID.toString();
-        
-        // Compare against each known Raven service UUID
-        for (int j = 0; j < sizeof(raven_service_uuids)/sizeof(raven_service_uuids[0]); j++) {
-            if (strcasecmp(uuidStr.c_str(), raven_service_uuids[j]) == 0) {
-                // Match found! Store the detected service UUID if requested
-                if (detected_service_out != nullptr) {
-                    strncpy(detected_service_out, uuidStr.c_str(), 40);
-                }
-                return true;
-            }
-        }
-    }
-    
-    return false;
+    xTaskNotify(radio_task_handle, (uint32_t)(uintptr_t)pvTimerGetTimerID(timer), eSetBits);
 }
 
-// Get a human-readable description of the Raven service
-const char* get_raven_service_description(const char* uuid)
+static void ui_timer_callback(TimerHandle_t timer)
 {
-    if (!uuid) return "Unknown Service";
-    
-    if (strcasecmp(uuid, RAVEN_DEVICE_INFO_SERVICE) == 0)
-        return "Device Information (Serial, Model, Firmware)";
-    if (strcasecmp(uuid, RAVEN_GPS_SERVICE) == 0)
-        return "GPS Location Service (Lat/Lon/Alt)";
-    if (strcasecmp(uuid, RAVEN_POWER_SERVICE) == 0)
-        return "Power Management (Battery/Solar)";
-    if (strcasecmp(uuid, RAVEN_NETWORK_SERVICE) == 0)
-        return "Network Status (LTE/WiFi)";
-    if (strcasecmp(uuid, RAVEN_UPLOAD_SERVICE) == 0)
-        return "Upload Statistics Service";
-    if (strcasecmp(uuid, RAVEN_ERROR_SERVICE) == 0)
-        return "Error/Failure Tracking Service";
-    if (strcasecmp(uuid, RAVEN_OLD_HEALTH_SERVICE) == 0)
-        return "Health/Temperature Service (Legacy)";
-    if (strcasecmp(uuid, RAVEN_OLD_LOCATION_SERVICE) == 0)
-        return "Location Service (Legacy)";
-    
-    return "Unknown Raven Service";
+    xTaskNotify(ui_task_handle, (uint32_t)(uintptr_t)pvTimerGetTimerID(timer), eSetBits);
 }
 
-// Estimate firmware version based on detected service UUIDs
-const char* estimate_raven_firmware_version(NimBLEAdvertisedDevice* device)
+void radio_task(void* param)
 {
-    if (!device || !device->haveServiceUUID()) return "Unknown";
-    
-    bool has_new_gps = false;
-    bool has_old_location = false;
-    bool has_power_service = false;
-    
-    int serviceCount = device->getServiceUUIDCount();
-    for (int i = 0; i < serviceCount; i++) {
-        NimBLEUUID serviceUUID = device->getServiceUUID(i);
-        std::string uuidStr = serviceUUID.toString();
-        
-        if (strcasecmp(uuidStr.c_str(), RAVEN_GPS_SERVICE) == 0)
-            has_new_gps = true;
-        if (strcasecmp(uuidStr.c_str(), RAVEN_OLD_LOCATION_SERVICE) == 0)
-            has_old_location = true;
-        if (strcasecmp(uuidStr.c_str(), RAVEN_POWER_SERVICE) == 0)
-            has_power_service = true;
+    for (;;) {
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, 0xFFFFFFFF, &bits, portMAX_DELAY);
+        if (bits & NOTIFY_CHANNEL_HOP) {
+            hop_channel();
+        }
+        if (bits & NOTIFY_BLE_SCAN) {
+            start_ble_scan();
+        }
+        if (bits & NOTIFY_BLE_CANDIDATES) {
+            start_ble_candidate_scan();
+        }
     }
-    
-    // Firmware version heuristics based on service presence
-    if (has_old_location && !has_new_gps)
-        return "1.1.x (Legacy)";
-    if (has_new_gps && !has_power_service)
-        return "1.2.x";
-    if (has_new_gps && has_power_service)
-        return "1.3.x (Latest)";
-    
-    return "Unknown Version";
 }
 
-// ============================================================================
-// WIFI PROMISCUOUS MODE HANDLER
-// ============================================================================
-
-typedef struct {
-    unsigned frame_ctrl:16;
-    unsigned duration_id:16;
-    uint8_t addr1[6]; /* receiver address */
-    uint8_t addr2[6]; /* sender address */
-    uint8_t addr3[6]; /* filtering address */
-    unsigned sequence_ctrl:16;
-    uint8_t addr4[6]; /* optional */
-} wifi_ieee80211_mac_hdr_t;
-
-typedef struct {
-    wifi_ieee80211_mac_hdr_t hdr;
-    uint8_t payload[0]; /* network data ended with 4 bytes csum (CRC32) */
-} wifi_ieee80211_packet_t;
-
-void wifi_sniffer_packet_handler(void* buff, wifi_promiscuous_pkt_type_t type)
+void detect_task(void* param)
 {
-    
-    const wifi_promiscuous_pkt_t *ppkt = (wifi_promiscuous_pkt_t *)buff;
-    const wifi_ieee80211_packet_t *ipkt = (wifi_ieee80211_packet_t *)ppkt->payload;
-    const wifi_ieee80211_mac_hdr_t *hdr = &ipkt->hdr;
-    
-    // Check for probe requests (subtype 0x04) and beacons (subtype 0x08)
-    uint8_t frame_type = (hdr->frame_ctrl & 0xFF) >> 2;
-    if (frame_type != 0x10 && frame_type != 0x20) { // Probe request (0x10) or beacon (0x20)
-        return;
-    }
-    
-    // Extract SSID from probe request or beacon
-    char ssid[33] = {0};
-    uint8_t *payload = (uint8_t *)ipkt + 24; // Skip MAC header
-    
-    if (frame_type == 0x10) { // Probe request
-        payload += 0; // Probe requests start with SSID immediately
-    } else { // Beacon frame
-        payload += 12; // Skip fixed parameters in beacon
-    }
-    
-    // Parse SSID element (tag 0, length, data)
-    if (payload[0] == 0 && payload[1] <= 32) {
-        memcpy(ssid, &payload[2], payload[1]);
-        ssid[payload[1]] = '\0';
-    }
-    
-    // Check if SSID matches our patterns
-    if (strlen(ssid) > 0 && check_ssid_pattern(ssid)) {
-        const char* detection_type = (frame_type == 0x10) ? "probe_request" : "beacon";
-        output_wifi_detection_json(ssid, hdr->addr2, ppkt->rx_ctrl.rssi, detection_type);
-        
-        if (!triggered) {
-            triggered = true;
-            flock_detected_notification(String("WiFi: ") + ssid + " [RSSI:" + String(ppkt->rx_ctrl.rssi) + "]");
+    DetectionEvent ev;
+    for (;;) {
+        // Wake at least once per load period so the level can come down
+        if (xQueueReceive(detection_queue, &ev, pdMS_TO_TICKS(LOAD_PERIOD_MS)) == pdTRUE) {
+            uint32_t depth = uxQueueMessagesWaiting(detection_queue) + 1;
+            int64_t start_us = esp_timer_get_time();
+            uint64_t notify_us = detect_notify_us;
+            process_detection_event(ev);
+            uint64_t busy_us = esp_timer_get_time() - start_us - (detect_notify_us - notify_us);
+            load_note_event(depth, busy_us);
         }
-        // Always update detection time for heartbeat tracking
-        last_detection_time = millis();
-        last_rssi = ppkt->rx_ctrl.rssi;
-        return;
-    }
-    
-    // Check MAC address
-    if (check_mac_prefix(hdr->addr2)) {
-        const char* detection_type = (frame_type == 0x10) ? "probe_request_mac" : "beacon_mac";
-        output_wifi_detection_json(ssid[0] ? ssid : "hidden", hdr->addr2, ppkt->rx_ctrl.rssi, detection_type);
-        
-        if (!triggered) {
-            triggered = true;
-            char mac_str[18];
-            snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x:%02x:%02x:%02x", 
-                     hdr->addr2[0], hdr->addr2[1], hdr->addr2[2], hdr->addr2[3], hdr->addr2[4], hdr->addr2[5]);
-            flock_detected_notification(String("WiFi MAC: ") + mac_str + " [RSSI:" + String(ppkt->rx_ctrl.rssi) + "]");
-        }
-        // Always update detection time for heartbeat tracking
-        last_detection_time = millis();
-        last_rssi = ppkt->rx_ctrl.rssi;
-        return;
+        load_tick();
     }
 }
 
-// ============================================================================
-// BLE SCANNING
-// ============================================================================
-
-class AdvertisedDeviceCallbacks: public NimBLEAdvertisedDeviceCallbacks {
-    void onResult(NimBLEAdvertisedDevice* advertisedDevice) {
-        
-        NimBLEAddress addr = advertisedDevice->getAddress();
-        std::string addrStr = addr.toString();
-        uint8_t mac[6];
-        sscanf(addrStr.c_str(), "%02x:%02x:%02x:%02x:%02x:%02x", 
-               &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5]);
-        
-        int rssi = advertisedDevice->getRSSI();
-        std::string name = "";
-        if (advertisedDevice->haveName()) {
-            name = advertisedDevice->getName();
+void ui_task(void* param)
+{
+    unsigned long lastLog = 0;
+    unsigned long led_wait_ms = 0;
+    for (;;) {
+        // Wake on timer notifications, at the next LED change or after UI_FRAME_MS
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, 0xFFFFFFFF, &bits, pdMS_TO_TICKS(min(led_wait_ms, (unsigned long)UI_FRAME_MS)));
+        if (bits & NOTIFY_HEARTBEAT) {
+            send_heartbeat();
         }
-        
-        // Check MAC prefix
-        if (check_mac_prefix(mac)) {
-            output_ble_detection_json(addrStr.c_str(), name.c_str(), rssi, "mac_prefix");
-            if (!triggered) {
-                triggered = true;
-                flock_detected_notification(String("BLE MAC: ") + addrStr.c_str() + " [RSSI:" + String(rssi) + "]");
-            }
-            // Always update detection time for heartbeat tracking
-            last_detection_time = millis();
-            last_rssi = rssi;
-            return;
+        if (bits & NOTIFY_OUT_OF_RANGE) {
+            handle_out_of_range();
         }
-        
-        // Check device name
-        if (!name.empty() && check_device_name_pattern(name.c_str())) {
-            output_ble_detection_json(addrStr.c_str(), name.c_str(), rssi, "device_name");
-            if (!triggered) {
-                triggered = true;
-                flock_detected_notification(String("BLE Name: ") + name.c_str() + " [RSSI:" + String(rssi) + "]");
-            }
-            // Always update detection time for heartbeat tracking
-            last_detection_time = millis();
-            last_rssi = rssi;
-            return;
+        if (bits & NOTIFY_LOG_FLUSH) {
+            log_flush();
         }
-        
-        // Check for Raven surveillance device service UUIDs
-        char detected_service_uuid[41] = {0};
-        if (check_raven_service_uuid(advertisedDevice, detected_service_uuid)) {
-            update_detection_state(RAVEN);
-            // Raven device detected! Get firmware version estimate
-            const char* fw_version = estimate_raven_firmware_version(advertisedDevice);
-            const char* service_desc = get_raven_service_description(detected_service_uuid);
-            
-            // Create enhanced JSON output with Raven-specific data
-            StaticJsonDocument<1024> doc;
-            doc["protocol"] = "bluetooth_le";
-            doc["detection_method"] = "raven_service_uuid";
-            doc["device_type"] = "RAVEN_GUNSHOT_DETECTOR";
-            doc["manufacturer"] = "SoundThinking/ShotSpotter";
-            doc["mac_address"] = addrStr.c_str();
-            doc["rssi"] = rssi;
-            doc["signal_strength"] = rssi > -50 ? "STRONG" : (rssi > -70 ? "MEDIUM" : "WEAK");
-            
-            if (!name.empty()) {
-                doc["device_name"] = name.c_str();
-            }
-            
-            // Raven-specific information
-            doc["raven_service_uuid"] = detected_service_uuid;
-            doc["raven_service_description"] = service_desc;
-            doc["raven_firmware_version"] = fw_version;
-            doc["threat_level"] = "CRITICAL";
-            doc["threat_score"] = 100;
-            
-            // List all detected service UUIDs
-            if (advertisedDevice->haveServiceUUID()) {
-                JsonArray services = doc.createNestedArray("service_uuids");
-                int serviceCount = advertisedDevice->getServiceUUIDCount();
-                for (int i = 0; i < serviceCount; i++) {
-                    NimBLEUUID serviceUUID = advertisedDevice->getServiceUUID(i);
-                    services.add(serviceUUID.toString().c_str());
-                }
+        if (bits & NOTIFY_SNAPSHOT) {
+            if (state_dirty) {
+                save_state_snapshot();
             }
-            
-            // Output the detection
-            serializeJson(doc, Serial);
-            Serial.println();
-            
-            if (!triggered) {
-                triggered = true;
-                device_in_range = true; // Enable fast blinking LED
-                flock_detected_notification(String("Raven: ") + service_desc + " [RSSI:" + String(rssi) + "]");
-            }
-            // Always update detection time for heartbeat tracking
-            last_detection_time = millis();
-            last_rssi = rssi;
-            device_in_range = true; // Ensure heartbeat keeps going with fresh RSSI
-            return;
+            save_session_sketches(false);
+        }
+        if (bits & NOTIFY_TELEMETRY) {
+            control_telemetry_due = true;
+        }
+        if ((bits & NOTIFY_SURVEY) && survey_mode != SURVEY_OFF) {
+            survey_send_report();
         }
-    }
-};
 
-// ============================================================================
-// CHANNEL HOPPING
-// ============================================================================
+        handle_serial_commands();
+        continue_capture();
+        continue_log_dump();
+        continue_control();
+        led_wait_ms = render_led(millis());
 
-void hop_channel()
-{
-    unsigned long now = millis();
-    if (now - last_channel_hop > CHANNEL_HOP_INTERVAL) {
-        current_channel++;
-        if (current_channel > MAX_CHANNEL) {
-            current_channel = 1;
+        if (verbosity >= VERBOSITY_NORMAL && millis() - lastLog > 2000) {
+            lastLog = millis();
+            Serial.println("System active - Scanning...");
         }
-        esp_wifi_set_channel(current_channel, WIFI_SECOND_CHAN_NONE);
-        last_channel_hop = now;
-         printf("[WiFi] Hopped to channel %d\n", current_channel);
     }
 }
 
+void start_tasks()
+{
+    hop_timer = xTimerCreate("hop", pdMS_TO_TICKS(hop_interval_ms), pdTRUE,
+                             (void*)(uintptr_t)NOTIFY_CHANNEL_HOP, radio_timer_callback);
+    ble_scan_timer = xTimerCreate("ble_scan", pdMS_TO_TICKS(ble_scan_interval_ms), pdTRUE,
+                                  (void*)(uintptr_t)NOTIFY_BLE_SCAN, radio_timer_callback);
+    heartbeat_timer = xTimerCreate("heartbeat", pdMS_TO_TICKS(heartbeat_interval_ms), pdTRUE,
+                                   (void*)(uintptr_t)NOTIFY_HEARTBEAT, ui_timer_callback);
+    range_timer = xTimerCreate("range", pdMS_TO_TICKS(out_of_range_ms), pdFALSE,
+                               (void*)(uintptr_t)NOTIFY_OUT_OF_RANGE, ui_timer_callback);
+    log_flush_timer = xTimerCreate("log_flush", pdMS_TO_TICKS(LOG_FLUSH_INTERVAL_MS), pdTRUE,
+                                   (void*)(uintptr_t)NOTIFY_LOG_FLUSH, ui_timer_callback);
+    snapshot_timer = xTimerCreate("snapshot", pdMS_TO_TICKS(STATE_SNAPSHOT_INTERVAL_MS), pdTRUE,
+                                  (void*)(uintptr_t)NOTIFY_SNAPSHOT, ui_timer_callback);
+    // Period set by a CTRL_SUBSCRIBE request
+    telemetry_timer = xTimerCreate("telemetry", pdMS_TO_TICKS(1000), pdTRUE,
+                                   (void*)(uintptr_t)NOTIFY_TELEMETRY, ui_timer_callback);
+    survey_timer = xTimerCreate("survey", pdMS_TO_TICKS(survey_report_ms), pdTRUE,
+                                (void*)(uintptr_t)NOTIFY_SURVEY, ui_timer_callback);
+
+    xTaskCreatePinnedToCore(detect_task, "detect", DETECT_TASK_STACK, NULL,
+                            DETECT_TASK_PRIORITY, &detect_task_handle, DETECT_TASK_CORE);
+    xTaskCreatePinnedToCore(ui_task, "ui", UI_TASK_STACK, NULL,
+                            UI_TASK_PRIORITY, &ui_task_handle, UI_TASK_CORE);
+    xTaskCreatePinnedToCore(radio_task, "radio", RADIO_TASK_STACK, NULL,
+                            RADIO_TASK_PRIORITY, &radio_task_handle, RADIO_TASK_CORE);
+
+    xTimerStart(hop_timer, 0);
+    xTimerStart(ble_scan_timer, 0);
+    xTimerStart(log_flush_timer, 0);
+    xTimerStart(snapshot_timer, 0);
+    if (survey_mode != SURVEY_OFF) {
+        survey_take_baseline();
+        xTimerStart(survey_timer, 0);
+    }
+    // Kick off the first BLE scan right away rather than one interval from now
+    xTaskNotify(radio_task_handle, NOTIFY_BLE_SCAN, eSetBits);
+}
+
 // ============================================================================
 // MAIN FUNCTIONS
 // ============================================================================
 
 void setup()
 {
+    // USB CDC attaches whenever a host shows up - never wait for it, output
+    // printed before then is simply dropped
+#if ARDUINO_USB_MODE
+    // Room for a whole PCAP capture chunk, so writes rarely wait on the host
+    Serial.setTxBufferSize(SERIAL_TX_BUFFER_SIZE);
+#endif
     Serial.begin(115200);
     
     // Create mutex for thread-safe BLE notifications
     bleMutex = xSemaphoreCreateMutex();
+    device_table_mutex = xSemaphoreCreateMutex();
+    threat_mutex = xSemaphoreCreateMutex();
 
     // Initialize session tracking
     session_start_time = millis();
@@ -1476,39 +7684,68 @@ void setup()
     memset(seenDevices, 0, sizeof(seenDevices));
     seenDeviceCount = 0;
 
-    // Initialize RGB LED
-    pixel.begin();
-    pixel.setBrightness(20); // Low-ish brightness (max 255)
-    pixel.setPixelColor(0, pixel.Color(0, 0, 255)); // Blue start
-    pixel.show();
+    // Restore the device table and counters from the last run (~1 ms)
+    state_prefs.begin(STATE_NVS_NAMESPACE, false);
+    restore_state_snapshot();
+    restore_session_sketches();
+    config_load();
+    esp_register_shutdown_handler(state_shutdown_handler);
 
-    // Wait for Serial connection
-    delay(2000); 
-    unsigned long start = millis();
-    while(!Serial && (millis() - start < 5000)) {
-        delay(10);
-    }
-    
-    printf("Starting Flock Squawk Enhanced Detection System...\n\n");
-    printf("Type 'help' for available serial commands\n\n");
-    
-    // Initialize WiFi in promiscuous mode
+    // Matches are queued from the very first frame; the detect task drains
+    // them once it starts below
+    detection_queue = xQueueCreate(DETECTION_QUEUE_LENGTH, sizeof(DetectionEvent));
+    control_queue = xQueueCreate(CONTROL_QUEUE_LENGTH, sizeof(ControlRequest));
+    log_request_queue = xQueueCreate(LOG_REQUEST_QUEUE_LENGTH, sizeof(LogOffloadRequest));
+
+    // Initialize WiFi in promiscuous mode - radios first, everything else later
     WiFi.mode(WIFI_STA);
     WiFi.disconnect();
-    delay(100);
     
+    // Map the signature database (if one was uploaded) and build the
+    // prefilters from whichever tables are active
+    sigdb_init();
+
+    // Only management frames are of interest - keep data/control traffic
+    // from ever waking the callback, unless the channel survey is on
+    survey_reset_dwell();
+    wifi_promiscuous_filter_t promisc_filter = {};
+    promisc_filter.filter_mask = survey_filter_mask();
+    esp_wifi_set_promiscuous_filter(&promisc_filter);
+
     esp_wifi_set_promiscuous(true);
     esp_wifi_set_promiscuous_rx_cb(&wifi_sniffer_packet_handler);
     esp_wifi_set_channel(current_channel, WIFI_SECOND_CHAN_NONE);
     
+    // Initialize BLE and start scanning before bringing up the GATT server
+    NimBLEDevice::init("FlockDetector");
+    NimBLEDevice::setMTU(BLE_PREFERRED_MTU);
+
+    pBLEScan = NimBLEDevice::getScan();
+    // Every advertisement, not just the first per scan: the gaps between
+    // them are the advertising interval (see noteDeviceArrival)
+    pBLEScan->setAdvertisedDeviceCallbacks(new AdvertisedDeviceCallbacks(), true);
+    pBLEScan->setDuplicateFilter(false);
+    pBLEScan->setInterval(100);
+    pBLEScan->setWindow(99);
+    start_ble_scan();   // Active or passive, see BLE SCAN POLICY
+    gatt_init();
+    boot_scan_ready_us = esp_timer_get_time();
+
+    // Initialize RGB LED
+    led_init();
+    led_show(LED_RGB(0, 0, 255)); // Blue start
+
+    printf("Starting Flock Squawk Enhanced Detection System...\n\n");
+    printf("Type 'help' for available serial commands\n\n");
     printf("WiFi promiscuous mode enabled on channel %d\n", current_channel);
     printf("Monitoring probe requests and beacons...\n");
-    
-    // Initialize BLE
-    printf("Initializing BLE scanner and server...\n");
-    NimBLEDevice::init("FlockDetector");
-    
+    printf("Scanning %lu ms after boot\n", (unsigned long)(boot_scan_ready_us / 1000));
+
+    // Mount the detection log before the detect task starts appending
+    log_mount();
+
     // Create the BLE Server
+    printf("Initializing BLE server...\n");
     pServer = NimBLEDevice::createServer();
     pServer->setCallbacks(new MyServerCallbacks());
 
@@ -1521,345 +7758,57 @@ void setup()
                                         NIMBLE_PROPERTY::NOTIFY
                                     );
                                     
+    // Binary control requests; responses come back on TX (see BLE CONTROL PROTOCOL)
     NimBLECharacteristic * pRxCharacteristic = pService->createCharacteristic(
                                              CHARACTERISTIC_UUID_RX,
                                              NIMBLE_PROPERTY::WRITE
                                          );
+    pRxCharacteristic->setCallbacks(new ControlCharacteristicCallbacks());
+
+    // Detection log offload: write {from_seq, count} to start, records arrive as notifications
+    pLogCharacteristic = pService->createCharacteristic(
+                                        CHARACTERISTIC_UUID_LOG,
+                                        NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::NOTIFY
+                                    );
+    pLogCharacteristic->setCallbacks(new LogCharacteristicCallbacks());
 
     // Start the service
     pService->start();
 
     // Start advertising
+#if CONFIG_BT_NIMBLE_EXT_ADV
+    // Extended advertising builds: a legacy instance, so every phone can connect
+    NimBLEExtAdvertisement advert(BLE_HCI_LE_PHY_1M, BLE_HCI_LE_PHY_1M);
+    advert.setLegacyAdvertising(true);
+    advert.setConnectable(true);
+    advert.setScannable(true);
+    advert.addServiceUUID(NimBLEUUID(SERVICE_UUID));
+    NimBLEExtAdvertisement scan_response(BLE_HCI_LE_PHY_1M, BLE_HCI_LE_PHY_1M);
+    scan_response.setLegacyAdvertising(true);
+    scan_response.setName("FlockDetector");
+    NimBLEExtAdvertising *pAdvertising = NimBLEDevice::getAdvertising();
+    pAdvertising->setInstanceData(0, advert);
+    pAdvertising->setScanResponseData(0, scan_response);
+    pAdvertising->start(0);
+#else
     NimBLEAdvertising *pAdvertising = NimBLEDevice::getAdvertising();
     pAdvertising->addServiceUUID(SERVICE_UUID);
     pAdvertising->setScanResponse(true);
     pAdvertising->start();
+#endif
     printf("BLE Advertising started. Connect to 'FlockDetector' to receive notifications.\n");
-
-    pBLEScan = NimBLEDevice::getScan();
-    pBLEScan->setAdvertisedDeviceCallbacks(new AdvertisedDeviceCallbacks());
-    pBLEScan->setActiveScan(true);
-    pBLEScan->setInterval(100);
-    pBLEScan->setWindow(99);
     
-    printf("BLE scanner initialized\n");
     printf("System ready - hunting for Flock Safety devices...\n\n");
     printf("Type 'test' or 'axon' in serial console to simulate Axon detection\n\n");
     
     last_channel_hop = millis();
+
+    // Hand over to the task graph
+    start_tasks();
 }
 
 void loop() 
 {
-    unsigned long now = millis();
-
-    // ===================================
-    // SERIAL COMMAND HANDLER
-    // ===================================
-    if (Serial.available() > 0) {
-        String cmd = Serial.readStringUntil('\n');
-        cmd.trim();
-        String cmdLower = cmd;
-        cmdLower.toLowerCase();
-        
-        if (cmdLower == "test" || cmdLower == "axon") {
-            printf("\n[TEST] Simulating Axon Body Cam detection...\n");
-            
-            // Create fake Axon BLE detection
-            DynamicJsonDocument doc(2048);
-            doc["timestamp"] = millis();
-            doc["detection_time"] = String(millis() / 1000.0, 3) + "s";
-            doc["protocol"] = "bluetooth_le";
-            doc["detection_method"] = "test_console";
-            doc["alert_level"] = "HIGH";
-            doc["device_category"] = "AXON";
-            doc["mac_address"] = "00:25:df:aa:bb:cc";
-            doc["device_name"] = "Axon Body 3";
-            doc["rssi"] = -55;
-            doc["signal_strength"] = "STRONG";
-            doc["threat_score"] = 95;
-            doc["vendor_oui"] = "00:25:df";
-            doc["manufacturer"] = "Axon Enterprise";
-            doc["test_mode"] = true;
-
-            String json_output;
-            serializeJson(doc, json_output);
-            Serial.println(json_output);
-            send_notification(json_output);
-
-            // Update detection state
-            update_detection_state(AXON);
-            last_rssi = -55;
-            
-            printf("[TEST] Axon detection simulated successfully\n\n");
-            
-        } else if (cmdLower == "status") {
-            // Display current status
-            unsigned long uptime = millis() / 1000;
-            printf("\n========== FLOCK-YOU STATUS ==========\n");
-            printf("Uptime: %lu seconds\n", uptime);
-            printf("Session start: %lu ms ago\n", millis() - session_start_time);
-            printf("WiFi Channel: %d / %d\n", current_channel, MAX_CHANNEL);
-            printf("BLE Connected: %s\n", deviceConnected ? "YES" : "NO");
-            printf("Device in range: %s\n", device_in_range ? "YES" : "NO");
-            printf("Current detection: %d\n", current_detection_type);
-            printf("Last RSSI: %d dBm\n", last_rssi);
-            printf("\n--- Detection Stats ---\n");
-            printf("Total WiFi detections: %d\n", total_wifi_detections);
-            printf("Total BLE detections: %d\n", total_ble_detections);
-            printf("Unique devices seen: %d\n", unique_devices_seen);
-            printf("Debounce cache: %d / %d\n", seenDeviceCount, MAX_SEEN_DEVICES);
-            printf("\n--- Memory ---\n");
-            printf("Free heap: %d bytes\n", ESP.getFreeHeap());
-            printf("Min free heap: %d bytes\n", ESP.getMinFreeHeap());
-            printf("=======================================\n\n");
-            
-        } else if (cmdLower == "stats") {
-            // JSON stats output (for app consumption)
-            DynamicJsonDocument doc(1024);
-            doc["uptime_seconds"] = millis() / 1000;
-            doc["wifi_channel"] = current_channel;
-            doc["ble_connected"] = deviceConnected;
-            doc["device_in_range"] = device_in_range;
-            doc["current_detection"] = current_detection_type;
-            doc["last_rssi"] = last_rssi;
-            doc["total_wifi_detections"] = total_wifi_detections;
-            doc["total_ble_detections"] = total_ble_detections;
-            doc["unique_devices"] = unique_devices_seen;
-            doc["debounce_cache_size"] = seenDeviceCount;
-            doc["free_heap"] = ESP.getFreeHeap();
-            
-            String json_output;
-            serializeJson(doc, json_output);
-            Serial.println(json_output);
-            
-        } else if (cmdLower == "devices") {
-            // List seen devices
-            printf("\n========== SEEN DEVICES ==========\n");
-            for (int i = 0; i < seenDeviceCount; i++) {
-                unsigned long age = (millis() - seenDevices[i].lastSeen) / 1000;
-                printf("%d. %s - Count: %d, Last seen: %lu sec ago\n",
-                    i + 1,
-                    seenDevices[i].mac,
-                    seenDevices[i].detectionCount,
-                    age);
-            }
-            printf("==================================\n\n");
-            
-        } else if (cmdLower == "clear") {
-            // Clear debounce cache
-            seenDeviceCount = 0;
-            unique_devices_seen = 0;
-            total_wifi_detections = 0;
-            total_ble_detections = 0;
-            printf("[OK] Stats and debounce cache cleared\n");
-            
-        } else if (cmdLower == "help") {
-            printf("\n========== FLOCK-YOU COMMANDS ==========\n");
-            printf("status  - Show detailed system status\n");
-            printf("stats   - Output stats as JSON\n");
-            printf("devices - List recently seen devices\n");
-            printf("clear   - Clear detection cache and stats\n");
-            printf("test    - Simulate Axon detection\n");
-            printf("axon    - Simulate Axon detection\n");
-            printf("help    - Show this help message\n");
-            printf("=========================================\n\n");
-            
-        } else if (cmdLower.length() > 0) {
-            printf("Unknown command: %s\n", cmd.c_str());
-            printf("Type 'help' for available commands\n\n");
-        }
-    }
-
-    // ===================================
-    // LED CONTROL LOGIC (RGB)
-    // ===================================
-    if (device_in_range) {
-
-        switch (current_detection_type) {
-            case RAVEN:
-                // CRITICAL PRIORITY: RAVEN / GUNSHOT DETECTION
-                // FAST RED STROBE (50ms ON/OFF)
-                if ((now % 100) < 50) {
-                    pixel.setPixelColor(0, pixel.Color(255, 0, 0)); // RED
-                } else {
-                    pixel.setPixelColor(0, pixel.Color(0, 0, 0));
-                }
-                break;
-
-            case AXON:
-                // HIGH PRIORITY: AXON / POLICE SYSTEMS
-                // BLUE/RED POLICE STROBE
-                if ((now % 200) < 100) {
-                    pixel.setPixelColor(0, pixel.Color(0, 0, 255)); // BLUE
-                } else {
-                    pixel.setPixelColor(0, pixel.Color(255, 0, 0)); // RED
-                }
-                break;
-
-            case RING:
-                // MEDIUM PRIORITY: RING DEVICES
-                // CYAN BLINK (300ms ON/300ms OFF)
-                if ((now % 600) < 300) {
-                    pixel.setPixelColor(0, pixel.Color(0, 255, 255)); // CYAN
-                } else {
-                    pixel.setPixelColor(0, pixel.Color(0, 0, 0));
-                }
-                break;
-
-            case CRADLEPOINT:
-                // MEDIUM PRIORITY: NETWORK EQUIPMENT (used in surveillance)
-                // GREEN BLINK (400ms ON/400ms OFF)
-                if ((now % 800) < 400) {
-                    pixel.setPixelColor(0, pixel.Color(0, 255, 0)); // GREEN
-                } else {
-                    pixel.setPixelColor(0, pixel.Color(0, 0, 0));
-                }
-                break;
-
-            case ARUBA:
-                // MEDIUM PRIORITY: ARUBA NETWORKS
-                // MAGENTA BLINK (400ms ON/400ms OFF)
-                if ((now % 800) < 400) {
-                    pixel.setPixelColor(0, pixel.Color(255, 0, 255)); // MAGENTA
-                } else {
-                    pixel.setPixelColor(0, pixel.Color(0, 0, 0));
-                }
-                break;
-
-            case DRONE:
-                // LOW PRIORITY: DRONES (DJI, Parrot, Skydio)
-                // YELLOW SLOW BLINK (500ms ON/500ms OFF)
-                if ((now % 1000) < 500) {
-                    pixel.setPixelColor(0, pixel.Color(255, 255, 0)); // YELLOW
-                } else {
-                    pixel.setPixelColor(0, pixel.Color(0, 0, 0));
-                }
-                break;
-
-            case NEST_GOOGLE:
-                // MEDIUM PRIORITY: NEST/GOOGLE CAMERAS
-                // WHITE BLINK (400ms ON/400ms OFF)
-                if ((now % 800) < 400) {
-                    pixel.setPixelColor(0, pixel.Color(255, 255, 255)); // WHITE
-                } else {
-                    pixel.setPixelColor(0, pixel.Color(0, 0, 0));
-                }
-                break;
-
-            case ARLO:
-                // MEDIUM PRIORITY: ARLO CAMERAS
-                // GREEN BLINK (400ms ON/400ms OFF)
-                if ((now % 800) < 400) {
-                    pixel.setPixelColor(0, pixel.Color(0, 255, 100)); // GREEN-TEAL
-                } else {
-                    pixel.setPixelColor(0, pixel.Color(0, 0, 0));
-                }
-                break;
-
-            case EUFY:
-                // MEDIUM PRIORITY: EUFY CAMERAS
-                // PINK BLINK (400ms ON/400ms OFF)
-                if ((now % 800) < 400) {
-                    pixel.setPixelColor(0, pixel.Color(255, 100, 200)); // PINK
-                } else {
-                    pixel.setPixelColor(0, pixel.Color(0, 0, 0));
-                }
-                break;
-
-            case WYZE:
-                // MEDIUM PRIORITY: WYZE CAMERAS
-                // LIGHT BLUE BLINK (400ms ON/400ms OFF)
-                if ((now % 800) < 400) {
-                    pixel.setPixelColor(0, pixel.Color(100, 200, 255)); // LIGHT BLUE
-                } else {
-                    pixel.setPixelColor(0, pixel.Color(0, 0, 0));
-                }
-                break;
-
-            case BLINK:
-                // MEDIUM PRIORITY: BLINK/AMAZON CAMERAS
-                // CYAN/WHITE ALTERNATING (300ms each)
-                if ((now % 600) < 300) {
-                    pixel.setPixelColor(0, pixel.Color(0, 255, 255)); // CYAN
-                } else {
-                    pixel.setPixelColor(0, pixel.Color(255, 255, 255)); // WHITE
-                }
-                break;
-
-            case FLOCK_SAFETY:
-            default:
-                // HIGH PRIORITY: FLOCK SAFETY
-                // ORANGE BLINK (200ms ON/200ms OFF)
-                if ((now % 400) < 200) {
-                    pixel.setPixelColor(0, pixel.Color(255, 140, 0)); // ORANGE
-                } else {
-                    pixel.setPixelColor(0, pixel.Color(0, 0, 0));
-                }
-                break;
-        }
-
-    } else {
-        // SCANNING BREATHE/BLINK (Blue)
-        // Gentle Blue Pulse every 2 seconds
-        int cycle = now % 2000;
-        if (cycle < 100) {
-           pixel.setPixelColor(0, pixel.Color(0, 0, 50)); // Dim Blue
-        } else {
-           pixel.setPixelColor(0, pixel.Color(0, 0, 0)); // OFF
-        }
-        
-        // Reset detection type if not in range to avoid stale state on next detect
-        current_detection_type = NONE;
-    }
-    pixel.show();
-
-    // (put this at the top of the loop)
-    static unsigned long lastLog = 0;
-    if (millis() - lastLog > 2000) {
-        lastLog = millis();
-        Serial.println("System active - Scanning...");
-    }
-    // Handle channel hopping for WiFi promiscuous mode
-    hop_channel();
-    
-    // Handle heartbeat pulse if device is in range
-    if (device_in_range) {
-        unsigned long now = millis();
-        
-        // Check if 10 seconds have passed since last heartbeat
-        if (now - last_heartbeat >= 10000) {
-            // Send heartbeat as JSON
-            DynamicJsonDocument doc(256);
-            doc["type"] = "heartbeat";
-            doc["message"] = "Still Detected";
-            doc["rssi"] = last_rssi;
-            doc["timestamp"] = millis();
-            String json_output;
-            serializeJson(doc, json_output);
-            send_notification(json_output);
-            
-            last_heartbeat = now;
-        }
-        
-        // Check if device has gone out of range (no detection for 30 seconds)
-        if (now - last_detection_time >= 30000) {
-            printf("Device out of range - stopping heartbeat\n");
-            send_notification("Device out of range");
-            device_in_range = false;
-            triggered = false; // Allow new detections
-        }
-    }
-    
-    if (millis() - last_ble_scan >= BLE_SCAN_INTERVAL && !pBLEScan->isScanning()) {
-        printf("[BLE] scan...\n");
-        pBLEScan->start(BLE_SCAN_DURATION, false);
-        last_ble_scan = millis();
-    }
-    
-    if (pBLEScan->isScanning() == false && millis() - last_ble_scan > BLE_SCAN_DURATION * 1000) {
-        pBLEScan->clearResults();
-    }
-    
-    delay(100);
+    // All work happens in the tasks started from setup()
+    vTaskDelete(NULL);
 }
@@ -0,0 +1,90 @@
+// Output rate limiting core, see OUTPUT RATE LIMITING in main.cpp. Plain C++
+// with no Arduino dependencies so the native test env can build it; main.cpp
+// owns the buckets and supplies the live limits and which sinks are up.
+
+#pragma once
+#include <stdint.h>
+
+enum OutputSink {
+    OUT_SINK_SERIAL = 0,
+    OUT_SINK_BLE = 1,
+    OUT_SINK_COUNT
+};
+
+// Where one detection goes, with the messages of its kind each sink dropped
+// since the last one it took
+struct OutputSinks {
+    uint8_t mask;                           // 1 << OutputSink
+    uint16_t suppressed[OUT_SINK_COUNT];
+};
+
+#define RATE_TOKEN 60000u       // Credit per message: a minute in ms, so
+                                // elapsed_ms * per_minute refills exactly
+
+struct RateBucket {
+    uint32_t credit;            // In 1/RATE_TOKEN messages
+    unsigned long last_ms;
+    uint16_t suppressed;        // Since the last message taken
+    bool used;                  // Starts full
+};
+
+struct RateLimits {
+    int32_t per_minute[OUT_SINK_COUNT];     // 0 = unlimited
+    int32_t burst[OUT_SINK_COUNT];
+};
+
+// Take a token for one message, or count it as suppressed
+static inline bool rate_take(RateBucket& b, int32_t per_minute, int32_t burst, unsigned long now)
+{
+    uint64_t cap = (uint64_t)burst * RATE_TOKEN;
+    uint64_t credit = b.credit;
+    if (!b.used) {
+        credit = cap;
+        b.used = true;
+    } else {
+        credit += (uint64_t)(now - b.last_ms) * per_minute;
+    }
+    if (credit > cap) {
+        credit = cap;
+    }
+    b.last_ms = now;
+    if (credit >= RATE_TOKEN) {
+        b.credit = (uint32_t)(credit - RATE_TOKEN);
+        return true;
+    }
+    b.credit = (uint32_t)credit;
+    if (b.suppressed < UINT16_MAX) {
+        b.suppressed++;
+    }
+    return false;
+}
+
+// Sinks a detection goes to, given its category's buckets (one per sink) and
+// the sinks that are up. Critical detections bypass the limits; summarized
+// ones go nowhere and cost no tokens. suppressed_total counts the drops.
+static inline OutputSinks rate_gate(RateBucket* buckets, uint32_t* suppressed_total, const RateLimits& limits,
+                                    uint8_t sinks_up, bool critical, bool summarize, unsigned long now)
+{
+    OutputSinks sinks = {};
+    if (summarize) {
+        return sinks;
+    }
+    if (critical) {
+        sinks.mask = sinks_up;
+        return sinks;
+    }
+    for (int sink = 0; sink < OUT_SINK_COUNT; sink++) {
+        if (!(sinks_up & (1u << sink))) {
+            continue;
+        }
+        RateBucket& b = buckets[sink];
+        if (limits.per_minute[sink] == 0 || rate_take(b, limits.per_minute[sink], limits.burst[sink], now)) {
+            sinks.mask |= 1u << sink;
+            sinks.suppressed[sink] = b.suppressed;
+            b.suppressed = 0;
+        } else {
+            suppressed_total[sink]++;
+        }
+    }
+    return sinks;
+}
@@ -0,0 +1,123 @@
+// Threat arbitration core, see THREAT ARBITRATION in main.cpp. Plain C++
+// with no Arduino or FreeRTOS dependencies so the native test env can build
+// it; main.cpp holds the class table and the slots and takes the locks.
+
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+struct ThreatClass {
+    const char* name;
+    uint8_t priority;           // Higher wins the LED and heads the lists
+    uint16_t expiry_pct;        // Stays active this long after the last detection,
+                                // in percent of the out-of-range timeout
+};
+
+struct ThreatSlot {
+    unsigned long first_seen;
+    unsigned long last_seen;    // Last detection at or above the hold score
+    uint32_t detections;
+    int8_t rssi;
+    uint8_t score;              // Best score while active
+    bool active;
+};
+
+struct ThreatView {
+    uint8_t type;               // DetectionType, index into the class table
+    ThreatSlot slot;
+};
+
+static inline unsigned long threat_class_expiry_ms(const ThreatClass& c, unsigned long timeout_ms)
+{
+    return timeout_ms * c.expiry_pct / 100;
+}
+
+static inline int8_t threat_rssi(int rssi)
+{
+    return (int8_t)(rssi < -128 ? -128 : rssi > 127 ? 127 : rssi);
+}
+
+// Returns true if the slot is active afterwards
+static inline bool threat_slot_update(ThreatSlot& s, unsigned long expiry_ms, int score, int rssi,
+                                      int enter_score, int hold_score, unsigned long now)
+{
+    if (s.active && now - s.last_seen >= expiry_ms) {
+        s.active = false;
+    }
+    if (!s.active && score >= enter_score) {
+        memset(&s, 0, sizeof(s));
+        s.active = true;
+        s.first_seen = now;
+    }
+    if (s.active && score >= hold_score) {
+        s.last_seen = now;
+        s.detections++;
+        s.rssi = threat_rssi(rssi);
+        if (score > s.score) s.score = (uint8_t)score;
+    }
+    return s.active;
+}
+
+// Debounced repeat sighting: keeps an active threat alive, never raises one
+static inline bool threat_slot_refresh(ThreatSlot& s, unsigned long expiry_ms, int rssi, unsigned long now)
+{
+    if (s.active && now - s.last_seen >= expiry_ms) {
+        s.active = false;
+    }
+    if (s.active) {
+        s.last_seen = now;
+        s.rssi = threat_rssi(rssi);
+    }
+    return s.active;
+}
+
+// Active threats by priority (most recent first on a tie) into out[0..n);
+// returns the count. Expired slots are deactivated on the way.
+static inline int threat_rank(const ThreatClass* classes, ThreatSlot* slots, int count,
+                              unsigned long timeout_ms, ThreatView* out, int n, unsigned long now)
+{
+    int found = 0;
+    for (int t = 0; t < count; t++) {
+        ThreatSlot& s = slots[t];
+        if (!s.active) continue;
+        if (now - s.last_seen >= threat_class_expiry_ms(classes[t], timeout_ms)) {
+            s.active = false;
+            continue;
+        }
+        // Insertion into the short sorted output
+        int i = found < n ? found++ : n;
+        while (i > 0) {
+            const ThreatView& prev = out[i - 1];
+            uint8_t prev_priority = classes[prev.type].priority;
+            uint8_t priority = classes[t].priority;
+            if (prev_priority > priority ||
+                (prev_priority == priority && prev.slot.last_seen >= s.last_seen)) {
+                break;
+            }
+            if (i < n) out[i] = prev;
+            i--;
+        }
+        if (i < n) {
+            out[i].type = (uint8_t)t;
+            out[i].slot = s;
+        }
+    }
+    return found;
+}
+
+// Milliseconds until the last active threat expires, 0 if none is active
+static inline unsigned long threat_rank_remaining_ms(const ThreatClass* classes, const ThreatSlot* slots,
+                                                     int count, unsigned long timeout_ms, unsigned long now)
+{
+    unsigned long remaining = 0;
+    for (int t = 0; t < count; t++) {
+        const ThreatSlot& s = slots[t];
+        if (!s.active) continue;
+        unsigned long expiry = threat_class_expiry_ms(classes[t], timeout_ms);
+        unsigned long age = now - s.last_seen;
+        if (age < expiry && expiry - age > remaining) {
+            remaining = expiry - age;
+        }
+    }
+    return remaining;
+}
@@ -0,0 +1,406 @@
+// Output rate limiting: token bucket arithmetic, and a replay of a dense
+// residential event trace through rate_gate() as process_detection_event()
+// drives it. Run with: pio test -e native -f test_rate_limit
+
+#include <unity.h>
+#include <string.h>
+#include "rate_limit.h"
+
+// Categories of the trace; AXON and RAVEN are critical
+enum { RING, NEST, BLINK, WYZE, EUFY, ARLO, FLOCK, AXON, RAVEN, CATEGORIES };
+
+static const RateLimits limits = { { 60, 20 }, { 10, 5 } };    // The firmware defaults
+static const uint8_t BOTH = (1u << OUT_SINK_SERIAL) | (1u << OUT_SINK_BLE);
+
+static RateBucket buckets[CATEGORIES][OUT_SINK_COUNT];
+static uint32_t suppressed_total[OUT_SINK_COUNT];
+
+void setUp()
+{
+    memset(buckets, 0, sizeof(buckets));
+    memset(suppressed_total, 0, sizeof(suppressed_total));
+}
+
+void tearDown() {}
+
+// ----------------------------------------------------------------------------
+// Token bucket
+// ----------------------------------------------------------------------------
+
+void test_first_use_starts_full()
+{
+    RateBucket b = {};
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_TRUE(rate_take(b, 20, 5, 1000));
+    }
+    TEST_ASSERT_FALSE(rate_take(b, 20, 5, 1000));
+    TEST_ASSERT_EQUAL_UINT16(1, b.suppressed);
+}
+
+void test_refill_is_exact()
+{
+    RateBucket b = {};
+    rate_take(b, 20, 1, 1000);
+    TEST_ASSERT_FALSE(rate_take(b, 20, 1, 3999));     // 20/min = one per 3 s
+    TEST_ASSERT_TRUE(rate_take(b, 20, 1, 4000));
+
+    // Drained, then polled every 7 ms for a minute: no credit lost to rounding
+    RateBucket d = {};
+    for (int i = 0; i < 5; i++) rate_take(d, 20, 5, 1000);
+    int taken = 0;
+    for (unsigned long t = 1007; t < 61007; t += 7) {
+        taken += rate_take(d, 20, 5, t);
+    }
+    TEST_ASSERT_EQUAL_INT(20, taken);
+}
+
+void test_refill_caps_at_burst()
+{
+    RateBucket b = {};
+    for (int i = 0; i < 3; i++) rate_take(b, 60, 3, 1000);
+    int taken = 0;
+    for (int i = 0; i < 10; i++) {
+        taken += rate_take(b, 60, 3, 1000 + 3600000);
+    }
+    TEST_ASSERT_EQUAL_INT(3, taken);
+}
+
+void test_long_gap_does_not_overflow()
+{
+    RateBucket b = {};
+    rate_take(b, 6000, 100, 1);
+    for (int i = 0; i < 99; i++) rate_take(b, 6000, 100, 1);
+    TEST_ASSERT_FALSE(rate_take(b, 6000, 100, 1));
+    TEST_ASSERT_TRUE(rate_take(b, 6000, 100, 1 + 0x7FFFFFFFUL));
+}
+
+void test_suppressed_saturates()
+{
+    RateBucket b = {};
+    rate_take(b, 1, 1, 1000);
+    b.suppressed = UINT16_MAX - 1;
+    rate_take(b, 1, 1, 1000);
+    rate_take(b, 1, 1, 1000);
+    TEST_ASSERT_EQUAL_UINT16(UINT16_MAX, b.suppressed);
+}
+
+// ----------------------------------------------------------------------------
+// Gate
+// ----------------------------------------------------------------------------
+
+void test_sinks_limited_independently()
+{
+    int serial = 0, ble = 0;
+    for (int i = 0; i < 30; i++) {
+        OutputSinks s = rate_gate(buckets[RING], suppressed_total, limits, BOTH, false, false, 1000);
+        serial += (s.mask >> OUT_SINK_SERIAL) & 1;
+        ble += (s.mask >> OUT_SINK_BLE) & 1;
+    }
+    TEST_ASSERT_EQUAL_INT(10, serial);
+    TEST_ASSERT_EQUAL_INT(5, ble);
+    TEST_ASSERT_EQUAL_UINT32(20, suppressed_total[OUT_SINK_SERIAL]);
+    TEST_ASSERT_EQUAL_UINT32(25, suppressed_total[OUT_SINK_BLE]);
+
+    // Another category has its own buckets
+    OutputSinks s = rate_gate(buckets[NEST], suppressed_total, limits, BOTH, false, false, 1000);
+    TEST_ASSERT_EQUAL_UINT8(BOTH, s.mask);
+}
+
+void test_suppressed_folded_into_next_message()
+{
+    for (int i = 0; i < 14; i++) {
+        rate_gate(buckets[RING], suppressed_total, limits, BOTH, false, false, 1000);
+    }
+    // One serial token a second, one BLE token every 3 s
+    OutputSinks s = rate_gate(buckets[RING], suppressed_total, limits, BOTH, false, false, 2000);
+    TEST_ASSERT_EQUAL_UINT8(1u << OUT_SINK_SERIAL, s.mask);
+    TEST_ASSERT_EQUAL_UINT16(4, s.suppressed[OUT_SINK_SERIAL]);
+    s = rate_gate(buckets[RING], suppressed_total, limits, BOTH, false, false, 4000);
+    TEST_ASSERT_EQUAL_UINT8(BOTH, s.mask);
+    TEST_ASSERT_EQUAL_UINT16(0, s.suppressed[OUT_SINK_SERIAL]);
+    TEST_ASSERT_EQUAL_UINT16(10, s.suppressed[OUT_SINK_BLE]);
+}
+
+void test_critical_bypasses_limits()
+{
+    for (int i = 0; i < 50; i++) {
+        OutputSinks s = rate_gate(buckets[RAVEN], suppressed_total, limits, BOTH, true, false, 1000);
+        TEST_ASSERT_EQUAL_UINT8(BOTH, s.mask);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, suppressed_total[OUT_SINK_SERIAL]);
+    TEST_ASSERT_FALSE(buckets[RAVEN][OUT_SINK_SERIAL].used);
+}
+
+void test_summarized_costs_nothing()
+{
+    OutputSinks s = rate_gate(buckets[RING], suppressed_total, limits, BOTH, false, true, 1000);
+    TEST_ASSERT_EQUAL_UINT8(0, s.mask);
+    TEST_ASSERT_FALSE(buckets[RING][OUT_SINK_SERIAL].used);
+    TEST_ASSERT_EQUAL_UINT32(0, suppressed_total[OUT_SINK_SERIAL]);
+}
+
+void test_sink_down_is_not_charged()
+{
+    OutputSinks s = rate_gate(buckets[RING], suppressed_total, limits, 1u << OUT_SINK_SERIAL, false, false, 1000);
+    TEST_ASSERT_EQUAL_UINT8(1u << OUT_SINK_SERIAL, s.mask);
+    TEST_ASSERT_FALSE(buckets[RING][OUT_SINK_BLE].used);
+    TEST_ASSERT_EQUAL_UINT32(0, suppressed_total[OUT_SINK_BLE]);
+}
+
+void test_zero_rate_is_unlimited()
+{
+    RateLimits unlimited = { { 0, 0 }, { 1, 1 } };
+    for (int i = 0; i < 1000; i++) {
+        OutputSinks s = rate_gate(buckets[RING], suppressed_total, unlimited, BOTH, false, false, 1000);
+        TEST_ASSERT_EQUAL_UINT8(BOTH, s.mask);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Trace replay
+// ----------------------------------------------------------------------------
+//
+// Ten minutes on a residential street: doorbells and cameras of six brands
+// sending detections faster than the limits, a Flock camera well under
+// them, and occasional Axon and Raven hits. Load shedding is at summary from
+// 4:00 to 5:00, and the phone is disconnected from 6:40 to 8:00.
+
+#define TRACE_MS 600000UL
+#define SUMMARY_FROM 240000UL
+#define SUMMARY_TO 300000UL
+#define BLE_DOWN_FROM 400000UL
+#define BLE_DOWN_TO 480000UL
+#define TRACE_MAX 4096
+
+struct TraceEvent {
+    unsigned long ms;
+    uint8_t category;
+};
+
+static const unsigned long mean_gap_ms[CATEGORIES] = {
+    700, 900, 1500, 2000, 2500, 4000,   // RING .. EUFY over the BLE limit, RING over Serial's
+    20000,                              // FLOCK
+    30000, 45000,                       // AXON, RAVEN
+};
+
+static TraceEvent trace[TRACE_MAX];
+
+static uint32_t lcg(uint32_t* state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+// Deterministic, merged in time order
+static int build_trace()
+{
+    uint32_t seed = 0x5eed;
+    int n = 0;
+    unsigned long next[CATEGORIES];
+    for (int c = 0; c < CATEGORIES; c++) {
+        next[c] = 1 + lcg(&seed) % mean_gap_ms[c];
+    }
+    for (;;) {
+        int c = 0;
+        for (int i = 1; i < CATEGORIES; i++) {
+            if (next[i] < next[c]) c = i;
+        }
+        if (next[c] >= TRACE_MS || n == TRACE_MAX) break;
+        trace[n].ms = next[c];
+        trace[n].category = (uint8_t)c;
+        n++;
+        next[c] += mean_gap_ms[c] / 2 + lcg(&seed) % mean_gap_ms[c];
+    }
+    return n;
+}
+
+static bool is_critical(int category)
+{
+    return category == AXON || category == RAVEN;
+}
+
+struct Tally {
+    uint32_t offered, taken, folded, with_suppressed;
+    unsigned long taken_ms[TRACE_MAX];
+};
+
+static Tally tally[CATEGORIES][OUT_SINK_COUNT];
+static uint32_t summary_counts[CATEGORIES];
+static uint32_t critical_seen, critical_delivered;
+
+static void replay(int n)
+{
+    memset(tally, 0, sizeof(tally));
+    memset(summary_counts, 0, sizeof(summary_counts));
+    critical_seen = critical_delivered = 0;
+    for (int i = 0; i < n; i++) {
+        const TraceEvent& ev = trace[i];
+        bool critical = is_critical(ev.category);
+        bool summarize = !critical && ev.ms >= SUMMARY_FROM && ev.ms < SUMMARY_TO;
+        bool ble_up = ev.ms < BLE_DOWN_FROM || ev.ms >= BLE_DOWN_TO;
+        uint8_t up = (1u << OUT_SINK_SERIAL) | (ble_up ? 1u << OUT_SINK_BLE : 0);
+
+        OutputSinks s = rate_gate(buckets[ev.category], suppressed_total, limits, up, critical, summarize, ev.ms);
+        TEST_ASSERT_EQUAL_UINT8(0, s.mask & ~up);
+        if (summarize) {
+            TEST_ASSERT_EQUAL_UINT8(0, s.mask);
+            summary_counts[ev.category]++;
+            continue;
+        }
+        if (critical) {
+            critical_seen++;
+            critical_delivered += s.mask == up && s.suppressed[0] == 0 && s.suppressed[1] == 0;
+            continue;
+        }
+        for (int sink = 0; sink < OUT_SINK_COUNT; sink++) {
+            if (!(up & (1u << sink))) continue;
+            Tally& t = tally[ev.category][sink];
+            t.offered++;
+            if (s.mask & (1u << sink)) {
+                t.taken_ms[t.taken++] = ev.ms;
+                t.folded += s.suppressed[sink];
+                t.with_suppressed += s.suppressed[sink] > 0;
+            }
+        }
+    }
+}
+
+void test_replay_every_message_accounted_for()
+{
+    int n = build_trace();
+    TEST_ASSERT_GREATER_OR_EQUAL(1500, n);
+    replay(n);
+    uint32_t dropped[OUT_SINK_COUNT] = {0, 0};
+    for (int c = 0; c < CATEGORIES; c++) {
+        for (int sink = 0; sink < OUT_SINK_COUNT; sink++) {
+            const Tally& t = tally[c][sink];
+            // Sent, reported in a later message, or still pending
+            TEST_ASSERT_EQUAL_UINT32(t.offered, t.taken + t.folded + buckets[c][sink].suppressed);
+            dropped[sink] += t.folded + buckets[c][sink].suppressed;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(dropped[OUT_SINK_SERIAL], suppressed_total[OUT_SINK_SERIAL]);
+    TEST_ASSERT_EQUAL_UINT32(dropped[OUT_SINK_BLE], suppressed_total[OUT_SINK_BLE]);
+    TEST_ASSERT_TRUE(tally[RING][OUT_SINK_SERIAL].with_suppressed > 0);
+    TEST_ASSERT_TRUE(tally[WYZE][OUT_SINK_BLE].with_suppressed > 0);
+}
+
+void test_replay_rate_holds_in_every_minute()
+{
+    replay(build_trace());
+    for (int c = 0; c < CATEGORIES; c++) {
+        for (int sink = 0; sink < OUT_SINK_COUNT; sink++) {
+            const Tally& t = tally[c][sink];
+            uint32_t most = (uint32_t)(limits.per_minute[sink] + limits.burst[sink]);
+            for (uint32_t i = 0, j = 0; i < t.taken; i++) {
+                while (t.taken_ms[i] - t.taken_ms[j] >= 60000) j++;
+                TEST_ASSERT_LESS_OR_EQUAL_UINT32(most, i - j + 1);
+            }
+        }
+    }
+}
+
+void test_replay_busy_category_gets_its_full_rate()
+{
+    replay(build_trace());
+    // RING offers ~86/min; before the summary window Serial should take the
+    // burst plus one a second, and BLE the burst plus one every 3 s
+    uint32_t serial = 0, ble = 0;
+    for (uint32_t i = 0; i < tally[RING][OUT_SINK_SERIAL].taken; i++) {
+        serial += tally[RING][OUT_SINK_SERIAL].taken_ms[i] < SUMMARY_FROM;
+    }
+    for (uint32_t i = 0; i < tally[RING][OUT_SINK_BLE].taken; i++) {
+        ble += tally[RING][OUT_SINK_BLE].taken_ms[i] < SUMMARY_FROM;
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(10 + 240 - 2, serial);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(10 + 240, serial);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(5 + 80 - 2, ble);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(5 + 80, ble);
+}
+
+void test_replay_quiet_category_never_limited()
+{
+    replay(build_trace());
+    for (int sink = 0; sink < OUT_SINK_COUNT; sink++) {
+        TEST_ASSERT_TRUE(tally[FLOCK][sink].offered > 0);
+        TEST_ASSERT_EQUAL_UINT32(tally[FLOCK][sink].offered, tally[FLOCK][sink].taken);
+        TEST_ASSERT_EQUAL_UINT32(0, tally[FLOCK][sink].folded);
+    }
+}
+
+void test_replay_critical_always_delivered()
+{
+    replay(build_trace());
+    TEST_ASSERT_TRUE(critical_seen >= 20);
+    TEST_ASSERT_EQUAL_UINT32(critical_seen, critical_delivered);
+    TEST_ASSERT_EQUAL_UINT32(0, summary_counts[AXON] + summary_counts[RAVEN]);
+    TEST_ASSERT_FALSE(buckets[AXON][OUT_SINK_SERIAL].used || buckets[RAVEN][OUT_SINK_BLE].used);
+}
+
+void test_replay_summary_window_counts_not_limits()
+{
+    int n = build_trace();
+    replay(n);
+    uint32_t in_window[CATEGORIES] = {0};
+    for (int i = 0; i < n; i++) {
+        if (trace[i].ms >= SUMMARY_FROM && trace[i].ms < SUMMARY_TO && !is_critical(trace[i].category)) {
+            in_window[trace[i].category]++;
+        }
+    }
+    for (int c = 0; c < CATEGORIES; c++) {
+        TEST_ASSERT_EQUAL_UINT32(in_window[c], summary_counts[c]);
+    }
+    TEST_ASSERT_TRUE(summary_counts[RING] > 60);
+
+    // Nothing was sent or charged while summarizing, so the buckets refilled:
+    // the first RING message after the window is sent on both sinks
+    const Tally& t = tally[RING][OUT_SINK_SERIAL];
+    uint32_t after = 0;
+    while (t.taken_ms[after] < SUMMARY_TO) after++;
+    TEST_ASSERT_TRUE(t.taken_ms[after] < SUMMARY_TO + 2000);
+    for (uint32_t k = 1; k < 10; k++) {
+        TEST_ASSERT_TRUE(t.taken_ms[after + k] - t.taken_ms[after] < 20000);
+    }
+}
+
+void test_replay_ble_down_not_charged()
+{
+    replay(build_trace());
+    for (int c = 0; c < CATEGORIES; c++) {
+        const Tally& t = tally[c][OUT_SINK_BLE];
+        for (uint32_t i = 0; i < t.taken; i++) {
+            TEST_ASSERT_TRUE(t.taken_ms[i] < BLE_DOWN_FROM || t.taken_ms[i] >= BLE_DOWN_TO);
+        }
+    }
+    // Serial kept going meanwhile
+    uint32_t serial = 0;
+    const Tally& t = tally[RING][OUT_SINK_SERIAL];
+    for (uint32_t i = 0; i < t.taken; i++) {
+        serial += t.taken_ms[i] >= BLE_DOWN_FROM && t.taken_ms[i] < BLE_DOWN_TO;
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(70, serial);
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_first_use_starts_full);
+    RUN_TEST(test_refill_is_exact);
+    RUN_TEST(test_refill_caps_at_burst);
+    RUN_TEST(test_long_gap_does_not_overflow);
+    RUN_TEST(test_suppressed_saturates);
+    RUN_TEST(test_sinks_limited_independently);
+    RUN_TEST(test_suppressed_folded_into_next_message);
+    RUN_TEST(test_critical_bypasses_limits);
+    RUN_TEST(test_summarized_costs_nothing);
+    RUN_TEST(test_sink_down_is_not_charged);
+    RUN_TEST(test_zero_rate_is_unlimited);
+    RUN_TEST(test_replay_every_message_accounted_for);
+    RUN_TEST(test_replay_rate_holds_in_every_minute);
+    RUN_TEST(test_replay_busy_category_gets_its_full_rate);
+    RUN_TEST(test_replay_quiet_category_never_limited);
+    RUN_TEST(test_replay_critical_always_delivered);
+    RUN_TEST(test_replay_summary_window_counts_not_limits);
+    RUN_TEST(test_replay_ble_down_not_charged);
+    return UNITY_END();
+}
@@ -0,0 +1,190 @@
+// Threat arbitration: thresholds, priority ordering, tie-breaks and
+// per-category expiry. Run with: pio test -e native -f test_threat
+
+#include <unity.h>
+#include "threat_arbiter.h"
+
+#define TIMEOUT_MS 10000
+#define ENTER 60
+#define HOLD 40
+
+enum { LOW_A, LOW_B, MID, HIGH, FIXED, CLASSES };
+
+static const ThreatClass classes[CLASSES] = {
+    {"LOW_A",   30, 100},
+    {"LOW_B",   30, 100},
+    {"MID",     60, 100},
+    {"HIGH",    90, 100},
+    {"FIXED",  100, 200},
+};
+
+static ThreatSlot slots[CLASSES];
+
+void setUp()
+{
+    memset(slots, 0, sizeof(slots));
+}
+
+void tearDown() {}
+
+static bool update(int type, int score, unsigned long now)
+{
+    return threat_slot_update(slots[type], threat_class_expiry_ms(classes[type], TIMEOUT_MS), score, -60,
+                              ENTER, HOLD, now);
+}
+
+static bool refresh(int type, unsigned long now)
+{
+    return threat_slot_refresh(slots[type], threat_class_expiry_ms(classes[type], TIMEOUT_MS), -60, now);
+}
+
+static int rank(ThreatView* out, int n, unsigned long now)
+{
+    return threat_rank(classes, slots, CLASSES, TIMEOUT_MS, out, n, now);
+}
+
+void test_enter_and_hold_thresholds()
+{
+    TEST_ASSERT_FALSE(update(MID, ENTER - 1, 1000));
+    TEST_ASSERT_TRUE(update(MID, ENTER, 2000));
+    TEST_ASSERT_EQUAL_UINT32(1, slots[MID].detections);
+
+    // Between the thresholds: keeps it alive and counts
+    TEST_ASSERT_TRUE(update(MID, HOLD, 11000));
+    TEST_ASSERT_EQUAL_UINT32(2, slots[MID].detections);
+    TEST_ASSERT_EQUAL_UINT32(11000, slots[MID].last_seen);
+
+    // Below the hold score: reported, but does not extend the threat
+    TEST_ASSERT_TRUE(update(MID, HOLD - 1, 15000));
+    TEST_ASSERT_EQUAL_UINT32(11000, slots[MID].last_seen);
+    TEST_ASSERT_FALSE(update(MID, HOLD, 21000));
+}
+
+void test_refresh_never_raises()
+{
+    TEST_ASSERT_FALSE(refresh(HIGH, 1000));
+    TEST_ASSERT_TRUE(update(HIGH, 80, 2000));
+    TEST_ASSERT_TRUE(refresh(HIGH, 9000));
+    TEST_ASSERT_TRUE(refresh(HIGH, 18000));
+    TEST_ASSERT_EQUAL_UINT32(1, slots[HIGH].detections);
+    TEST_ASSERT_FALSE(refresh(HIGH, 28000));
+}
+
+void test_best_score_and_rssi_clamp()
+{
+    threat_slot_update(slots[MID], TIMEOUT_MS, 90, -200, ENTER, HOLD, 1000);
+    threat_slot_update(slots[MID], TIMEOUT_MS, 70, 300, ENTER, HOLD, 2000);
+    TEST_ASSERT_EQUAL_UINT8(90, slots[MID].score);
+    TEST_ASSERT_EQUAL_INT8(127, slots[MID].rssi);
+    threat_slot_update(slots[MID], TIMEOUT_MS, 70, -200, ENTER, HOLD, 3000);
+    TEST_ASSERT_EQUAL_INT8(-128, slots[MID].rssi);
+}
+
+void test_priority_ordering()
+{
+    update(LOW_A, 70, 1000);
+    update(HIGH, 70, 2000);
+    update(MID, 70, 3000);
+    update(FIXED, 70, 4000);
+
+    ThreatView top[CLASSES];
+    TEST_ASSERT_EQUAL_INT(4, rank(top, CLASSES, 5000));
+    TEST_ASSERT_EQUAL_UINT8(FIXED, top[0].type);
+    TEST_ASSERT_EQUAL_UINT8(HIGH, top[1].type);
+    TEST_ASSERT_EQUAL_UINT8(MID, top[2].type);
+    TEST_ASSERT_EQUAL_UINT8(LOW_A, top[3].type);
+}
+
+void test_top_n_keeps_highest()
+{
+    update(LOW_A, 70, 1000);
+    update(MID, 70, 2000);
+    update(HIGH, 70, 3000);
+    update(LOW_B, 70, 4000);
+
+    ThreatView top[2];
+    TEST_ASSERT_EQUAL_INT(2, rank(top, 2, 5000));
+    TEST_ASSERT_EQUAL_UINT8(HIGH, top[0].type);
+    TEST_ASSERT_EQUAL_UINT8(MID, top[1].type);
+
+    TEST_ASSERT_EQUAL_INT(1, rank(top, 1, 5000));
+    TEST_ASSERT_EQUAL_UINT8(HIGH, top[0].type);
+}
+
+void test_tie_break_most_recent_first()
+{
+    update(LOW_A, 70, 1000);
+    update(LOW_B, 70, 2000);
+
+    ThreatView top[2];
+    TEST_ASSERT_EQUAL_INT(2, rank(top, 2, 3000));
+    TEST_ASSERT_EQUAL_UINT8(LOW_B, top[0].type);
+    TEST_ASSERT_EQUAL_UINT8(LOW_A, top[1].type);
+
+    // A refresh makes LOW_A the most recent
+    refresh(LOW_A, 4000);
+    rank(top, 2, 5000);
+    TEST_ASSERT_EQUAL_UINT8(LOW_A, top[0].type);
+    TEST_ASSERT_EQUAL_UINT8(LOW_B, top[1].type);
+}
+
+void test_per_category_expiry()
+{
+    update(HIGH, 70, 1000);
+    update(FIXED, 70, 1000);
+
+    ThreatView top[CLASSES];
+    TEST_ASSERT_EQUAL_INT(2, rank(top, CLASSES, 1000 + TIMEOUT_MS - 1));
+
+    // HIGH expires at 100% of the timeout, FIXED holds for 200%
+    TEST_ASSERT_EQUAL_INT(1, rank(top, CLASSES, 1000 + TIMEOUT_MS));
+    TEST_ASSERT_EQUAL_UINT8(FIXED, top[0].type);
+    TEST_ASSERT_FALSE(slots[HIGH].active);
+    TEST_ASSERT_EQUAL_INT(1, rank(top, CLASSES, 1000 + 2 * TIMEOUT_MS - 1));
+    TEST_ASSERT_EQUAL_INT(0, rank(top, CLASSES, 1000 + 2 * TIMEOUT_MS));
+}
+
+void test_expired_threat_needs_enter_score_again()
+{
+    update(MID, 70, 1000);
+    TEST_ASSERT_FALSE(update(MID, HOLD, 1000 + TIMEOUT_MS));
+    TEST_ASSERT_TRUE(update(MID, ENTER, 1000 + TIMEOUT_MS + 1));
+    TEST_ASSERT_EQUAL_UINT32(1, slots[MID].detections);
+    TEST_ASSERT_EQUAL_UINT32(1000 + TIMEOUT_MS + 1, slots[MID].first_seen);
+}
+
+void test_remaining_ms()
+{
+    TEST_ASSERT_EQUAL_UINT32(0, threat_rank_remaining_ms(classes, slots, CLASSES, TIMEOUT_MS, 1000));
+    update(HIGH, 70, 1000);
+    update(FIXED, 70, 2000);
+    TEST_ASSERT_EQUAL_UINT32(2 * TIMEOUT_MS - 1000,
+                             threat_rank_remaining_ms(classes, slots, CLASSES, TIMEOUT_MS, 3000));
+    TEST_ASSERT_EQUAL_UINT32(0, threat_rank_remaining_ms(classes, slots, CLASSES, TIMEOUT_MS,
+                                                         2000 + 2 * TIMEOUT_MS));
+}
+
+void test_millis_wraparound()
+{
+    unsigned long start = (unsigned long)-2000;
+    update(MID, 70, start);
+    ThreatView top[1];
+    TEST_ASSERT_EQUAL_INT(1, rank(top, 1, start + TIMEOUT_MS - 1));
+    TEST_ASSERT_EQUAL_INT(0, rank(top, 1, start + TIMEOUT_MS));
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_enter_and_hold_thresholds);
+    RUN_TEST(test_refresh_never_raises);
+    RUN_TEST(test_best_score_and_rssi_clamp);
+    RUN_TEST(test_priority_ordering);
+    RUN_TEST(test_top_n_keeps_highest);
+    RUN_TEST(test_tie_break_most_recent_first);
+    RUN_TEST(test_per_category_expiry);
+    RUN_TEST(test_expired_threat_needs_enter_score_again);
+    RUN_TEST(test_remaining_ms);
+    RUN_TEST(test_millis_wraparound);
+    return UNITY_END();
+}
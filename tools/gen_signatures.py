@@ -0,0 +1,346 @@
+#!/usr/bin/env python3
+"""
+Compile tools/signatures.json and the datasets it references into the
+compiled-in signature tables (src/generated/*.h).
+
+Runs as a PlatformIO pre-build script (see extra_scripts in platformio.ini)
+and can be run by hand:
+
+    python tools/gen_signatures.py
+
+Every table is a sorted constexpr array, so the firmware binary searches
+them straight out of flash with no initialization at boot. Headers are only
+rewritten when their content changes, so an unchanged dataset does not
+trigger a rebuild.
+"""
+
+import os
+import sys
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+    PROJECT_DIR = env["PROJECT_DIR"]  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+sys.path.insert(0, os.path.join(PROJECT_DIR, "tools"))
+import sigdb  # noqa: E402
+
+SPEC_PATH = os.path.join(PROJECT_DIR, "tools", "signatures.json")
+OUT_DIR = os.path.join(PROJECT_DIR, "src", "generated")
+
+# Sizes on the 32-bit targets, for the footprint report
+PTR = 4
+SIZEOF = {
+    "GenVendor": 8,                 # category, flags, pad, name
+    "GenPattern": 8,                # text, category, priority, flags, pad
+    "GenRavenService": 24,          # uuid[16], fw_mask, pad, description
+    "GenRavenCharacteristic": 24,   # uuid[16], service, fw_mask, pad, name
+}
+
+BANNER = ("// Generated by tools/gen_signatures.py from tools/signatures.json and\n"
+          "// datasets/ - do not edit, re-run the generator instead.\n")
+
+CATEGORY_NAMES = {v: k for k, v in sigdb.CATEGORIES.items()}
+
+
+def c_string(text):
+    return '"%s"' % text.replace("\\", "\\\\").replace('"', '\\"')
+
+
+def c_uuid(text):
+    raw = sigdb.parse_uuid(text)
+    return "{ %s }" % ", ".join("0x%02x" % b for b in raw)
+
+
+def write_if_changed(path, content):
+    old = None
+    if os.path.exists(path):
+        with open(path) as f:
+            old = f.read()
+    if old != content:
+        with open(path, "w") as f:
+            f.write(content)
+        return True
+    return False
+
+
+def gen_sig_tables(spec, report):
+    vendors = spec.get("vendors", [])
+    lines = [BANNER, "#pragma once", "#include <stdint.h>", ""]
+    lines += [
+        "#define GEN_VENDOR_ALERT 0x01       // OUI alone is enough to alert",
+        "#define GEN_PATTERN_ALERT 0x01      // Match alone is enough to alert",
+        "",
+        "struct GenVendor {",
+        "    uint8_t category;               // DetectionType",
+        "    uint8_t flags;",
+        "    const char* name;",
+        "};",
+        "",
+        "struct GenPattern {",
+        "    const char* text;               // Case-insensitive substring",
+        "    uint8_t category;               // DetectionType",
+        "    uint8_t priority;               // Lower wins when several patterns match",
+        "    uint8_t flags;",
+        "};",
+        "",
+    ]
+
+    strings = 0
+    lines.append("static constexpr GenVendor GEN_VENDORS[] = {")
+    for v in vendors:
+        flags = "GEN_VENDOR_ALERT" if v.get("alert", True) else "0"
+        lines.append("    { %2d, %s, %s },  // %s" % (sigdb.category_id(v["category"]), flags,
+                                                     c_string(v["name"]), v["category"]))
+        strings += len(v["name"]) + 1
+    lines += ["};", ""]
+
+    ouis = []
+    for vi, v in enumerate(vendors):
+        for text in v.get("ouis", []):
+            ouis.append((sigdb.parse_oui(text), vi))
+    ouis.sort()
+    for a, b in zip(ouis, ouis[1:]):
+        if a[0] == b[0]:
+            sys.exit("error: OUI %s listed twice" % sigdb.format_oui(a[0]))
+    lines.append("// (oui << 8) | vendor index, sorted by OUI")
+    lines.append("static constexpr uint32_t GEN_OUIS[] = {")
+    for oui, vi in ouis:
+        lines.append("    0x%06x%02x,  // %s %s" % (oui, vi, sigdb.format_oui(oui), vendors[vi]["name"]))
+    lines += ["};", ""]
+
+    pattern_counts = {}
+    for kind, key in (("SSID", "ssid_patterns"), ("NAME", "name_patterns")):
+        patterns = sorted(spec.get(key, []),
+                          key=lambda p: (sigdb.pattern_priority(p), not p.get("alert", True),
+                                         p["pattern"].lower()))
+        seen = set()
+        lines.append("// Sorted by priority: the first match in table order is the best one")
+        lines.append("static constexpr GenPattern GEN_%s_PATTERNS[] = {" % kind)
+        for p in patterns:
+            folded = p["pattern"].lower()
+            if folded in seen:
+                sys.exit("error: %s pattern '%s' listed twice" % (kind.lower(), p["pattern"]))
+            seen.add(folded)
+            flags = "GEN_PATTERN_ALERT" if p.get("alert", True) else "0"
+            lines.append("    { %s, %d, %d, %s },  // %s" % (
+                c_string(p["pattern"]), sigdb.category_id(p["category"]),
+                sigdb.pattern_priority(p), flags, p["category"]))
+            strings += len(p["pattern"]) + 1
+        lines += ["};", ""]
+        pattern_counts[kind] = len(patterns)
+
+    channels = spec["_datasets"]["channels"]
+    lines.append("// Known Flock access points per 2.4 GHz channel in the datasets (index = channel)")
+    lines.append("static constexpr uint16_t GEN_DATASET_CHANNEL_COUNTS[15] = {")
+    lines.append("    %s" % ", ".join(str(c) for c in channels))
+    lines += ["};", ""]
+
+    report.append(("vendors", len(vendors), len(vendors) * SIZEOF["GenVendor"]))
+    report.append(("OUIs", len(ouis), len(ouis) * 4))
+    report.append(("SSID patterns", pattern_counts["SSID"], pattern_counts["SSID"] * SIZEOF["GenPattern"]))
+    report.append(("name patterns", pattern_counts["NAME"], pattern_counts["NAME"] * SIZEOF["GenPattern"]))
+    report.append(("channel counts", 15, 30))
+    report.append(("strings", None, strings))
+    return "\n".join(lines)
+
+
+def gen_raven_tables(spec, report):
+    raven = spec["_datasets"]["raven"]
+    versions = raven["versions"]
+    descriptions = {sigdb.normalize_uuid(u["uuid"]): u.get("description", "")
+                    for u in spec.get("uuids", []) if u.get("raven", False)}
+    services = sorted(set(raven["services"]) | set(descriptions), key=sigdb.parse_uuid)
+    service_index = {s: i for i, s in enumerate(services)}
+
+    lines = [BANNER, "#pragma once", "#include <stdint.h>", ""]
+    lines += [
+        "struct GenRavenService {",
+        "    uint8_t uuid[16];               // Big endian, as printed",
+        "    uint8_t fw_mask;                // Bit i = firmware version i exposes it",
+        "    const char* description;",
+        "};",
+        "",
+        "struct GenRavenCharacteristic {",
+        "    uint8_t uuid[16];",
+        "    uint8_t service;                // Index into GEN_RAVEN_SERVICES",
+        "    uint8_t fw_mask;",
+        "    const char* name;",
+        "};",
+        "",
+    ]
+    if len(versions) > 6:
+        sys.exit("error: at most 6 Raven firmware versions")
+
+    def family(i):
+        label = ".".join(versions[i].split(".")[:2]) + ".x"
+        if len(versions) > 1 and i == 0:
+            label += " (Legacy)"
+        elif len(versions) > 1 and i == len(versions) - 1:
+            label += " (Latest)"
+        return label
+
+    # Every combination of firmware versions a set of advertised services is
+    # consistent with, so the estimate is a single indexed load
+    strings = 0
+    lines.append("#define GEN_RAVEN_FIRMWARE_COUNT %d  // Oldest first: %s" % (len(versions), ", ".join(versions)))
+    lines.append("static constexpr const char* GEN_RAVEN_FIRMWARE_BY_MASK[%d] = {" % (1 << len(versions)))
+    for mask in range(1 << len(versions)):
+        bits = [i for i in range(len(versions)) if mask & (1 << i)]
+        label = " or ".join(family(i) for i in bits) if bits else "Unknown Version"
+        lines.append("    %s," % c_string(label))
+        strings += len(label) + 1
+    lines += ["};", ""]
+
+    lines.append("// Sorted by UUID")
+    lines.append("static constexpr GenRavenService GEN_RAVEN_SERVICES[] = {")
+    for s in services:
+        desc = descriptions.get(s, "Raven Service")
+        lines.append("    { %s, 0x%02x, %s },  // %s" % (c_uuid(s), raven["services"].get(s, 0),
+                                                     c_string(desc), s))
+        strings += len(desc) + 1
+    lines += ["};", ""]
+
+    chars = sorted(raven["characteristics"].items(),
+                   key=lambda kv: (sigdb.parse_uuid(kv[0][0]), service_index[kv[0][1]]))
+    lines.append("// Sorted by UUID, then service")
+    lines.append("static constexpr GenRavenCharacteristic GEN_RAVEN_CHARACTERISTICS[] = {")
+    for (char, service), (mask, name) in chars:
+        lines.append("    { %s, %d, 0x%02x, %s },  // %s" % (c_uuid(char), service_index[service], mask,
+                                                        c_string(name), char))
+        strings += len(name) + 1
+    lines += ["};", ""]
+
+    report.append(("Raven firmware labels", 1 << len(versions), (1 << len(versions)) * PTR))
+    report.append(("Raven services", len(services), len(services) * SIZEOF["GenRavenService"]))
+    report.append(("Raven characteristics", len(chars), len(chars) * SIZEOF["GenRavenCharacteristic"]))
+    report.append(("Raven strings", None, strings))
+    return "\n".join(lines)
+
+
+KNOWN_MAC_BLOCK = 32  # MACs per block; lookups binary search inside a block
+
+
+class BitWriter:
+    def __init__(self):
+        self.words = []
+        self.bits = 0
+
+    def put(self, value, n):
+        for i in range(n):
+            if self.bits % 32 == 0:
+                self.words.append(0)
+            if (value >> i) & 1:
+                self.words[-1] |= 1 << (self.bits % 32)
+            self.bits += 1
+
+
+def encode_known_macs(known):
+    """Sorted MACs in blocks of up to KNOWN_MAC_BLOCK.
+
+    Each block stores its first MAC in the block index and the rest as
+    fixed-width offsets from it (frame of reference), bit-packed. A lookup
+    binary searches the index, then binary searches the packed offsets, so
+    its cost does not depend on how the MACs cluster. Serial-numbered units
+    from one vendor sit close together, which keeps the offsets narrow.
+    A block never mixes OUIs or categories, so offsets are at most 24 bits.
+    """
+    macs = sorted(known)
+    bits = BitWriter()
+    blocks = []
+    i = 0
+    while i < len(macs):
+        first = macs[i]
+        j = i + 1
+        while (j < len(macs) and j - i < KNOWN_MAC_BLOCK and known[macs[j]] == known[first]
+               and macs[j] >> 24 == first >> 24):
+            j += 1
+        width = (macs[j - 1] - first).bit_length()
+        offset = bits.bits
+        for mac in macs[i + 1:j]:
+            bits.put(mac - first, width)
+        blocks.append((first, j - i, width, offset, known[first]))
+        i = j
+    bits.words.append(0)  # Lookups read two words at a time
+    return blocks, bits.words
+
+
+def gen_known_macs(spec, report):
+    known = spec["_datasets"]["known_macs"]
+    blocks, words = encode_known_macs(known)
+    if blocks and blocks[-1][3] >= (1 << 24):
+        sys.exit("error: known MAC set exceeds 16 Mbit")
+
+    lines = [BANNER, "#pragma once", "#include <stdint.h>", ""]
+    lines += [
+        "// Full 48-bit MACs of surveyed units, see encode_known_macs() in",
+        "// tools/gen_signatures.py for the layout",
+        "#define GEN_KNOWN_MAC_COUNT %d" % len(known),
+        "",
+        "struct GenMacBlock {",
+        "    uint32_t first_hi;              // First (lowest) MAC of the block, top 32 bits",
+        "    uint16_t first_lo;              // ...and low 16 bits",
+        "    uint8_t count;                  // MACs in the block, including the first",
+        "    uint8_t width;                  // Bits per packed (mac - first)",
+        "    uint32_t packed;                // (bit offset in GEN_KNOWN_MAC_BITS << 8) | DetectionType",
+        "};",
+        "",
+        "// Sorted by first MAC",
+        "static constexpr GenMacBlock GEN_KNOWN_MAC_BLOCKS[] = {",
+    ]
+    for first, count, width, offset, category in blocks:
+        lines.append("    { 0x%08x, 0x%04x, %d, %d, 0x%06x%02x },  // %s" % (
+            first >> 16, first & 0xFFFF, count, width, offset, category, sigdb.format_oui(first >> 24)))
+    lines += ["};", ""]
+    lines.append("static constexpr uint32_t GEN_KNOWN_MAC_BITS[] = {")
+    for i in range(0, len(words), 6):
+        lines.append("    " + " ".join("0x%08x," % w for w in words[i:i + 6]))
+    lines += ["};", ""]
+
+    size = len(blocks) * 12 + len(words) * 4
+    report.append(("known MAC blocks", len(blocks), len(blocks) * 12))
+    report.append(("known MACs", len(known), len(words) * 4))
+    if known:
+        print("  known MACs: %.1f bits per MAC, %.0f%% of a plain sorted array"
+              % (size * 8.0 / len(known), 100.0 * size / (len(known) * 6)))
+    return "\n".join(lines)
+
+
+def coverage(spec):
+    """Dataset SSIDs/names that no alerting pattern would catch."""
+    missed = {}
+    for kind, text in spec["_datasets"]["texts"]:
+        patterns = spec.get("ssid_patterns" if kind == "ssid" else "name_patterns", [])
+        if not any(p.get("alert", True) and p["pattern"].lower() in text.lower() for p in patterns):
+            missed[(kind, text)] = missed.get((kind, text), 0) + 1
+    return missed
+
+
+def generate():
+    spec = sigdb.load_spec(SPEC_PATH)
+    os.makedirs(OUT_DIR, exist_ok=True)
+
+    report = []
+    outputs = {
+        "sig_tables.h": gen_sig_tables(spec, report),
+        "raven_tables.h": gen_raven_tables(spec, report),
+        "known_macs.h": gen_known_macs(spec, report),
+    }
+    changed = [name for name, content in outputs.items()
+               if write_if_changed(os.path.join(OUT_DIR, name), content)]
+
+    ds = spec["_datasets"]
+    print("Signature tables: %d dataset rows, %d OUIs derived from datasets%s"
+          % (ds["rows"], ds["dataset_ouis"],
+             (", regenerated " + ", ".join(changed)) if changed else ", up to date"))
+    total = 0
+    for name, count, size in report:
+        print("  %-22s %6s  %7d bytes flash" % (name, "" if count is None else count, size))
+        total += size
+    print("  %-22s %6s  %7d bytes flash, 0 bytes RAM" % ("total", "", total))
+    for (kind, text), n in sorted(coverage(spec).items()):
+        print("warning: dataset %s '%s' (%d rows) matches no alerting pattern" % (kind, text, n))
+
+
+generate()
@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+"""
+Write a .pcap from the firmware's serial capture stream.
+
+Starts a capture, writes the frames to a pcap file (radiotap link type, opens
+in Wireshark) and stops the capture on Ctrl-C:
+
+    python tools/pcap_capture.py --port /dev/ttyACM0 -o drive.pcap
+    python tools/pcap_capture.py --port /dev/ttyACM0 --mode mgmt --snaplen 512 -o all.pcap
+
+A raw serial log saved by other means can be converted instead:
+
+    python tools/pcap_capture.py --input serial.bin -o drive.pcap
+
+The stream is framed in chunks (see PCAP CAPTURE in src/main.cpp): a 20 byte
+header with magic "FP", flags, payload length, record count, sequence number,
+running drop count and a CRC32, then whole pcap records. Anything between
+chunks (detections, command output) is skipped, or echoed with --echo.
+Frames the device had to drop and chunks lost on the link are reported.
+
+Device timestamps count from boot; they are shifted to the host clock unless
+--device-time is given.
+"""
+
+import argparse
+import struct
+import sys
+import time
+import zlib
+
+CHUNK_MAGIC = b"FP"
+CHUNK_HEADER = struct.Struct("<HBBHHIII")
+CHUNK_START = 0x01
+CHUNK_MAX_PAYLOAD = 4096 - CHUNK_HEADER.size
+FILE_HEADER_SIZE = 24
+RECORD_HEADER = struct.Struct("<IIII")
+
+
+class StreamParser:
+    """Resynchronising chunk parser; feed() bytes, chunks go to the writer."""
+
+    def __init__(self, writer, echo):
+        self.writer = writer
+        self.echo = echo
+        self.buf = bytearray()
+        self.text = bytearray()
+        self.next_seq = None
+        self.lost_chunks = 0
+        self.dropped = 0
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            start = self.buf.find(CHUNK_MAGIC)
+            if start < 0:
+                # Keep a trailing 'F', it may be the start of the next magic
+                keep = 1 if self.buf.endswith(CHUNK_MAGIC[:1]) else 0
+                self.skip(len(self.buf) - keep)
+                return
+            self.skip(start)
+            if len(self.buf) < CHUNK_HEADER.size:
+                return
+            magic, flags, _, length, frames, seq, dropped, crc = CHUNK_HEADER.unpack_from(self.buf)
+            if length > CHUNK_MAX_PAYLOAD:
+                self.skip(1)
+                continue
+            end = CHUNK_HEADER.size + length
+            if len(self.buf) < end:
+                return
+            payload = bytes(self.buf[CHUNK_HEADER.size:end])
+            if zlib.crc32(payload, zlib.crc32(bytes(self.buf[:CHUNK_HEADER.size - 4]))) != crc:
+                # Not a chunk after all, or text landed in the middle of one
+                self.skip(1)
+                continue
+            del self.buf[:end]
+            self.chunk(flags, frames, seq, dropped, payload)
+
+    def skip(self, n):
+        if n <= 0:
+            return
+        if self.echo:
+            self.text += self.buf[:n]
+            while b"\n" in self.text:
+                line, _, self.text = bytes(self.text).partition(b"\n")
+                self.text = bytearray(self.text)
+                sys.stderr.write(line.decode("utf-8", "replace").rstrip("\r") + "\n")
+        del self.buf[:n]
+
+    def chunk(self, flags, frames, seq, dropped, payload):
+        if flags & CHUNK_START:
+            if self.next_seq is not None:
+                print("capture restarted on the device", file=sys.stderr)
+            self.next_seq = 0
+            self.dropped = 0
+        elif self.next_seq is None:
+            # Joined a capture that was already running: no file header yet
+            self.next_seq = seq
+        if seq != self.next_seq:
+            self.lost_chunks += (seq - self.next_seq) & 0xFFFFFFFF
+            print("lost %d chunk(s) before #%d" % ((seq - self.next_seq) & 0xFFFFFFFF, seq), file=sys.stderr)
+        self.next_seq = seq + 1
+        if dropped > self.dropped:
+            print("device dropped %d frame(s)" % (dropped - self.dropped), file=sys.stderr)
+            self.dropped = dropped
+        self.writer.write_chunk(bool(flags & CHUNK_START), frames, payload)
+
+
+class PcapWriter:
+    def __init__(self, path, device_time):
+        self.out = open(path, "wb")
+        self.device_time = device_time
+        self.have_header = False
+        self.offset_us = None
+        self.frames = 0
+
+    def write_chunk(self, start, frames, payload):
+        if start:
+            header, payload = payload[:FILE_HEADER_SIZE], payload[FILE_HEADER_SIZE:]
+            if not self.have_header:
+                self.out.write(header)
+                self.have_header = True
+        if not self.have_header:
+            return
+        if not self.device_time:
+            payload = self.rebase(payload)
+        self.out.write(payload)
+        self.out.flush()
+        self.frames += frames
+
+    def rebase(self, payload):
+        out = bytearray(payload)
+        pos = 0
+        while pos + RECORD_HEADER.size <= len(out):
+            sec, usec, incl, orig = RECORD_HEADER.unpack_from(out, pos)
+            ts = sec * 1000000 + usec
+            if self.offset_us is None:
+                self.offset_us = int(time.time() * 1000000) - ts
+            ts += self.offset_us
+            RECORD_HEADER.pack_into(out, pos, ts // 1000000, ts % 1000000, incl, orig)
+            pos += RECORD_HEADER.size + incl
+        return bytes(out)
+
+    def close(self):
+        self.out.close()
+
+
+def capture_serial(args, parser):
+    try:
+        import serial
+    except ImportError:
+        sys.exit("error: pyserial is required (pip install pyserial)")
+
+    port = serial.Serial(args.port, args.baud, timeout=0.2)
+    port.reset_input_buffer()
+    port.write(b"capture %s %d\n" % (args.mode.encode(), args.snaplen))
+    print("Capturing %s frames to %s, Ctrl-C to stop" % (args.mode, args.output), file=sys.stderr)
+    try:
+        while True:
+            parser.feed(port.read(65536))
+    except KeyboardInterrupt:
+        pass
+    port.write(b"capture off\n")
+    deadline = time.time() + 1.0
+    while time.time() < deadline:
+        parser.feed(port.read(65536))
+    port.close()
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Write a pcap from the serial capture stream")
+    src = ap.add_mutually_exclusive_group(required=True)
+    src.add_argument("--port", help="serial port of the device, e.g. /dev/ttyACM0")
+    src.add_argument("--input", help="raw serial log to convert")
+    ap.add_argument("-o", "--output", default="capture.pcap")
+    ap.add_argument("--baud", type=int, default=115200, help="ignored by USB CDC")
+    ap.add_argument("--mode", choices=["matched", "mgmt"], default="matched",
+                    help="frames that produced a detection, or every management frame")
+    ap.add_argument("--snaplen", type=int, default=256, help="bytes kept per frame (24..2400)")
+    ap.add_argument("--device-time", action="store_true", help="keep timestamps relative to boot")
+    ap.add_argument("--echo", action="store_true", help="print the text between chunks to stderr")
+    args = ap.parse_args()
+
+    writer = PcapWriter(args.output, args.device_time)
+    parser = StreamParser(writer, args.echo)
+    if args.port:
+        capture_serial(args, parser)
+    else:
+        with open(args.input, "rb") as f:
+            parser.feed(f.read())
+    writer.close()
+
+    print("%d frames written to %s; %d dropped on the device, %d chunks lost on the link"
+          % (writer.frames, args.output, parser.dropped, parser.lost_chunks), file=sys.stderr)
+    if not writer.have_header:
+        print("warning: no capture start seen, %s is empty" % args.output, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,489 @@
+#!/usr/bin/env python3
+"""
+Flock-You signature database tool.
+
+Builds the binary signature image the firmware maps from its sigdb_a/sigdb_b
+partitions, inspects an image, and uploads one over the serial console.
+
+    python tools/sigdb.py build tools/signatures.json -o sigdb.bin
+    python tools/sigdb.py info sigdb.bin
+    python tools/sigdb.py upload sigdb.bin --port /dev/ttyACM0
+
+The layout mirrors the SIGNATURE DATABASE section of src/main.cpp; keep the
+two in sync when changing either.
+"""
+
+import argparse
+import csv
+import glob
+import json
+import os
+import struct
+import sys
+import time
+import zlib
+
+SIGDB_MAGIC = 0x47535946  # "FYSG"
+SIGDB_FORMAT_VERSION = 1
+SIGDB_MAX_SECTIONS = 8
+SIGDB_NO_PATTERN = 0xFFFF
+HEADER_SIZE = 176
+
+SECTION_STRINGS = 1
+SECTION_VENDORS = 2
+SECTION_OUIS = 3
+SECTION_SSID_AUTOMATON = 4
+SECTION_NAME_AUTOMATON = 5
+SECTION_UUIDS = 6
+
+SECTION_NAMES = {
+    SECTION_STRINGS: "strings",
+    SECTION_VENDORS: "vendors",
+    SECTION_OUIS: "ouis",
+    SECTION_SSID_AUTOMATON: "ssid automaton",
+    SECTION_NAME_AUTOMATON: "name automaton",
+    SECTION_UUIDS: "uuids",
+}
+
+VENDOR_ALERT = 0x01
+PATTERN_ALERT = 0x01
+UUID_RAVEN = 0x01
+
+# DetectionType in src/main.cpp
+CATEGORIES = {
+    "NONE": 0, "FLOCK_SAFETY": 1, "AXON": 2, "RAVEN": 3, "RING": 4,
+    "CRADLEPOINT": 5, "DRONE": 6, "NEST_GOOGLE": 7, "ARLO": 8, "EUFY": 9,
+    "WYZE": 10, "BLINK": 11, "ARUBA": 12,
+}
+
+# When several patterns match, the category earliest in this list wins.
+# The generated tables in src/generated/ are sorted by the same order.
+CATEGORY_PRIORITY = [
+    "RAVEN", "AXON", "RING", "CRADLEPOINT", "ARUBA", "DRONE",
+    "NEST_GOOGLE", "ARLO", "EUFY", "WYZE", "BLINK", "FLOCK_SAFETY",
+]
+
+
+class StringPool:
+    def __init__(self):
+        self.data = bytearray()
+        self.offsets = {}
+
+    def add(self, text):
+        if text not in self.offsets:
+            self.offsets[text] = len(self.data)
+            self.data += text.encode("utf-8") + b"\0"
+            if len(self.data) > 0x10000:
+                sys.exit("error: string pool exceeds 64 KB")
+        return self.offsets[text]
+
+
+def parse_oui(text):
+    parts = text.replace("-", ":").split(":")
+    if len(parts) != 3:
+        raise ValueError("bad OUI '%s'" % text)
+    return (int(parts[0], 16) << 16) | (int(parts[1], 16) << 8) | int(parts[2], 16)
+
+
+def parse_uuid(text):
+    raw = bytes.fromhex(text.replace("-", ""))
+    if len(raw) != 16:
+        raise ValueError("bad UUID '%s'" % text)
+    return raw
+
+
+def format_oui(oui):
+    return "%02x:%02x:%02x" % (oui >> 16, (oui >> 8) & 0xFF, oui & 0xFF)
+
+
+def parse_mac(text):
+    raw = bytes.fromhex(text.replace(":", "").replace("-", ""))
+    if len(raw) != 6:
+        raise ValueError("bad MAC '%s'" % text)
+    return int.from_bytes(raw, "big")
+
+
+def normalize_uuid(text, where=""):
+    """Lower-case 8-4-4-4-12 form. Short groups are zero padded on the left
+    (the Raven dump has e.g. '0002AB8-...'), with a warning."""
+    groups = text.strip().lower().split("-")
+    widths = [8, 4, 4, 4, 12]
+    if len(groups) != 5 or any(len(g) > w for g, w in zip(groups, widths)):
+        raise ValueError("bad UUID '%s'" % text)
+    fixed = "-".join(g.rjust(w, "0") for g, w in zip(groups, widths))
+    if fixed != text.strip().lower():
+        print("warning: %sUUID '%s' read as '%s'" % (where, text, fixed), file=sys.stderr)
+    return fixed
+
+
+def load_spec(path):
+    """Read a signature spec and fold in the datasets it references.
+
+    Every CSV row with a netid contributes its MAC to the exact-MAC set and
+    its OUI to a per-vendor count; OUIs seen at least min_oui_count times
+    (and not locally administered or excluded) are added to that vendor.
+    The Raven dump provides service/characteristic UUIDs per firmware."""
+    with open(path) as f:
+        spec = json.load(f)
+    base = os.path.dirname(os.path.abspath(path))
+    datasets = spec.get("datasets", {})
+    vendors = {v["name"]: v for v in spec.get("vendors", [])}
+    owner = {}
+    for v in spec.get("vendors", []):
+        for text in v.get("ouis", []):
+            owner[parse_oui(text)] = v["name"]
+
+    known_macs = {}
+    oui_counts = {}
+    channels = [0] * 15
+    texts = []          # (kind, text) seen in the datasets, for coverage reporting
+    rows_total = 0
+    for source in datasets.get("sources", []):
+        vendor = vendors.get(source["vendor"])
+        if vendor is None:
+            sys.exit("error: dataset vendor '%s' is not in vendors" % source["vendor"])
+        files = sorted(glob.glob(os.path.join(base, source["files"])))
+        if not files:
+            print("warning: no files match %s" % source["files"], file=sys.stderr)
+        for name in files:
+            with open(name, encoding="utf-8-sig", newline="") as f:
+                for row in csv.DictReader(f):
+                    netid = (row.get("netid") or "").strip()
+                    if not netid:
+                        continue
+                    rows_total += 1
+                    mac = parse_mac(netid)
+                    known_macs[mac] = category_id(vendor["category"])
+                    oui = mac >> 24
+                    if not (oui >> 16) & 0x02:  # Locally administered, not an OUI
+                        oui_counts[(oui, vendor["name"])] = oui_counts.get((oui, vendor["name"]), 0) + 1
+                    is_ble = (row.get("type") or "").upper() in ("BLE", "BT")
+                    label = (row.get("name") or row.get("ssid") or "").strip()
+                    if label:
+                        texts.append(("name" if is_ble else "ssid", label))
+                    channel = (row.get("channel") or "").strip()
+                    if not is_ble and channel.isdigit() and 1 <= int(channel) <= 14:
+                        channels[int(channel)] += 1
+
+    excluded = {parse_oui(t) for t in datasets.get("exclude_ouis", [])}
+    min_count = datasets.get("min_oui_count", 1)
+    dataset_ouis = 0
+    for (oui, vendor_name), count in sorted(oui_counts.items()):
+        if count < min_count or oui in excluded:
+            continue
+        if oui in owner:
+            if owner[oui] != vendor_name:
+                sys.exit("error: dataset OUI %s of %s is listed under %s"
+                         % (format_oui(oui), vendor_name, owner[oui]))
+            continue
+        owner[oui] = vendor_name
+        vendors[vendor_name].setdefault("ouis", []).append(format_oui(oui))
+        dataset_ouis += 1
+
+    raven = {"versions": [], "services": {}, "characteristics": {}}
+    if "raven" in datasets:
+        with open(os.path.join(base, datasets["raven"])) as f:
+            configs = json.load(f)
+        for bit, config in enumerate(configs):
+            raven["versions"].append(config["firmwareVersion"])
+            where = "Raven %s: " % config["firmwareVersion"]
+            for c in config.get("characteristics", []):
+                service = normalize_uuid(c["serviceUuid"], where)
+                char = normalize_uuid(c["characteristicUuid"], where)
+                raven["services"][service] = raven["services"].get(service, 0) | (1 << bit)
+                key = (char, service)
+                mask, label = raven["characteristics"].get(key, (0, c.get("name", "")))
+                raven["characteristics"][key] = (mask | (1 << bit), label)
+        if len(raven["versions"]) > 8:
+            sys.exit("error: at most 8 Raven firmware versions")
+
+    spec["_datasets"] = {
+        "rows": rows_total, "known_macs": known_macs, "dataset_ouis": dataset_ouis,
+        "channels": channels, "texts": texts, "raven": raven,
+    }
+    return spec
+
+
+def category_id(name):
+    if name not in CATEGORIES:
+        sys.exit("error: unknown category '%s'" % name)
+    return CATEGORIES[name]
+
+
+def pattern_priority(entry):
+    if "priority" in entry:
+        return int(entry["priority"])
+    name = entry["category"]
+    return CATEGORY_PRIORITY.index(name) if name in CATEGORY_PRIORITY else 255
+
+
+def build_automaton(patterns, strings):
+    """Case-insensitive Aho-Corasick DFA.
+
+    Characters that occur in some pattern get their own class, everything
+    else shares class 0. The goto function is fully resolved, so matching is
+    one table lookup per input byte. Each state records the best pattern
+    ending there (directly or through its failure chain), overall and among
+    the alerting patterns."""
+    records = []
+    for p in patterns:
+        text = p["pattern"]
+        if not text:
+            sys.exit("error: empty pattern")
+        records.append({
+            "text": text,
+            "folded": text.lower().encode("utf-8"),
+            "category": category_id(p["category"]),
+            "priority": pattern_priority(p),
+            "alert": bool(p.get("alert", True)),
+        })
+
+    chars = sorted({c for r in records for c in r["folded"]})
+    class_map = [0] * 256
+    for i, c in enumerate(chars):
+        class_map[c] = i + 1
+        if ord("a") <= c <= ord("z"):
+            class_map[c - 32] = i + 1
+    num_classes = len(chars) + 1
+
+    # Trie
+    goto = [{}]
+    outputs = [[]]
+    for idx, r in enumerate(records):
+        state = 0
+        for c in r["folded"]:
+            cls = class_map[c]
+            if cls not in goto[state]:
+                goto.append({})
+                outputs.append([])
+                goto[state][cls] = len(goto) - 1
+            state = goto[state][cls]
+        outputs[state].append(idx)
+
+    # Failure links (BFS) and the full transition table
+    num_states = len(goto)
+    if num_states > 0xFFFF:
+        sys.exit("error: automaton has too many states (%d)" % num_states)
+    fail = [0] * num_states
+    table = [[0] * num_classes for _ in range(num_states)]
+    queue = []
+    for cls in range(num_classes):
+        nxt = goto[0].get(cls)
+        if nxt is not None:
+            table[0][cls] = nxt
+            queue.append(nxt)
+    while queue:
+        state = queue.pop(0)
+        outputs[state] = outputs[state] + outputs[fail[state]]
+        for cls in range(num_classes):
+            nxt = goto[state].get(cls)
+            if nxt is None:
+                table[state][cls] = table[fail[state]][cls]
+            else:
+                fail[nxt] = table[fail[state]][cls]
+                table[state][cls] = nxt
+                queue.append(nxt)
+
+    def best(candidates):
+        if not candidates:
+            return SIGDB_NO_PATTERN
+        return min(candidates, key=lambda i: (records[i]["priority"], i))
+
+    blob = bytearray(struct.pack("<HHHH", num_states, len(records), num_classes, 0))
+    blob += bytes(class_map)
+    for r in records:
+        blob += struct.pack("<BBBBHH", r["category"], r["priority"],
+                            PATTERN_ALERT if r["alert"] else 0, 0, strings.add(r["text"]), 0)
+    for row in table:
+        blob += struct.pack("<%dH" % num_classes, *row)
+    for out in outputs:
+        blob += struct.pack("<HH", best(out), best([i for i in out if records[i]["alert"]]))
+    return blob, len(records), num_states, num_classes
+
+
+def build_image(spec, generation):
+    strings = StringPool()
+    strings.add("")
+
+    vendors = spec.get("vendors", [])
+    if len(vendors) > 256:
+        sys.exit("error: at most 256 vendors")
+    vendor_blob = bytearray()
+    oui_entries = {}
+    for vi, v in enumerate(vendors):
+        vendor_blob += struct.pack("<BBH", category_id(v["category"]),
+                                   VENDOR_ALERT if v.get("alert", True) else 0,
+                                   strings.add(v["name"]))
+        for text in v.get("ouis", []):
+            oui = parse_oui(text)
+            if oui in oui_entries:
+                sys.exit("error: OUI %s listed twice" % text)
+            oui_entries[oui] = vi
+    oui_blob = bytearray()
+    for oui in sorted(oui_entries):
+        oui_blob += struct.pack("<I", (oui << 8) | oui_entries[oui])
+
+    ssid_blob, ssid_patterns, ssid_states, ssid_classes = build_automaton(spec.get("ssid_patterns", []), strings)
+    name_blob, name_patterns, name_states, name_classes = build_automaton(spec.get("name_patterns", []), strings)
+
+    uuids = {}
+    for u in spec.get("uuids", []):
+        raw = parse_uuid(u["uuid"])
+        if raw in uuids:
+            sys.exit("error: UUID %s listed twice" % u["uuid"])
+        uuids[raw] = struct.pack("<BBH", UUID_RAVEN if u.get("raven", False) else 0, 0,
+                                 strings.add(u.get("description", "")))
+    uuid_blob = bytearray()
+    for raw in sorted(uuids):
+        uuid_blob += raw + uuids[raw]
+
+    sections = [
+        (SECTION_VENDORS, vendor_blob, len(vendors)),
+        (SECTION_OUIS, oui_blob, len(oui_entries)),
+        (SECTION_SSID_AUTOMATON, ssid_blob, ssid_patterns),
+        (SECTION_NAME_AUTOMATON, name_blob, name_patterns),
+        (SECTION_UUIDS, uuid_blob, len(uuids)),
+        (SECTION_STRINGS, strings.data, len(strings.offsets)),
+    ]
+
+    body = bytearray()
+    table = []
+    for stype, blob, count in sections:
+        while (HEADER_SIZE + len(body)) % 4:
+            body.append(0)
+        table.append((stype, HEADER_SIZE + len(body), len(blob), count))
+        body += blob
+    total = HEADER_SIZE + len(body)
+
+    section_table = b"".join(struct.pack("<HHIII", t, 0, o, s, c) for t, o, s, c in table)
+    section_table += bytes(16 * (SIGDB_MAX_SECTIONS - len(table)))
+    label = spec.get("label", "").encode("utf-8")[:23]
+    tail = struct.pack("<II24s", generation, int(time.time()), label) + section_table + body
+    crc = zlib.crc32(tail) & 0xFFFFFFFF
+    image = struct.pack("<IHHII", SIGDB_MAGIC, SIGDB_FORMAT_VERSION, len(table), total, crc) + tail
+    assert len(image) == total
+
+    stats = {
+        "vendors": len(vendors), "ouis": len(oui_entries),
+        "ssid": (ssid_patterns, ssid_states, ssid_classes),
+        "name": (name_patterns, name_states, name_classes),
+        "uuids": len(uuids), "strings": len(strings.data),
+    }
+    return bytes(image), stats
+
+
+def read_image(path):
+    with open(path, "rb") as f:
+        image = f.read()
+    if len(image) < HEADER_SIZE:
+        sys.exit("error: %s is too short" % path)
+    magic, fmt, count, total, crc = struct.unpack_from("<IHHII", image, 0)
+    generation, build_time, label = struct.unpack_from("<II24s", image, 16)
+    if magic != SIGDB_MAGIC or fmt != SIGDB_FORMAT_VERSION:
+        sys.exit("error: %s is not a format %d signature database" % (path, SIGDB_FORMAT_VERSION))
+    if total != len(image):
+        sys.exit("error: size mismatch (header %d, file %d)" % (total, len(image)))
+    sections = [struct.unpack_from("<HHIII", image, 48 + 16 * i) for i in range(count)]
+    return image, {
+        "generation": generation, "build_time": build_time,
+        "label": label.rstrip(b"\0").decode("utf-8", "replace"),
+        "crc": crc, "crc_ok": (zlib.crc32(image[16:]) & 0xFFFFFFFF) == crc,
+        "sections": sections,
+    }
+
+
+def cmd_build(args):
+    spec = load_spec(args.spec)
+    generation = args.generation if args.generation is not None else int(time.time())
+    image, stats = build_image(spec, generation)
+    with open(args.output, "wb") as f:
+        f.write(image)
+    print("Wrote %s: %d bytes, generation %d" % (args.output, len(image), generation))
+    print("  %d vendors, %d OUIs, %d UUIDs, %d bytes of strings"
+          % (stats["vendors"], stats["ouis"], stats["uuids"], stats["strings"]))
+    for kind in ("ssid", "name"):
+        patterns, states, classes = stats[kind]
+        print("  %s automaton: %d patterns, %d states x %d classes"
+              % (kind, patterns, states, classes))
+
+
+def cmd_info(args):
+    image, info = read_image(args.image)
+    print("%s: '%s' generation %d, %d bytes, CRC %08x (%s)"
+          % (args.image, info["label"], info["generation"], len(image), info["crc"],
+             "ok" if info["crc_ok"] else "BAD"))
+    print("Built %s" % time.strftime("%Y-%m-%d %H:%M:%S", time.localtime(info["build_time"])))
+    for stype, _, offset, size, count in info["sections"]:
+        print("  %-15s offset %6d  size %6d  count %5d"
+              % (SECTION_NAMES.get(stype, "type %d" % stype), offset, size, count))
+
+
+def cmd_upload(args):
+    try:
+        import serial
+    except ImportError:
+        sys.exit("error: pyserial is required (pip install pyserial)")
+
+    image, info = read_image(args.image)
+    if not info["crc_ok"]:
+        sys.exit("error: %s fails its CRC" % args.image)
+
+    port = serial.Serial(args.port, args.baud, timeout=0.5)
+    port.reset_input_buffer()
+    port.write(b"sigdb load %d\n" % len(image))
+
+    # Detections keep streaming while we wait, skip anything that is not ours
+    def wait_for(markers, timeout):
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            line = port.readline().decode("utf-8", "replace").strip()
+            if line.startswith("[SIGDB]"):
+                print(line)
+                for marker in markers:
+                    if marker in line:
+                        return marker
+        return None
+
+    if wait_for(["Ready", "No partition", "size must", "Out of memory"], 5) != "Ready":
+        sys.exit("error: device did not accept the upload")
+
+    chunk = 512
+    for offset in range(0, len(image), chunk):
+        port.write(image[offset:offset + chunk])
+        port.flush()
+        print("\r  %d / %d bytes" % (min(offset + chunk, len(image)), len(image)), end="")
+    print()
+
+    result = wait_for(["active", "rejected", "not newer", "timed out", "failed"], 15)
+    port.close()
+    if result != "active":
+        sys.exit("error: upload not activated")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Flock-You signature database tool")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("build", help="Build a signature image from a JSON spec")
+    p.add_argument("spec", help="Signature spec, e.g. tools/signatures.json")
+    p.add_argument("-o", "--output", default="sigdb.bin")
+    p.add_argument("--generation", type=int, default=None,
+                   help="Image generation (default: current Unix time)")
+    p.set_defaults(func=cmd_build)
+
+    p = sub.add_parser("info", help="Describe a signature image")
+    p.add_argument("image")
+    p.set_defaults(func=cmd_info)
+
+    p = sub.add_parser("upload", help="Upload a signature image over the serial console")
+    p.add_argument("image")
+    p.add_argument("--port", required=True)
+    p.add_argument("--baud", type=int, default=115200)
+    p.set_defaults(func=cmd_upload)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
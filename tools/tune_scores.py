@@ -0,0 +1,192 @@
+#!/usr/bin/env python3
+"""
+Fit the detection scoring weights against labelled captures.
+
+The firmware prints every detection as a JSON line carrying its feature
+vector ("score_features", one integer per ScoreFeature). Capture a serial
+log near devices you can label, then:
+
+    python tools/tune_scores.py capture1.log capture2.log \\
+        --positive-macs confirmed.txt --negative-macs benign.txt
+
+Lines with a "label" field (true/false or 1/0) are labelled by that field,
+others by the MAC lists; anything else is skipped. The weights are a
+logistic regression, so the resulting threat_score is a calibrated
+probability. The report compares the current and tuned weights with the
+firmware's own fixed-point arithmetic, including a calibration table.
+--write replaces the score_weights table in src/main.cpp.
+
+The feature names, weights and sigmoid table are read from src/main.cpp so
+this tool never drifts from the firmware.
+"""
+
+import argparse
+import json
+import math
+import os
+import re
+import sys
+
+MAIN_CPP = os.path.join(os.path.dirname(os.path.dirname(os.path.abspath(__file__))), "src", "main.cpp")
+Q = 256  # Q8 fixed point, as in the firmware
+
+
+def read_firmware(path):
+    with open(path) as f:
+        src = f.read()
+    enum = re.search(r"enum ScoreFeature \{(.*?)\};", src, re.S)
+    weights = re.search(r"(static const int16_t score_weights\[SCORE_FEATURE_COUNT\] = \{)(.*?)(\};)", src, re.S)
+    sigmoid = re.search(r"score_sigmoid_permille\[33\] = \{(.*?)\};", src, re.S)
+    if not (enum and weights and sigmoid):
+        sys.exit("error: scoring tables not found in %s" % path)
+    names = [n for n in re.findall(r"^\s*(SCORE_\w+)", enum.group(1), re.M) if n != "SCORE_FEATURE_COUNT"]
+    values = [int(v) for v in re.findall(r"(-?\d+),", weights.group(2))]
+    table = [int(v) for v in re.findall(r"\d+", sigmoid.group(1))]
+    if len(values) != len(names) or len(table) != 33:
+        sys.exit("error: score_weights does not match enum ScoreFeature")
+    return src, weights, names, values, table
+
+
+def firmware_score(weights, x, table):
+    """score_compute() from src/main.cpp, bit for bit."""
+    logit = sum(w * v for w, v in zip(weights, x))
+    pos = logit + 8 * Q
+    if pos <= 0:
+        return 0
+    if pos >= 16 * Q:
+        return 100
+    idx = pos >> 7
+    frac = pos & 127
+    permille = table[idx] + (((table[idx + 1] - table[idx]) * frac) >> 7)
+    return (permille + 5) // 10
+
+
+def read_mac_list(path):
+    macs = set()
+    if path:
+        with open(path) as f:
+            for line in f:
+                line = line.split("#")[0].strip().lower()
+                if line:
+                    macs.add(line)
+    return macs
+
+
+def load_corpus(paths, feature_count, positives, negatives):
+    samples = []
+    skipped = 0
+    for path in paths:
+        with open(path, errors="replace") as f:
+            for line in f:
+                start = line.find("{")
+                if start < 0:
+                    continue
+                try:
+                    doc = json.loads(line[start:])
+                except ValueError:
+                    continue
+                x = doc.get("score_features")
+                if not isinstance(x, list) or len(x) != feature_count:
+                    continue
+                mac = str(doc.get("mac_address", "")).lower()
+                if "label" in doc:
+                    y = 1 if doc["label"] in (True, 1, "1", "true") else 0
+                elif mac in positives:
+                    y = 1
+                elif mac in negatives:
+                    y = 0
+                else:
+                    skipped += 1
+                    continue
+                samples.append(([int(v) for v in x], y))
+    return samples, skipped
+
+
+def fit(samples, start, l2, iterations, rate):
+    """Batch gradient descent on the log loss, float logits. The L2 term pulls
+    towards the current table, so features the corpus never exercises keep
+    their weights."""
+    w0 = [v / float(Q) for v in start]
+    w = list(w0)
+    n = float(len(samples))
+    for _ in range(iterations):
+        grad = [0.0] * len(w)
+        for x, y in samples:
+            z = sum(wi * xi for wi, xi in zip(w, x))
+            p = 1.0 / (1.0 + math.exp(-max(-30.0, min(30.0, z))))
+            for i, xi in enumerate(x):
+                if xi:
+                    grad[i] += (p - y) * xi
+        for i in range(len(w)):
+            w[i] -= rate * (grad[i] / n + l2 * (w[i] - w0[i]))
+    return [max(-32768, min(32767, int(round(v * Q)))) for v in w]
+
+
+def evaluate(samples, weights, table):
+    loss = 0.0
+    brier = 0.0
+    bins = [[0, 0, 0.0] for _ in range(10)]
+    for x, y in samples:
+        score = firmware_score(weights, x, table)
+        p = min(max(score / 100.0, 0.005), 0.995)
+        loss -= math.log(p) if y else math.log(1.0 - p)
+        brier += (score / 100.0 - y) ** 2
+        b = bins[min(score // 10, 9)]
+        b[0] += 1
+        b[1] += y
+        b[2] += score
+    n = float(len(samples))
+    return loss / n, brier / n, bins
+
+
+def print_report(title, result):
+    loss, brier, bins = result
+    print("%s: log loss %.4f, Brier %.4f" % (title, loss, brier))
+    print("  score    n   mean score  observed")
+    for i, (count, pos, total) in enumerate(bins):
+        if count:
+            print("  %2d-%-3d %5d   %8.1f   %6.1f%%" % (i * 10, i * 10 + 9 + (i == 9), count,
+                                                      total / float(count), 100.0 * pos / count))
+
+
+def c_table(names, weights):
+    lines = []
+    for name, w in zip(names, weights):
+        lines.append("    %-7s // %s" % ("%d," % w, name))
+    return "\n" + "\n".join(lines) + "\n"
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Tune detection scoring weights")
+    ap.add_argument("captures", nargs="+", help="serial logs / JSON lines with score_features")
+    ap.add_argument("--positive-macs", help="file of MACs that are real targets")
+    ap.add_argument("--negative-macs", help="file of MACs that are not")
+    ap.add_argument("--l2", type=float, default=0.01, help="pull towards the current weights (default 0.01)")
+    ap.add_argument("--iterations", type=int, default=2000)
+    ap.add_argument("--rate", type=float, default=0.5, help="gradient descent step")
+    ap.add_argument("--firmware", default=MAIN_CPP, help="path to src/main.cpp")
+    ap.add_argument("--write", action="store_true", help="update score_weights in the firmware source")
+    args = ap.parse_args()
+
+    src, match, names, current, table = read_firmware(args.firmware)
+    samples, skipped = load_corpus(args.captures, len(names),
+                                   read_mac_list(args.positive_macs), read_mac_list(args.negative_macs))
+    positives = sum(y for _, y in samples)
+    print("%d labelled detections (%d positive), %d unlabelled skipped" % (len(samples), positives, skipped))
+    if positives == 0 or positives == len(samples):
+        sys.exit("error: need both positive and negative examples")
+
+    tuned = fit(samples, current, args.l2, args.iterations, args.rate)
+    print_report("Current weights", evaluate(samples, current, table))
+    print_report("Tuned weights", evaluate(samples, tuned, table))
+    print("\nstatic const int16_t score_weights[SCORE_FEATURE_COUNT] = {%s};" % c_table(names, tuned))
+
+    if args.write:
+        src = src[:match.start(2)] + c_table(names, tuned) + src[match.end(2):]
+        with open(args.firmware, "w") as f:
+            f.write(src)
+        print("Updated %s" % args.firmware)
+
+
+if __name__ == "__main__":
+    main()